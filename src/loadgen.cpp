@@ -0,0 +1,219 @@
+// Load generator for the tag server. One connection writes batches of
+// timestamped Int64 values to a set of tags, a second one subscribes to the
+// same tags and measures how long each value took to come back. Without
+// --socket or --port it starts its own server and a stand-in UI loop that
+// drains and publishes once per frame.
+
+#include <iostream>
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "xs_client.hpp"
+#include "xs_server.hpp"
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        std::string socket;
+        std::uint16_t port{ 0 };
+        std::size_t tags{ 1000 };
+        std::size_t batch{ 500 };
+        std::size_t ackEvery{ 16 };
+        double seconds{ 5.0 };
+        std::int64_t frameUs{ 16667 };
+    };
+
+    std::int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    bool parse(int argc, char** argv, Options& o) {
+        for (int k = 1; k < argc; ++k) {
+            const std::string arg = argv[k];
+            const bool hasValue = k + 1 < argc;
+            if (arg == "--socket" && hasValue) o.socket = argv[++k];
+            else if (arg == "--port" && hasValue) o.port = static_cast<std::uint16_t>(std::atoi(argv[++k]));
+            else if (arg == "--tags" && hasValue) o.tags = std::strtoull(argv[++k], nullptr, 10);
+            else if (arg == "--batch" && hasValue) o.batch = std::strtoull(argv[++k], nullptr, 10);
+            else if (arg == "--ack-every" && hasValue) o.ackEvery = std::strtoull(argv[++k], nullptr, 10);
+            else if (arg == "--seconds" && hasValue) o.seconds = std::atof(argv[++k]);
+            else if (arg == "--frame-us" && hasValue) o.frameUs = std::atoll(argv[++k]);
+            else return false;
+        }
+        return o.tags > 0 && o.batch > 0 && o.ackEvery > 0 && o.seconds > 0.0;
+    }
+
+    bool connect(xs::core::ProtocolClient& client, const Options& o, std::string& error) {
+        return o.port != 0 ? client.connect_tcp(o.port, error) : client.connect_unix(o.socket, error);
+    }
+
+    // Stands in for the HMI main loop when the server runs in-process.
+    class SelfHost {
+    public:
+        explicit SelfHost(std::int64_t frameUs) : m_ingest(1 << 16), m_server(m_store, m_ingest), m_frameUs(frameUs) {}
+
+        ~SelfHost() { stop(); }
+
+        void stop() {
+            m_stop = true;
+            if (m_thread.joinable()) m_thread.join();
+        }
+
+        bool start(const std::string& path, std::string& error) {
+            if (!m_server.listen_unix(path, error) || !m_server.start(error)) return false;
+            m_thread = std::thread([this] { loop(); });
+            return true;
+        }
+
+        void report() const {
+            const auto s = m_server.stats();
+            std::cout << "server: " << s.requests << " requests, " << s.writes << " writes, " << s.updates
+                << " updates pushed, " << s.bytesOut / 1024 << " KiB out\n";
+            if (m_frames > 0) {
+                std::cout << "ui thread drain+publish: avg " << m_busyNs / m_frames / 1000.0 << " us, max "
+                    << m_maxNs / 1000.0 << " us over " << m_frames << " frames\n";
+            }
+        }
+
+    private:
+        void loop() {
+            auto next = Clock::now();
+            while (!m_stop) {
+                const std::int64_t t0 = now_ns();
+                m_ingest.drain(m_store);
+                m_server.publish();
+                const std::int64_t busy = now_ns() - t0;
+                m_busyNs += static_cast<std::uint64_t>(busy);
+                m_maxNs = std::max(m_maxNs, static_cast<std::uint64_t>(busy));
+                ++m_frames;
+                next += std::chrono::microseconds(m_frameUs);
+                std::this_thread::sleep_until(next);
+            }
+            m_server.stop();
+        }
+
+        xs::core::VariableStore m_store;
+        xs::core::IngestQueue m_ingest;
+        xs::core::ProtocolServer m_server;
+        std::int64_t m_frameUs;
+        std::thread m_thread;
+        std::atomic<bool> m_stop{ false };
+        std::uint64_t m_frames{ 0 };
+        std::uint64_t m_busyNs{ 0 };
+        std::uint64_t m_maxNs{ 0 };
+    };
+
+    double percentile(std::vector<std::int64_t>& v, double p) {
+        if (v.empty()) return 0.0;
+        const std::size_t k = std::min(v.size() - 1, static_cast<std::size_t>(p * static_cast<double>(v.size())));
+        std::nth_element(v.begin(), v.begin() + static_cast<long>(k), v.end());
+        return static_cast<double>(v[k]) / 1000.0;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    Options o;
+    if (!parse(argc, argv, o)) {
+        std::cerr << "usage: XSmallHMI_loadgen [--socket path | --port n] [--tags n] [--batch n]\n"
+                     "                         [--ack-every n] [--seconds s] [--frame-us us]\n";
+        return 2;
+    }
+
+    std::string error;
+    std::unique_ptr<SelfHost> self;
+    if (o.socket.empty() && o.port == 0) {
+        o.socket = (std::filesystem::temp_directory_path() / "xs_loadgen.sock").string();
+        self = std::make_unique<SelfHost>(o.frameUs);
+        if (!self->start(o.socket, error)) {
+            std::cerr << "ERROR: " << error << "\n";
+            return 1;
+        }
+    }
+
+    xs::core::ProtocolClient writer;
+    xs::core::ProtocolClient reader;
+    if (!connect(writer, o, error) || !connect(reader, o, error)) {
+        std::cerr << "ERROR: " << error << "\n";
+        return 1;
+    }
+
+    std::vector<std::string> names;
+    for (std::size_t k = 0; k < o.tags; ++k) names.push_back("loadgen.t" + std::to_string(k));
+    std::vector<xs::core::TagId> ids;
+    if (!writer.resolve(names, ids, true) || !reader.subscribe(ids)) {
+        std::cerr << "ERROR: setup failed: " << writer.error() << reader.error() << "\n";
+        return 1;
+    }
+
+    const auto deadline = Clock::now() + std::chrono::duration<double>(o.seconds);
+    std::atomic<bool> writing{ true };
+    std::uint64_t written = 0;
+    std::thread producer([&] {
+        std::vector<xs::core::TagUpdate> batch(o.batch);
+        std::size_t next = 0;
+        for (std::size_t round = 1; Clock::now() < deadline; ++round) {
+            const std::int64_t stamp = now_ns();
+            for (auto& u : batch) {
+                u.id = ids[next++ % ids.size()];
+                u.value = xs::core::Value::make_int64(stamp);
+            }
+            std::uint32_t accepted = static_cast<std::uint32_t>(batch.size());
+            if (!writer.write(batch, round % o.ackEvery == 0, &accepted)) break;
+            written += accepted;
+        }
+        writing = false;
+    });
+
+    std::vector<std::int64_t> latency;
+    std::uint64_t received = 0;
+    std::vector<xs::core::TagUpdate> got;
+    const auto started = Clock::now();
+    // Keep reading a little after the writer stops so the tail arrives.
+    while (writing || Clock::now() < deadline + std::chrono::milliseconds(200)) {
+        got.clear();
+        reader.poll_updates(got, 50);
+        const std::int64_t now = now_ns();
+        for (const auto& u : got) {
+            if (u.value.type() != xs::core::Value::Type::Int64) continue;
+            latency.push_back(now - u.value.as_int64());
+            ++received;
+        }
+    }
+    producer.join();
+    const double secs = std::chrono::duration<double>(deadline - started).count();
+
+    std::cout << "tags " << o.tags << ", batch " << o.batch << ", " << o.seconds << " s\n";
+    std::cout << "writes: " << written << " (" << static_cast<double>(written) / secs << "/s)\n";
+    std::cout << "updates received: " << received << " (" << static_cast<double>(received) / secs
+        << "/s; the rest were coalesced)\n";
+    std::cout << "end-to-end latency us: p50 " << percentile(latency, 0.50) << ", p95 " << percentile(latency, 0.95)
+        << ", p99 " << percentile(latency, 0.99) << ", max " << percentile(latency, 1.0) << "\n";
+    if (self) {
+        self->stop();
+        self->report();
+    }
+    return 0;
+}
+
+#else
+
+int main() {
+    std::cerr << "The tag server needs Linux (epoll).\n";
+    return 1;
+}
+
+#endif
@@ -1,607 +1,243 @@
 #include <SFML/Graphics.hpp>
 
-#include <iomanip>
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
 #include <memory>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "xs_alarm.hpp"
 #include "xs_core.hpp"
-
-namespace xs::ui {
-    
-    struct Theme {
-        sf::Color bg{ sf::Color(22, 22, 26) };
-        sf::Color panel{ sf::Color(34, 34, 40) };
-        sf::Color border{ sf::Color(90, 90, 105) };
-        sf::Color text{ sf::Color(235, 235, 240) };
-        sf::Color hint{ sf::Color(170, 170, 185) };
-        sf::Color accent{ sf::Color(80, 160, 255) };
-    };
-
-    static std::string value_to_string(const xs::core::Value& v) {
-        switch (v.type) {
-        case xs::core::Value::Type::Int:
-            return std::to_string(v.i);
-        case xs::core::Value::Type::Float: {
-            std::ostringstream oss;
-            oss << std::fixed << std::setprecision(2) << v.f;
-            return oss.str();
-        }
-        case xs::core::Value::Type::Bool:
-            return v.b ? "true" : "false";
-        case xs::core::Value::Type::String:
-            return v.s;
-        default:
-            return "";
-        }
+#include "xs_expr.hpp"
+#include "xs_historian.hpp"
+#include "xs_ingest.hpp"
+#include "xs_metrics.hpp"
+#include "xs_screen.hpp"
+#include "xs_screen_host.hpp"
+#include "xs_server.hpp"
+#include "xs_snapshot.hpp"
+#include "xs_ui.hpp"
+
+namespace {
+
+    // The span build_screen() gives the named trend, or 0 if there is none.
+    std::int64_t trend_span(const xs::core::ScreenImage& image, std::string_view id) {
+        for (std::size_t k = 0; k < image.widget_count(); ++k) {
+            const xs::core::WidgetRecord r = image.widget(k);
+            if (r.kind != xs::core::WidgetKind::Trend || image.str(r.id) != id) continue;
+            return r.param > 0.f ? static_cast<std::int64_t>(r.param) : xs::ui::TrendChart::default_span;
+        }
+        return 0;
     }
 
-    class Widget {
-    public:
-        virtual ~Widget() = default;
-
-        virtual void handle_event(const sf::Event& e, const sf::RenderWindow& window) = 0;
-        virtual void update(float dt) { (void)dt; }
-        virtual void draw(sf::RenderTarget& target) const = 0;
-
-        virtual void set_position(const sf::Vector2f& p) { m_pos = p; }
-        virtual void set_size(const sf::Vector2f& s) { m_size = s; }
-
-        sf::Vector2f position() const { return m_pos; }
-        sf::Vector2f size() const { return m_size; }
-
-        bool contains(const sf::Vector2f& p) const {
-            return (p.x >= m_pos.x && p.x <= m_pos.x + m_size.x &&
-                p.y >= m_pos.y && p.y <= m_pos.y + m_size.y);
-        }
-
-        void set_enabled(bool enabled) { m_enabled = enabled; }
-        bool enabled() const { return m_enabled; }
-
-    protected:
-        sf::Vector2f m_pos{ 0.f, 0.f };
-        sf::Vector2f m_size{ 0.f, 0.f };
-        bool m_enabled{ true };
-    };
-
-    class Label final : public Widget {
-    public:
-        Label(const sf::Font& font, unsigned int charSize, const Theme& theme)
-            : m_theme(theme) {
-            m_text.setFont(font);
-            m_text.setCharacterSize(charSize);
-            m_text.setFillColor(m_theme.text);
-            m_size = sf::Vector2f(300.f, static_cast<float>(charSize) + 10.f);
-        }
-
-        void set_prefix(const std::string& p) { m_prefix = p; rebuild(); }
-        void set_text(const std::string& t) { m_valueText = t; rebuild(); }
-
-        void bind_to(xs::core::VariableStore& store, const std::string& varName) {
-            store.ensure(varName, xs::core::Value::make_string(""));
-            xs::core::Variable& var = store.at(varName);
-
-            m_subId = var.subscribe([this](const xs::core::Value& v) {
-                this->set_text(value_to_string(v));
-                });
-        }
-
-        void handle_event(const sf::Event&, const sf::RenderWindow&) override {
-            
-        }
-
-        void draw(sf::RenderTarget& target) const override {
-            target.draw(m_text);
-        }
-
-        void set_position(const sf::Vector2f& p) override {
-            Widget::set_position(p);
-            m_text.setPosition(m_pos);
-        }
-
-    private:
-        void rebuild() {
-            std::string combined = m_prefix;
-            if (!combined.empty()) combined += " ";
-            combined += m_valueText;
-            m_text.setString(combined);
-        }
-
-    private:
-        Theme m_theme;
-        sf::Text m_text;
-        std::string m_prefix;
-        std::string m_valueText;
-        std::size_t m_subId{ 0 };
-    };
-
-    class Button final : public Widget {
-    public:
-        Button(const sf::Font& font, unsigned int charSize, const Theme& theme)
-            : m_theme(theme) {
-            m_box.setFillColor(m_theme.panel);
-            m_box.setOutlineThickness(1.f);
-            m_box.setOutlineColor(m_theme.border);
-
-            m_text.setFont(font);
-            m_text.setCharacterSize(charSize);
-            m_text.setFillColor(m_theme.text);
-
-            m_size = sf::Vector2f(200.f, 40.f);
-            m_box.setSize(m_size);
-        }
-
-        void set_caption(const std::string& s) {
-            m_caption = s;
-            m_text.setString(m_caption);
-            center_text();
-        }
-
-        void set_on_click(std::function<void()> fn) { m_onClick = std::move(fn); }
-
-        void bind_toggle_bool(xs::core::VariableStore& store, const std::string& varName) {
-            store.ensure(varName, xs::core::Value::make_bool(false));
-            xs::core::Variable& var = store.at(varName);
-
-            m_subId = var.subscribe([this](const xs::core::Value& v) {
-                m_isOn = (v.type == xs::core::Value::Type::Bool) ? v.b : false;
-                refresh_style();
-                });
-
-            set_on_click([&store, varName]() {
-                const bool cur = store.get_bool(varName, false);
-                store.set(varName, xs::core::Value::make_bool(!cur));
-                });
-        }
-
-        void handle_event(const sf::Event& e, const sf::RenderWindow& window) override {
-            if (!enabled()) return;
-
-            if (e.type == sf::Event::MouseMoved) {
-                const sf::Vector2i mp = sf::Mouse::getPosition(window);
-                m_hover = contains(sf::Vector2f(static_cast<float>(mp.x), static_cast<float>(mp.y)));
-                refresh_style();
-            }
-
-            if (e.type == sf::Event::MouseButtonPressed && e.mouseButton.button == sf::Mouse::Left) {
-                const sf::Vector2f p(static_cast<float>(e.mouseButton.x), static_cast<float>(e.mouseButton.y));
-                if (contains(p)) {
-                    m_pressed = true;
-                    refresh_style();
-                }
-            }
-
-            if (e.type == sf::Event::MouseButtonReleased && e.mouseButton.button == sf::Mouse::Left) {
-                const sf::Vector2f p(static_cast<float>(e.mouseButton.x), static_cast<float>(e.mouseButton.y));
-                const bool wasPressed = m_pressed;
-                m_pressed = false;
-                refresh_style();
-
-                if (wasPressed && contains(p)) {
-                    if (m_onClick) m_onClick();
-                }
-            }
-        }
-
-        void draw(sf::RenderTarget& target) const override {
-            target.draw(m_box);
-            target.draw(m_text);
-        }
-
-        void set_position(const sf::Vector2f& p) override {
-            Widget::set_position(p);
-            m_box.setPosition(m_pos);
-            center_text();
-        }
-
-        void set_size(const sf::Vector2f& s) override {
-            Widget::set_size(s);
-            m_box.setSize(m_size);
-            center_text();
-        }
-
-    private:
-        void center_text() {
-            const sf::FloatRect tb = m_text.getLocalBounds();
-            const float x = m_pos.x + (m_size.x - tb.width) * 0.5f - tb.left;
-            const float y = m_pos.y + (m_size.y - tb.height) * 0.5f - tb.top;
-            m_text.setPosition(sf::Vector2f(x, y));
-        }
-
-        void refresh_style() {
-            if (!enabled()) {
-                m_box.setFillColor(sf::Color(45, 45, 52));
-                m_box.setOutlineColor(sf::Color(80, 80, 90));
-                m_text.setFillColor(sf::Color(150, 150, 160));
-                return;
-            }
-
-            m_box.setOutlineColor(m_isOn ? m_theme.accent : m_theme.border);
-
-            if (m_pressed) {
-                m_box.setFillColor(sf::Color(28, 28, 34));
-            }
-            else if (m_hover) {
-                m_box.setFillColor(sf::Color(40, 40, 48));
-            }
-            else {
-                m_box.setFillColor(m_theme.panel);
-            }
-
-            m_text.setFillColor(m_theme.text);
-        }
-
-    private:
-        Theme m_theme;
-        sf::RectangleShape m_box;
-        sf::Text m_text;
-
-        std::string m_caption{ "Button" };
-        std::function<void()> m_onClick;
-
-        bool m_hover{ false };
-        bool m_pressed{ false };
-        bool m_isOn{ false };
-
-        std::size_t m_subId{ 0 };
-    };
-
-    class TextField final : public Widget {
-    public:
-        TextField(const sf::Font& font, unsigned int charSize, const Theme& theme)
-            : m_theme(theme) {
-            m_box.setFillColor(m_theme.panel);
-            m_box.setOutlineThickness(1.f);
-            m_box.setOutlineColor(m_theme.border);
-
-            m_text.setFont(font);
-            m_text.setCharacterSize(charSize);
-            m_text.setFillColor(m_theme.text);
-
-            m_hintText.setFont(font);
-            m_hintText.setCharacterSize(charSize);
-            m_hintText.setFillColor(m_theme.hint);
-
-            m_caret.setSize(sf::Vector2f(1.f, static_cast<float>(charSize)));
-            m_caret.setFillColor(m_theme.accent);
-
-            m_size = sf::Vector2f(260.f, 40.f);
-            m_box.setSize(m_size);
-        }
-
-        void set_hint(const std::string& s) {
-            m_hint = s;
-            m_hintText.setString(m_hint);
-        }
-
-        void set_text(const std::string& s) {
-            m_value = s;
-            if (m_caretPos > m_value.size()) m_caretPos = m_value.size();
-            apply_text();
-        }
-
-        void bind_string(xs::core::VariableStore& store, const std::string& varName) {
-            store.ensure(varName, xs::core::Value::make_string(""));
-            xs::core::Variable& var = store.at(varName);
-
-            m_subId = var.subscribe([this](const xs::core::Value& v) {
-                if (!m_focused && v.type == xs::core::Value::Type::String) {
-                    this->set_text(v.s);
-                }
-                });
+}
 
-            m_commit = [&store, varName, this]() {
-                store.set(varName, xs::core::Value::make_string(this->m_value));
-                };
+int main(int argc, char** argv) {
+    if (argc == 4 && std::string(argv[1]) == "--compile") {
+        std::string error;
+        if (!xs::core::compile_screen_file(argv[2], argv[3], error)) {
+            std::cerr << "ERROR: " << error << "\n";
+            return 1;
         }
+        return 0;
+    }
 
-        void handle_event(const sf::Event& e, const sf::RenderWindow& window) override {
-            if (!enabled()) return;
-
-            if (e.type == sf::Event::MouseButtonPressed && e.mouseButton.button == sf::Mouse::Left) {
-                const sf::Vector2f p(static_cast<float>(e.mouseButton.x), static_cast<float>(e.mouseButton.y));
-                const bool nowFocused = contains(p);
-
-                if (m_focused && !nowFocused) {
-                    if (m_commit) m_commit();
-                }
-
-                m_focused = nowFocused;
-                refresh_style();
-
-                if (m_focused) {
-                    m_caretPos = m_value.size();
-                    update_caret_position();
-                }
-            }
-
-            if (!m_focused) return;
-
-            if (e.type == sf::Event::TextEntered) {
-                const sf::Uint32 code = e.text.unicode;
-
-                if (code == 8) {
-                    if (m_caretPos > 0 && !m_value.empty()) {
-                        m_value.erase(m_caretPos - 1, 1);
-                        --m_caretPos;
-                        apply_text();
-                    }
-                    return;
-                }
+    // Every screen path opens its own window.
+    std::vector<std::string> screenPaths;
+    std::string metricsPath;
+    std::string servePath;
+    int servePort = -1;
+    for (int k = 1; k < argc; ++k) {
+        const std::string arg = argv[k];
+        if (arg == "--metrics" && k + 1 < argc) metricsPath = argv[++k];
+        else if (arg == "--serve" && k + 1 < argc) servePath = argv[++k];
+        else if (arg == "--serve-tcp" && k + 1 < argc) servePort = std::atoi(argv[++k]);
+        else screenPaths.push_back(arg);
+    }
 
-                if (code == 13) {
-                    if (m_commit) m_commit();
-                    m_focused = false;
-                    refresh_style();
-                    return;
-                }
+    // A compiled screen is mapped directly; the text form is compiled on load.
+    if (screenPaths.empty()) {
+        screenPaths.push_back("assets/screens/main.xsb");
+        if (!xs::core::MappedFile(screenPaths[0]).is_open()) screenPaths[0] = "assets/screens/main.xss";
+    }
 
-                if (code == 9) return;
+    const std::string fontPath = "Roboto-Regular.ttf";
+    if (!xs::core::MappedFile(fontPath).is_open()) {
+        std::cerr << "ERROR: Cannot load font: " << fontPath << "\n";
+        std::cerr << "Put a TTF font near the exe and rename it to Roboto-Regular.ttf\n";
+        return 1;
+    }
 
-                if (code >= 32 && code <= 126) {
-                    if (m_value.size() < m_maxLen) {
-                        m_value.insert(m_caretPos, 1, static_cast<char>(code));
-                        ++m_caretPos;
-                        apply_text();
+    // Producers of the queue, the tag server and the screens wake the loop
+    // below, which otherwise sleeps until its next deadline.
+    xs::core::WakeSignal wake;
+    xs::core::VariableStore vars;
+    xs::core::IngestQueue ingest(4096);
+    ingest.set_wake(&wake);
+    xs::core::ExpressionEngine expressions(vars);
+
+    std::string error;
+    std::vector<std::unique_ptr<xs::core::ScreenFile>> screenFiles;
+    for (const std::string& path : screenPaths) {
+        auto file = std::make_unique<xs::core::ScreenFile>();
+        if (!file->load(path, error)) {
+            std::cerr << "ERROR: Cannot load screen: " << error << "\n";
+            return 1;
+        }
+        file->image().create_tags(vars);
+        if (!file->image().define_expressions(expressions, error)) {
+            std::cerr << "ERROR: " << path << ": " << error << "\n";
+            return 1;
+        }
+        screenFiles.push_back(std::move(file));
+    }
+    const xs::core::TagId temperature = vars.ensure_tag("temperature", xs::core::Value::make_float(23.50f));
+
+    xs::core::AlarmEngine alarms(vars);
+    alarms.publish_count(vars.ensure_tag("alarms.active", xs::core::Value::make_int(0)));
+    xs::core::AlarmConfig tempHigh;
+    tempHigh.kind = xs::core::AlarmKind::Hi;
+    tempHigh.limit = 30.0;
+    tempHigh.deadband = 0.5;
+    tempHigh.onDelay = 2000;
+    alarms.add(temperature, tempHigh);
+
+    xs::core::Historian historian(vars, "history.xsh");
+    historian.record(temperature, xs::core::HistoryConfig{ 4096, 0.0, 0.05 });
+
+    // Each screen renders on its own thread from a mirror of the tags it
+    // uses; this thread owns vars and publishes to the screens once per tick.
+    // screen.<name>.visible hides and suspends a screen.
+    std::vector<std::unique_ptr<xs::ui::ScreenHost>> hosts;
+    std::vector<xs::core::Subscription> visibility;
+    for (std::size_t k = 0; k < screenFiles.size(); ++k) {
+        const xs::core::ScreenImage& image = screenFiles[k]->image();
+        const std::string name = std::filesystem::path(screenPaths[k]).stem().string();
+
+        xs::ui::ScreenHost::Options options;
+        options.title = "XSmall-HMI SCADA - " + name;
+        options.fontPath = fontPath;
+        auto host = std::make_unique<xs::ui::ScreenHost>(image, options, vars, ingest);
+
+        // The historian is not thread-safe, so the backfill is queried here.
+        if (const std::int64_t span = trend_span(image, "tempTrend")) {
+            const std::int64_t trendEnd = xs::core::now_ms();
+            auto buckets = historian.query(temperature, trendEnd - span, trendEnd, 240);
+            host->on_built([buckets = std::move(buckets)](xs::ui::LoadedScreen& screen) {
+                if (auto tempTrend = screen.find<xs::ui::TrendChart>("tempTrend")) {
+                    for (const auto& b : buckets) {
+                        if (b.count > 0) tempTrend->add_envelope(0, b.begin, b.min, b.max);
                     }
                 }
-            }
-
-            if (e.type == sf::Event::KeyPressed) {
-                if (e.key.code == sf::Keyboard::Left) {
-                    if (m_caretPos > 0) { --m_caretPos; update_caret_position(); }
-                }
-                else if (e.key.code == sf::Keyboard::Right) {
-                    if (m_caretPos < m_value.size()) { ++m_caretPos; update_caret_position(); }
-                }
-                else if (e.key.code == sf::Keyboard::Escape) {
-                    m_focused = false;
-                    refresh_style();
-                }
-            }
-
-            (void)window;
-        }
-
-        void update(float dt) override {
-            if (!m_focused) { m_caretVisible = false; return; }
-            m_blinkTimer += dt;
-            if (m_blinkTimer >= 0.5f) {
-                m_blinkTimer = 0.f;
-                m_caretVisible = !m_caretVisible;
-            }
-        }
-
-        void draw(sf::RenderTarget& target) const override {
-            target.draw(m_box);
-
-            if (!m_value.empty()) target.draw(m_text);
-            else target.draw(m_hintText);
-
-            if (m_focused && m_caretVisible) target.draw(m_caret);
-        }
-
-        void set_position(const sf::Vector2f& p) override {
-            Widget::set_position(p);
-            m_box.setPosition(m_pos);
-
-            const float pad = 10.f;
-            m_text.setPosition(sf::Vector2f(m_pos.x + pad, m_pos.y + 8.f));
-            m_hintText.setPosition(sf::Vector2f(m_pos.x + pad, m_pos.y + 8.f));
-
-            update_caret_position();
+            });
         }
 
-        void set_size(const sf::Vector2f& s) override {
-            Widget::set_size(s);
-            m_box.setSize(m_size);
-            update_caret_position();
-        }
-
-    private:
-        void apply_text() {
-            m_text.setString(m_value);
-            update_caret_position();
-        }
-
-        void update_caret_position() {
-            const float pad = 10.f;
-
-            sf::Text tmp = m_text;
-            tmp.setString(m_value.substr(0, m_caretPos));
-            const sf::FloatRect bounds = tmp.getLocalBounds();
-
-            const float x = m_pos.x + pad + bounds.width;
-            const float y = m_text.getPosition().y;
-            m_caret.setPosition(sf::Vector2f(x, y));
-        }
-
-        void refresh_style() {
-            if (!enabled()) {
-                m_box.setOutlineColor(sf::Color(80, 80, 90));
-                return;
-            }
-            m_box.setOutlineColor(m_focused ? m_theme.accent : m_theme.border);
-            m_blinkTimer = 0.f;
-            m_caretVisible = m_focused;
-        }
-
-    private:
-        Theme m_theme;
-
-        sf::RectangleShape m_box;
-        sf::Text m_text;
-        sf::Text m_hintText;
-        sf::RectangleShape m_caret;
-
-        std::string m_hint{ "Enter text..." };
-        std::string m_value;
-
-        bool m_focused{ false };
-        std::size_t m_caretPos{ 0 };
-        std::size_t m_maxLen{ 32 };
-
-        float m_blinkTimer{ 0.f };
-        bool m_caretVisible{ false };
-
-        std::size_t m_subId{ 0 };
-        std::function<void()> m_commit;
-    };
-
-    class Panel final : public Widget {
-    public:
-        explicit Panel(const Theme& theme) : m_theme(theme) {
-            m_box.setFillColor(m_theme.panel);
-            m_box.setOutlineThickness(1.f);
-            m_box.setOutlineColor(m_theme.border);
-        }
-
-        void add(const std::shared_ptr<Widget>& w) {
-            m_children.push_back(w);
-        }
-
-        void handle_event(const sf::Event& e, const sf::RenderWindow& window) override {
-            for (auto& w : m_children) w->handle_event(e, window);
-        }
-
-        void update(float dt) override {
-            for (auto& w : m_children) w->update(dt);
-        }
-
-        void draw(sf::RenderTarget& target) const override {
-            target.draw(m_box);
-            for (auto& w : m_children) w->draw(target);
-        }
-
-        void set_position(const sf::Vector2f& p) override {
-            Widget::set_position(p);
-            m_box.setPosition(m_pos);
-        }
+        const xs::core::TagId shown = vars.ensure_tag("screen." + name + ".visible", xs::core::Value::make_bool(true));
+        xs::ui::ScreenHost* h = host.get();
+        visibility.push_back(vars.at(shown).subscribe_scoped([h](const xs::core::Value& v) {
+            if (v.type() == xs::core::Value::Type::Bool) h->set_visible(v.as_bool());
+        }));
+        hosts.push_back(std::move(host));
+    }
 
-        void set_size(const sf::Vector2f& s) override {
-            Widget::set_size(s);
-            m_box.setSize(m_size);
+    // Retentive values come back from the last snapshot; a missing file just
+    // means a first start.
+    const std::string snapshotPath = "state.xsv";
+    if (xs::core::MappedFile(snapshotPath).is_open() && !xs::core::load_snapshot(vars, snapshotPath, error)) {
+        std::cerr << "WARNING: " << error << "\n";
+    }
+    xs::core::SnapshotWriter snapshots(snapshotPath, 10000);
+
+    // --serve <socket> / --serve-tcp <port> let local tools read, write and
+    // subscribe to tags.
+#ifdef __linux__
+    xs::core::ProtocolServer server(vars, ingest);
+    if (!servePath.empty() || servePort >= 0) {
+        const bool listening = (servePath.empty() || server.listen_unix(servePath, error))
+            && (servePort < 0 || server.listen_tcp(static_cast<std::uint16_t>(servePort), error));
+        if (!listening || !server.start(error)) {
+            std::cerr << "ERROR: Cannot start tag server: " << error << "\n";
+            return 1;
         }
-
-    private:
-        Theme m_theme;
-        sf::RectangleShape m_box;
-        std::vector<std::shared_ptr<Widget>> m_children;
-    };
-
-}
-
-static std::string on_off(bool v) { return v ? "ON" : "OFF"; }
-
-int main() {
-    sf::RenderWindow window(
-        sf::VideoMode(760, 420),
-        "XSmall-HMI SCADA - IO Components (SFML)",
-        sf::Style::Titlebar | sf::Style::Close
-    );
-    window.setVerticalSyncEnabled(true);
-
-    sf::Font font;
-    if (!font.loadFromFile("Roboto-Regular.ttf")) {
-        std::cerr << "ERROR: Cannot load font: Roboto-Regular.ttf\n";
-        std::cerr << "Put a TTF font near the exe and rename it to Roboto-Regular.ttf\n";
+    }
+#else
+    if (!servePath.empty() || servePort >= 0) std::cerr << "WARNING: the tag server needs Linux\n";
+#endif
+
+    // F3 shows a metrics overlay per window; --metrics <file> logs a CSV
+    // line per second for this thread, with the frames of all screens, and
+    // prints the frame totals on exit.
+    xs::core::MetricsSampler sampler;
+    if (!metricsPath.empty() && !sampler.open_csv(metricsPath)) {
+        std::cerr << "ERROR: Cannot write metrics: " << metricsPath << "\n";
         return 1;
     }
+    xs::core::metrics().enabled = sampler.logging();
+
+    for (auto& host : hosts) host->start();
+
+    for (;;) {
+        std::size_t open = 0;
+        std::uint64_t frames = 0;
+        std::uint64_t drawCalls = 0;
+        for (const auto& host : hosts) {
+            frames += host->frames();
+            drawCalls += host->draw_calls();
+            if (!host->closed()) ++open;
+        }
+        if (open == 0) break;
+
+        {
+            xs::core::PhaseTimer timer(xs::core::Phase::Ingest);
+            ingest.drain(vars);
+#ifdef __linux__
+            server.publish();
+#endif
+        }
+        {
+            xs::core::PhaseTimer timer(xs::core::Phase::Logic);
+            alarms.tick();
+            historian.tick();
+            snapshots.tick(vars);
+        }
+        {
+            xs::core::PhaseTimer timer(xs::core::Phase::Update);
+            for (auto& host : hosts) host->publish();
+        }
+
+        std::int64_t due = std::min({ alarms.next_due(), historian.next_due(), snapshots.next_due() });
+        if (xs::core::metrics_enabled()) {
+            sampler.tick(xs::core::now_ms(), vars.size(), frames, drawCalls);
+            due = std::min(due, sampler.next_due());
+        }
+        // Nothing changes until a wake or a deadline, so an idle panel costs
+        // no ticks in between.
+        wake.wait_for(due - xs::core::now_ms());
+    }
 
-    xs::core::VariableStore vars;
-    vars.set("pump.enabled", xs::core::Value::make_bool(false));
-    vars.set("operator.name", xs::core::Value::make_string("Ivan"));
-    vars.set("temperature", xs::core::Value::make_float(23.50f));
-    vars.set("pump.enabled.view", xs::core::Value::make_string("OFF"));
-    vars.at("pump.enabled").subscribe([&vars](const xs::core::Value& v) {
-        const bool b = (v.type == xs::core::Value::Type::Bool) ? v.b : false;
-        vars.set("pump.enabled.view", xs::core::Value::make_string(on_off(b)));
-        });
-
-    const xs::ui::Theme theme;
-
-    auto panel = std::make_shared<xs::ui::Panel>(theme);
-    panel->set_position(sf::Vector2f(20.f, 20.f));
-    panel->set_size(sf::Vector2f(720.f, 380.f));
-
-    auto title = std::make_shared<xs::ui::Label>(font, 22, theme);
-    title->set_position(sf::Vector2f(40.f, 35.f));
-    title->set_text("IO Components Demo");
-    panel->add(title);
-
-    auto pumpLabel = std::make_shared<xs::ui::Label>(font, 18, theme);
-    pumpLabel->set_prefix("Pump:");
-    pumpLabel->set_position(sf::Vector2f(40.f, 85.f));
-    pumpLabel->bind_to(vars, "pump.enabled.view");
-    panel->add(pumpLabel);
-
-    auto pumpBtn = std::make_shared<xs::ui::Button>(font, 18, theme);
-    pumpBtn->set_position(sf::Vector2f(240.f, 78.f));
-    pumpBtn->set_size(sf::Vector2f(220.f, 42.f));
-    pumpBtn->set_caption("Toggle pump.enabled");
-    pumpBtn->bind_toggle_bool(vars, "pump.enabled");
-    panel->add(pumpBtn);
-
-    auto tempLabel = std::make_shared<xs::ui::Label>(font, 18, theme);
-    tempLabel->set_prefix("Temperature:");
-    tempLabel->set_position(sf::Vector2f(40.f, 145.f));
-    tempLabel->bind_to(vars, "temperature");
-    panel->add(tempLabel);
-
-    auto tempUp = std::make_shared<xs::ui::Button>(font, 18, theme);
-    tempUp->set_position(sf::Vector2f(240.f, 138.f));
-    tempUp->set_size(sf::Vector2f(220.f, 42.f));
-    tempUp->set_caption("Temperature +0.25");
-    tempUp->set_on_click([&vars]() {
-        const float t = vars.get_float("temperature", 0.f);
-        vars.set("temperature", xs::core::Value::make_float(t + 0.25f));
-        });
-    panel->add(tempUp);
-
-    auto nameLabel = std::make_shared<xs::ui::Label>(font, 18, theme);
-    nameLabel->set_prefix("Operator name:");
-    nameLabel->set_position(sf::Vector2f(40.f, 215.f));
-    nameLabel->bind_to(vars, "operator.name");
-    panel->add(nameLabel);
-
-    auto nameField = std::make_shared<xs::ui::TextField>(font, 18, theme);
-    nameField->set_position(sf::Vector2f(240.f, 205.f));
-    nameField->set_size(sf::Vector2f(320.f, 42.f));
-    nameField->set_hint("Type name, press Enter...");
-    nameField->bind_string(vars, "operator.name");
-    panel->add(nameField);
-
-    auto tip1 = std::make_shared<xs::ui::Label>(font, 16, theme);
-    tip1->set_position(sf::Vector2f(40.f, 290.f));
-    tip1->set_text("Variables: pump.enabled, operator.name, temperature");
-    panel->add(tip1);
-
-    auto tip2 = std::make_shared<xs::ui::Label>(font, 16, theme);
-    tip2->set_position(sf::Vector2f(40.f, 320.f));
-    tip2->set_text("Tip: click text field -> type -> Enter to commit");
-    panel->add(tip2);
-
-    sf::Clock clock;
-    while (window.isOpen()) {
-        const float dt = clock.restart().asSeconds();
-
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) {
-                window.close();
-                break;
-            }
-            panel->handle_event(event, window);
-        }
-
-        panel->update(dt);
+    xs::ui::FrameStats stats;
+    bool failed = false;
+    for (auto& host : hosts) {
+        host->stop();
+        if (!host->error().empty()) {
+            std::cerr << "ERROR: " << host->error() << "\n";
+            failed = true;
+        }
+        stats.frames += host->stats().frames;
+        stats.skipped += host->stats().skipped;
+        stats.full_repaints += host->stats().full_repaints;
+        stats.regions += host->stats().regions;
+    }
+    // The writer flushes this last capture before it is destroyed.
+    snapshots.capture(vars);
 
-        window.clear(theme.bg);
-        panel->draw(window);
-        window.display();
+    if (!metricsPath.empty()) {
+        std::cout << "frames: " << stats.frames << ", skipped: " << stats.skipped
+            << ", full repaints: " << stats.full_repaints << ", regions: " << stats.regions << "\n";
     }
 
-    return 0;
-}
\ No newline at end of file
+    return failed ? 1 : 0;
+}
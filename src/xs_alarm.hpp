@@ -0,0 +1,399 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "xs_core.hpp"
+
+namespace xs::core {
+
+    enum class AlarmKind : std::uint8_t { HiHi, Hi, Lo, LoLo, Deviation, RateOfChange };
+    enum class AlarmEvent : std::uint8_t { Raised, Cleared, Acknowledged, Shelved, Unshelved };
+
+    using AlarmId = std::uint32_t;
+
+    // limit is a value for HI/LO, a distance from the setpoint for Deviation
+    // and units per second for RateOfChange. An alarm clears once the value
+    // is back past the limit by more than deadband; the condition has to hold
+    // for onDelay ms before the alarm is raised and be gone for offDelay ms
+    // before it clears.
+    struct AlarmConfig {
+        AlarmKind kind{ AlarmKind::Hi };
+        double limit{ 0.0 };
+        double deadband{ 0.0 };
+        std::int64_t onDelay{ 0 };
+        std::int64_t offDelay{ 0 };
+        TagId setpointTag{ invalid_tag };
+        double setpoint{ 0.0 };
+        std::uint8_t priority{ 0 };
+    };
+
+    // Evaluates alarms when their tag changes, never by polling. Alarm state
+    // lives in one contiguous table; the alarm list (active or not yet
+    // acknowledged), the pending timers and the rising rate-of-change alarms
+    // are index lists with back-pointers, so every transition is O(1).
+    class AlarmEngine final {
+    public:
+        using Listener = std::function<void(AlarmId, AlarmEvent)>;
+
+        explicit AlarmEngine(VariableStore& store) : m_store(store), m_clock(now_ms) {}
+
+        ~AlarmEngine() {
+            for (TagId id = 0; id < m_watch.size(); ++id) {
+                if (m_watch[id] != 0) m_store.at(id).unsubscribe(m_watch[id]);
+            }
+        }
+
+        AlarmEngine(const AlarmEngine&) = delete;
+        AlarmEngine& operator=(const AlarmEngine&) = delete;
+
+        void set_clock(std::function<std::int64_t()> clock) { m_clock = std::move(clock); }
+        void set_listener(Listener fn) { m_listener = std::move(fn); }
+
+        // Keeps the number of active alarms in a tag, e.g. for a summary label.
+        void publish_count(TagId tag) {
+            m_countTag = tag;
+            publish();
+        }
+
+        AlarmId add(TagId tag, const AlarmConfig& cfg) {
+            const auto id = static_cast<AlarmId>(m_slots.size());
+            Slot s;
+            s.tag = tag;
+            s.setpointTag = cfg.setpointTag;
+            s.kind = cfg.kind;
+            s.priority = cfg.priority;
+            s.limit = cfg.limit;
+            s.deadband = cfg.deadband;
+            s.setpoint = cfg.setpoint;
+            s.onDelay = cfg.onDelay;
+            s.offDelay = cfg.offDelay;
+            m_slots.push_back(s);
+
+            const bool timed = cfg.onDelay > 0 || cfg.offDelay > 0 || cfg.kind == AlarmKind::RateOfChange;
+            attach(tag, id, timed);
+            if (cfg.kind == AlarmKind::Deviation && cfg.setpointTag != invalid_tag) attach(cfg.setpointTag, id, timed);
+
+            evaluate(id, timed ? m_clock() : 0);
+            return id;
+        }
+
+        std::size_t size() const { return m_slots.size(); }
+        TagId tag(AlarmId id) const { return m_slots[id].tag; }
+        AlarmKind kind(AlarmId id) const { return m_slots[id].kind; }
+        std::uint8_t priority(AlarmId id) const { return m_slots[id].priority; }
+
+        bool active(AlarmId id) const { return (m_slots[id].flags & Active) != 0; }
+        bool acknowledged(AlarmId id) const { return (m_slots[id].flags & Acked) != 0; }
+        bool shelved(AlarmId id) const { return (m_slots[id].flags & Shelved) != 0; }
+
+        // Alarms that are active or returned to normal but not acknowledged.
+        const std::vector<AlarmId>& alarm_list() const { return m_list; }
+        std::size_t active_count() const { return m_activeCount; }
+        std::uint64_t evaluations() const { return m_evaluations; }
+
+        bool acknowledge(AlarmId id) {
+            Slot& s = m_slots[id];
+            if (s.listPos == npos || (s.flags & Acked)) return false;
+            s.flags |= Acked;
+            if (!(s.flags & Active)) list_remove(id);
+            emit(id, AlarmEvent::Acknowledged);
+            return true;
+        }
+
+        void acknowledge_all() {
+            for (std::size_t k = m_list.size(); k-- > 0;) {
+                if (k < m_list.size()) acknowledge(m_list[k]);
+            }
+        }
+
+        // Suppresses the alarm until 'until' (0 = until unshelve()).
+        bool shelve(AlarmId id, std::int64_t until = 0) {
+            Slot& s = m_slots[id];
+            if (s.flags & Shelved) return false;
+            timer_cancel(id);
+            if (s.flags & Active) {
+                s.flags &= ~Active;
+                --m_activeCount;
+                publish();
+            }
+            if (s.listPos != npos) list_remove(id);
+            rate_unwatch(id);
+            s.flags = static_cast<std::uint8_t>((s.flags & ~Condition) | Shelved | Acked);
+            if (until > 0) timer_start(id, until);
+            emit(id, AlarmEvent::Shelved);
+            return true;
+        }
+
+        bool unshelve(AlarmId id) {
+            Slot& s = m_slots[id];
+            if (!(s.flags & Shelved)) return false;
+            timer_cancel(id);
+            s.flags &= ~Shelved;
+            emit(id, AlarmEvent::Unshelved);
+            evaluate(id, m_clock());
+            return true;
+        }
+
+        // Fires expired on/off delays and shelving periods, and re-measures
+        // rate-of-change alarms whose condition holds against the held value,
+        // so their rate decays once the tag stops moving. Only alarms with a
+        // pending timer or a rising rate are visited.
+        void tick() {
+            if (m_timers.empty() && m_rates.empty()) return;
+            const std::int64_t now = m_clock();
+            // Backwards, as evaluate() may swap the last entry into k.
+            for (std::size_t k = m_rates.size(); k-- > 0;) {
+                if (k < m_rates.size()) evaluate(m_rates[k], now, true);
+            }
+            for (std::size_t k = 0; k < m_timers.size();) {
+                const AlarmId id = m_timers[k];
+                Slot& s = m_slots[id];
+                if (s.deadline > now) {
+                    ++k;
+                    continue;
+                }
+                timer_cancel(id);
+                if (s.flags & Shelved) unshelve(id);
+                else if (s.flags & Active) clear(id);
+                else raise(id);
+            }
+        }
+
+        // When tick() next has work to do, on the engine's clock: the first
+        // pending timer, or when a rising rate will have decayed below its
+        // clear limit if the value holds. INT64_MAX if nothing is pending.
+        std::int64_t next_due() const {
+            std::int64_t due = std::numeric_limits<std::int64_t>::max();
+            for (AlarmId id : m_timers) due = std::min(due, m_slots[id].deadline);
+            for (AlarmId id : m_rates) {
+                const Slot& s = m_slots[id];
+                const double clearRate = s.limit - s.deadband;
+                if (clearRate <= 0.0) continue;
+                // One ms late, so rounding cannot leave the rate on the limit.
+                const double ms = std::ceil(std::fabs(s.lastValue - s.prevValue) * 1000.0 / clearRate) + 1.0;
+                if (ms < static_cast<double>(due - s.prevTime)) due = s.prevTime + static_cast<std::int64_t>(ms);
+            }
+            return due;
+        }
+
+    private:
+        static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+
+        enum Flags : std::uint8_t {
+            Condition = 1 << 0,
+            Active = 1 << 1,
+            Acked = 1 << 2,
+            Shelved = 1 << 3,
+            HasLast = 1 << 4,
+        };
+
+        struct Slot {
+            TagId tag{ invalid_tag };
+            TagId setpointTag{ invalid_tag };
+            AlarmKind kind{ AlarmKind::Hi };
+            std::uint8_t flags{ Acked };
+            std::uint8_t priority{ 0 };
+            std::uint32_t listPos{ npos };
+            std::uint32_t timerPos{ npos };
+            std::uint32_t ratePos{ npos };
+            double limit{ 0.0 };
+            double deadband{ 0.0 };
+            double setpoint{ 0.0 };
+            double lastValue{ 0.0 };
+            std::int64_t lastTime{ 0 };
+            double prevValue{ 0.0 };
+            std::int64_t prevTime{ 0 };
+            std::int64_t onDelay{ 0 };
+            std::int64_t offDelay{ 0 };
+            std::int64_t deadline{ 0 };
+        };
+
+        void attach(TagId tag, AlarmId id, bool timed) {
+            if (m_byTag.size() <= tag) {
+                m_byTag.resize(m_store.size());
+                m_watch.resize(m_store.size(), 0);
+                m_timed.resize(m_store.size(), 0);
+            }
+            m_byTag[tag].push_back(id);
+            if (timed) m_timed[tag] = 1;
+            if (m_watch[tag] == 0) {
+                m_watch[tag] = m_store.at(tag).subscribe([this, tag](const Value&) { on_change(tag); });
+            }
+        }
+
+        void on_change(TagId tag) {
+            const std::int64_t now = m_timed[tag] ? m_clock() : 0;
+            for (AlarmId id : m_byTag[tag]) evaluate(id, now);
+        }
+
+        // held re-measures a rate against the sample before the last one,
+        // as if the last step had taken until now.
+        bool condition(Slot& s, double v, std::int64_t now, bool held) {
+            const bool was = (s.flags & Condition) != 0;
+            double x = v;
+            switch (s.kind) {
+            case AlarmKind::Lo:
+            case AlarmKind::LoLo:
+                return was ? v < s.limit + s.deadband : v <= s.limit;
+            case AlarmKind::Deviation: {
+                double sp = s.setpoint;
+                if (s.setpointTag != invalid_tag && !to_double(m_store.get(s.setpointTag), sp)) return was;
+                x = std::fabs(v - sp);
+                break;
+            }
+            case AlarmKind::RateOfChange: {
+                if (!(s.flags & HasLast)) {
+                    s.lastValue = s.prevValue = v;
+                    s.lastTime = s.prevTime = now;
+                    s.flags |= HasLast;
+                    return was;
+                }
+                if (held) {
+                    const std::int64_t dt = now - s.prevTime;
+                    if (dt <= 0) return was;
+                    x = std::fabs(v - s.prevValue) * 1000.0 / static_cast<double>(dt);
+                    break;
+                }
+                // Samples within the same millisecond are measured against
+                // the older base sample once time has moved on.
+                const std::int64_t dt = now - s.lastTime;
+                if (dt <= 0) return was;
+                x = std::fabs(v - s.lastValue) * 1000.0 / static_cast<double>(dt);
+                s.prevValue = s.lastValue;
+                s.prevTime = s.lastTime;
+                s.lastValue = v;
+                s.lastTime = now;
+                break;
+            }
+            default:
+                break;
+            }
+            return was ? x > s.limit - s.deadband : x >= s.limit;
+        }
+
+        void evaluate(AlarmId id, std::int64_t now, bool held = false) {
+            Slot& s = m_slots[id];
+            ++m_evaluations;
+            if (s.flags & Shelved) return;
+
+            double v = 0.0;
+            if (!to_double(m_store.get(s.tag), v) || std::isnan(v)) return;
+
+            const bool cond = condition(s, v, now, held);
+            if (s.kind == AlarmKind::RateOfChange) {
+                if (cond) rate_watch(id);
+                else rate_unwatch(id);
+            }
+            if (cond == ((s.flags & Condition) != 0)) return;
+
+            if (cond) {
+                s.flags |= Condition;
+                if (s.flags & Active) timer_cancel(id);
+                else if (s.onDelay <= 0) raise(id);
+                else timer_start(id, now + s.onDelay);
+            }
+            else {
+                s.flags &= ~Condition;
+                if (!(s.flags & Active)) timer_cancel(id);
+                else if (s.offDelay <= 0) clear(id);
+                else timer_start(id, now + s.offDelay);
+            }
+        }
+
+        void raise(AlarmId id) {
+            Slot& s = m_slots[id];
+            s.flags = static_cast<std::uint8_t>((s.flags | Active) & ~Acked);
+            if (s.listPos == npos) {
+                s.listPos = static_cast<std::uint32_t>(m_list.size());
+                m_list.push_back(id);
+            }
+            ++m_activeCount;
+            publish();
+            emit(id, AlarmEvent::Raised);
+        }
+
+        void clear(AlarmId id) {
+            Slot& s = m_slots[id];
+            s.flags &= ~Active;
+            if (s.flags & Acked) list_remove(id);
+            --m_activeCount;
+            publish();
+            emit(id, AlarmEvent::Cleared);
+        }
+
+        void list_remove(AlarmId id) {
+            Slot& s = m_slots[id];
+            const AlarmId last = m_list.back();
+            m_list[s.listPos] = last;
+            m_slots[last].listPos = s.listPos;
+            m_list.pop_back();
+            s.listPos = npos;
+        }
+
+        void timer_start(AlarmId id, std::int64_t deadline) {
+            Slot& s = m_slots[id];
+            s.deadline = deadline;
+            if (s.timerPos != npos) return;
+            s.timerPos = static_cast<std::uint32_t>(m_timers.size());
+            m_timers.push_back(id);
+        }
+
+        void timer_cancel(AlarmId id) {
+            Slot& s = m_slots[id];
+            if (s.timerPos == npos) return;
+            const AlarmId last = m_timers.back();
+            m_timers[s.timerPos] = last;
+            m_slots[last].timerPos = s.timerPos;
+            m_timers.pop_back();
+            s.timerPos = npos;
+        }
+
+        void rate_watch(AlarmId id) {
+            Slot& s = m_slots[id];
+            if (s.ratePos != npos) return;
+            s.ratePos = static_cast<std::uint32_t>(m_rates.size());
+            m_rates.push_back(id);
+        }
+
+        void rate_unwatch(AlarmId id) {
+            Slot& s = m_slots[id];
+            if (s.ratePos == npos) return;
+            const AlarmId last = m_rates.back();
+            m_rates[s.ratePos] = last;
+            m_slots[last].ratePos = s.ratePos;
+            m_rates.pop_back();
+            s.ratePos = npos;
+        }
+
+        void publish() {
+            if (m_countTag != invalid_tag) m_store.set(m_countTag, Value::make_int(static_cast<int>(m_activeCount)));
+        }
+
+        void emit(AlarmId id, AlarmEvent e) {
+            if (m_listener) m_listener(id, e);
+        }
+
+        VariableStore& m_store;
+        std::function<std::int64_t()> m_clock;
+        Listener m_listener;
+        TagId m_countTag{ invalid_tag };
+
+        std::vector<Slot> m_slots;
+        std::vector<std::vector<AlarmId>> m_byTag;
+        std::vector<std::size_t> m_watch;
+        std::vector<std::uint8_t> m_timed;
+
+        std::vector<AlarmId> m_list;
+        std::vector<AlarmId> m_timers;
+        std::vector<AlarmId> m_rates;
+        std::size_t m_activeCount{ 0 };
+        std::uint64_t m_evaluations{ 0 };
+    };
+
+}
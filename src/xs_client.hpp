@@ -0,0 +1,301 @@
+#pragma once
+
+#ifdef __linux__
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "xs_ingest.hpp"
+#include "xs_protocol.hpp"
+
+namespace xs::core {
+
+    // Blocking client for ProtocolServer, for tools and tests. Each call
+    // waits for its reply; updates pushed while waiting are kept for
+    // poll_updates(). Not thread-safe: use one client per thread.
+    class ProtocolClient final {
+    public:
+        ProtocolClient() = default;
+        ~ProtocolClient() { close(); }
+
+        ProtocolClient(const ProtocolClient&) = delete;
+        ProtocolClient& operator=(const ProtocolClient&) = delete;
+
+        bool connect_unix(const std::string& path, std::string& error) {
+            sockaddr_un addr{};
+            if (path.size() >= sizeof(addr.sun_path)) {
+                error = "socket path too long: " + path;
+                return false;
+            }
+            addr.sun_family = AF_UNIX;
+            std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+            return open(AF_UNIX, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr), error);
+        }
+
+        bool connect_tcp(std::uint16_t port, std::string& error) {
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (!open(AF_INET, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr), error)) return false;
+            const int on = 1;
+            ::setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            return true;
+        }
+
+        void close() {
+            if (m_fd >= 0) ::close(m_fd);
+            m_fd = -1;
+            m_in.clear();
+            m_inPos = 0;
+        }
+
+        bool connected() const { return m_fd >= 0; }
+        const std::string& error() const { return m_error; }
+
+        // Unknown names come back as invalid_tag unless create is set, in
+        // which case they are created as Int 0.
+        bool resolve(const std::vector<std::string>& names, std::vector<TagId>& handles, bool create = false) {
+            const std::uint32_t id = begin(protocol::Op::Resolve);
+            m_writer.u8(create ? 1 : 0);
+            m_writer.u32(static_cast<std::uint32_t>(names.size()));
+            for (const std::string& n : names) m_writer.text16(n);
+            protocol::FrameReader in(nullptr, 0);
+            if (!call(id, in)) return false;
+            return read_ids(in, handles);
+        }
+
+        // Missing tags come back with id == invalid_tag.
+        bool read(const std::vector<TagId>& handles, std::vector<TagUpdate>& values) {
+            const std::uint32_t id = begin(protocol::Op::Read);
+            put_ids(handles);
+            protocol::FrameReader in(nullptr, 0);
+            if (!call(id, in)) return false;
+
+            std::uint32_t n = 0;
+            if (!in.u32(n) || n != handles.size()) return fail("bad read reply");
+            values.resize(n);
+            for (std::uint32_t k = 0; k < n; ++k) {
+                bool present = false;
+                if (!in.value(values[k].value, present)) return fail("bad read reply");
+                values[k].id = present ? handles[k] : invalid_tag;
+            }
+            return true;
+        }
+
+        // With wait set, blocks for the server's count of accepted writes;
+        // otherwise only queues the frame.
+        bool write(const std::vector<TagUpdate>& updates, bool wait = false, std::uint32_t* accepted = nullptr) {
+            const std::uint32_t id = wait ? begin(protocol::Op::Write) : begin(protocol::Op::Write, 0);
+            m_writer.u32(static_cast<std::uint32_t>(updates.size()));
+            for (const TagUpdate& u : updates) {
+                m_writer.u32(u.id);
+                m_writer.value(u.value);
+            }
+            if (!wait) {
+                m_writer.end();
+                return send_all();
+            }
+            protocol::FrameReader in(nullptr, 0);
+            if (!call(id, in)) return false;
+            std::uint32_t n = 0;
+            if (!in.u32(n)) return fail("bad write reply");
+            if (accepted) *accepted = n;
+            return true;
+        }
+
+        // Numeric tags are pushed only once they move by at least deadband
+        // from the last value sent; everything else on every change.
+        bool subscribe(const std::vector<TagId>& handles, double deadband = 0.0) {
+            const std::uint32_t id = begin(protocol::Op::Subscribe);
+            m_writer.f64(deadband);
+            put_ids(handles);
+            protocol::FrameReader in(nullptr, 0);
+            return call(id, in);
+        }
+
+        bool unsubscribe(const std::vector<TagId>& handles) {
+            const std::uint32_t id = begin(protocol::Op::Unsubscribe);
+            put_ids(handles);
+            protocol::FrameReader in(nullptr, 0);
+            return call(id, in);
+        }
+
+        // Appends pushed updates, waiting up to timeoutMs for the first one.
+        // Returns the number appended.
+        std::size_t poll_updates(std::vector<TagUpdate>& out, int timeoutMs) {
+            const std::size_t before = out.size();
+            drain_updates(out);
+            if (out.size() > before) return out.size() - before;
+
+            protocol::FrameHeader h{};
+            const std::uint8_t* frame = nullptr;
+            if (!next(timeoutMs, h, frame)) return 0;
+            if (h.op == static_cast<std::uint8_t>(protocol::Op::Update)) decode_update(frame, h.length, out);
+            consume(h.length);
+            // Whatever else has already arrived.
+            while (next(0, h, frame)) {
+                if (h.op == static_cast<std::uint8_t>(protocol::Op::Update)) decode_update(frame, h.length, out);
+                consume(h.length);
+            }
+            return out.size() - before;
+        }
+
+    private:
+        bool open(int family, const sockaddr* addr, socklen_t len, std::string& error) {
+            close();
+            m_fd = ::socket(family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (m_fd < 0 || ::connect(m_fd, addr, len) != 0) {
+                error = std::string("connect: ") + std::strerror(errno);
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        bool fail(const char* what) {
+            m_error = what;
+            return false;
+        }
+
+        // Request id 0 means "no reply", so it is skipped on wrap-around.
+        std::uint32_t begin(protocol::Op op) {
+            if (++m_nextRequest == 0) ++m_nextRequest;
+            return begin(op, m_nextRequest);
+        }
+
+        std::uint32_t begin(protocol::Op op, std::uint32_t request) {
+            m_out.clear();
+            m_writer.begin(static_cast<std::uint8_t>(op), request);
+            return request;
+        }
+
+        void put_ids(const std::vector<TagId>& ids) {
+            m_writer.u32(static_cast<std::uint32_t>(ids.size()));
+            for (TagId id : ids) m_writer.u32(id);
+        }
+
+        static bool read_ids(protocol::FrameReader& in, std::vector<TagId>& ids) {
+            std::uint32_t n = 0;
+            if (!in.u32(n) || !in.fits(n, sizeof(TagId))) return false;
+            ids.resize(n);
+            for (TagId& id : ids) {
+                if (!in.u32(id)) return false;
+            }
+            return true;
+        }
+
+        bool send_all() {
+            std::size_t sent = 0;
+            while (sent < m_out.size()) {
+                const ssize_t n = ::send(m_fd, m_out.data() + sent, m_out.size() - sent, MSG_NOSIGNAL);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return fail("send failed");
+                sent += static_cast<std::size_t>(n);
+            }
+            return true;
+        }
+
+        // Sends the frame started by begin() and waits for the reply to it.
+        // in is left positioned on the reply payload.
+        bool call(std::uint32_t request, protocol::FrameReader& in) {
+            m_writer.end();
+            if (!send_all()) return false;
+            for (;;) {
+                protocol::FrameHeader h{};
+                const std::uint8_t* frame = nullptr;
+                if (!next(-1, h, frame)) return fail("connection closed");
+                if (h.op == static_cast<std::uint8_t>(protocol::Op::Update)) {
+                    decode_update(frame, h.length, m_pending);
+                    consume(h.length);
+                    continue;
+                }
+                if (h.request != request) {
+                    consume(h.length);
+                    continue;
+                }
+                m_reply.assign(frame + sizeof(h), frame + h.length);
+                consume(h.length);
+                if (h.op == protocol::reply_op(protocol::Op::Error)) return fail("server error");
+                in = protocol::FrameReader(m_reply.data(), m_reply.size());
+                return true;
+            }
+        }
+
+        // Waits up to timeoutMs (-1 = forever) for a complete frame at the
+        // front of the receive buffer.
+        bool next(int timeoutMs, protocol::FrameHeader& h, const std::uint8_t*& frame) {
+            for (;;) {
+                const long length = protocol::next_frame(m_in.data() + m_inPos, m_in.size() - m_inPos);
+                if (length < 0) return fail("corrupt stream");
+                if (length > 0) {
+                    frame = m_in.data() + m_inPos;
+                    h = protocol::frame_header(frame);
+                    return true;
+                }
+                if (m_fd < 0) return false;
+                pollfd p{ m_fd, POLLIN, 0 };
+                const int ready = ::poll(&p, 1, timeoutMs);
+                if (ready < 0 && errno == EINTR) continue;
+                if (ready <= 0) return false;
+
+                if (m_inPos > 0) {
+                    m_in.erase(m_in.begin(), m_in.begin() + static_cast<long>(m_inPos));
+                    m_inPos = 0;
+                }
+                const std::size_t used = m_in.size();
+                m_in.resize(used + 64 * 1024);
+                const ssize_t n = ::recv(m_fd, m_in.data() + used, 64 * 1024, 0);
+                m_in.resize(used + static_cast<std::size_t>(n > 0 ? n : 0));
+                if (n == 0 || (n < 0 && errno != EINTR && errno != EAGAIN)) {
+                    close();
+                    return fail("connection closed");
+                }
+            }
+        }
+
+        void consume(std::uint32_t length) { m_inPos += length; }
+
+        static void decode_update(const std::uint8_t* frame, std::uint32_t length, std::vector<TagUpdate>& out) {
+            protocol::FrameReader in(frame + sizeof(protocol::FrameHeader), length - sizeof(protocol::FrameHeader));
+            std::uint32_t n = 0;
+            if (!in.u32(n)) return;
+            for (std::uint32_t k = 0; k < n; ++k) {
+                TagUpdate u;
+                bool present = false;
+                if (!in.u32(u.id) || !in.value(u.value, present)) return;
+                out.push_back(std::move(u));
+            }
+        }
+
+        void drain_updates(std::vector<TagUpdate>& out) {
+            for (TagUpdate& u : m_pending) out.push_back(std::move(u));
+            m_pending.clear();
+        }
+
+        int m_fd{ -1 };
+        std::string m_error;
+        std::uint32_t m_nextRequest{ 0 };
+        std::vector<std::uint8_t> m_out;
+        protocol::FrameWriter m_writer{ m_out };
+        std::vector<std::uint8_t> m_in;
+        std::size_t m_inPos{ 0 };
+        std::vector<std::uint8_t> m_reply;
+        std::vector<TagUpdate> m_pending;
+    };
+
+}
+
+#endif
@@ -1,53 +1,349 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <new>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "xs_metrics.hpp"
+
 namespace xs::core {
 
-    struct Value {
-        enum class Type { Int, Float, Bool, String };
+    inline std::int64_t now_ms() {
+        using namespace std::chrono;
+        return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+    }
+
+    class Value final {
+    public:
+        enum class Type : std::uint8_t { Int, Float, Bool, String, Double, Int64 };
+
+        static constexpr std::size_t inline_capacity = 16;
+
+        Value() noexcept { m_data.l = 0; }
+        ~Value() { release(); }
 
-        Type type{ Type::Int };
-        int i{ 0 };
-        float f{ 0.0f };
-        bool b{ false };
-        std::string s;
+        Value(const Value& other) noexcept { copy_from(other); }
+        Value(Value&& other) noexcept { move_from(other); }
+
+        Value& operator=(const Value& other) noexcept {
+            if (this != &other) {
+                release();
+                copy_from(other);
+            }
+            return *this;
+        }
+
+        Value& operator=(Value&& other) noexcept {
+            if (this != &other) {
+                release();
+                move_from(other);
+            }
+            return *this;
+        }
 
         static Value make_int(int v) {
-            Value x; x.type = Type::Int; x.i = v; return x;
+            Value x; x.m_type = Type::Int; x.m_data.i = v; return x;
         }
         static Value make_float(float v) {
-            Value x; x.type = Type::Float; x.f = v; return x;
+            Value x; x.m_type = Type::Float; x.m_data.f = v; return x;
         }
         static Value make_bool(bool v) {
-            Value x; x.type = Type::Bool; x.b = v; return x;
+            Value x; x.m_type = Type::Bool; x.m_data.b = v; return x;
+        }
+        static Value make_double(double v) {
+            Value x; x.m_type = Type::Double; x.m_data.d = v; return x;
+        }
+        static Value make_int64(std::int64_t v) {
+            Value x; x.m_type = Type::Int64; x.m_data.l = v; return x;
+        }
+
+        static Value make_string(std::string_view v) {
+            Value x; x.m_type = Type::String;
+            if (v.size() <= inline_capacity) {
+                if (!v.empty()) std::memcpy(x.m_data.small, v.data(), v.size());
+                x.m_size = static_cast<std::uint8_t>(v.size());
+            }
+            else {
+                x.m_data.shared = new SharedString{ {1}, std::string(v) };
+                x.m_size = shared_marker;
+            }
+            return x;
+        }
+        static Value make_string(const char* v) {
+            return make_string(std::string_view(v));
         }
         static Value make_string(const std::string& v) {
-            Value x; x.type = Type::String; x.s = v; return x;
+            return make_string(std::string_view(v));
+        }
+        static Value make_string(std::string&& v) {
+            if (v.size() <= inline_capacity) return make_string(std::string_view(v));
+            Value x; x.m_type = Type::String;
+            x.m_data.shared = new SharedString{ {1}, std::move(v) };
+            x.m_size = shared_marker;
+            return x;
+        }
+
+        Type type() const { return m_type; }
+
+        int as_int() const { return m_data.i; }
+        float as_float() const { return m_data.f; }
+        bool as_bool() const { return m_data.b; }
+        double as_double() const { return m_data.d; }
+        std::int64_t as_int64() const { return m_data.l; }
+
+        std::string_view as_string() const {
+            if (m_type != Type::String) return {};
+            if (m_size == shared_marker) return m_data.shared->str;
+            return std::string_view(m_data.small, m_size);
         }
 
         bool equals(const Value& other) const {
-            if (type != other.type) return false;
-            switch (type) {
-            case Type::Int:    return i == other.i;
-            case Type::Float:  return f == other.f;
-            case Type::Bool:   return b == other.b;
-            case Type::String: return s == other.s;
+            if (m_type != other.m_type) return false;
+            switch (m_type) {
+            case Type::Int:    return m_data.i == other.m_data.i;
+            case Type::Float:  return m_data.f == other.m_data.f;
+            case Type::Bool:   return m_data.b == other.m_data.b;
+            case Type::Double: return m_data.d == other.m_data.d;
+            case Type::Int64:  return m_data.l == other.m_data.l;
+            case Type::String:
+                if (m_size != shared_marker && other.m_size != shared_marker) {
+                    return m_size == other.m_size &&
+                        std::memcmp(m_data.small, other.m_data.small, m_size) == 0;
+                }
+                if (m_size == other.m_size && m_data.shared == other.m_data.shared) return true;
+                return as_string() == other.as_string();
             default:           return false;
             }
         }
+
+    private:
+        // Long strings are immutable and shared between copies, so copying a
+        // Value never allocates.
+        struct SharedString {
+            std::atomic<std::uint32_t> refs;
+            std::string str;
+        };
+
+        static constexpr std::uint8_t shared_marker = 0xFF;
+
+        bool is_shared() const { return m_type == Type::String && m_size == shared_marker; }
+
+        void release() noexcept {
+            if (!is_shared()) return;
+            SharedString* sh = m_data.shared;
+            if (sh->refs.load(std::memory_order_acquire) == 1 ||
+                sh->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete sh;
+            }
+        }
+
+        void copy_from(const Value& other) noexcept {
+            m_data = other.m_data;
+            m_size = other.m_size;
+            m_type = other.m_type;
+            if (other.is_shared()) m_data.shared->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void move_from(Value& other) noexcept {
+            m_data = other.m_data;
+            m_size = other.m_size;
+            m_type = other.m_type;
+            other.m_type = Type::Int;
+            other.m_size = 0;
+            other.m_data.l = 0;
+        }
+
+        union Payload {
+            std::int32_t i;
+            float f;
+            bool b;
+            double d;
+            std::int64_t l;
+            SharedString* shared;
+            char small[inline_capacity];
+        };
+
+        Payload m_data;
+        std::uint8_t m_size{ 0 };
+        Type m_type{ Type::Int };
     };
 
+    inline bool to_double(const Value& v, double& out) {
+        switch (v.type()) {
+        case Value::Type::Int:    out = v.as_int(); return true;
+        case Value::Type::Float:  out = v.as_float(); return true;
+        case Value::Type::Bool:   out = v.as_bool() ? 1.0 : 0.0; return true;
+        case Value::Type::Double: out = v.as_double(); return true;
+        case Value::Type::Int64:  out = static_cast<double>(v.as_int64()); return true;
+        default:                  return false;
+        }
+    }
+
+    // Where a value came from and whether it can be trusted. Drivers report
+    // CommFailure while the source is unreachable; the last value is kept.
+    enum class Quality : std::uint8_t { Good, Uncertain, Bad, CommFailure };
+
+    // Move-only callable for value notifications. Closures up to inline_size
+    // bytes (a this pointer plus a few ids) are stored in place, so a
+    // subscription does not allocate and a call is one indirect jump.
+    class ValueCallback final {
+    public:
+        static constexpr std::size_t inline_size = 4 * sizeof(void*);
+
+        ValueCallback() = default;
+        ValueCallback(std::nullptr_t) {}
+
+        template <typename F, typename = std::enable_if_t<
+            !std::is_same_v<std::decay_t<F>, ValueCallback> &&
+            std::is_invocable_v<std::decay_t<F>&, const Value&>>>
+        ValueCallback(F&& fn) { assign(std::forward<F>(fn)); }
+
+        ValueCallback(ValueCallback&& other) noexcept { move_from(other); }
+
+        ValueCallback& operator=(ValueCallback&& other) noexcept {
+            if (this != &other) {
+                reset();
+                move_from(other);
+            }
+            return *this;
+        }
+
+        ValueCallback(const ValueCallback&) = delete;
+        ValueCallback& operator=(const ValueCallback&) = delete;
+
+        ~ValueCallback() { reset(); }
+
+        explicit operator bool() const { return m_invoke != nullptr; }
+
+        void operator()(const Value& v) const { m_invoke(const_cast<unsigned char*>(m_buf), v); }
+
+        void reset() {
+            if (m_manage) m_manage(Op::Destroy, m_buf, nullptr);
+            m_invoke = nullptr;
+            m_manage = nullptr;
+        }
+
+    private:
+        enum class Op { Move, Destroy };
+
+        template <typename T> struct is_function_object : std::false_type {};
+        template <typename S> struct is_function_object<std::function<S>> : std::true_type {};
+
+        template <typename F>
+        void assign(F&& fn) {
+            using T = std::decay_t<F>;
+            if constexpr (std::is_pointer_v<T> || is_function_object<T>::value) {
+                if (!fn) return;
+            }
+
+            if constexpr (sizeof(T) <= inline_size && alignof(T) <= alignof(std::max_align_t) &&
+                std::is_nothrow_move_constructible_v<T>) {
+                new (m_buf) T(std::forward<F>(fn));
+                m_invoke = [](void* p, const Value& v) { (*static_cast<T*>(p))(v); };
+                // Trivial closures are moved with memcpy and need no cleanup.
+                if constexpr (!std::is_trivially_copyable_v<T>) {
+                    m_manage = [](Op op, void* self, void* other) {
+                        if (op == Op::Move) {
+                            new (self) T(std::move(*static_cast<T*>(other)));
+                        }
+                        static_cast<T*>(op == Op::Move ? other : self)->~T();
+                    };
+                }
+            }
+            else {
+                T* heap = new T(std::forward<F>(fn));
+                std::memcpy(m_buf, &heap, sizeof(heap));
+                m_invoke = [](void* p, const Value& v) { (**static_cast<T**>(p))(v); };
+                m_manage = [](Op op, void* self, void* other) {
+                    if (op == Op::Move) std::memcpy(self, other, sizeof(T*));
+                    else delete *static_cast<T**>(self);
+                };
+            }
+        }
+
+        void move_from(ValueCallback& other) noexcept {
+            if (other.m_manage) other.m_manage(Op::Move, m_buf, other.m_buf);
+            else if (other.m_invoke) std::memcpy(m_buf, other.m_buf, inline_size);
+            m_invoke = other.m_invoke;
+            m_manage = other.m_manage;
+            other.m_invoke = nullptr;
+            other.m_manage = nullptr;
+        }
+
+        alignas(std::max_align_t) unsigned char m_buf[inline_size];
+        void (*m_invoke)(void*, const Value&) { nullptr };
+        void (*m_manage)(Op, void*, void*) { nullptr };
+    };
+
+    // Subscribers live in a dense array that notify() walks front to back.
+    // Ids are stable handles into a slot table (slot + generation), so
+    // unsubscribe is O(1) and a stale id is ignored. Callbacks may set the
+    // variable, subscribe and unsubscribe; while a notification is running,
+    // removals only mark the entry and additions are parked, and both are
+    // applied when the outermost notification returns.
     class Variable final {
     public:
-        using Callback = std::function<void(const Value&)>;
+        using Callback = ValueCallback;
+
+        // Owns one subscription and drops it when destroyed or reassigned.
+        // The variable must outlive the token.
+        class Subscription final {
+        public:
+            Subscription() = default;
+            Subscription(Variable& var, std::size_t id) : m_var(&var), m_id(id) {}
+
+            Subscription(Subscription&& other) noexcept
+                : m_var(std::exchange(other.m_var, nullptr)), m_id(std::exchange(other.m_id, 0)) {}
+
+            Subscription& operator=(Subscription&& other) noexcept {
+                if (this != &other) {
+                    reset();
+                    m_var = std::exchange(other.m_var, nullptr);
+                    m_id = std::exchange(other.m_id, 0);
+                }
+                return *this;
+            }
+
+            Subscription(const Subscription&) = delete;
+            Subscription& operator=(const Subscription&) = delete;
+
+            ~Subscription() { reset(); }
+
+            void reset() {
+                if (m_var) m_var->unsubscribe(m_id);
+                m_var = nullptr;
+                m_id = 0;
+            }
+
+            std::size_t id() const { return m_id; }
+            explicit operator bool() const { return m_var != nullptr; }
+
+        private:
+            Variable* m_var{ nullptr };
+            std::size_t m_id{ 0 };
+        };
 
         Variable() : m_value(Value::make_int(0)) {}
         explicit Variable(const Value& v) : m_value(v) {}
+        explicit Variable(Value&& v) : m_value(std::move(v)) {}
+
+        Variable(Variable&&) = default;
+        Variable& operator=(Variable&&) = default;
+        Variable(const Variable&) = delete;
+        Variable& operator=(const Variable&) = delete;
 
         const Value& get() const { return m_value; }
 
@@ -57,86 +353,843 @@ namespace xs::core {
             notify();
         }
 
+        void set(Value&& v) {
+            if (m_value.equals(v)) return;
+            m_value = std::move(v);
+            notify();
+        }
+
+        // Calls cb with the current value right away. Returns a non-zero id.
         std::size_t subscribe(Callback cb) {
-            const std::size_t id = ++m_nextId;
-            m_subs.push_back(Subscriber{ id, cb });
-            if (cb) cb(m_value);
+            const std::uint32_t slot = acquire_slot();
+            const std::size_t id = make_id(slot, m_slots[slot].generation);
+            if (!cb) {
+                // Keeps the id valid without an entry to call.
+                m_slots[slot].index = empty_entry;
+                return id;
+            }
+
+            ++m_notifying;
+            if (m_notifying == 1) {
+                m_slots[slot].index = static_cast<std::uint32_t>(m_subs.size());
+                m_subs.push_back(Subscriber{ std::move(cb), slot, false });
+                const std::size_t k = m_subs.size() - 1;
+                m_subs[k].cb(m_value);
+            }
+            else {
+                // Inside a notification the list must not grow; the entry is
+                // parked and joins once the outermost notify() returns.
+                cb(m_value);
+                if (!m_added) m_added = std::make_unique<std::vector<Subscriber>>();
+                m_slots[slot].index = parked | static_cast<std::uint32_t>(m_added->size());
+                m_added->push_back(Subscriber{ std::move(cb), slot, false });
+                m_deferred = true;
+            }
+            end_notify();
             return id;
         }
 
+        [[nodiscard]] Subscription subscribe_scoped(Callback cb) {
+            return Subscription(*this, subscribe(std::move(cb)));
+        }
+
         void unsubscribe(std::size_t id) {
-            for (std::size_t k = 0; k < m_subs.size(); ++k) {
-                if (m_subs[k].id == id) {
-                    m_subs.erase(m_subs.begin() + static_cast<long>(k));
-                    return;
-                }
+            const std::size_t slot = (id & slot_mask) - 1;
+            if (slot >= m_slots.size() || m_slots[slot].generation != generation_of(id)) return;
+
+            const std::uint32_t index = m_slots[slot].index;
+            release_slot(static_cast<std::uint32_t>(slot));
+
+            if (index == empty_entry) return;
+            if (index & parked) {
+                (*m_added)[index & ~parked].dead = true;
+            }
+            else if (m_notifying > 0) {
+                m_subs[index].dead = true;
+                m_deferred = true;
+            }
+            else {
+                remove_at(index);
+            }
+        }
+
+        std::size_t subscriber_count() const {
+            std::size_t n = 0;
+            for (const auto& s : m_subs) n += s.dead ? 0 : 1;
+            if (m_added) {
+                for (const auto& s : *m_added) n += s.dead ? 0 : 1;
             }
+            return n;
         }
 
     private:
+        friend class VariableStore;
+
+        static constexpr unsigned slot_bits = sizeof(std::size_t) * 4;
+        static constexpr std::size_t slot_mask = (std::size_t{ 1 } << slot_bits) - 1;
+        static constexpr std::uint32_t parked = 0x80000000u;
+        static constexpr std::uint32_t empty_entry = 0xFFFFFFFFu;
+        static constexpr std::uint32_t no_slot = 0xFFFFFFFFu;
+
         struct Subscriber {
-            std::size_t id{};
-            Callback cb{};
+            Callback cb;
+            std::uint32_t slot{ 0 };
+            bool dead{ false };
         };
 
+        // index points into m_subs (or m_added when parked) while the slot is
+        // in use, and to the next free slot while it is not.
+        struct Slot {
+            std::uint32_t index{ 0 };
+            std::uint32_t generation{ 1 };
+        };
+
+        static std::size_t make_id(std::uint32_t slot, std::uint32_t generation) {
+            return (static_cast<std::size_t>(generation) << slot_bits) | (static_cast<std::size_t>(slot) + 1);
+        }
+
+        static std::uint32_t generation_of(std::size_t id) {
+            return static_cast<std::uint32_t>((id >> slot_bits) & slot_mask);
+        }
+
+        std::uint32_t acquire_slot() {
+            if (m_freeSlot != no_slot) {
+                const std::uint32_t slot = m_freeSlot;
+                m_freeSlot = m_slots[slot].index;
+                return slot;
+            }
+            m_slots.push_back(Slot{});
+            return static_cast<std::uint32_t>(m_slots.size() - 1);
+        }
+
+        void release_slot(std::uint32_t slot) {
+            Slot& s = m_slots[slot];
+            s.generation = static_cast<std::uint32_t>((s.generation + 1) & slot_mask);
+            if (s.generation == 0) s.generation = 1;
+            s.index = m_freeSlot;
+            m_freeSlot = slot;
+        }
+
+        // Swap-remove; only called while no notification is running.
+        void remove_at(std::size_t k) {
+            const std::size_t last = m_subs.size() - 1;
+            if (k != last) {
+                m_subs[k] = std::move(m_subs[last]);
+                if (!m_subs[k].dead) m_slots[m_subs[k].slot].index = static_cast<std::uint32_t>(k);
+            }
+            m_subs.pop_back();
+        }
+
+        void apply_deferred() {
+            m_deferred = false;
+            for (std::size_t k = 0; k < m_subs.size();) {
+                if (m_subs[k].dead) remove_at(k);
+                else ++k;
+            }
+            if (!m_added) return;
+            for (auto& s : *m_added) {
+                if (s.dead) continue;
+                m_slots[s.slot].index = static_cast<std::uint32_t>(m_subs.size());
+                m_subs.push_back(std::move(s));
+            }
+            m_added->clear();
+        }
+
+        void end_notify() {
+            if (--m_notifying == 0 && m_deferred) apply_deferred();
+        }
+
+        bool assign(Value&& v) {
+            if (m_value.equals(v)) return false;
+            m_value = std::move(v);
+            return true;
+        }
+
         void notify() {
-            for (auto& s : m_subs) {
-                if (s.cb) s.cb(m_value);
+            Metrics* stats = nullptr;
+            if constexpr (metrics_compiled) {
+                if (metrics().enabled) {
+                    stats = &metrics();
+                    ++stats->notifies;
+                    stats->callbacks += m_subs.size();
+                    stats->maxDepth = std::max(stats->maxDepth, ++stats->depth);
+                }
+            }
+
+            ++m_notifying;
+            const std::size_t n = m_subs.size();
+            for (std::size_t k = 0; k < n; ++k) {
+                const Subscriber& s = m_subs[k];
+                if (!s.dead) s.cb(m_value);
             }
+            if (stats) --stats->depth;
+            end_notify();
         }
 
         Value m_value;
         std::vector<Subscriber> m_subs;
-        std::size_t m_nextId{ 0 };
+        std::vector<Slot> m_slots;
+        std::unique_ptr<std::vector<Subscriber>> m_added;
+        std::uint32_t m_freeSlot{ no_slot };
+        std::uint16_t m_notifying{ 0 };
+        bool m_deferred{ false };
+    };
+
+    using Subscription = Variable::Subscription;
+
+    using TagId = std::uint32_t;
+    inline constexpr TagId invalid_tag = std::numeric_limits<TagId>::max();
+
+    // Open-addressing map from tag name to TagId. A slot holds the id and 32
+    // bits of the hash; the names stay with the caller. Tags are never
+    // removed, so probing needs no tombstones and growing needs no rehashing
+    // of names.
+    class TagIndex final {
+    public:
+        template <typename Names>
+        TagId find(std::string_view name, const Names& names) const {
+            if (m_slots.empty()) return invalid_tag;
+            const std::uint32_t h = hash(name);
+            for (std::size_t i = h & m_mask;; i = (i + 1) & m_mask) {
+                const Slot& s = m_slots[i];
+                if (s.id == invalid_tag) return invalid_tag;
+                if (s.hash == h && names[s.id] == name) return s.id;
+            }
+        }
+
+        // The name must not be present yet.
+        void insert(std::string_view name, TagId id) {
+            if ((m_size + 1) * 2 > m_slots.size()) grow(m_size + 1);
+            place(Slot{ hash(name), id });
+            ++m_size;
+        }
+
+        void reserve(std::size_t names) {
+            if (names * 2 > m_slots.size()) grow(names);
+        }
+
+        std::size_t size() const { return m_size; }
+
+    private:
+        struct Slot {
+            std::uint32_t hash;
+            TagId id;
+        };
+
+        static std::uint32_t hash(std::string_view name) {
+            // Widened first: shifting a 32-bit size_t by 32 is undefined.
+            const std::uint64_t h = std::hash<std::string_view>{}(name);
+            return static_cast<std::uint32_t>(h ^ (h >> 32));
+        }
+
+        void place(Slot slot) {
+            std::size_t i = slot.hash & m_mask;
+            while (m_slots[i].id != invalid_tag) i = (i + 1) & m_mask;
+            m_slots[i] = slot;
+        }
+
+        // Keeps the load factor at or below one half.
+        void grow(std::size_t names) {
+            std::size_t capacity = 16;
+            while (capacity < names * 2) capacity *= 2;
+            std::vector<Slot> old(capacity, Slot{ 0, invalid_tag });
+            old.swap(m_slots);
+            m_mask = capacity - 1;
+            for (const Slot& s : old) {
+                if (s.id != invalid_tag) place(s);
+            }
+        }
+
+        std::vector<Slot> m_slots;
+        std::size_t m_mask{ 0 };
+        std::size_t m_size{ 0 };
     };
 
+
+    // Radix tree over tag names for prefix queries. Edge labels are slices of
+    // one append-only character arena; splitting an edge only splits its
+    // slice, so shared prefixes are stored once and inserts copy nothing but
+    // the new suffix. Children are kept sorted, so walks visit names in
+    // lexicographic order.
+    class TagTree final {
+    public:
+        TagTree() { m_nodes.push_back(Node{}); }
+
+        void insert(std::string_view name, TagId id) {
+            std::uint32_t node = 0;
+            std::size_t pos = 0;
+            while (pos < name.size()) {
+                std::uint32_t prev = none;
+                std::uint32_t child = m_nodes[node].child;
+                while (child != none && first_char(child) < name[pos]) {
+                    prev = child;
+                    child = m_nodes[child].sibling;
+                }
+                if (child == none || first_char(child) != name[pos]) {
+                    link(node, prev, add_node(name.substr(pos), id, child));
+                    ++m_size;
+                    return;
+                }
+
+                const std::string_view label = label_of(child);
+                std::size_t common = 1;
+                while (common < label.size() && pos + common < name.size() && label[common] == name[pos + common]) ++common;
+                if (common < label.size()) {
+                    // Split the edge: a node for the shared part takes the
+                    // child's place and the child keeps the rest.
+                    Node mid;
+                    mid.labelAt = m_nodes[child].labelAt;
+                    mid.labelLength = static_cast<std::uint32_t>(common);
+                    mid.child = child;
+                    mid.sibling = m_nodes[child].sibling;
+                    const auto at = static_cast<std::uint32_t>(m_nodes.size());
+                    m_nodes.push_back(mid);
+                    m_nodes[child].labelAt += static_cast<std::uint32_t>(common);
+                    m_nodes[child].labelLength -= static_cast<std::uint32_t>(common);
+                    m_nodes[child].sibling = none;
+                    link(node, prev, at);
+                    child = at;
+                }
+                node = child;
+                pos += common;
+            }
+            if (m_nodes[node].tag == invalid_tag) ++m_size;
+            m_nodes[node].tag = id;
+        }
+
+        TagId find(std::string_view name) const {
+            bool exact = false;
+            const std::uint32_t node = descend(name, exact);
+            return node != none && exact ? m_nodes[node].tag : invalid_tag;
+        }
+
+        // Calls fn(id) for every name that starts with prefix.
+        template <typename Fn>
+        void for_each_prefix(std::string_view prefix, Fn&& fn) const {
+            bool exact = false;
+            const std::uint32_t top = descend(prefix, exact);
+            if (top == none) return;
+
+            if (m_nodes[top].tag != invalid_tag) fn(m_nodes[top].tag);
+            std::vector<std::uint32_t> stack;
+            if (m_nodes[top].child != none) stack.push_back(m_nodes[top].child);
+            while (!stack.empty()) {
+                const Node& n = m_nodes[stack.back()];
+                stack.pop_back();
+                if (n.sibling != none) stack.push_back(n.sibling);
+                if (n.child != none) stack.push_back(n.child);
+                if (n.tag != invalid_tag) fn(n.tag);
+            }
+        }
+
+        std::size_t size() const { return m_size; }
+        std::size_t memory_bytes() const { return m_nodes.capacity() * sizeof(Node) + m_chars.capacity(); }
+
+    private:
+        static constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+        struct Node {
+            std::uint32_t labelAt{ 0 };
+            std::uint32_t labelLength{ 0 };
+            std::uint32_t child{ none };
+            std::uint32_t sibling{ none };
+            TagId tag{ invalid_tag };
+        };
+
+        std::string_view label_of(std::uint32_t n) const {
+            return std::string_view(m_chars.data() + m_nodes[n].labelAt, m_nodes[n].labelLength);
+        }
+
+        char first_char(std::uint32_t n) const { return m_chars[m_nodes[n].labelAt]; }
+
+        std::uint32_t add_node(std::string_view label, TagId id, std::uint32_t sibling) {
+            Node n;
+            n.labelAt = static_cast<std::uint32_t>(m_chars.size());
+            n.labelLength = static_cast<std::uint32_t>(label.size());
+            n.sibling = sibling;
+            n.tag = id;
+            m_chars.append(label);
+            m_nodes.push_back(n);
+            return static_cast<std::uint32_t>(m_nodes.size() - 1);
+        }
+
+        void link(std::uint32_t parent, std::uint32_t prev, std::uint32_t n) {
+            if (prev == none) m_nodes[parent].child = n;
+            else m_nodes[prev].sibling = n;
+        }
+
+        // Follows key from the root to the first node whose path covers all
+        // of it, or none. exact is false if the key ends inside that node's
+        // edge label, i.e. it is only a prefix of the node's names.
+        std::uint32_t descend(std::string_view key, bool& exact) const {
+            std::uint32_t node = 0;
+            std::size_t pos = 0;
+            exact = true;
+            while (pos < key.size()) {
+                std::uint32_t child = m_nodes[node].child;
+                while (child != none && first_char(child) < key[pos]) child = m_nodes[child].sibling;
+                if (child == none || first_char(child) != key[pos]) return none;
+
+                const std::string_view label = label_of(child);
+                const std::string_view rest = key.substr(pos);
+                if (rest.size() < label.size()) {
+                    if (label.substr(0, rest.size()) != rest) return none;
+                    exact = false;
+                    return child;
+                }
+                if (rest.substr(0, label.size()) != label) return none;
+                pos += label.size();
+                node = child;
+            }
+            return node;
+        }
+
+        std::vector<Node> m_nodes;
+        std::string m_chars;
+        std::size_t m_size{ 0 };
+    };
+
+    // Glob over tag names: '*' matches any run of characters, dots included,
+    // and '?' any single character.
+    inline bool match_pattern(std::string_view pattern, std::string_view name) {
+        std::size_t p = 0;
+        std::size_t n = 0;
+        std::size_t star = std::string_view::npos;
+        std::size_t resume = 0;
+        while (n < name.size()) {
+            if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+                ++p;
+                ++n;
+            }
+            else if (p < pattern.size() && pattern[p] == '*') {
+                star = p++;
+                resume = n;
+            }
+            else if (star != std::string_view::npos) {
+                p = star + 1;
+                n = ++resume;
+            }
+            else {
+                return false;
+            }
+        }
+        while (p < pattern.size() && pattern[p] == '*') ++p;
+        return p == pattern.size();
+    }
+
     class VariableStore final {
     public:
+        using TagCallback = std::function<void(TagId, const Value&)>;
+
+        TagId resolve(const std::string& name) const {
+            return m_index.find(name, m_names);
+        }
+
+        TagId ensure_tag(const std::string& name, const Value& initial) {
+            const TagId found = m_index.find(name, m_names);
+            if (found != invalid_tag) return found;
+
+            const TagId id = static_cast<TagId>(m_vars.size());
+            m_vars.emplace_back(initial);
+            m_quality.push_back(Quality::Good);
+            m_stamps.push_back(0);
+            m_names.push_back(name);
+            m_index.insert(name, id);
+            if (m_treeBuilt) m_tree.insert(name, id);
+            for (std::size_t k = 0; k < m_patterns.size(); ++k) {
+                if (match_pattern(m_patterns[k]->pattern, name)) attach(*m_patterns[k], id);
+            }
+            return id;
+        }
+
+        // Avoids rehashing the name index while many tags are created at once.
+        void reserve(std::size_t tags) {
+            m_names.reserve(tags);
+            m_quality.reserve(tags);
+            m_stamps.reserve(tags);
+            m_index.reserve(tags);
+        }
+
+        bool valid(TagId id) const { return id < m_vars.size(); }
+        std::size_t size() const { return m_vars.size(); }
+        const std::string& name(TagId id) const { return m_names[id]; }
+
+        Variable& at(TagId id) { return m_vars[id]; }
+        const Variable& at(TagId id) const { return m_vars[id]; }
+
+        // Keeps the tag's quality and timestamp.
+        void set(TagId id, const Value& value) {
+            if constexpr (metrics_compiled) {
+                if (metrics().enabled) ++metrics().sets;
+            }
+            if (m_batchDepth > 0) {
+                stage(id, value);
+            }
+            else if (!m_hooks.empty()) {
+                begin_batch();
+                stage(id, value);
+                commit();
+            }
+            else {
+                m_vars[id].set(value);
+            }
+        }
+
+        // A write from a data source. The timestamp is recorded even when
+        // nothing changed, so stale_tags() sees that the source is alive;
+        // subscribers are notified if the value or the quality changed.
+        void set(TagId id, const Value& value, Quality quality, std::int64_t timestamp) {
+            if constexpr (metrics_compiled) {
+                if (metrics().enabled) ++metrics().sets;
+            }
+            if (m_batchDepth > 0) {
+                stage(id, value, quality, timestamp);
+            }
+            else if (!m_hooks.empty()) {
+                begin_batch();
+                stage(id, value, quality, timestamp);
+                commit();
+            }
+            else {
+                const bool requalified = m_quality[id] != quality;
+                m_quality[id] = quality;
+                m_stamps[id] = timestamp;
+                if (m_vars[id].assign(Value(value)) || requalified) m_vars[id].notify();
+            }
+        }
+
+        // Keeps the value, including one staged in the open batch.
+        void set_quality(TagId id, Quality quality) {
+            if (m_batchDepth > 0 && id < m_pendingSlot.size() && m_pendingSlot[id] != no_slot) {
+                m_pending[m_pendingSlot[id]].quality = quality;
+                return;
+            }
+            set(id, m_vars[id].get(), quality, m_stamps[id]);
+        }
+
+        // Quality lives only here; Variable holds just the value.
+        Quality quality(TagId id) const { return m_quality[id]; }
+
+        // Milliseconds since the Unix epoch, as now_ms(); 0 until a source
+        // writes the tag.
+        std::int64_t timestamp(TagId id) const { return m_stamps[id]; }
+
+        // Dense per-tag arrays indexed by TagId, for scans that should not
+        // touch the values.
+        const std::vector<Quality>& qualities() const { return m_quality; }
+        const std::vector<std::int64_t>& timestamps() const { return m_stamps; }
+
+        std::size_t count_quality(Quality q) const {
+            std::size_t n = 0;
+            for (Quality x : m_quality) n += x == q;
+            return n;
+        }
+
+        // Appends every tag whose quality is not Good.
+        void tags_not_good(std::vector<TagId>& out) const {
+            const std::size_t n = m_quality.size();
+            for (std::size_t k = 0; k < n; ++k) {
+                if (m_quality[k] != Quality::Good) out.push_back(static_cast<TagId>(k));
+            }
+        }
+
+        // Appends every tag last written by a source before the given time.
+        void stale_tags(std::int64_t before, std::vector<TagId>& out) const {
+            const std::size_t n = m_stamps.size();
+            for (std::size_t k = 0; k < n; ++k) {
+                if (m_stamps[k] < before) out.push_back(static_cast<TagId>(k));
+            }
+        }
+        const Value& get(TagId id) const {
+            count_get();
+            return m_vars[id].get();
+        }
+
+        bool get_bool(TagId id, bool fallback) const {
+            if (!valid(id)) return fallback;
+            const Value& v = get(id);
+            return (v.type() == Value::Type::Bool) ? v.as_bool() : fallback;
+        }
+
+        float get_float(TagId id, float fallback) const {
+            if (!valid(id)) return fallback;
+            const Value& v = get(id);
+            switch (v.type()) {
+            case Value::Type::Float:  return v.as_float();
+            case Value::Type::Int:    return static_cast<float>(v.as_int());
+            case Value::Type::Double: return static_cast<float>(v.as_double());
+            case Value::Type::Int64:  return static_cast<float>(v.as_int64());
+            default:                  return fallback;
+            }
+        }
+
+        std::string get_string(TagId id, const std::string& fallback) const {
+            if (!valid(id)) return fallback;
+            const Value& v = get(id);
+            return (v.type() == Value::Type::String) ? std::string(v.as_string()) : fallback;
+        }
+
         bool has(const std::string& name) const {
-            return m_vars.find(name) != m_vars.end();
+            return resolve(name) != invalid_tag;
         }
 
         Variable& ensure(const std::string& name, const Value& initial) {
-            auto it = m_vars.find(name);
-            if (it == m_vars.end()) {
-                it = m_vars.insert(std::make_pair(name, Variable(initial))).first;
-            }
-            return it->second;
+            return m_vars[ensure_tag(name, initial)];
         }
 
-        Variable& at(const std::string& name) { return m_vars.at(name); }
-        const Variable& at(const std::string& name) const { return m_vars.at(name); }
+        Variable& at(const std::string& name) { return m_vars.at(resolve(name)); }
+        const Variable& at(const std::string& name) const { return m_vars.at(resolve(name)); }
 
         void set(const std::string& name, const Value& value) {
-            ensure(name, value).set(value);
+            set(ensure_tag(name, value), value);
         }
 
-        Value get(const std::string& name) const {
-            return m_vars.at(name).get();
+        const Value& get(const std::string& name) const {
+            count_get();
+            return at(name).get();
         }
 
         bool get_bool(const std::string& name, bool fallback) const {
-            if (!has(name)) return fallback;
-            Value v = get(name);
-            return (v.type == Value::Type::Bool) ? v.b : fallback;
+            return get_bool(resolve(name), fallback);
         }
 
         float get_float(const std::string& name, float fallback) const {
-            if (!has(name)) return fallback;
-            Value v = get(name);
-            if (v.type == Value::Type::Float) return v.f;
-            if (v.type == Value::Type::Int) return static_cast<float>(v.i);
-            return fallback;
+            return get_float(resolve(name), fallback);
         }
 
         std::string get_string(const std::string& name, const std::string& fallback) const {
-            if (!has(name)) return fallback;
-            Value v = get(name);
-            return (v.type == Value::Type::String) ? v.s : fallback;
+            return get_string(resolve(name), fallback);
+        }
+
+        // Calls fn(id) for every tag matching a glob (see match_pattern), in
+        // name order. The text before the first wildcard is looked up in a
+        // radix tree of the names, built on first use and kept up to date by
+        // ensure_tag() from then on.
+        template <typename Fn>
+        void for_each_match(std::string_view pattern, Fn&& fn) const {
+            const std::size_t wild = pattern.find_first_of("*?");
+            if (wild == std::string_view::npos) {
+                const TagId id = m_index.find(pattern, m_names);
+                if (id != invalid_tag) fn(id);
+                return;
+            }
+            // "a.b*" needs no further check.
+            const bool prefixOnly = wild + 1 == pattern.size() && pattern[wild] == '*';
+            name_tree().for_each_prefix(pattern.substr(0, wild), [&](TagId id) {
+                if (prefixOnly || match_pattern(pattern, m_names[id])) fn(id);
+            });
+        }
+
+        std::vector<TagId> match(std::string_view pattern) const {
+            std::vector<TagId> out;
+            for_each_match(pattern, [&](TagId id) { out.push_back(id); });
+            return out;
+        }
+
+        // cb(id, value) runs for the current value of every matching tag and
+        // then on each change, including tags created later by ensure_tag().
+        std::size_t subscribe_pattern(std::string pattern, TagCallback cb) {
+            free_retired_patterns();
+            auto watch = std::make_unique<PatternWatch>();
+            watch->id = ++m_nextPatternId;
+            watch->pattern = std::move(pattern);
+            watch->cb = std::move(cb);
+            PatternWatch& w = *watch;
+            m_patterns.push_back(std::move(watch));
+            for (TagId id : match(w.pattern)) attach(w, id);
+            return w.id;
+        }
+
+        // Safe from inside the pattern's own callback, even followed by a
+        // new subscribe_pattern(): the record is only freed once none of its
+        // callbacks is running.
+        void unsubscribe_pattern(std::size_t id) {
+            for (std::size_t k = 0; k < m_patterns.size(); ++k) {
+                if (m_patterns[k]->id != id) continue;
+                m_patterns[k]->subs.clear();
+                m_retiredPatterns.push_back(std::move(m_patterns[k]));
+                m_patterns.erase(m_patterns.begin() + static_cast<long>(k));
+                break;
+            }
+            free_retired_patterns();
+        }
+
+        // While a batch is open, set() only records the last written value per
+        // tag. commit() of the outermost batch applies them and notifies each
+        // changed tag once; writes made by subscribers are applied in further
+        // rounds of the same commit.
+        void begin_batch() { ++m_batchDepth; }
+
+        void commit() {
+            if (m_batchDepth == 0) return;
+            if (--m_batchDepth == 0) flush();
+        }
+
+        bool in_batch() const { return m_batchDepth > 0; }
+        std::size_t pending() const { return m_pending.size(); }
+
+        // Commit hooks run once a change set has been applied and notified.
+        // Writes they make are applied as part of the same commit; hooks run
+        // again until no writes are left.
+        std::size_t add_commit_hook(std::function<void()> fn) {
+            const std::size_t id = ++m_nextHookId;
+            m_hooks.push_back(CommitHook{ id, std::move(fn) });
+            return id;
+        }
+
+        void remove_commit_hook(std::size_t id) {
+            for (std::size_t k = 0; k < m_hooks.size(); ++k) {
+                if (m_hooks[k].id == id) {
+                    m_hooks.erase(m_hooks.begin() + static_cast<long>(k));
+                    return;
+                }
+            }
+        }
+
+    private:
+        static void count_get() {
+            if constexpr (metrics_compiled) {
+                if (metrics().enabled) ++metrics().gets;
+            }
         }
 
+        struct PendingWrite {
+            TagId id{};
+            Quality quality{ Quality::Good };
+            std::int64_t timestamp{ 0 };
+            Value value;
+        };
+
+        struct CommitHook {
+            std::size_t id{};
+            std::function<void()> fn;
+        };
+
+        struct PatternWatch {
+            std::size_t id{};
+            std::string pattern;
+            TagCallback cb;
+            std::vector<Subscription> subs;
+            std::uint32_t running{ 0 };  // callbacks on the stack
+        };
+
+        void attach(PatternWatch& w, TagId id) {
+            PatternWatch* target = &w;
+            w.subs.push_back(m_vars[id].subscribe_scoped([target, id](const Value& v) {
+                ++target->running;
+                target->cb(id, v);
+                --target->running;
+            }));
+        }
+
+        void free_retired_patterns() {
+            auto& r = m_retiredPatterns;
+            r.erase(std::remove_if(r.begin(), r.end(), [](const auto& w) { return w->running == 0; }), r.end());
+        }
+
+        const TagTree& name_tree() const {
+            if (!m_treeBuilt) {
+                for (std::size_t id = 0; id < m_names.size(); ++id) m_tree.insert(m_names[id], static_cast<TagId>(id));
+                m_treeBuilt = true;
+            }
+            return m_tree;
+        }
+
+        static constexpr std::uint32_t no_slot = std::numeric_limits<std::uint32_t>::max();
+
+        std::uint32_t& pending_slot(TagId id) {
+            if (m_pendingSlot.size() <= id) m_pendingSlot.resize(m_vars.size(), no_slot);
+            return m_pendingSlot[id];
+        }
+
+        // A plain write keeps whatever quality and timestamp are staged or
+        // current for the tag.
+        void stage(TagId id, const Value& value) {
+            std::uint32_t& slot = pending_slot(id);
+            if (slot != no_slot) {
+                m_pending[slot].value = value;
+                return;
+            }
+            slot = static_cast<std::uint32_t>(m_pending.size());
+            m_pending.push_back(PendingWrite{ id, m_quality[id], m_stamps[id], value });
+        }
+
+        void stage(TagId id, const Value& value, Quality quality, std::int64_t timestamp) {
+            std::uint32_t& slot = pending_slot(id);
+            if (slot != no_slot) {
+                m_pending[slot].value = value;
+                m_pending[slot].quality = quality;
+                m_pending[slot].timestamp = timestamp;
+                return;
+            }
+            slot = static_cast<std::uint32_t>(m_pending.size());
+            m_pending.push_back(PendingWrite{ id, quality, timestamp, value });
+        }
+
+        // Never re-entered: commits inside callbacks only close a nested batch.
+        void flush() {
+            std::vector<PendingWrite>& writes = m_flushWrites;
+            std::vector<TagId>& changed = m_flushChanged;
+
+            ++m_batchDepth;
+            for (;;) {
+                while (!m_pending.empty()) {
+                    writes.swap(m_pending);
+                    m_pending.clear();
+                    changed.clear();
+
+                    for (auto& w : writes) {
+                        m_pendingSlot[w.id] = no_slot;
+                        const bool requalified = m_quality[w.id] != w.quality;
+                        m_quality[w.id] = w.quality;
+                        m_stamps[w.id] = w.timestamp;
+                        if (m_vars[w.id].assign(std::move(w.value)) || requalified) changed.push_back(w.id);
+                    }
+                    for (TagId id : changed) m_vars[id].notify();
+                }
+                for (std::size_t k = 0; k < m_hooks.size(); ++k) m_hooks[k].fn();
+                if (m_pending.empty()) break;
+            }
+            // The next batch stages into the bigger buffer.
+            writes.clear();
+            if (writes.capacity() > m_pending.capacity()) writes.swap(m_pending);
+            --m_batchDepth;
+        }
+
+        std::deque<Variable> m_vars;
+        std::vector<Quality> m_quality;
+        std::vector<std::int64_t> m_stamps;
+        std::vector<std::string> m_names;
+        TagIndex m_index;
+
+        std::size_t m_batchDepth{ 0 };
+        std::vector<PendingWrite> m_pending;
+        std::vector<std::uint32_t> m_pendingSlot;
+        // flush() swaps rounds between these and m_pending; they keep their
+        // capacity, so a steady stream of commits does not allocate.
+        std::vector<PendingWrite> m_flushWrites;
+        std::vector<TagId> m_flushChanged;
+
+        std::vector<CommitHook> m_hooks;
+        std::size_t m_nextHookId{ 0 };
+
+        mutable TagTree m_tree;
+        mutable bool m_treeBuilt{ false };
+        std::vector<std::unique_ptr<PatternWatch>> m_patterns;
+        std::vector<std::unique_ptr<PatternWatch>> m_retiredPatterns;
+        std::size_t m_nextPatternId{ 0 };
+    };
+
+    class UpdateBatch final {
+    public:
+        explicit UpdateBatch(VariableStore& store) : m_store(store) { m_store.begin_batch(); }
+        ~UpdateBatch() { m_store.commit(); }
+
+        UpdateBatch(const UpdateBatch&) = delete;
+        UpdateBatch& operator=(const UpdateBatch&) = delete;
+
     private:
-        std::unordered_map<std::string, Variable> m_vars;
+        VariableStore& m_store;
     };
 
 }
\ No newline at end of file
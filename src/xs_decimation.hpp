@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace xs::core {
+
+    // Reduces a time series to one min/max envelope per pixel column over a
+    // sliding window. Samples are folded into their column as they arrive, so
+    // adding a sample is O(1) and reading the envelope is O(columns),
+    // independent of how many samples were plotted.
+    class MinMaxDecimator final {
+    public:
+        struct Column {
+            double min{ std::numeric_limits<double>::infinity() };
+            double max{ -std::numeric_limits<double>::infinity() };
+
+            bool empty() const { return min > max; }
+        };
+
+        MinMaxDecimator(std::size_t columns = 1, std::int64_t span = 1) { reset(columns, span); }
+
+        void reset(std::size_t columns, std::int64_t span) {
+            columns = std::max<std::size_t>(columns, 1);
+            m_cols.assign(columns, Column{});
+            const auto n = static_cast<std::int64_t>(columns);
+            m_width = std::max<std::int64_t>(1, (span + n - 1) / n);
+            m_started = false;
+            m_head = 0;
+            ++m_version;
+        }
+
+        std::size_t columns() const { return m_cols.size(); }
+        std::int64_t column_width() const { return m_width; }
+        std::uint64_t version() const { return m_version; }
+
+        // End of the window (exclusive); column k covers
+        // [window_end() - (columns() - k) * column_width(), ...).
+        std::int64_t window_end() const { return (m_head + 1) * m_width; }
+
+        void add(std::int64_t t, double v) { add_range(t, v, v); }
+
+        void add_range(std::int64_t t, double mn, double mx) {
+            const std::int64_t idx = floor_div(t, m_width);
+            if (!m_started) {
+                m_head = idx;
+                m_started = true;
+            }
+            else if (idx > m_head) {
+                advance_index(idx);
+            }
+            else if (idx <= m_head - static_cast<std::int64_t>(m_cols.size())) {
+                return;
+            }
+
+            Column& c = m_cols[slot(idx)];
+            c.min = std::min(c.min, mn);
+            c.max = std::max(c.max, mx);
+            ++m_version;
+        }
+
+        void add_block(const std::int64_t* t, const double* v, std::size_t n) {
+            for (std::size_t k = 0; k < n; ++k) add(t[k], v[k]);
+        }
+
+        // Scrolls the window so that it ends at t, dropping columns that fall
+        // off its start.
+        void advance_to(std::int64_t t) {
+            const std::int64_t idx = floor_div(t, m_width);
+            if (!m_started) {
+                m_head = idx;
+                m_started = true;
+                ++m_version;
+            }
+            else if (idx > m_head) {
+                advance_index(idx);
+            }
+        }
+
+        // k = 0 is the oldest column of the window.
+        const Column& column(std::size_t k) const {
+            return m_cols[slot(m_head - static_cast<std::int64_t>(m_cols.size()) + 1 + static_cast<std::int64_t>(k))];
+        }
+
+    private:
+        static std::int64_t floor_div(std::int64_t a, std::int64_t b) {
+            const std::int64_t q = a / b;
+            return (a % b != 0 && a < 0) ? q - 1 : q;
+        }
+
+        std::size_t slot(std::int64_t idx) const {
+            const auto n = static_cast<std::int64_t>(m_cols.size());
+            return static_cast<std::size_t>(((idx % n) + n) % n);
+        }
+
+        void advance_index(std::int64_t idx) {
+            const std::int64_t steps = idx - m_head;
+            if (steps >= static_cast<std::int64_t>(m_cols.size())) {
+                std::fill(m_cols.begin(), m_cols.end(), Column{});
+            }
+            else {
+                for (std::int64_t k = 1; k <= steps; ++k) m_cols[slot(m_head + k)] = Column{};
+            }
+            m_head = idx;
+            ++m_version;
+        }
+
+        std::vector<Column> m_cols;
+        std::int64_t m_width{ 1 };
+        std::int64_t m_head{ 0 };
+        bool m_started{ false };
+        std::uint64_t m_version{ 0 };
+    };
+
+}
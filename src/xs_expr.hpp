@@ -0,0 +1,728 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <initializer_list>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "xs_core.hpp"
+
+namespace xs::core {
+
+    // Expressions for derived tags, e.g.
+    //   temperature * 1.8 + 32
+    //   pump.enabled ? "ON" : "OFF"
+    //   max(abs(flow.a - flow.b), 0.5) > limit && !maintenance
+    // compiled once to stack bytecode over Value. Tag names are resolved to
+    // TagIds at compile time; integer operands stay integral except for '/'.
+    class Expression final {
+    public:
+        enum class Op : std::uint8_t {
+            Const, Load,
+            Neg, Not, Abs,
+            Add, Sub, Mul, Div, Mod, Min, Max,
+            Eq, Ne, Lt, Le, Gt, Ge, And, Or,
+            Jump, JumpIfFalse
+        };
+
+        struct Instr {
+            Op op;
+            std::uint32_t arg;
+        };
+
+        bool compile(std::string_view source, VariableStore& store, std::string& error) {
+            m_code.clear();
+            m_consts.clear();
+            m_deps.clear();
+            m_maxStack = 0;
+            Parser p(source, store, *this);
+            return p.parse(error);
+        }
+
+        const std::vector<Instr>& code() const { return m_code; }
+        const std::vector<Value>& constants() const { return m_consts; }
+        const std::vector<TagId>& dependencies() const { return m_deps; }
+        std::size_t max_stack() const { return m_maxStack; }
+
+        bool evaluate(const VariableStore& store, Value& out) const {
+            std::vector<Value> stack;
+            return run([&store](TagId id) -> const Value& { return store.get(id); }, stack, out);
+        }
+
+        // load(TagId) returns the current value of a tag; stack is scratch
+        // space that callers reuse between evaluations.
+        template <typename Load>
+        bool run(Load&& load, std::vector<Value>& stack, Value& out) const {
+            if (stack.size() < m_maxStack) stack.resize(m_maxStack);
+            return execute(m_code.data(), m_code.size(), m_consts.data(), load, stack.data(), out);
+        }
+
+        // Runs code that was copied elsewhere, e.g. into a shared pool; the
+        // stack must hold at least max_stack() values.
+        template <typename Load>
+        static bool execute(const Instr* code, std::size_t n, const Value* consts, Load&& load, Value* stack, Value& out) {
+            Value* sp = stack;
+
+            for (std::size_t pc = 0; pc < n; ++pc) {
+                const Instr in = code[pc];
+                switch (in.op) {
+                case Op::Const: *sp++ = consts[in.arg]; break;
+                case Op::Load:  *sp++ = load(static_cast<TagId>(in.arg)); break;
+                case Op::Neg: {
+                    Value& a = sp[-1];
+                    double d = 0.0;
+                    if (a.type() == Value::Type::Int) a = integral(-static_cast<std::int64_t>(a.as_int()), false);
+                    else if (a.type() == Value::Type::Int64) a = Value::make_int64(negate(a.as_int64()));
+                    else if (to_double(a, d)) a = Value::make_double(-d);
+                    else return false;
+                    break;
+                }
+                case Op::Not: sp[-1] = Value::make_bool(!truthy(sp[-1])); break;
+                case Op::Abs: {
+                    Value& a = sp[-1];
+                    double d = 0.0;
+                    if (a.type() == Value::Type::Int) a = integral(std::llabs(a.as_int()), false);
+                    else if (a.type() == Value::Type::Int64) a = Value::make_int64(a.as_int64() < 0 ? negate(a.as_int64()) : a.as_int64());
+                    else if (to_double(a, d)) a = Value::make_double(std::fabs(d));
+                    else return false;
+                    break;
+                }
+                case Op::Add: case Op::Sub: case Op::Mul: case Op::Div:
+                case Op::Mod: case Op::Min: case Op::Max: {
+                    const Value& b = operand(in, consts, sp);
+                    if (!arith(in.op, sp[-1], b, sp[-1])) return false;
+                    break;
+                }
+                case Op::Eq: case Op::Ne: case Op::Lt: case Op::Le: case Op::Gt: case Op::Ge: {
+                    const Value& b = operand(in, consts, sp);
+                    if (!compare(in.op, sp[-1], b, sp[-1])) return false;
+                    break;
+                }
+                case Op::And:
+                    --sp;
+                    sp[-1] = Value::make_bool(truthy(sp[-1]) && truthy(sp[0]));
+                    break;
+                case Op::Or:
+                    --sp;
+                    sp[-1] = Value::make_bool(truthy(sp[-1]) || truthy(sp[0]));
+                    break;
+                case Op::Jump:
+                    pc = in.arg - 1;
+                    break;
+                case Op::JumpIfFalse:
+                    if (!truthy(*--sp)) pc = in.arg - 1;
+                    break;
+                }
+            }
+            out = std::move(stack[0]);
+            return true;
+        }
+
+    private:
+        // Right operand of a binary op: a constant when arg != 0 (const
+        // index + 1), otherwise popped from the stack.
+        static const Value& operand(const Instr& in, const Value* consts, Value*& sp) {
+            if (in.arg != 0) return consts[in.arg - 1];
+            return *--sp;
+        }
+
+        static bool truthy(const Value& v) {
+            switch (v.type()) {
+            case Value::Type::Bool:   return v.as_bool();
+            case Value::Type::String: return !v.as_string().empty();
+            default: {
+                double d = 0.0;
+                return to_double(v, d) && d != 0.0;
+            }
+            }
+        }
+
+        static bool is_integral(const Value& v) {
+            return v.type() == Value::Type::Int || v.type() == Value::Type::Int64;
+        }
+
+        static std::int64_t int_of(const Value& v) {
+            return v.type() == Value::Type::Int ? v.as_int() : v.as_int64();
+        }
+
+        static Value integral(std::int64_t r, bool wide) {
+            if (!wide && r >= std::numeric_limits<std::int32_t>::min() && r <= std::numeric_limits<std::int32_t>::max()) {
+                return Value::make_int(static_cast<int>(r));
+            }
+            return Value::make_int64(r);
+        }
+
+        // Wraps like arith(): -INT64_MIN stays INT64_MIN.
+        static std::int64_t negate(std::int64_t x) {
+            return static_cast<std::int64_t>(std::uint64_t{ 0 } - static_cast<std::uint64_t>(x));
+        }
+
+        static bool arith(Op op, const Value& a, const Value& b, Value& out) {
+            if (op == Op::Add && a.type() == Value::Type::String && b.type() == Value::Type::String) {
+                std::string s;
+                s.reserve(a.as_string().size() + b.as_string().size());
+                s.append(a.as_string()).append(b.as_string());
+                out = Value::make_string(std::move(s));
+                return true;
+            }
+
+            if (op != Op::Div && is_integral(a) && is_integral(b)) {
+                const std::int64_t x = int_of(a);
+                const std::int64_t y = int_of(b);
+                const bool wide = a.type() == Value::Type::Int64 || b.type() == Value::Type::Int64;
+                std::int64_t r = 0;
+                switch (op) {
+                case Op::Add: r = static_cast<std::int64_t>(static_cast<std::uint64_t>(x) + static_cast<std::uint64_t>(y)); break;
+                case Op::Sub: r = static_cast<std::int64_t>(static_cast<std::uint64_t>(x) - static_cast<std::uint64_t>(y)); break;
+                case Op::Mul: r = static_cast<std::int64_t>(static_cast<std::uint64_t>(x) * static_cast<std::uint64_t>(y)); break;
+                case Op::Mod: if (y == 0 || (x == std::numeric_limits<std::int64_t>::min() && y == -1)) return false; r = x % y; break;
+                case Op::Min: r = std::min(x, y); break;
+                case Op::Max: r = std::max(x, y); break;
+                default: return false;
+                }
+                out = integral(r, wide);
+                return true;
+            }
+
+            double x = 0.0, y = 0.0;
+            if (!to_double(a, x) || !to_double(b, y)) return false;
+            double r = 0.0;
+            switch (op) {
+            case Op::Add: r = x + y; break;
+            case Op::Sub: r = x - y; break;
+            case Op::Mul: r = x * y; break;
+            case Op::Div: if (y == 0.0) return false; r = x / y; break;
+            case Op::Mod: if (y == 0.0) return false; r = std::fmod(x, y); break;
+            case Op::Min: r = std::min(x, y); break;
+            case Op::Max: r = std::max(x, y); break;
+            default: return false;
+            }
+            out = Value::make_double(r);
+            return true;
+        }
+
+        static bool compare(Op op, const Value& a, const Value& b, Value& out) {
+            int c = 0;
+            const bool sa = a.type() == Value::Type::String;
+            const bool sb = b.type() == Value::Type::String;
+            if (sa && sb) {
+                c = a.as_string().compare(b.as_string());
+            }
+            else if (sa || sb) {
+                if (op != Op::Eq && op != Op::Ne) return false;
+                out = Value::make_bool(op == Op::Ne);
+                return true;
+            }
+            else if (is_integral(a) && is_integral(b)) {
+                const std::int64_t x = int_of(a), y = int_of(b);
+                c = (x < y) ? -1 : (x > y) ? 1 : 0;
+            }
+            else {
+                double x = 0.0, y = 0.0;
+                to_double(a, x);
+                to_double(b, y);
+                c = (x < y) ? -1 : (x > y) ? 1 : 0;
+            }
+
+            bool r = false;
+            switch (op) {
+            case Op::Eq: r = c == 0; break;
+            case Op::Ne: r = c != 0; break;
+            case Op::Lt: r = c < 0; break;
+            case Op::Le: r = c <= 0; break;
+            case Op::Gt: r = c > 0; break;
+            case Op::Ge: r = c >= 0; break;
+            default: return false;
+            }
+            out = Value::make_bool(r);
+            return true;
+        }
+
+        // Recursive descent, lowest to highest precedence:
+        // ?:  ||  &&  == !=  < <= > >=  + -  * / %  unary ! -
+        class Parser {
+        public:
+            Parser(std::string_view src, VariableStore& store, Expression& out)
+                : m_src(src), m_store(store), m_out(out) {}
+
+            bool parse(std::string& error) {
+                next();
+                if (ternary() && m_kind != Kind::End) fail("unexpected '" + std::string(m_text) + "'");
+                if (m_out.m_code.empty() && m_error.empty()) fail("empty expression");
+                if (!m_error.empty()) {
+                    error = m_error;
+                    return false;
+                }
+                return true;
+            }
+
+        private:
+            enum class Kind { End, Number, String, Ident, Punct };
+
+            bool fail(std::string message) {
+                if (m_error.empty()) m_error = std::move(message);
+                return false;
+            }
+
+            static bool ident_start(char c) { return std::isalpha(static_cast<unsigned char>(c)) || c == '_'; }
+            static bool ident_char(char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.'; }
+
+            void next() {
+                while (m_pos < m_src.size() && std::isspace(static_cast<unsigned char>(m_src[m_pos]))) ++m_pos;
+                const std::size_t start = m_pos;
+                if (m_pos >= m_src.size()) {
+                    m_kind = Kind::End;
+                    m_text = {};
+                    return;
+                }
+
+                const char c = m_src[m_pos];
+                if (std::isdigit(static_cast<unsigned char>(c)) ||
+                    (c == '.' && m_pos + 1 < m_src.size() && std::isdigit(static_cast<unsigned char>(m_src[m_pos + 1])))) {
+                    m_kind = Kind::Number;
+                    while (m_pos < m_src.size()) {
+                        const char d = m_src[m_pos];
+                        const bool exp = (d == '+' || d == '-') && (m_src[m_pos - 1] == 'e' || m_src[m_pos - 1] == 'E');
+                        if (!std::isalnum(static_cast<unsigned char>(d)) && d != '.' && !exp) break;
+                        ++m_pos;
+                    }
+                }
+                else if (ident_start(c)) {
+                    m_kind = Kind::Ident;
+                    while (m_pos < m_src.size() && ident_char(m_src[m_pos])) ++m_pos;
+                }
+                else if (c == '"') {
+                    m_kind = Kind::String;
+                    m_string.clear();
+                    ++m_pos;
+                    while (m_pos < m_src.size() && m_src[m_pos] != '"') {
+                        if (m_src[m_pos] == '\\' && m_pos + 1 < m_src.size()) ++m_pos;
+                        m_string.push_back(m_src[m_pos++]);
+                    }
+                    if (m_pos >= m_src.size()) {
+                        fail("unterminated string");
+                        m_kind = Kind::End;
+                        return;
+                    }
+                    ++m_pos;
+                }
+                else {
+                    m_kind = Kind::Punct;
+                    static const char* two[] = { "==", "!=", "<=", ">=", "&&", "||" };
+                    m_pos += 1;
+                    for (const char* t : two) {
+                        if (m_src.compare(start, 2, t) == 0) {
+                            m_pos = start + 2;
+                            break;
+                        }
+                    }
+                }
+                m_text = m_src.substr(start, m_pos - start);
+            }
+
+            bool accept(std::string_view punct) {
+                if (m_kind != Kind::Punct || m_text != punct) return false;
+                next();
+                return true;
+            }
+
+            bool expect(std::string_view punct) {
+                if (accept(punct)) return true;
+                return fail("expected '" + std::string(punct) + "'");
+            }
+
+            std::size_t emit(Op op, std::uint32_t arg, int stackDelta) {
+                m_depth += stackDelta;
+                m_out.m_maxStack = std::max<std::size_t>(m_out.m_maxStack, static_cast<std::size_t>(m_depth));
+                m_out.m_code.push_back(Instr{ op, arg });
+                return m_out.m_code.size() - 1;
+            }
+
+            void emit_const(Value v) {
+                m_out.m_consts.push_back(std::move(v));
+                emit(Op::Const, static_cast<std::uint32_t>(m_out.m_consts.size() - 1), 1);
+            }
+
+            void patch(std::size_t at) { m_out.m_code[at].arg = static_cast<std::uint32_t>(m_out.m_code.size()); }
+
+            bool ternary() {
+                if (!logical_or()) return false;
+                if (!accept("?")) return true;
+
+                const std::size_t jumpElse = emit(Op::JumpIfFalse, 0, -1);
+                if (!ternary()) return false;
+                const std::size_t jumpEnd = emit(Op::Jump, 0, 0);
+                --m_depth;
+                patch(jumpElse);
+                if (!expect(":") || !ternary()) return false;
+                patch(jumpEnd);
+                return true;
+            }
+
+            // A constant right operand is folded into the operator itself.
+            template <typename Next>
+            bool binary(Next next, std::initializer_list<std::pair<std::string_view, Op>> ops) {
+                if (!(this->*next)()) return false;
+                for (;;) {
+                    bool matched = false;
+                    for (const auto& o : ops) {
+                        if (accept(o.first)) {
+                            auto& code = m_out.m_code;
+                            const std::size_t start = code.size();
+                            if (!(this->*next)()) return false;
+                            if (o.second != Op::And && o.second != Op::Or &&
+                                code.size() == start + 1 && code.back().op == Op::Const) {
+                                const std::uint32_t k = code.back().arg;
+                                code.pop_back();
+                                --m_depth;
+                                emit(o.second, k + 1, 0);
+                            }
+                            else {
+                                emit(o.second, 0, -1);
+                            }
+                            matched = true;
+                            break;
+                        }
+                    }
+                    if (!matched) return true;
+                }
+            }
+
+            bool logical_or() { return binary(&Parser::logical_and, { { "||", Op::Or } }); }
+            bool logical_and() { return binary(&Parser::equality, { { "&&", Op::And } }); }
+            bool equality() { return binary(&Parser::relational, { { "==", Op::Eq }, { "!=", Op::Ne } }); }
+            bool relational() {
+                return binary(&Parser::additive, { { "<=", Op::Le }, { ">=", Op::Ge }, { "<", Op::Lt }, { ">", Op::Gt } });
+            }
+            bool additive() { return binary(&Parser::multiplicative, { { "+", Op::Add }, { "-", Op::Sub } }); }
+            bool multiplicative() { return binary(&Parser::unary, { { "*", Op::Mul }, { "/", Op::Div }, { "%", Op::Mod } }); }
+
+            bool unary() {
+                if (accept("-")) {
+                    if (!unary()) return false;
+                    emit(Op::Neg, 0, 0);
+                    return true;
+                }
+                if (accept("!")) {
+                    if (!unary()) return false;
+                    emit(Op::Not, 0, 0);
+                    return true;
+                }
+                return primary();
+            }
+
+            bool number() {
+                const std::string text(m_text);
+                char* end = nullptr;
+                const bool isFloat = text.find_first_of(".eE") != std::string::npos;
+                if (isFloat) {
+                    const double d = std::strtod(text.c_str(), &end);
+                    if (end != text.c_str() + text.size()) return fail("bad number '" + text + "'");
+                    emit_const(Value::make_double(d));
+                }
+                else {
+                    const long long v = std::strtoll(text.c_str(), &end, 10);
+                    if (end != text.c_str() + text.size()) return fail("bad number '" + text + "'");
+                    emit_const(integral(v, false));
+                }
+                next();
+                return true;
+            }
+
+            bool call(const std::string& name) {
+                Op op;
+                std::size_t arity = 2;
+                if (name == "abs") { op = Op::Abs; arity = 1; }
+                else if (name == "min") op = Op::Min;
+                else if (name == "max") op = Op::Max;
+                else return fail("unknown function '" + name + "'");
+
+                for (std::size_t k = 0; k < arity; ++k) {
+                    if (k > 0 && !expect(",")) return false;
+                    if (!ternary()) return false;
+                }
+                if (!expect(")")) return false;
+                emit(op, 0, arity == 1 ? 0 : -1);
+                return true;
+            }
+
+            bool primary() {
+                switch (m_kind) {
+                case Kind::Number:
+                    return number();
+                case Kind::String:
+                    emit_const(Value::make_string(m_string));
+                    next();
+                    return true;
+                case Kind::Ident: {
+                    const std::string name(m_text);
+                    next();
+                    if (name == "true" || name == "false") {
+                        emit_const(Value::make_bool(name == "true"));
+                        return true;
+                    }
+                    if (accept("(")) return call(name);
+
+                    const TagId id = m_store.ensure_tag(name, Value::make_float(0.f));
+                    auto& deps = m_out.m_deps;
+                    if (std::find(deps.begin(), deps.end(), id) == deps.end()) deps.push_back(id);
+                    emit(Op::Load, id, 1);
+                    return true;
+                }
+                case Kind::Punct:
+                    if (accept("(")) return ternary() && expect(")");
+                    return fail("unexpected '" + std::string(m_text) + "'");
+                default:
+                    return fail("unexpected end of expression");
+                }
+            }
+
+            std::string_view m_src;
+            VariableStore& m_store;
+            Expression& m_out;
+            std::size_t m_pos{ 0 };
+            Kind m_kind{ Kind::End };
+            std::string_view m_text;
+            std::string m_string;
+            int m_depth{ 0 };
+            std::string m_error;
+        };
+
+        std::vector<Instr> m_code;
+        std::vector<Value> m_consts;
+        std::vector<TagId> m_deps;
+        std::size_t m_maxStack{ 0 };
+    };
+
+    // Keeps derived tags up to date. Each expression owns its target tag and
+    // is re-evaluated when one of its inputs changes: changes are collected
+    // while a change set is notified, and a commit hook then evaluates the
+    // affected expressions once each, in dependency order, carrying on to
+    // downstream expressions only where a result actually changed.
+    class ExpressionEngine final {
+    public:
+        explicit ExpressionEngine(VariableStore& store) : m_store(store) {
+            m_hook = m_store.add_commit_hook([this]() { evaluate_pending(); });
+        }
+
+        ~ExpressionEngine() {
+            m_store.remove_commit_hook(m_hook);
+            for (TagId id = 0; id < m_watch.size(); ++id) {
+                if (m_watch[id] != 0) m_store.at(id).unsubscribe(m_watch[id]);
+            }
+        }
+
+        ExpressionEngine(const ExpressionEngine&) = delete;
+        ExpressionEngine& operator=(const ExpressionEngine&) = delete;
+
+        bool define(const std::string& target, std::string_view source, std::string& error) {
+            Expression expr;
+            if (!expr.compile(source, m_store, error)) {
+                error = target + ": " + error;
+                return false;
+            }
+
+            const TagId tag = m_store.ensure_tag(target, Value());
+            if (node_of(tag) != no_node) {
+                error = target + ": already defined";
+                return false;
+            }
+            for (TagId d : expr.dependencies()) {
+                if (d == tag || reaches(tag, d)) {
+                    error = target + ": circular reference through '" + m_store.name(d) + "'";
+                    return false;
+                }
+            }
+
+            // Code, constants and dependencies of all expressions live in
+            // shared pools so that a pass walks contiguous memory.
+            Node node;
+            node.code = static_cast<std::uint32_t>(m_code.size());
+            node.length = static_cast<std::uint32_t>(expr.code().size());
+            node.consts = static_cast<std::uint32_t>(m_consts.size());
+            node.deps = static_cast<std::uint32_t>(m_deps.size());
+            node.depCount = static_cast<std::uint32_t>(expr.dependencies().size());
+            node.target = tag;
+            node.value = m_store.get(tag);
+            m_code.insert(m_code.end(), expr.code().begin(), expr.code().end());
+            m_consts.insert(m_consts.end(), expr.constants().begin(), expr.constants().end());
+            m_deps.insert(m_deps.end(), expr.dependencies().begin(), expr.dependencies().end());
+            if (m_stack.size() < expr.max_stack()) m_stack.resize(expr.max_stack());
+
+            const auto n = static_cast<std::uint32_t>(m_nodes.size());
+            m_nodes.push_back(std::move(node));
+            grow(tag);
+            m_targetNode[tag] = n;
+            if (m_watch[tag] != 0) {
+                m_store.at(tag).unsubscribe(m_watch[tag]);
+                m_watch[tag] = 0;
+            }
+            for (TagId d : expr.dependencies()) {
+                grow(d);
+                m_dependents[d].push_back(n);
+            }
+            assign_level(n);
+            for (TagId d : expr.dependencies()) watch(d);
+
+            queue(n);
+            UpdateBatch batch(m_store);
+            return true;
+        }
+
+        std::size_t size() const { return m_nodes.size(); }
+        std::uint64_t evaluations() const { return m_evaluations; }
+
+        // Runs from the store's commit hook; only needs to be called directly
+        // when sources were changed through Variable::set().
+        void evaluate_pending() {
+            if (m_queued == 0) return;
+
+            auto load = [this](TagId id) -> const Value& {
+                const std::uint32_t n = node_of(id);
+                return (n != no_node) ? m_nodes[n].value : m_store.get(id);
+            };
+
+            UpdateBatch batch(m_store);
+            for (std::uint32_t level = 0; level < m_levels.size(); ++level) {
+                m_pass.swap(m_levels[level]);
+                for (std::uint32_t n : m_pass) {
+                    Node& node = m_nodes[n];
+                    if (node.level != level) {
+                        // Raised by a define() while queued.
+                        if (m_levels.size() <= node.level) m_levels.resize(node.level + 1);
+                        m_levels[node.level].push_back(n);
+                        continue;
+                    }
+                    node.queued = false;
+                    --m_queued;
+                    ++m_evaluations;
+
+                    const bool ok = Expression::execute(m_code.data() + node.code, node.length,
+                        m_consts.data() + node.consts, load, m_stack.data(), m_result);
+                    if (!ok || node.value.equals(m_result)) continue;
+
+                    node.value = m_result;
+                    m_store.set(node.target, node.value);
+                    for (std::uint32_t d : m_dependents[node.target]) queue(d);
+                }
+                m_pass.clear();
+            }
+        }
+
+    private:
+        static constexpr std::uint32_t no_node = std::numeric_limits<std::uint32_t>::max();
+
+        struct Node {
+            std::uint32_t code{ 0 };
+            std::uint32_t length{ 0 };
+            std::uint32_t consts{ 0 };
+            std::uint32_t deps{ 0 };
+            std::uint32_t depCount{ 0 };
+            TagId target{ invalid_tag };
+            std::uint32_t level{ 0 };
+            bool queued{ false };
+            Value value;
+        };
+
+        std::uint32_t node_of(TagId id) const {
+            return id < m_targetNode.size() ? m_targetNode[id] : no_node;
+        }
+
+        void grow(TagId id) {
+            if (m_targetNode.size() <= id) {
+                m_targetNode.resize(m_store.size(), no_node);
+                m_dependents.resize(m_store.size());
+                m_watch.resize(m_store.size(), 0);
+            }
+        }
+
+        // Nodes are queued by level (longest path from a source tag), so
+        // evaluating the levels in order respects every dependency.
+        void queue(std::uint32_t n) {
+            Node& node = m_nodes[n];
+            if (node.queued) return;
+            node.queued = true;
+            ++m_queued;
+            if (m_levels.size() <= node.level) m_levels.resize(node.level + 1);
+            m_levels[node.level].push_back(n);
+        }
+
+        void assign_level(std::uint32_t n) {
+            std::uint32_t level = 0;
+            const Node& node = m_nodes[n];
+            for (std::uint32_t k = 0; k < node.depCount; ++k) {
+                const std::uint32_t src = node_of(m_deps[node.deps + k]);
+                if (src != no_node) level = std::max(level, m_nodes[src].level + 1);
+            }
+            m_nodes[n].level = level;
+
+            std::vector<std::uint32_t> stack{ n };
+            while (!stack.empty()) {
+                const std::uint32_t k = stack.back();
+                stack.pop_back();
+                for (std::uint32_t d : m_dependents[m_nodes[k].target]) {
+                    if (m_nodes[d].level <= m_nodes[k].level) {
+                        m_nodes[d].level = m_nodes[k].level + 1;
+                        stack.push_back(d);
+                    }
+                }
+            }
+        }
+
+        // Derived tags are written by the engine only, and their dependents are
+        // already part of the pass that wrote them.
+        void on_change(TagId id) {
+            if (node_of(id) != no_node) return;
+            for (std::uint32_t n : m_dependents[id]) queue(n);
+        }
+
+        void watch(TagId id) {
+            if (m_watch[id] != 0 || node_of(id) != no_node) return;
+            m_watch[id] = m_store.at(id).subscribe([this, id](const Value&) { on_change(id); });
+        }
+
+        // True if 'to' is downstream of 'from'.
+        bool reaches(TagId from, TagId to) const {
+            if (from >= m_dependents.size() || m_dependents[from].empty()) return false;
+
+            std::vector<TagId> stack{ from };
+            std::vector<bool> seen(m_store.size(), false);
+            while (!stack.empty()) {
+                const TagId t = stack.back();
+                stack.pop_back();
+                if (t == to) return true;
+                if (t >= m_dependents.size() || seen[t]) continue;
+                seen[t] = true;
+                for (std::uint32_t n : m_dependents[t]) stack.push_back(m_nodes[n].target);
+            }
+            return false;
+        }
+
+        VariableStore& m_store;
+        std::size_t m_hook{ 0 };
+
+        std::vector<Node> m_nodes;
+        std::vector<Expression::Instr> m_code;
+        std::vector<Value> m_consts;
+        std::vector<TagId> m_deps;
+
+        std::vector<std::uint32_t> m_targetNode;
+        std::vector<std::vector<std::uint32_t>> m_dependents;
+        std::vector<std::size_t> m_watch;
+        std::vector<std::vector<std::uint32_t>> m_levels;
+        std::vector<std::uint32_t> m_pass;
+        std::size_t m_queued{ 0 };
+
+        std::vector<Value> m_stack;
+        Value m_result;
+        std::uint64_t m_evaluations{ 0 };
+    };
+
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "xs_core.hpp"
+#include "xs_ingest.hpp"
+
+namespace xs::core {
+
+    // The changes to one screen's tags published by ScreenFeed::publish():
+    // entry k sets mirror tag slots[k]. Until the render thread takes a
+    // frame, later publishes merge into it, so no change is lost; once
+    // taken it is never changed again, so render threads read it without
+    // locking.
+    struct TagFrame {
+        std::uint64_t seq{ 0 };
+        std::vector<std::uint32_t> slots;
+        std::vector<Value> values;
+        std::vector<Quality> quality;
+        std::vector<std::int64_t> stamps;
+    };
+
+    // Connects a screen running on its own render thread to the shared
+    // store, which only the UI loop thread touches. The screen's widgets
+    // bind to a private mirror store; the loop thread publishes the tags
+    // that changed as immutable frames, the render thread applies them to
+    // its mirror between frames, and writes made on the screen go back
+    // through the ingest queue. Neither side ever waits for the other: a
+    // write the full queue rejects is kept and retried on the next apply().
+    //
+    // A suspended feed drops its subscriptions and publishes nothing; on
+    // resume the next frame carries every tag again.
+    class ScreenFeed final {
+    public:
+        ScreenFeed(VariableStore& source, IngestQueue& writes) : m_source(source), m_writes(writes) {}
+
+        ScreenFeed(const ScreenFeed&) = delete;
+        ScreenFeed& operator=(const ScreenFeed&) = delete;
+
+        // --- Loop thread ---
+
+        // Picks up a pending connect() and, while active, publishes the tags
+        // that changed since the last publish, in O(changed tags).
+        void publish() {
+            if (!m_connected && !resolve()) return;
+            if (!m_active || m_dirty.empty()) return;
+
+            // The render thread only reads a frame after taking it under the
+            // lock, so one it has not taken yet is still ours to extend.
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_latest) m_latest = std::make_shared<TagFrame>();
+            TagFrame& frame = *m_latest;
+            frame.seq = ++m_seq;
+            for (std::uint32_t slot : m_dirty) {
+                const TagId id = m_tags[slot];
+                std::size_t pos = m_framePos[slot];
+                if (pos >= frame.slots.size() || frame.slots[pos] != slot) {
+                    pos = frame.slots.size();
+                    m_framePos[slot] = static_cast<std::uint32_t>(pos);
+                    frame.slots.push_back(slot);
+                    frame.values.emplace_back();
+                    frame.quality.push_back(Quality::Good);
+                    frame.stamps.push_back(0);
+                }
+                frame.values[pos] = m_source.at(id).get();
+                frame.quality[pos] = m_source.quality(id);
+                frame.stamps[pos] = m_source.timestamp(id);
+                m_isDirty[slot] = 0;
+            }
+            m_dirty.clear();
+            m_latestSeq.store(m_seq, std::memory_order_release);
+        }
+
+        void set_active(bool on) {
+            if (on == m_active.load(std::memory_order_relaxed)) return;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_active.store(on, std::memory_order_release);
+            }
+            if (m_connected) {
+                if (on) watch();
+                else unwatch();
+            }
+            m_wake.notify_all();
+        }
+
+        bool connected() const { return m_connected; }
+
+        // --- Render thread ---
+
+        // Hands the mirror's tags to the loop thread. Tags missing from the
+        // shared store are created with the mirror's values. Tags added to
+        // the mirror later are not fed.
+        void connect(VariableStore& mirror) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_request.clear();
+                for (TagId id = 0; id < mirror.size(); ++id) m_request.emplace_back(mirror.name(id), mirror.get(id));
+                m_requested = true;
+            }
+            // The loop thread picks the request up in its next publish().
+            m_writes.wake();
+        }
+
+        // True if a frame newer than the last applied one is waiting.
+        bool has_frame() const { return m_latestSeq.load(std::memory_order_acquire) > m_appliedSeq; }
+
+        // Retries rejected screen writes, then applies the waiting frame to
+        // the mirror in one batch, so each changed tag notifies once.
+        // Returns false if there was no frame.
+        bool apply(VariableStore& mirror) {
+            retry_writes();
+            if (!has_frame()) return false;
+            std::shared_ptr<const TagFrame> frame;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                frame = std::move(m_latest);
+            }
+            if (!frame) return false;
+            {
+                m_applying = true;
+                UpdateBatch batch(mirror);
+                for (std::size_t k = 0; k < frame->slots.size(); ++k) {
+                    mirror.set(static_cast<TagId>(frame->slots[k]), frame->values[k], frame->quality[k], frame->stamps[k]);
+                }
+            }
+            m_applying = false;
+            m_appliedSeq = frame->seq;
+            if (m_mirrorSubs.empty()) subscribe_mirror(mirror);
+            return true;
+        }
+
+        // Screen writes the ingest queue had no room for yet.
+        std::size_t pending_writes() const { return m_unsent.size(); }
+
+        bool active() const { return m_active.load(std::memory_order_acquire); }
+
+        // Blocks while the feed is suspended. Returns false once closed.
+        bool wait_active() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_active.load(std::memory_order_relaxed) || m_closed; });
+            return !m_closed;
+        }
+
+        // Drops the mirror subscriptions; call before the mirror goes away.
+        void disconnect() { m_mirrorSubs.clear(); }
+
+        // --- Either thread ---
+
+        void close() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_closed = true;
+            }
+            m_wake.notify_all();
+        }
+
+        bool closed() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_closed;
+        }
+
+    private:
+        bool resolve() {
+            std::vector<std::pair<std::string, Value>> request;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_requested) return false;
+                request.swap(m_request);
+            }
+            const std::size_t n = request.size();
+            m_tags.resize(n);
+            for (std::size_t k = 0; k < n; ++k) m_tags[k] = m_source.ensure_tag(request[k].first, request[k].second);
+            m_isDirty.assign(n, 0);
+            m_framePos.assign(n, 0);
+            m_connected = true;
+            if (m_active) watch();
+            return true;
+        }
+
+        // Subscribing delivers the current values, so every slot starts dirty.
+        void watch() {
+            m_sourceSubs.reserve(m_tags.size());
+            for (std::size_t k = 0; k < m_tags.size(); ++k) {
+                const auto slot = static_cast<std::uint32_t>(k);
+                m_sourceSubs.push_back(m_source.at(m_tags[k]).subscribe_scoped([this, slot](const Value&) { mark(slot); }));
+            }
+        }
+
+        void unwatch() {
+            m_sourceSubs.clear();
+            for (std::uint32_t slot : m_dirty) m_isDirty[slot] = 0;
+            m_dirty.clear();
+        }
+
+        void mark(std::uint32_t slot) {
+            if (m_isDirty[slot]) return;
+            m_isDirty[slot] = 1;
+            m_dirty.push_back(slot);
+        }
+
+        // Mirror changes made outside apply() came from the screen. The
+        // subscriptions are made after the first frame, once m_tags is set.
+        void subscribe_mirror(VariableStore& mirror) {
+            const std::size_t n = std::min<std::size_t>(m_tags.size(), mirror.size());
+            m_applying = true;
+            m_mirrorSubs.reserve(n);
+            for (std::size_t k = 0; k < n; ++k) {
+                const auto slot = static_cast<std::uint32_t>(k);
+                m_mirrorSubs.push_back(mirror.at(static_cast<TagId>(k)).subscribe_scoped([this, slot](const Value& v) {
+                    if (!m_applying) write(slot, v);
+                }));
+            }
+            m_applying = false;
+        }
+
+        // Writes keep their order; a newer write to a waiting tag replaces it.
+        void write(std::uint32_t slot, const Value& v) {
+            if (m_unsent.empty() && m_writes.try_push(m_tags[slot], v)) return;
+            for (auto& w : m_unsent) {
+                if (w.first == slot) {
+                    w.second = v;
+                    return;
+                }
+            }
+            m_unsent.emplace_back(slot, v);
+        }
+
+        void retry_writes() {
+            std::size_t sent = 0;
+            while (sent < m_unsent.size() && m_writes.try_push(m_tags[m_unsent[sent].first], m_unsent[sent].second)) ++sent;
+            m_unsent.erase(m_unsent.begin(), m_unsent.begin() + static_cast<std::ptrdiff_t>(sent));
+        }
+
+        VariableStore& m_source;
+        IngestQueue& m_writes;
+
+        // Loop thread. m_tags is written once before the first frame and
+        // read-only afterwards.
+        std::vector<TagId> m_tags;
+        bool m_connected{ false };
+        std::uint64_t m_seq{ 0 };
+        std::vector<Subscription> m_sourceSubs;
+        std::vector<std::uint32_t> m_dirty;
+        std::vector<std::uint8_t> m_isDirty;
+        std::vector<std::uint32_t> m_framePos;  // slot's entry in m_latest, if it is still there
+
+        // Render thread.
+        std::uint64_t m_appliedSeq{ 0 };
+        bool m_applying{ false };
+        std::vector<Subscription> m_mirrorSubs;
+        std::vector<std::pair<std::uint32_t, Value>> m_unsent;
+
+        // Shared.
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::shared_ptr<TagFrame> m_latest;  // not yet taken by the render thread
+        std::atomic<std::uint64_t> m_latestSeq{ 0 };
+        std::atomic<bool> m_active{ true };
+        std::vector<std::pair<std::string, Value>> m_request;
+        bool m_requested{ false };
+        bool m_closed{ false };
+    };
+
+}
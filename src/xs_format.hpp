@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "xs_core.hpp"
+
+namespace xs::core {
+
+    // How a bound value is displayed. decimals applies to floating point
+    // values, and to every number in the engineering notations. thousands is
+    // the group separator for the integer part (0 = none). A non-empty unit
+    // is appended after a space; SiPrefix puts the prefix in front of it
+    // ("1.20 kW").
+    struct FormatSpec {
+        enum class Notation : std::uint8_t { Fixed, Engineering, SiPrefix };
+
+        int decimals{ 2 };
+        Notation notation{ Notation::Fixed };
+        char thousands{ 0 };
+        std::string unit;
+    };
+
+    // Fixed-size output for format_value(); longer results are truncated.
+    class FormatBuffer final {
+    public:
+        static constexpr std::size_t capacity = 64;
+
+        std::string_view view() const { return std::string_view(m_data, m_size); }
+        void clear() { m_size = 0; }
+
+        void append(char c) {
+            if (m_size < capacity) m_data[m_size++] = c;
+        }
+
+        void append(std::string_view s) {
+            const std::size_t n = std::min(s.size(), capacity - m_size);
+            std::memcpy(m_data + m_size, s.data(), n);
+            m_size += n;
+        }
+
+    private:
+        char m_data[capacity];
+        std::size_t m_size{ 0 };
+    };
+
+    namespace detail {
+
+        // Copies a plain number ("-1234.5"), putting sep between groups of
+        // three digits in the integer part.
+        inline void append_grouped(FormatBuffer& out, std::string_view num, char sep) {
+            std::size_t k = 0;
+            if (k < num.size() && num[k] == '-') out.append(num[k++]);
+            std::size_t digits = 0;
+            while (k + digits < num.size() && num[k + digits] >= '0' && num[k + digits] <= '9') ++digits;
+            for (std::size_t d = 0; d < digits; ++d) {
+                if (sep != 0 && d > 0 && (digits - d) % 3 == 0) out.append(sep);
+                out.append(num[k + d]);
+            }
+            out.append(num.substr(k + digits));
+        }
+
+        template <typename Int>
+        void append_integer(FormatBuffer& out, Int v, char sep) {
+            char tmp[24];
+            const auto r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+            append_grouped(out, std::string_view(tmp, static_cast<std::size_t>(r.ptr - tmp)), sep);
+        }
+
+        inline void append_fixed(FormatBuffer& out, double v, int decimals, char sep) {
+            char tmp[FormatBuffer::capacity];
+            auto r = std::to_chars(tmp, tmp + sizeof(tmp), v, std::chars_format::fixed, decimals);
+            if (r.ec != std::errc()) r = std::to_chars(tmp, tmp + sizeof(tmp), v, std::chars_format::scientific, decimals);
+            if (r.ec != std::errc()) return;
+            append_grouped(out, std::string_view(tmp, static_cast<std::size_t>(r.ptr - tmp)), sep);
+        }
+
+        // Mantissa in [1, 1000) with an exponent that is a multiple of three.
+        // Returns the SI prefix for SiPrefix, or 0 if none applies.
+        inline char append_engineering(FormatBuffer& out, double v, int decimals, const FormatSpec& spec) {
+            int exp = 0;
+            if (v != 0.0 && std::isfinite(v)) {
+                exp = static_cast<int>(std::floor(std::log10(std::fabs(v)) / 3.0)) * 3;
+                v /= std::pow(10.0, exp);
+                // Rounding may carry the mantissa up to 1000.
+                if (std::fabs(v) >= 1000.0 - 0.5 * std::pow(10.0, -decimals)) {
+                    v /= 1000.0;
+                    exp += 3;
+                }
+            }
+            append_fixed(out, v, decimals, spec.thousands);
+
+            static constexpr char prefixes[] = "pnum kMGT";
+            if (spec.notation == FormatSpec::Notation::SiPrefix && exp >= -12 && exp <= 12) {
+                return exp == 0 ? 0 : prefixes[(exp + 12) / 3];
+            }
+            if (exp != 0) {
+                out.append('e');
+                append_integer(out, exp, 0);
+            }
+            return 0;
+        }
+
+    }
+
+    // Formats without touching the heap. Strings are returned as a view of
+    // the value itself; everything else as a view of 'out'.
+    inline std::string_view format_value(const Value& v, const FormatSpec& spec, FormatBuffer& out) {
+        out.clear();
+        const int decimals = std::clamp(spec.decimals, 0, 15);
+        const bool fixed = spec.notation == FormatSpec::Notation::Fixed;
+        char prefix = 0;
+
+        switch (v.type()) {
+        case Value::Type::String:
+            return v.as_string();
+        case Value::Type::Bool:
+            out.append(v.as_bool() ? "true" : "false");
+            return out.view();
+        case Value::Type::Int:
+            if (fixed) detail::append_integer(out, v.as_int(), spec.thousands);
+            else prefix = detail::append_engineering(out, v.as_int(), decimals, spec);
+            break;
+        case Value::Type::Int64:
+            if (fixed) detail::append_integer(out, v.as_int64(), spec.thousands);
+            else prefix = detail::append_engineering(out, static_cast<double>(v.as_int64()), decimals, spec);
+            break;
+        case Value::Type::Float:
+        case Value::Type::Double: {
+            const double d = v.type() == Value::Type::Float ? v.as_float() : v.as_double();
+            if (fixed) detail::append_fixed(out, d, decimals, spec.thousands);
+            else prefix = detail::append_engineering(out, d, decimals, spec);
+            break;
+        }
+        default:
+            return out.view();
+        }
+
+        if (prefix != 0 || !spec.unit.empty()) {
+            out.append(' ');
+            if (prefix != 0) out.append(prefix);
+            out.append(spec.unit);
+        }
+        return out.view();
+    }
+
+}
@@ -0,0 +1,437 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "xs_core.hpp"
+#include "xs_mapped_file.hpp"
+
+namespace xs::core {
+
+    struct HistoryConfig {
+        std::size_t capacity{ 4096 };
+        double deadband{ 0.0 };
+        double compression{ 0.0 };
+    };
+
+    struct TrendBucket {
+        std::int64_t begin{ 0 };
+        std::int64_t end{ 0 };
+        double min{ 0.0 };
+        double max{ 0.0 };
+        double avg{ 0.0 };
+        std::uint64_t count{ 0 };
+    };
+
+    // Fixed-size ring of samples kept as two parallel arrays, so scans over
+    // timestamps never touch values and vice versa.
+    class SampleRing final {
+    public:
+        explicit SampleRing(std::size_t capacity)
+            : m_times(std::max<std::size_t>(capacity, 1)), m_values(std::max<std::size_t>(capacity, 1)) {}
+
+        std::size_t capacity() const { return m_times.size(); }
+        std::size_t size() const { return m_size; }
+        bool full() const { return m_size == capacity(); }
+
+        void push(std::int64_t t, double v) {
+            m_times[m_head] = t;
+            m_values[m_head] = v;
+            m_head = (m_head + 1 == capacity()) ? 0 : m_head + 1;
+            if (m_size < capacity()) ++m_size;
+        }
+
+        // k-th oldest sample.
+        std::int64_t time(std::size_t k) const { return m_times[index(k)]; }
+        double value(std::size_t k) const { return m_values[index(k)]; }
+
+    private:
+        std::size_t index(std::size_t k) const { return (m_head + capacity() - m_size + k) % capacity(); }
+
+        std::vector<std::int64_t> m_times;
+        std::vector<double> m_values;
+        std::size_t m_head{ 0 };
+        std::size_t m_size{ 0 };
+    };
+
+    // Exception deadband followed by swinging-door compression. Points that
+    // must be archived are passed to emit(t, v); the latest accepted point is
+    // held back until a later sample proves it is needed.
+    class SwingingDoor final {
+    public:
+        SwingingDoor(double deadband = 0.0, double deviation = 0.0)
+            : m_deadband(deadband), m_deviation(deviation) {}
+
+        template <typename Emit>
+        void add(std::int64_t t, double v, Emit&& emit) {
+            if (!m_hasArchived) {
+                archive(t, v, emit);
+                return;
+            }
+            if (t < (m_hasHeld ? m_heldT : m_archT)) return;
+
+            const double ref = m_hasHeld ? m_heldV : m_archV;
+            if (m_deadband > 0.0 && std::abs(v - ref) <= m_deadband) return;
+
+            if (m_deviation <= 0.0) {
+                archive(t, v, emit);
+                return;
+            }
+            if (t == m_archT) return;
+            if (m_hasHeld && t == m_heldT) {
+                hold(t, v);
+                return;
+            }
+
+            const double dt = static_cast<double>(t - m_archT);
+            const double up = (v - (m_archV + m_deviation)) / dt;
+            const double low = (v - (m_archV - m_deviation)) / dt;
+
+            if (m_hasHeld) {
+                const double maxUp = std::max(m_maxUp, up);
+                const double minLow = std::min(m_minLow, low);
+                if (maxUp <= minLow) {
+                    m_maxUp = maxUp;
+                    m_minLow = minLow;
+                    hold(t, v);
+                    return;
+                }
+
+                archive(m_heldT, m_heldV, emit);
+                const double dn = static_cast<double>(t - m_archT);
+                m_maxUp = (v - (m_archV + m_deviation)) / dn;
+                m_minLow = (v - (m_archV - m_deviation)) / dn;
+                hold(t, v);
+                return;
+            }
+
+            m_maxUp = up;
+            m_minLow = low;
+            hold(t, v);
+        }
+
+        template <typename Emit>
+        void close(Emit&& emit) {
+            if (m_hasHeld) archive(m_heldT, m_heldV, emit);
+        }
+
+        bool has_held() const { return m_hasHeld; }
+        std::int64_t held_time() const { return m_heldT; }
+        double held_value() const { return m_heldV; }
+
+    private:
+        template <typename Emit>
+        void archive(std::int64_t t, double v, Emit& emit) {
+            emit(t, v);
+            m_hasArchived = true;
+            m_hasHeld = false;
+            m_archT = t;
+            m_archV = v;
+        }
+
+        void hold(std::int64_t t, double v) {
+            m_hasHeld = true;
+            m_heldT = t;
+            m_heldV = v;
+        }
+
+        double m_deadband;
+        double m_deviation;
+
+        bool m_hasArchived{ false };
+        std::int64_t m_archT{ 0 };
+        double m_archV{ 0.0 };
+
+        bool m_hasHeld{ false };
+        std::int64_t m_heldT{ 0 };
+        double m_heldV{ 0.0 };
+
+        double m_maxUp{ 0.0 };
+        double m_minLow{ 0.0 };
+    };
+
+    // Opt-in trend recorder. Each recorded tag gets a compressed sample ring;
+    // archived samples are periodically appended to a binary file as blocks
+    // carrying min/max/sum summaries, and queries read that file through a
+    // memory mapping so that whole blocks inside one bucket are merged from
+    // their summary without touching the samples.
+    class Historian final {
+    public:
+        explicit Historian(VariableStore& store, std::string path = {})
+            : m_store(store), m_path(std::move(path)), m_clock(now_ms) {
+            if (m_path.empty()) return;
+
+            std::ifstream in(m_path, std::ios::binary | std::ios::ate);
+            m_fileSize = in ? static_cast<std::size_t>(in.tellg()) : 0;
+            if (m_fileSize == 0) {
+                std::ofstream out(m_path, std::ios::binary | std::ios::trunc);
+                out.write(file_magic, sizeof(file_magic));
+                m_fileSize = out ? sizeof(file_magic) : 0;
+            }
+        }
+
+        ~Historian() {
+            for (auto& s : m_series) {
+                m_store.at(s.id).unsubscribe(s.subId);
+                s.door.close([&](std::int64_t t, double v) { append(s, t, v); });
+            }
+            flush();
+        }
+
+        Historian(const Historian&) = delete;
+        Historian& operator=(const Historian&) = delete;
+
+        void set_clock(std::function<std::int64_t()> clock) { m_clock = std::move(clock); }
+        void set_flush_interval(std::int64_t ms) { m_flushInterval = ms; }
+
+        bool record(TagId id, const HistoryConfig& cfg = {}) {
+            if (!m_store.valid(id) || series_of(id) != no_series) return false;
+
+            if (m_seriesOf.size() <= id) m_seriesOf.resize(static_cast<std::size_t>(id) + 1, no_series);
+            const std::uint32_t index = static_cast<std::uint32_t>(m_series.size());
+            m_seriesOf[id] = index;
+            m_series.push_back(Series{ id, m_store.name(id), SwingingDoor(cfg.deadband, cfg.compression),
+                SampleRing(cfg.capacity) });
+
+            m_series[index].subId = m_store.at(id).subscribe([this, index](const Value& v) {
+                double d = 0.0;
+                if (to_double(v, d)) add_sample(m_series[index], m_clock(), d);
+                });
+            return true;
+        }
+
+        void sample(TagId id, std::int64_t t, double v) {
+            const std::uint32_t index = series_of(id);
+            if (index != no_series) add_sample(m_series[index], t, v);
+        }
+
+        // When tick() next flushes, on the historian's clock.
+        std::int64_t next_due() const { return m_lastFlush + m_flushInterval; }
+
+        void tick() {
+            const std::int64_t now = m_clock();
+            if (now - m_lastFlush < m_flushInterval) return;
+            m_lastFlush = now;
+            flush();
+        }
+
+        std::size_t flush() {
+            std::size_t written = 0;
+            for (auto& s : m_series) written += flush_series(s);
+            return written;
+        }
+
+        std::size_t stored(TagId id) const {
+            const std::uint32_t index = series_of(id);
+            return (index == no_series) ? 0 : m_series[index].ring.size();
+        }
+
+        std::vector<TrendBucket> query(TagId id, std::int64_t from, std::int64_t to, std::size_t buckets) {
+            if (!m_store.valid(id)) return {};
+            return query(m_store.name(id), from, to, buckets);
+        }
+
+        std::vector<TrendBucket> query(const std::string& name, std::int64_t from, std::int64_t to, std::size_t buckets) {
+            if (buckets == 0 || to <= from) return {};
+
+            const std::int64_t width = std::max<std::int64_t>(1,
+                (to - from + static_cast<std::int64_t>(buckets) - 1) / static_cast<std::int64_t>(buckets));
+            std::vector<TrendBucket> out(buckets);
+            std::vector<double> sums(buckets, 0.0);
+            for (std::size_t b = 0; b < buckets; ++b) {
+                out[b].begin = from + static_cast<std::int64_t>(b) * width;
+                out[b].end = std::min(to, out[b].begin + width);
+                out[b].min = std::numeric_limits<double>::infinity();
+                out[b].max = -std::numeric_limits<double>::infinity();
+            }
+
+            auto merge = [&](std::int64_t t, double mn, double mx, double sum, std::uint64_t n) {
+                const std::size_t b = static_cast<std::size_t>((t - from) / width);
+                TrendBucket& tb = out[b];
+                tb.min = std::min(tb.min, mn);
+                tb.max = std::max(tb.max, mx);
+                tb.count += n;
+                sums[b] += sum;
+                };
+            auto add = [&](std::int64_t t, double v) {
+                if (t >= from && t < to) merge(t, v, v, v, 1);
+                };
+
+            scan_file(name, from, to, width, merge, add);
+
+            const std::uint32_t index = find_series(name);
+            if (index != no_series) {
+                const Series& s = m_series[index];
+                for (std::size_t k = s.ring.size() - s.unflushed; k < s.ring.size(); ++k) add(s.ring.time(k), s.ring.value(k));
+                if (s.door.has_held()) add(s.door.held_time(), s.door.held_value());
+            }
+
+            for (std::size_t b = 0; b < buckets; ++b) {
+                if (out[b].count == 0) {
+                    out[b].min = out[b].max = out[b].avg = std::numeric_limits<double>::quiet_NaN();
+                }
+                else {
+                    out[b].avg = sums[b] / static_cast<double>(out[b].count);
+                }
+            }
+            return out;
+        }
+
+    private:
+        static constexpr char file_magic[8] = { 'X', 'S', 'H', 'I', 'S', 'T', '0', '1' };
+        static constexpr std::uint32_t block_magic = 0x42485358u;
+        static constexpr std::uint32_t no_series = std::numeric_limits<std::uint32_t>::max();
+
+        struct BlockHeader {
+            std::uint32_t magic;
+            std::uint32_t nameLength;
+            std::uint64_t count;
+            std::int64_t firstTime;
+            std::int64_t lastTime;
+            double minValue;
+            double maxValue;
+            double sum;
+        };
+
+        struct Series {
+            TagId id;
+            std::string name;
+            SwingingDoor door;
+            SampleRing ring;
+            std::size_t unflushed{ 0 };
+            std::size_t subId{ 0 };
+        };
+
+        static std::size_t padded(std::size_t n) { return (n + 7) & ~static_cast<std::size_t>(7); }
+
+        template <typename T>
+        static T load(const std::uint8_t* p) {
+            T v;
+            std::memcpy(&v, p, sizeof(T));
+            return v;
+        }
+
+        std::uint32_t series_of(TagId id) const {
+            return (id < m_seriesOf.size()) ? m_seriesOf[id] : no_series;
+        }
+
+        std::uint32_t find_series(const std::string& name) const {
+            for (std::size_t k = 0; k < m_series.size(); ++k) {
+                if (m_series[k].name == name) return static_cast<std::uint32_t>(k);
+            }
+            return no_series;
+        }
+
+        void add_sample(Series& s, std::int64_t t, double v) {
+            s.door.add(t, v, [&](std::int64_t at, double value) { append(s, at, value); });
+        }
+
+        void append(Series& s, std::int64_t t, double v) {
+            if (s.unflushed == s.ring.capacity() && !m_path.empty()) flush_series(s);
+            s.ring.push(t, v);
+            s.unflushed = std::min(s.unflushed + 1, s.ring.capacity());
+        }
+
+        std::size_t flush_series(Series& s) {
+            if (s.unflushed == 0 || m_path.empty() || m_fileSize == 0) return 0;
+
+            BlockHeader h{};
+            h.magic = block_magic;
+            h.nameLength = static_cast<std::uint32_t>(s.name.size());
+            h.count = s.unflushed;
+            h.minValue = std::numeric_limits<double>::infinity();
+            h.maxValue = -std::numeric_limits<double>::infinity();
+
+            std::vector<std::int64_t> times(s.unflushed);
+            std::vector<double> values(s.unflushed);
+            const std::size_t first = s.ring.size() - s.unflushed;
+            for (std::size_t k = 0; k < s.unflushed; ++k) {
+                times[k] = s.ring.time(first + k);
+                values[k] = s.ring.value(first + k);
+                h.minValue = std::min(h.minValue, values[k]);
+                h.maxValue = std::max(h.maxValue, values[k]);
+                h.sum += values[k];
+            }
+            h.firstTime = times.front();
+            h.lastTime = times.back();
+
+            std::ofstream out(m_path, std::ios::binary | std::ios::app);
+            const char pad[8] = {};
+            out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+            out.write(s.name.data(), static_cast<std::streamsize>(s.name.size()));
+            out.write(pad, static_cast<std::streamsize>(padded(s.name.size()) - s.name.size()));
+            out.write(reinterpret_cast<const char*>(times.data()), static_cast<std::streamsize>(times.size() * sizeof(std::int64_t)));
+            out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(double)));
+            if (!out) return 0;
+
+            m_fileSize += sizeof(h) + padded(s.name.size()) + s.unflushed * (sizeof(std::int64_t) + sizeof(double));
+            const std::size_t written = s.unflushed;
+            s.unflushed = 0;
+            return written;
+        }
+
+        template <typename Merge, typename Add>
+        void scan_file(const std::string& name, std::int64_t from, std::int64_t to, std::int64_t width, Merge& merge, Add& add) {
+            if (m_path.empty()) return;
+            if (!m_map.is_open() || m_map.size() != m_fileSize) m_map.open(m_path);
+            if (m_map.size() < sizeof(file_magic) || std::memcmp(m_map.data(), file_magic, sizeof(file_magic)) != 0) return;
+
+            const std::uint8_t* base = m_map.data();
+            std::size_t pos = sizeof(file_magic);
+            while (pos + sizeof(BlockHeader) <= m_map.size()) {
+                const BlockHeader h = load<BlockHeader>(base + pos);
+                if (h.magic != block_magic) return;
+
+                const std::size_t nameAt = pos + sizeof(BlockHeader);
+                const std::size_t timesAt = nameAt + padded(h.nameLength);
+                const std::size_t valuesAt = timesAt + h.count * sizeof(std::int64_t);
+                const std::size_t next = valuesAt + h.count * sizeof(double);
+                if (next > m_map.size()) return;
+                pos = next;
+
+                if (h.nameLength != name.size() || std::memcmp(base + nameAt, name.data(), name.size()) != 0) continue;
+                if (h.lastTime < from || h.firstTime >= to || h.count == 0) continue;
+
+                if (h.firstTime >= from && h.lastTime < to && (h.firstTime - from) / width == (h.lastTime - from) / width) {
+                    merge(h.firstTime, h.minValue, h.maxValue, h.sum, h.count);
+                    continue;
+                }
+
+                std::size_t lo = 0;
+                std::size_t hi = h.count;
+                while (lo < hi) {
+                    const std::size_t mid = (lo + hi) / 2;
+                    if (load<std::int64_t>(base + timesAt + mid * sizeof(std::int64_t)) < from) lo = mid + 1;
+                    else hi = mid;
+                }
+                for (std::size_t k = lo; k < h.count; ++k) {
+                    const std::int64_t t = load<std::int64_t>(base + timesAt + k * sizeof(std::int64_t));
+                    if (t >= to) break;
+                    add(t, load<double>(base + valuesAt + k * sizeof(double)));
+                }
+            }
+        }
+
+        VariableStore& m_store;
+        std::string m_path;
+        std::function<std::int64_t()> m_clock;
+
+        std::int64_t m_flushInterval{ 10000 };
+        std::int64_t m_lastFlush{ 0 };
+
+        std::vector<Series> m_series;
+        std::vector<std::uint32_t> m_seriesOf;
+
+        std::size_t m_fileSize{ 0 };
+        MappedFile m_map;
+    };
+
+}
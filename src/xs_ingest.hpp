@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "xs_core.hpp"
+
+namespace xs::core {
+
+    // A timestamp of 0 is filled in with the time of the drain.
+    struct TagUpdate {
+        TagId id{ invalid_tag };
+        Value value;
+        Quality quality{ Quality::Good };
+        std::int64_t timestamp{ 0 };
+    };
+
+    // Wakes a loop that sleeps until it has work. Any thread may notify();
+    // one that finds a wake already pending costs a single atomic exchange.
+    class WakeSignal final {
+    public:
+        void notify() {
+            if (m_pending.exchange(true, std::memory_order_acq_rel)) return;
+            // Waiters check m_pending under the lock, so this cannot fall
+            // between their check and their wait.
+            { std::lock_guard<std::mutex> lock(m_mutex); }
+            m_cv.notify_one();
+        }
+
+        // Sleeps up to ms unless a wake is pending, and consumes it. Returns
+        // true if woken by notify().
+        bool wait_for(std::int64_t ms) {
+            // Far deadlines would overflow the clock inside wait_for().
+            constexpr std::int64_t longest = 3600 * 1000;
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (ms > 0) {
+                m_cv.wait_for(lock, std::chrono::milliseconds(std::min(ms, longest)),
+                    [this] { return m_pending.load(std::memory_order_acquire); });
+            }
+            return m_pending.exchange(false, std::memory_order_acq_rel);
+        }
+
+    private:
+        std::atomic<bool> m_pending{ false };
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+    };
+
+    // Bounded multi-producer / single-consumer ring buffer. I/O threads push
+    // (tag, value) pairs; the UI thread drains them into a VariableStore, so
+    // the store itself is only ever touched from one thread.
+    class IngestQueue final {
+    public:
+        explicit IngestQueue(std::size_t capacity) {
+            std::size_t n = 2;
+            while (n < capacity) n <<= 1;
+            m_mask = n - 1;
+            m_cells.reset(new Cell[n]);
+            for (std::size_t k = 0; k < n; ++k) m_cells[k].seq.store(k, std::memory_order_relaxed);
+        }
+
+        IngestQueue(const IngestQueue&) = delete;
+        IngestQueue& operator=(const IngestQueue&) = delete;
+
+        std::size_t capacity() const { return m_mask + 1; }
+
+        // Notified after every push, so the consumer can sleep while the
+        // queue is empty. Set it before producers start.
+        void set_wake(WakeSignal* wake) { m_wake = wake; }
+
+        // Wakes the consumer without a push, e.g. for a request that is not
+        // a tag write.
+        void wake() const {
+            if (m_wake) m_wake->notify();
+        }
+
+        bool try_push(TagId id, const Value& value, Quality quality = Quality::Good, std::int64_t timestamp = 0) {
+            Cell* cell = claim();
+            if (!cell) return false;
+            cell->update.id = id;
+            cell->update.value = value;
+            cell->update.quality = quality;
+            cell->update.timestamp = timestamp;
+            publish(cell);
+            wake();
+            return true;
+        }
+
+        bool try_push(TagId id, Value&& value, Quality quality = Quality::Good, std::int64_t timestamp = 0) {
+            Cell* cell = claim();
+            if (!cell) return false;
+            cell->update.id = id;
+            cell->update.value = std::move(value);
+            cell->update.quality = quality;
+            cell->update.timestamp = timestamp;
+            publish(cell);
+            wake();
+            return true;
+        }
+
+        void push(TagId id, const Value& value, Quality quality = Quality::Good, std::int64_t timestamp = 0) {
+            while (!try_push(id, value, quality, timestamp)) std::this_thread::yield();
+        }
+
+        // Consumer side; a hint only, as producers may push right after.
+        bool empty() const {
+            return m_cells[m_head & m_mask].seq.load(std::memory_order_acquire) != m_head + 1;
+        }
+
+        // Consumer side; must only be called from one thread.
+        bool try_pop(TagUpdate& out) {
+            Cell& cell = m_cells[m_head & m_mask];
+            const std::size_t seq = cell.seq.load(std::memory_order_acquire);
+            if (seq != m_head + 1) return false;
+
+            out.id = cell.update.id;
+            out.value = std::move(cell.update.value);
+            out.quality = cell.update.quality;
+            out.timestamp = cell.update.timestamp;
+            cell.seq.store(m_head + m_mask + 1, std::memory_order_release);
+            ++m_head;
+            return true;
+        }
+
+        // Applies up to maxItems queued updates as one batch, so each changed
+        // tag notifies its subscribers once per drain.
+        std::size_t drain(VariableStore& store, std::size_t maxItems = static_cast<std::size_t>(-1)) {
+            std::size_t n = 0;
+            TagUpdate u;
+            const std::int64_t now = now_ms();
+            UpdateBatch batch(store);
+            while (n < maxItems && try_pop(u)) {
+                if (store.valid(u.id)) store.set(u.id, u.value, u.quality, u.timestamp != 0 ? u.timestamp : now);
+                ++n;
+            }
+            return n;
+        }
+
+    private:
+        struct Cell {
+            std::atomic<std::size_t> seq{ 0 };
+            TagUpdate update;
+        };
+
+        Cell* claim() {
+            std::size_t pos = m_tail.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell* cell = &m_cells[pos & m_mask];
+                const std::size_t seq = cell->seq.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+                if (diff == 0) {
+                    if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return cell;
+                }
+                else if (diff < 0) {
+                    return nullptr;
+                }
+                else {
+                    pos = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void publish(Cell* cell) {
+            const std::size_t pos = cell->seq.load(std::memory_order_relaxed);
+            cell->seq.store(pos + 1, std::memory_order_release);
+        }
+
+        std::unique_ptr<Cell[]> m_cells;
+        std::size_t m_mask{ 0 };
+        WakeSignal* m_wake{ nullptr };
+
+        alignas(64) std::atomic<std::size_t> m_tail{ 0 };
+        alignas(64) std::size_t m_head{ 0 };
+    };
+
+}
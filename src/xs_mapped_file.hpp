@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace xs::core {
+
+    // Read-only memory mapping of a whole file. An empty file opens
+    // successfully with size() == 0 and no mapping.
+    class MappedFile final {
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::string& path) { open(path); }
+        ~MappedFile() { close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept { swap(other); }
+        MappedFile& operator=(MappedFile&& other) noexcept {
+            if (this != &other) {
+                close();
+                swap(other);
+            }
+            return *this;
+        }
+
+        bool open(const std::string& path) {
+            close();
+#ifdef _WIN32
+            HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) return false;
+
+            LARGE_INTEGER size{};
+            if (!GetFileSizeEx(file, &size)) { CloseHandle(file); return false; }
+            m_open = true;
+            m_size = static_cast<std::size_t>(size.QuadPart);
+            if (m_size == 0) { CloseHandle(file); return true; }
+
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            CloseHandle(file);
+            if (!mapping) { close(); return false; }
+            m_data = static_cast<const std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            CloseHandle(mapping);
+            if (!m_data) { close(); return false; }
+#else
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) return false;
+
+            struct stat st {};
+            if (::fstat(fd, &st) != 0) { ::close(fd); return false; }
+            m_open = true;
+            m_size = static_cast<std::size_t>(st.st_size);
+            if (m_size == 0) { ::close(fd); return true; }
+
+            void* p = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (p == MAP_FAILED) { close(); return false; }
+            m_data = static_cast<const std::uint8_t*>(p);
+#endif
+            return true;
+        }
+
+        void close() {
+            if (m_data) {
+#ifdef _WIN32
+                UnmapViewOfFile(m_data);
+#else
+                ::munmap(const_cast<std::uint8_t*>(m_data), m_size);
+#endif
+            }
+            m_data = nullptr;
+            m_size = 0;
+            m_open = false;
+        }
+
+        bool is_open() const { return m_open; }
+        const std::uint8_t* data() const { return m_data; }
+        std::size_t size() const { return m_size; }
+
+    private:
+        void swap(MappedFile& other) noexcept {
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+            std::swap(m_open, other.m_open);
+        }
+
+        const std::uint8_t* m_data{ nullptr };
+        std::size_t m_size{ 0 };
+        bool m_open{ false };
+    };
+
+}
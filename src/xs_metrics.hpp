@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// Build with -DXS_METRICS=0 to compile the counters out entirely.
+#ifndef XS_METRICS
+#define XS_METRICS 1
+#endif
+
+namespace xs::core {
+
+    inline constexpr bool metrics_compiled = XS_METRICS != 0;
+
+    enum class Phase : std::uint8_t { Events, Ingest, Logic, Update, Draw, Display, Count };
+
+    inline constexpr std::size_t phase_count = static_cast<std::size_t>(Phase::Count);
+    inline constexpr const char* phase_names[phase_count] = { "events", "ingest", "logic", "update", "draw", "display" };
+
+    // Counters for the thread that owns the store and the widgets. They are
+    // only touched while 'enabled' is set, so with metrics off a notify, set
+    // or get pays a single branch.
+    struct Metrics {
+        bool enabled{ false };
+        std::uint32_t depth{ 0 };
+        std::uint32_t maxDepth{ 0 };
+        std::uint64_t notifies{ 0 };
+        std::uint64_t callbacks{ 0 };
+        std::uint64_t sets{ 0 };
+        std::uint64_t gets{ 0 };
+        std::uint64_t phaseNs[phase_count]{};
+    };
+
+    inline Metrics& metrics() {
+        thread_local Metrics m;
+        return m;
+    }
+
+    inline bool metrics_enabled() {
+        if constexpr (metrics_compiled) return metrics().enabled;
+        else return false;
+    }
+
+    // Adds the time until the end of the scope to one main loop phase.
+    class PhaseTimer final {
+    public:
+        explicit PhaseTimer(Phase phase) : m_phase(phase), m_on(metrics_enabled()) {
+            if (m_on) m_start = std::chrono::steady_clock::now();
+        }
+
+        ~PhaseTimer() {
+            if (!m_on) return;
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - m_start).count();
+            metrics().phaseNs[static_cast<std::size_t>(m_phase)] += static_cast<std::uint64_t>(ns);
+        }
+
+        PhaseTimer(const PhaseTimer&) = delete;
+        PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    private:
+        Phase m_phase;
+        bool m_on;
+        std::chrono::steady_clock::time_point m_start{};
+    };
+
+    // Turns the counters into rates once per interval and optionally appends
+    // every sample to a CSV file. Frame and draw call counts come from the
+    // caller as running totals.
+    class MetricsSampler final {
+    public:
+        struct Sample {
+            std::int64_t time{ 0 };
+            double seconds{ 0.0 };
+            double fps{ 0.0 };
+            double notifiesPerSec{ 0.0 };
+            double callbacksPerSec{ 0.0 };
+            double setsPerSec{ 0.0 };
+            double getsPerSec{ 0.0 };
+            double drawCallsPerFrame{ 0.0 };
+            std::uint32_t maxDepth{ 0 };
+            std::size_t tags{ 0 };
+            double phaseMs[phase_count]{};  // average per frame
+        };
+
+        explicit MetricsSampler(std::int64_t intervalMs = 1000) : m_interval(intervalMs) {}
+
+        bool open_csv(const std::string& path) {
+            m_csv.open(path, std::ios::out | std::ios::trunc);
+            if (!m_csv) return false;
+            m_csv << "time_ms,fps,notifies_per_s,callbacks_per_s,max_depth,sets_per_s,gets_per_s,tags,draw_calls_per_frame";
+            for (const char* name : phase_names) m_csv << ',' << name << "_ms";
+            m_csv << '\n';
+            return true;
+        }
+
+        bool logging() const { return m_csv.is_open(); }
+
+        // When tick() next takes a sample; 0 before the first tick.
+        std::int64_t next_due() const { return m_started ? m_since + m_interval : 0; }
+
+        // Returns true when a new sample was taken.
+        bool tick(std::int64_t now, std::size_t tags, std::uint64_t frames, std::uint64_t drawCalls) {
+            Metrics& m = metrics();
+            if (!m_started) {
+                restart(now, frames, drawCalls);
+                return false;
+            }
+            if (now - m_since < m_interval) return false;
+
+            const double secs = static_cast<double>(now - m_since) / 1000.0;
+            const double frameCount = static_cast<double>(frames - m_frames);
+            const double perFrame = frameCount > 0.0 ? 1.0 / frameCount : 0.0;
+            Sample& s = m_last;
+            s.time = now;
+            s.seconds = secs;
+            s.fps = frameCount / secs;
+            s.notifiesPerSec = static_cast<double>(m.notifies - m_base.notifies) / secs;
+            s.callbacksPerSec = static_cast<double>(m.callbacks - m_base.callbacks) / secs;
+            s.setsPerSec = static_cast<double>(m.sets - m_base.sets) / secs;
+            s.getsPerSec = static_cast<double>(m.gets - m_base.gets) / secs;
+            s.drawCallsPerFrame = static_cast<double>(drawCalls - m_drawCalls) * perFrame;
+            s.maxDepth = m.maxDepth;
+            s.tags = tags;
+            for (std::size_t k = 0; k < phase_count; ++k) {
+                s.phaseMs[k] = static_cast<double>(m.phaseNs[k] - m_base.phaseNs[k]) / 1e6 * perFrame;
+            }
+            if (m_csv.is_open()) write(s);
+
+            restart(now, frames, drawCalls);
+            return true;
+        }
+
+        const Sample& last() const { return m_last; }
+
+    private:
+        void restart(std::int64_t now, std::uint64_t frames, std::uint64_t drawCalls) {
+            Metrics& m = metrics();
+            m.maxDepth = m.depth;
+            m_base = m;
+            m_since = now;
+            m_frames = frames;
+            m_drawCalls = drawCalls;
+            m_started = true;
+        }
+
+        void write(const Sample& s) {
+            m_csv << s.time << ',' << s.fps << ',' << s.notifiesPerSec << ',' << s.callbacksPerSec << ','
+                << s.maxDepth << ',' << s.setsPerSec << ',' << s.getsPerSec << ',' << s.tags << ','
+                << s.drawCallsPerFrame;
+            for (double ms : s.phaseMs) m_csv << ',' << ms;
+            m_csv << '\n';
+            m_csv.flush();
+        }
+
+        std::int64_t m_interval;
+        std::ofstream m_csv;
+        Sample m_last;
+        Metrics m_base;
+        std::int64_t m_since{ 0 };
+        std::uint64_t m_frames{ 0 };
+        std::uint64_t m_drawCalls{ 0 };
+        bool m_started{ false };
+    };
+
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "xs_core.hpp"
+
+// Binary protocol for local clients of the tag server (xs_server.hpp).
+// Both ends run on the same machine, so integers are in host byte order.
+//
+// Every frame starts with a FrameHeader whose length covers the whole frame.
+// Requests carry a client-chosen id that the reply repeats; replies set
+// reply_flag in the op and may arrive out of order. Payloads:
+//
+//   Resolve      u8 create, u32 n, n x (u16 length, name)
+//       reply    u32 n, n x u32 handle (invalid_tag if unknown)
+//   Read         u32 n, n x u32 handle
+//       reply    u32 n, n x value
+//   Write        u32 n, n x (u32 handle, value); no reply if the id is 0
+//       reply    u32 accepted
+//   Subscribe    f64 deadband, u32 n, n x u32 handle
+//       reply    u32 n
+//   Unsubscribe  u32 n, n x u32 handle
+//       reply    u32 n
+//   Update       (server push, id 0) u32 n, n x (u32 handle, value)
+//   Error        (reply) u16 length, message
+//
+// A value is a u8 Value::Type followed by 8 bytes (an int64 for Int, Bool
+// and Int64, a double for Float and Double) or, for String, a u32 length and
+// the text. Type missing_value has no payload.
+namespace xs::core::protocol {
+
+    enum class Op : std::uint8_t {
+        Resolve = 1,
+        Read = 2,
+        Write = 3,
+        Subscribe = 4,
+        Unsubscribe = 5,
+        Update = 16,
+        Error = 17,
+    };
+
+    inline constexpr std::uint8_t reply_flag = 0x80;
+    inline constexpr std::uint8_t missing_value = 0xFF;
+    inline constexpr std::uint32_t max_frame = 16u << 20;
+
+    struct FrameHeader {
+        std::uint32_t length;
+        std::uint8_t op;
+        std::uint8_t reserved[3];
+        std::uint32_t request;
+    };
+
+    static_assert(sizeof(FrameHeader) == 12, "frame header is part of the wire format");
+
+    inline std::uint8_t reply_op(Op op) { return static_cast<std::uint8_t>(op) | reply_flag; }
+
+    // Appends one frame to a byte buffer; end() patches the length.
+    class FrameWriter final {
+    public:
+        explicit FrameWriter(std::vector<std::uint8_t>& out) : m_out(out) {}
+
+        void begin(std::uint8_t op, std::uint32_t request) {
+            m_start = m_out.size();
+            FrameHeader h{};
+            h.op = op;
+            h.request = request;
+            put(&h, sizeof(h));
+        }
+
+        void end() {
+            const auto length = static_cast<std::uint32_t>(m_out.size() - m_start);
+            std::memcpy(m_out.data() + m_start, &length, sizeof(length));
+        }
+
+        void u8(std::uint8_t v) { m_out.push_back(v); }
+        void u16(std::uint16_t v) { put(&v, sizeof(v)); }
+        void u32(std::uint32_t v) { put(&v, sizeof(v)); }
+        void f64(double v) { put(&v, sizeof(v)); }
+
+        void text16(std::string_view s) {
+            u16(static_cast<std::uint16_t>(s.size()));
+            put(s.data(), s.size());
+        }
+
+        void value(const Value& v) {
+            u8(static_cast<std::uint8_t>(v.type()));
+            std::int64_t i = 0;
+            switch (v.type()) {
+            case Value::Type::Int:    i = v.as_int(); break;
+            case Value::Type::Bool:   i = v.as_bool() ? 1 : 0; break;
+            case Value::Type::Int64:  i = v.as_int64(); break;
+            case Value::Type::Float:  f64(v.as_float()); return;
+            case Value::Type::Double: f64(v.as_double()); return;
+            case Value::Type::String: {
+                const std::string_view s = v.as_string();
+                u32(static_cast<std::uint32_t>(s.size()));
+                put(s.data(), s.size());
+                return;
+            }
+            }
+            put(&i, sizeof(i));
+        }
+
+        void missing() { u8(missing_value); }
+
+        // Bytes written since begin(), header included.
+        std::size_t size() const { return m_out.size() - m_start; }
+
+    private:
+        void put(const void* p, std::size_t n) {
+            const auto* b = static_cast<const std::uint8_t*>(p);
+            m_out.insert(m_out.end(), b, b + n);
+        }
+
+        std::vector<std::uint8_t>& m_out;
+        std::size_t m_start{ 0 };
+    };
+
+    // Bounds-checked reader over one frame's payload. Every accessor returns
+    // false once the payload is exhausted; the value out-parameter is then
+    // left unspecified.
+    class FrameReader final {
+    public:
+        FrameReader(const std::uint8_t* data, std::size_t size) : m_data(data), m_size(size) {}
+
+        bool u8(std::uint8_t& v) { return get(&v, sizeof(v)); }
+        bool u16(std::uint16_t& v) { return get(&v, sizeof(v)); }
+        bool u32(std::uint32_t& v) { return get(&v, sizeof(v)); }
+        bool f64(double& v) { return get(&v, sizeof(v)); }
+
+        bool text16(std::string_view& s) {
+            std::uint16_t n = 0;
+            if (!u16(n) || n > m_size - m_pos) return false;
+            s = std::string_view(reinterpret_cast<const char*>(m_data + m_pos), n);
+            m_pos += n;
+            return true;
+        }
+
+        // A missing value reads as present == false.
+        bool value(Value& v, bool& present) {
+            std::uint8_t type = 0;
+            if (!u8(type)) return false;
+            present = type != missing_value;
+            if (!present) return true;
+
+            switch (static_cast<Value::Type>(type)) {
+            case Value::Type::Int:
+            case Value::Type::Bool:
+            case Value::Type::Int64: {
+                std::int64_t i = 0;
+                if (!get(&i, sizeof(i))) return false;
+                if (type == static_cast<std::uint8_t>(Value::Type::Int)) v = Value::make_int(static_cast<int>(i));
+                else if (type == static_cast<std::uint8_t>(Value::Type::Bool)) v = Value::make_bool(i != 0);
+                else v = Value::make_int64(i);
+                return true;
+            }
+            case Value::Type::Float:
+            case Value::Type::Double: {
+                double d = 0.0;
+                if (!f64(d)) return false;
+                v = type == static_cast<std::uint8_t>(Value::Type::Float) ? Value::make_float(static_cast<float>(d)) : Value::make_double(d);
+                return true;
+            }
+            case Value::Type::String: {
+                std::uint32_t n = 0;
+                if (!u32(n) || n > m_size - m_pos) return false;
+                v = Value::make_string(std::string_view(reinterpret_cast<const char*>(m_data + m_pos), n));
+                m_pos += n;
+                return true;
+            }
+            }
+            return false;
+        }
+
+        // Guards count-prefixed lists against counts the payload cannot hold.
+        bool fits(std::uint32_t count, std::size_t minBytesEach) const {
+            return static_cast<std::uint64_t>(count) * minBytesEach <= m_size - m_pos;
+        }
+
+        bool done() const { return m_pos == m_size; }
+
+    private:
+        bool get(void* p, std::size_t n) {
+            if (n > m_size - m_pos) return false;
+            std::memcpy(p, m_data + m_pos, n);
+            m_pos += n;
+            return true;
+        }
+
+        const std::uint8_t* m_data;
+        std::size_t m_size;
+        std::size_t m_pos{ 0 };
+    };
+
+    // Splits the frames at the front of a receive buffer. Returns the length
+    // of the first complete frame, 0 if more bytes are needed, or -1 if the
+    // stream is corrupt.
+    inline long next_frame(const std::uint8_t* data, std::size_t size) {
+        if (size < sizeof(std::uint32_t)) return 0;
+        std::uint32_t length = 0;
+        std::memcpy(&length, data, sizeof(length));
+        if (length < sizeof(FrameHeader) || length > max_frame) return -1;
+        return length <= size ? static_cast<long>(length) : 0;
+    }
+
+    inline FrameHeader frame_header(const std::uint8_t* frame) {
+        FrameHeader h;
+        std::memcpy(&h, frame, sizeof(h));
+        return h;
+    }
+
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "xs_core.hpp"
+#include "xs_ingest.hpp"
+
+// Build with -DXS_SIMD=0 to use the scalar kernels everywhere.
+#ifndef XS_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XS_SIMD 1
+#else
+#define XS_SIMD 0
+#endif
+#endif
+
+#if XS_SIMD
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace xs::core {
+
+    inline constexpr bool simd_compiled = XS_SIMD != 0;
+
+    // Engineering value of one raw register: raw * gain + offset, clamped to
+    // [lo, hi]. It is written to the tag only once it has moved more than
+    // deadband away from the value written last.
+    struct RegisterScale {
+        TagId tag{ invalid_tag };
+        float gain{ 1.f };
+        float offset{ 0.f };
+        float lo{ -std::numeric_limits<float>::max() };
+        float hi{ std::numeric_limits<float>::max() };
+        float deadband{ 0.f };
+    };
+
+    inline std::size_t mask_words(std::size_t registers) { return (registers + 63) / 64; }
+
+    namespace detail {
+
+        inline unsigned lowest_bit(std::uint64_t w) {
+#ifdef _MSC_VER
+            unsigned long k = 0;
+            _BitScanForward64(&k, w);
+            return static_cast<unsigned>(k);
+#else
+            return static_cast<unsigned>(__builtin_ctzll(w));
+#endif
+        }
+
+        // Clamping is written so a NaN input ends up at lo in both kernels,
+        // matching what the SSE min/max instructions do. A NaN last value
+        // (never written) always counts as a change.
+        inline bool scale_one(float x, float gain, float offset, float lo, float hi, float deadband, float& last, float& out) {
+            float y = x * gain + offset;
+            y = y > lo ? y : lo;
+            y = y < hi ? y : hi;
+            out = y;
+            if (std::fabs(y - last) <= deadband) return false;
+            last = y;
+            return true;
+        }
+
+#if XS_SIMD
+        inline __m128 load4(const std::int16_t* p) {
+            const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+            return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+        }
+
+        inline __m128 load4(const std::uint16_t* p) {
+            const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+            return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, _mm_setzero_si128()));
+        }
+
+        inline __m128 load4(const float* p) { return _mm_loadu_ps(p); }
+#endif
+
+    }
+
+    // Scaling for one register block, register k at entry k, compiled into
+    // one array per parameter so the kernel loads four registers at a time.
+    // The table remembers the last value written per register and owns the
+    // buffers of the last scale(), so use one table per block and thread.
+    // Raw may be std::int16_t, std::uint16_t or float.
+    class ScaleTable final {
+    public:
+        ScaleTable() = default;
+
+        explicit ScaleTable(const std::vector<RegisterScale>& registers) {
+            for (const RegisterScale& r : registers) add(r);
+        }
+
+        void add(const RegisterScale& r) {
+            m_tags.push_back(r.tag);
+            m_gain.push_back(r.gain);
+            m_offset.push_back(r.offset);
+            m_lo.push_back(r.lo);
+            m_hi.push_back(r.hi);
+            m_deadband.push_back(r.deadband);
+            m_last.push_back(std::numeric_limits<float>::quiet_NaN());
+        }
+
+        std::size_t size() const { return m_tags.size(); }
+        TagId tag(std::size_t k) const { return m_tags[k]; }
+        float last(std::size_t k) const { return m_last[k]; }
+
+        // Forgets the last values, so the next block writes every register.
+        // Call it after a failed read, once the tags have been marked.
+        void reset() { std::fill(m_last.begin(), m_last.end(), std::numeric_limits<float>::quiet_NaN()); }
+
+        // Writes the scaled value of each of the first count registers to
+        // scaled, sets bit k of changed (mask_words(count) words) for every
+        // register that moved past its deadband, and records those as the
+        // last values written. Returns the number of changed registers.
+        template <typename Raw>
+        std::size_t scale(const Raw* raw, std::size_t count, float* scaled, std::uint64_t* changed) {
+            count = std::min(count, size());
+            std::fill(changed, changed + mask_words(count), std::uint64_t{ 0 });
+            std::size_t k = 0;
+            std::size_t n = 0;
+#if XS_SIMD
+            const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+            for (; k + 4 <= count; k += 4) {
+                __m128 y = _mm_add_ps(_mm_mul_ps(detail::load4(raw + k), _mm_loadu_ps(&m_gain[k])), _mm_loadu_ps(&m_offset[k]));
+                y = _mm_min_ps(_mm_max_ps(y, _mm_loadu_ps(&m_lo[k])), _mm_loadu_ps(&m_hi[k]));
+                _mm_storeu_ps(scaled + k, y);
+
+                // NaN compares false, so an unwritten register is a change.
+                const __m128 last = _mm_loadu_ps(&m_last[k]);
+                const __m128 diff = _mm_and_ps(_mm_sub_ps(y, last), absMask);
+                const __m128 moved = _mm_cmpnle_ps(diff, _mm_loadu_ps(&m_deadband[k]));
+                const int bits = _mm_movemask_ps(moved);
+                if (bits == 0) continue;
+                _mm_storeu_ps(&m_last[k], _mm_or_ps(_mm_and_ps(moved, y), _mm_andnot_ps(moved, last)));
+                changed[k / 64] |= static_cast<std::uint64_t>(bits) << (k % 64);
+                n += static_cast<std::size_t>((bits & 1) + ((bits >> 1) & 1) + ((bits >> 2) & 1) + ((bits >> 3) & 1));
+            }
+#endif
+            return n + scale_range(raw, k, count, scaled, changed);
+        }
+
+        // Reference kernel with the same contract as scale().
+        template <typename Raw>
+        std::size_t scale_scalar(const Raw* raw, std::size_t count, float* scaled, std::uint64_t* changed) {
+            count = std::min(count, size());
+            std::fill(changed, changed + mask_words(count), std::uint64_t{ 0 });
+            return scale_range(raw, 0, count, scaled, changed);
+        }
+
+        // Scales into the table's own buffers; see scaled() and for_each_changed().
+        template <typename Raw>
+        std::size_t scale(const Raw* raw, std::size_t count) {
+            count = std::min(count, size());
+            m_scaled.resize(count);
+            m_changed.resize(mask_words(count));
+            return scale(raw, count, m_scaled.data(), m_changed.data());
+        }
+
+        float scaled(std::size_t k) const { return m_scaled[k]; }
+
+        // Calls fn(k) for every register the last scale() marked changed.
+        template <typename Fn>
+        void for_each_changed(Fn&& fn) const {
+            for (std::size_t w = 0; w < m_changed.size(); ++w) {
+                for (std::uint64_t bits = m_changed[w]; bits != 0; bits &= bits - 1) fn(w * 64 + detail::lowest_bit(bits));
+            }
+        }
+
+    private:
+        template <typename Raw>
+        std::size_t scale_range(const Raw* raw, std::size_t k, std::size_t count, float* scaled, std::uint64_t* changed) {
+            std::size_t n = 0;
+            for (; k < count; ++k) {
+                if (detail::scale_one(static_cast<float>(raw[k]), m_gain[k], m_offset[k], m_lo[k], m_hi[k], m_deadband[k], m_last[k], scaled[k])) {
+                    changed[k / 64] |= std::uint64_t{ 1 } << (k % 64);
+                    ++n;
+                }
+            }
+            return n;
+        }
+
+        std::vector<TagId> m_tags;
+        std::vector<float> m_gain;
+        std::vector<float> m_offset;
+        std::vector<float> m_lo;
+        std::vector<float> m_hi;
+        std::vector<float> m_deadband;
+        std::vector<float> m_last;
+
+        std::vector<float> m_scaled;
+        std::vector<std::uint64_t> m_changed;
+    };
+
+    // Scales a block read from a device and writes the changed registers to
+    // their tags as Float with Good quality, in one batch. A timestamp of 0
+    // means now. UI thread only; I/O threads use push_block().
+    template <typename Raw>
+    std::size_t apply_block(VariableStore& store, ScaleTable& t, const Raw* raw, std::size_t count, std::int64_t timestamp = 0) {
+        const std::size_t n = t.scale(raw, count);
+        if (n == 0) return 0;
+
+        const std::int64_t stamp = timestamp != 0 ? timestamp : now_ms();
+        UpdateBatch batch(store);
+        t.for_each_changed([&](std::size_t k) {
+            const TagId id = t.tag(k);
+            if (store.valid(id)) store.set(id, Value::make_float(t.scaled(k)), Quality::Good, stamp);
+        });
+        return n;
+    }
+
+    // Same as apply_block(), from a driver thread: only the changed registers
+    // are queued, and drain() stamps them if timestamp is 0.
+    template <typename Raw>
+    std::size_t push_block(IngestQueue& queue, ScaleTable& t, const Raw* raw, std::size_t count, std::int64_t timestamp = 0) {
+        const std::size_t n = t.scale(raw, count);
+        t.for_each_changed([&](std::size_t k) {
+            queue.push(t.tag(k), Value::make_float(t.scaled(k)), Quality::Good, timestamp);
+        });
+        return n;
+    }
+
+}
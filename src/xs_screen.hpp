@@ -0,0 +1,506 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "xs_core.hpp"
+#include "xs_expr.hpp"
+#include "xs_mapped_file.hpp"
+
+namespace xs::core {
+
+    // Screens are authored as text (one element per line) and can be compiled
+    // to a binary image: a header, fixed-size tag, expression and widget
+    // records and a string pool. Records are 8-byte aligned and strings are referenced by
+    // offset, so a compiled screen is used straight from a memory mapping.
+    //
+    //   screen 760 420
+    //   tag temperature float 23.5
+    //   expr temperature.f = temperature * 1.8 + 32
+    //   panel 20 20 720 380
+    //     label 40 85 size=18 prefix="Temperature:" bind=temperature
+    //     button 240 78 220 42 caption="Toggle pump" toggle=pump.enabled
+    //     button 240 138 220 42 caption="+0.25" step=temperature by=0.25
+    //     textfield 240 205 320 42 hint="Type name..." bind=operator.name
+    //     trend 480 78 240 102 span=120000 bind=temperature id=tempTrend
+    //   end
+
+    enum class WidgetKind : std::uint8_t { Panel, Label, Button, TextField, Trend };
+    enum class ButtonAction : std::uint8_t { None, Toggle, Step };
+
+    struct StrRef {
+        std::uint32_t offset{ 0 };
+        std::uint32_t length{ 0 };
+    };
+
+    struct ScreenHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t width;
+        std::uint32_t height;
+        std::uint32_t tagCount;
+        std::uint32_t widgetCount;
+        std::uint32_t exprCount;
+        std::uint32_t stringBytes;
+        std::uint32_t reserved;
+    };
+
+    struct TagRecord {
+        StrRef name;
+        StrRef text;
+        Value::Type type;
+        std::uint8_t reserved[7];
+        std::int64_t bits;
+    };
+
+    struct ExprRecord {
+        StrRef target;
+        StrRef source;
+    };
+
+    struct WidgetRecord {
+        WidgetKind kind;
+        std::uint8_t charSize;
+        ButtonAction action;
+        std::uint8_t reserved;
+        std::uint32_t parent;
+        float x, y, w, h;
+        float param;
+        StrRef id;
+        StrRef text;
+        StrRef prefix;
+        StrRef bind;
+        std::uint32_t reserved2;
+    };
+
+    static_assert(sizeof(ScreenHeader) % 8 == 0, "screen records must stay 8-byte aligned");
+    static_assert(sizeof(TagRecord) % 8 == 0, "screen records must stay 8-byte aligned");
+    static_assert(sizeof(ExprRecord) % 8 == 0, "screen records must stay 8-byte aligned");
+    static_assert(sizeof(WidgetRecord) % 8 == 0, "screen records must stay 8-byte aligned");
+
+    inline constexpr char screen_magic[8] = { 'X', 'S', 'S', 'C', 'R', 'N', '0', '1' };
+    inline constexpr std::uint32_t screen_version = 2;
+    inline constexpr std::uint32_t no_parent = 0xFFFFFFFFu;
+
+    // Read-only view over a compiled screen image.
+    class ScreenImage final {
+    public:
+        bool open(const std::uint8_t* data, std::size_t size) {
+            m_data = nullptr;
+            if (size < sizeof(ScreenHeader)) return false;
+            std::memcpy(&m_header, data, sizeof(m_header));
+            if (std::memcmp(m_header.magic, screen_magic, sizeof(screen_magic)) != 0) return false;
+            if (m_header.version != screen_version) return false;
+
+            m_tags = sizeof(ScreenHeader);
+            m_exprs = m_tags + static_cast<std::size_t>(m_header.tagCount) * sizeof(TagRecord);
+            m_widgets = m_exprs + static_cast<std::size_t>(m_header.exprCount) * sizeof(ExprRecord);
+            m_strings = m_widgets + static_cast<std::size_t>(m_header.widgetCount) * sizeof(WidgetRecord);
+            if (m_strings + m_header.stringBytes > size) return false;
+
+            m_data = data;
+            return true;
+        }
+
+        bool valid() const { return m_data != nullptr; }
+        const ScreenHeader& header() const { return m_header; }
+        std::size_t tag_count() const { return m_header.tagCount; }
+        std::size_t widget_count() const { return m_header.widgetCount; }
+        std::size_t expr_count() const { return m_header.exprCount; }
+
+        TagRecord tag(std::size_t k) const { return load<TagRecord>(m_tags + k * sizeof(TagRecord)); }
+        ExprRecord expr(std::size_t k) const { return load<ExprRecord>(m_exprs + k * sizeof(ExprRecord)); }
+        WidgetRecord widget(std::size_t k) const { return load<WidgetRecord>(m_widgets + k * sizeof(WidgetRecord)); }
+
+        std::string_view str(const StrRef& r) const {
+            if (r.offset + static_cast<std::size_t>(r.length) > m_header.stringBytes) return {};
+            return std::string_view(reinterpret_cast<const char*>(m_data + m_strings + r.offset), r.length);
+        }
+
+        Value initial_value(const TagRecord& t) const {
+            switch (t.type) {
+            case Value::Type::Int:    return Value::make_int(static_cast<int>(t.bits));
+            case Value::Type::Bool:   return Value::make_bool(t.bits != 0);
+            case Value::Type::Int64:  return Value::make_int64(t.bits);
+            case Value::Type::String: return Value::make_string(str(t.text));
+            case Value::Type::Float: {
+                float f; std::memcpy(&f, &t.bits, sizeof(f)); return Value::make_float(f);
+            }
+            case Value::Type::Double: {
+                double d; std::memcpy(&d, &t.bits, sizeof(d)); return Value::make_double(d);
+            }
+            default:                  return Value();
+            }
+        }
+
+        // Pre-creates every declared tag with its initial value.
+        void create_tags(VariableStore& store) const {
+            for (std::size_t k = 0; k < tag_count(); ++k) {
+                const TagRecord t = tag(k);
+                store.ensure_tag(std::string(str(t.name)), initial_value(t));
+            }
+        }
+
+        bool define_expressions(ExpressionEngine& engine, std::string& error) const {
+            for (std::size_t k = 0; k < expr_count(); ++k) {
+                const ExprRecord e = expr(k);
+                if (!engine.define(std::string(str(e.target)), str(e.source), error)) return false;
+            }
+            return true;
+        }
+
+    private:
+        template <typename T>
+        T load(std::size_t offset) const {
+            T v;
+            std::memcpy(&v, m_data + offset, sizeof(T));
+            return v;
+        }
+
+        const std::uint8_t* m_data{ nullptr };
+        ScreenHeader m_header{};
+        std::size_t m_tags{ 0 };
+        std::size_t m_exprs{ 0 };
+        std::size_t m_widgets{ 0 };
+        std::size_t m_strings{ 0 };
+    };
+
+    class ScreenCompiler final {
+    public:
+        bool compile(std::string_view source, std::vector<std::uint8_t>& out, std::string& error) {
+            *this = ScreenCompiler();
+
+            std::size_t lineNo = 0;
+            std::size_t pos = 0;
+            while (pos <= source.size()) {
+                std::size_t end = source.find('\n', pos);
+                if (end == std::string_view::npos) end = source.size();
+                ++lineNo;
+                if (!parse_line(source.substr(pos, end - pos))) {
+                    error = "line " + std::to_string(lineNo) + ": " + m_error;
+                    return false;
+                }
+                pos = end + 1;
+            }
+            if (!m_open.empty()) {
+                error = "missing 'end' for panel";
+                return false;
+            }
+            if (m_widgets.empty()) {
+                error = "screen has no panel";
+                return false;
+            }
+
+            emit(out);
+            return true;
+        }
+
+    private:
+        struct Token {
+            std::string key;
+            std::string value;
+        };
+
+        bool fail(std::string message) {
+            m_error = std::move(message);
+            return false;
+        }
+
+        static bool tokenize(std::string_view line, std::vector<Token>& out) {
+            std::size_t k = 0;
+            while (k < line.size()) {
+                while (k < line.size() && (line[k] == ' ' || line[k] == '\t' || line[k] == '\r')) ++k;
+                if (k >= line.size() || line[k] == '#') break;
+
+                Token t;
+                std::string* dst = &t.value;
+                while (k < line.size() && line[k] != ' ' && line[k] != '\t' && line[k] != '\r') {
+                    const char c = line[k];
+                    if (c == '=' && dst == &t.value && t.key.empty()) {
+                        t.key = std::move(t.value);
+                        t.value.clear();
+                        ++k;
+                    }
+                    else if (c == '"') {
+                        ++k;
+                        while (k < line.size() && line[k] != '"') {
+                            if (line[k] == '\\' && k + 1 < line.size()) ++k;
+                            dst->push_back(line[k++]);
+                        }
+                        if (k >= line.size()) return false;
+                        ++k;
+                    }
+                    else {
+                        dst->push_back(c);
+                        ++k;
+                    }
+                }
+                out.push_back(std::move(t));
+            }
+            return true;
+        }
+
+        static bool to_float(const std::string& s, float& out) {
+            char* end = nullptr;
+            out = std::strtof(s.c_str(), &end);
+            return !s.empty() && end == s.c_str() + s.size();
+        }
+
+        StrRef intern(const std::string& s) {
+            if (s.empty()) return StrRef{};
+            auto it = m_interned.find(s);
+            if (it != m_interned.end()) return it->second;
+            const StrRef r{ static_cast<std::uint32_t>(m_strings.size()), static_cast<std::uint32_t>(s.size()) };
+            m_strings.insert(m_strings.end(), s.begin(), s.end());
+            m_interned.emplace(s, r);
+            return r;
+        }
+
+        bool parse_line(std::string_view line) {
+            std::vector<Token> tokens;
+            if (!tokenize(line, tokens)) return fail("unterminated string");
+            if (tokens.empty()) return true;
+
+            const std::string& cmd = tokens[0].value;
+            if (cmd == "screen") return parse_screen(tokens);
+            if (cmd == "tag") return parse_tag(tokens);
+            if (cmd == "expr") return parse_expr(line);
+            if (cmd == "end") {
+                if (m_open.empty()) return fail("'end' without panel");
+                m_open.pop_back();
+                return true;
+            }
+
+            WidgetRecord w{};
+            w.parent = m_open.empty() ? no_parent : m_open.back();
+            w.charSize = 18;
+
+            std::size_t geometry = 2;
+            if (cmd == "panel") { w.kind = WidgetKind::Panel; geometry = 4; }
+            else if (cmd == "label") { w.kind = WidgetKind::Label; }
+            else if (cmd == "button") { w.kind = WidgetKind::Button; geometry = 4; }
+            else if (cmd == "textfield") { w.kind = WidgetKind::TextField; geometry = 4; }
+            else if (cmd == "trend") { w.kind = WidgetKind::Trend; geometry = 4; }
+            else return fail("unknown element '" + cmd + "'");
+
+            if (w.kind == WidgetKind::Panel) {
+                if (m_open.empty() && !m_widgets.empty()) return fail("only one top-level panel is allowed");
+            }
+            else if (m_open.empty()) {
+                return fail("'" + cmd + "' must be inside a panel");
+            }
+
+            float geo[4] = { 0.f, 0.f, 0.f, 0.f };
+            for (std::size_t k = 0; k < geometry; ++k) {
+                if (k + 1 >= tokens.size() || !tokens[k + 1].key.empty() || !to_float(tokens[k + 1].value, geo[k])) {
+                    return fail("'" + cmd + "' expects " + std::to_string(geometry) + " numbers");
+                }
+            }
+            w.x = geo[0]; w.y = geo[1]; w.w = geo[2]; w.h = geo[3];
+
+            for (std::size_t k = geometry + 1; k < tokens.size(); ++k) {
+                const Token& t = tokens[k];
+                float f = 0.f;
+                if (t.key == "id") w.id = intern(t.value);
+                else if (t.key == "text" || t.key == "caption" || t.key == "hint") w.text = intern(t.value);
+                else if (t.key == "prefix") w.prefix = intern(t.value);
+                else if (t.key == "bind") w.bind = intern(t.value);
+                else if (t.key == "toggle") { w.action = ButtonAction::Toggle; w.bind = intern(t.value); }
+                else if (t.key == "step") { w.action = ButtonAction::Step; w.bind = intern(t.value); }
+                else if ((t.key == "by" || t.key == "span") && to_float(t.value, f)) w.param = f;
+                else if (t.key == "size" && to_float(t.value, f) && f > 0.f && f < 256.f) w.charSize = static_cast<std::uint8_t>(f);
+                else return fail("bad attribute '" + (t.key.empty() ? t.value : t.key) + "'");
+            }
+
+            if (w.kind == WidgetKind::Panel) m_open.push_back(static_cast<std::uint32_t>(m_widgets.size()));
+            m_widgets.push_back(w);
+            return true;
+        }
+
+        bool parse_screen(const std::vector<Token>& tokens) {
+            float w = 0.f, h = 0.f;
+            if (tokens.size() != 3 || !to_float(tokens[1].value, w) || !to_float(tokens[2].value, h)) {
+                return fail("'screen' expects width and height");
+            }
+            m_width = static_cast<std::uint32_t>(w);
+            m_height = static_cast<std::uint32_t>(h);
+            return true;
+        }
+
+        bool parse_tag(const std::vector<Token>& tokens) {
+            if (tokens.size() != 4) return fail("'tag' expects name, type and value");
+
+            TagRecord t{};
+            t.name = intern(tokens[1].value);
+            const std::string& type = tokens[2].value;
+            const std::string& value = tokens[3].value;
+            char* end = nullptr;
+
+            if (type == "string") {
+                t.type = Value::Type::String;
+                t.text = intern(value);
+                m_tags.push_back(t);
+                return true;
+            }
+            if (type == "bool") {
+                if (value != "true" && value != "false") return fail("bool must be true or false");
+                t.type = Value::Type::Bool;
+                t.bits = (value == "true") ? 1 : 0;
+            }
+            else if (type == "int" || type == "int64") {
+                t.type = (type == "int") ? Value::Type::Int : Value::Type::Int64;
+                t.bits = std::strtoll(value.c_str(), &end, 10);
+            }
+            else if (type == "float") {
+                t.type = Value::Type::Float;
+                const float f = std::strtof(value.c_str(), &end);
+                std::memcpy(&t.bits, &f, sizeof(f));
+            }
+            else if (type == "double") {
+                t.type = Value::Type::Double;
+                const double d = std::strtod(value.c_str(), &end);
+                std::memcpy(&t.bits, &d, sizeof(d));
+            }
+            else {
+                return fail("unknown tag type '" + type + "'");
+            }
+
+            if (end && end != value.c_str() + value.size()) return fail("bad " + type + " value '" + value + "'");
+            m_tags.push_back(t);
+            return true;
+        }
+
+        // The expression is the raw text after '='; it is syntax-checked here
+        // and compiled against the real store at load time.
+        bool parse_expr(std::string_view line) {
+            const std::size_t eq = line.find('=');
+            const std::size_t start = line.find("expr") + 4;
+            const std::string_view target = trim(line.substr(start, eq == std::string_view::npos ? 0 : eq - start));
+            if (eq == std::string_view::npos || target.empty() || target.find_first_of(" \t") != std::string_view::npos) {
+                return fail("'expr' expects: expr <tag> = <expression>");
+            }
+            const std::string_view source = trim(line.substr(eq + 1));
+
+            Expression check;
+            std::string error;
+            if (!check.compile(source, m_scratch, error)) return fail(error);
+
+            m_exprs.push_back(ExprRecord{ intern(std::string(target)), intern(std::string(source)) });
+            return true;
+        }
+
+        static std::string_view trim(std::string_view s) {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+            return s;
+        }
+
+        void emit(std::vector<std::uint8_t>& out) const {
+            ScreenHeader h{};
+            std::memcpy(h.magic, screen_magic, sizeof(screen_magic));
+            h.version = screen_version;
+            h.width = m_width;
+            h.height = m_height;
+            h.tagCount = static_cast<std::uint32_t>(m_tags.size());
+            h.widgetCount = static_cast<std::uint32_t>(m_widgets.size());
+            h.exprCount = static_cast<std::uint32_t>(m_exprs.size());
+            h.stringBytes = static_cast<std::uint32_t>(m_strings.size());
+
+            out.clear();
+            out.reserve(sizeof(h) + m_tags.size() * sizeof(TagRecord) + m_exprs.size() * sizeof(ExprRecord) +
+                m_widgets.size() * sizeof(WidgetRecord) + m_strings.size());
+            append(out, &h, sizeof(h));
+            if (!m_tags.empty()) append(out, m_tags.data(), m_tags.size() * sizeof(TagRecord));
+            if (!m_exprs.empty()) append(out, m_exprs.data(), m_exprs.size() * sizeof(ExprRecord));
+            if (!m_widgets.empty()) append(out, m_widgets.data(), m_widgets.size() * sizeof(WidgetRecord));
+            out.insert(out.end(), m_strings.begin(), m_strings.end());
+        }
+
+        static void append(std::vector<std::uint8_t>& out, const void* p, std::size_t n) {
+            const auto* b = static_cast<const std::uint8_t*>(p);
+            out.insert(out.end(), b, b + n);
+        }
+
+        std::uint32_t m_width{ 0 };
+        std::uint32_t m_height{ 0 };
+        std::vector<TagRecord> m_tags;
+        std::vector<ExprRecord> m_exprs;
+        std::vector<WidgetRecord> m_widgets;
+        std::vector<std::uint32_t> m_open;
+        std::vector<char> m_strings;
+        std::unordered_map<std::string, StrRef> m_interned;
+        std::string m_error;
+        VariableStore m_scratch;
+    };
+
+    // A screen loaded from disk: compiled files are memory-mapped, text files
+    // are compiled in memory. Either way the result is used through image().
+    class ScreenFile final {
+    public:
+        bool load(const std::string& path, std::string& error) {
+            m_image = ScreenImage();
+            m_bytes.clear();
+
+            if (!m_map.open(path)) {
+                error = "cannot open " + path;
+                return false;
+            }
+
+            const bool binary = m_map.size() >= sizeof(screen_magic) &&
+                std::memcmp(m_map.data(), screen_magic, sizeof(screen_magic)) == 0;
+            if (binary) {
+                if (m_image.open(m_map.data(), m_map.size())) return true;
+                error = path + ": corrupt or incompatible screen image";
+                return false;
+            }
+
+            const std::string_view source(reinterpret_cast<const char*>(m_map.data()), m_map.size());
+            ScreenCompiler compiler;
+            if (!compiler.compile(source, m_bytes, error)) {
+                error = path + ": " + error;
+                return false;
+            }
+            m_map.close();
+            return m_image.open(m_bytes.data(), m_bytes.size());
+        }
+
+        const ScreenImage& image() const { return m_image; }
+
+    private:
+        MappedFile m_map;
+        std::vector<std::uint8_t> m_bytes;
+        ScreenImage m_image;
+    };
+
+    inline bool compile_screen_file(const std::string& input, const std::string& output, std::string& error) {
+        std::ifstream in(input, std::ios::binary);
+        if (!in) {
+            error = "cannot open " + input;
+            return false;
+        }
+        const std::string source((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        std::vector<std::uint8_t> bytes;
+        ScreenCompiler compiler;
+        if (!compiler.compile(source, bytes, error)) {
+            error = input + ": " + error;
+            return false;
+        }
+
+        std::ofstream out(output, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!out) {
+            error = "cannot write " + output;
+            return false;
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "xs_feed.hpp"
+#include "xs_metrics.hpp"
+#include "xs_screen_ui.hpp"
+#include "xs_ui.hpp"
+
+namespace xs::ui {
+
+    // One screen in its own window on its own render thread. The thread
+    // creates the window, so the GL context never changes threads, and
+    // builds the widgets into a private mirror store fed by a ScreenFeed.
+    // The loop thread that owns the shared store calls publish() once per
+    // tick; the render thread never touches the shared store.
+    //
+    // A hidden screen hides its window and blocks until it is shown again,
+    // so it costs neither update nor draw time.
+    class ScreenHost final {
+    public:
+        struct Options {
+            std::string title;
+            std::string fontPath{ "Roboto-Regular.ttf" };
+            Theme theme;
+            bool vsync{ true };
+        };
+
+        // The image must outlive the host.
+        ScreenHost(const xs::core::ScreenImage& image, Options options, xs::core::VariableStore& store,
+            xs::core::IngestQueue& writes)
+            : m_image(image), m_options(std::move(options)), m_writes(writes), m_feed(store, writes) {}
+
+        ScreenHost(const ScreenHost&) = delete;
+        ScreenHost& operator=(const ScreenHost&) = delete;
+
+        ~ScreenHost() { stop(); }
+
+        // Runs on the render thread once the screen is built, before the
+        // first frame, e.g. to backfill trends. Set it before start().
+        void on_built(std::function<void(LoadedScreen&)> fn) { m_onBuilt = std::move(fn); }
+
+        void start() { m_thread = std::thread([this] { run(); }); }
+
+        void stop() {
+            m_stop = true;
+            m_feed.close();
+            if (m_thread.joinable()) m_thread.join();
+        }
+
+        // --- Loop thread ---
+
+        void publish() {
+            // A closed window needs no more frames.
+            if (closed()) m_feed.set_active(false);
+            else m_feed.publish();
+        }
+
+        void set_visible(bool on) { m_feed.set_active(on); }
+        bool visible() const { return m_feed.active(); }
+
+        // --- Any thread ---
+
+        // True once the window was closed or the screen failed to start;
+        // error() is empty in the first case.
+        bool closed() const { return m_closed.load(std::memory_order_acquire); }
+        const std::string& error() const { return m_error; }
+
+        std::uint64_t frames() const { return m_frames.load(std::memory_order_relaxed); }
+        std::uint64_t draw_calls() const { return m_drawCalls.load(std::memory_order_relaxed); }
+
+        // Valid once the host has stopped.
+        const FrameStats& stats() const { return m_stats; }
+
+    private:
+        void fail(std::string error) {
+            m_error = std::move(error);
+            set_closed();
+        }
+
+        // Wakes the loop thread so it sees the screen is gone.
+        void set_closed() {
+            m_closed.store(true, std::memory_order_release);
+            m_writes.wake();
+        }
+
+        void run() {
+            sf::Font font;
+            if (!font.loadFromFile(m_options.fontPath)) return fail("Cannot load font: " + m_options.fontPath);
+
+            xs::core::VariableStore mirror;
+            LoadedScreen screen = build_screen(m_image, font, m_options.theme, mirror);
+            if (!screen.root) return fail("Screen has no root panel: " + m_options.title);
+            if (m_onBuilt) m_onBuilt(screen);
+            m_feed.connect(mirror);
+            const auto panel = screen.root;
+
+            sf::RenderWindow window(
+                sf::VideoMode(screen.size.x ? screen.size.x : 760, screen.size.y ? screen.size.y : 420),
+                m_options.title,
+                sf::Style::Titlebar | sf::Style::Close
+            );
+            window.setVerticalSyncEnabled(m_options.vsync);
+
+            // Metrics are per thread, so each window samples its own.
+            xs::core::MetricsSampler sampler;
+            MetricsOverlay overlay(font, m_options.theme);
+            overlay.set_position(sf::Vector2f(static_cast<float>(window.getSize().x) - overlay.size().x - 10.f, 10.f));
+
+            const sf::Time idleTimeout = sf::milliseconds(50);
+            sf::Clock clock;
+            while (window.isOpen() && !m_stop) {
+                if (!m_feed.active()) {
+                    window.setVisible(false);
+                    if (!m_feed.wait_active()) break;
+                    window.setVisible(true);
+                    panel->mark_dirty();
+                    clock.restart();
+                }
+
+                sf::Event event;
+                bool hasEvent = window.pollEvent(event);
+                if (!hasEvent && !panel->needs_redraw() && !overlay.needs_redraw()) {
+                    hasEvent = wait_event(window, event, idleTimeout,
+                        [&] { return m_feed.has_frame() || m_stop || !m_feed.active(); });
+                }
+
+                const float dt = clock.restart().asSeconds();
+
+                {
+                    xs::core::PhaseTimer timer(xs::core::Phase::Events);
+                    while (hasEvent) {
+                        if (event.type == sf::Event::Closed) {
+                            window.close();
+                            break;
+                        }
+                        if (event.type == sf::Event::Resized || event.type == sf::Event::GainedFocus) {
+                            panel->mark_dirty();
+                        }
+                        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3) {
+                            overlay.set_visible(!overlay.visible());
+                            xs::core::metrics().enabled = overlay.visible();
+                            panel->mark_dirty();
+                        }
+                        panel->handle_event(event, window);
+                        hasEvent = window.pollEvent(event);
+                    }
+                }
+                if (!window.isOpen()) break;
+
+                {
+                    xs::core::PhaseTimer timer(xs::core::Phase::Ingest);
+                    m_feed.apply(mirror);
+                }
+                {
+                    xs::core::PhaseTimer timer(xs::core::Phase::Update);
+                    panel->update(dt);
+                }
+
+                if (xs::core::metrics_enabled() &&
+                    sampler.tick(xs::core::now_ms(), mirror.size(), m_stats.frames, draw_stats().calls) &&
+                    overlay.visible()) {
+                    overlay.show(sampler.last());
+                }
+
+                if (!panel->needs_redraw() && !overlay.needs_redraw()) {
+                    ++m_stats.skipped;
+                    continue;
+                }
+
+                {
+                    xs::core::PhaseTimer timer(xs::core::Phase::Draw);
+                    panel->compose(window, m_stats);
+                    overlay.draw(window);
+                    overlay.clear_dirty();
+                }
+                {
+                    xs::core::PhaseTimer timer(xs::core::Phase::Display);
+                    window.display();
+                }
+                ++m_stats.frames;
+                m_frames.store(m_stats.frames, std::memory_order_relaxed);
+                m_drawCalls.store(draw_stats().calls, std::memory_order_relaxed);
+            }
+            m_feed.disconnect();
+            set_closed();
+        }
+
+        const xs::core::ScreenImage& m_image;
+        Options m_options;
+        xs::core::IngestQueue& m_writes;
+        xs::core::ScreenFeed m_feed;
+        std::function<void(LoadedScreen&)> m_onBuilt;
+
+        std::thread m_thread;
+        std::atomic<bool> m_stop{ false };
+        std::atomic<bool> m_closed{ false };
+        std::atomic<std::uint64_t> m_frames{ 0 };
+        std::atomic<std::uint64_t> m_drawCalls{ 0 };
+        std::string m_error;
+        FrameStats m_stats;
+    };
+
+}
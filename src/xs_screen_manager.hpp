@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "xs_screen_ui.hpp"
+
+namespace xs::ui {
+
+    // Switches one window between screens. The screens shown last stay
+    // built and bound, so going back to one costs a repaint; older ones are
+    // torn down into a WidgetPool that the next build takes from. A screen
+    // that has to be built binds only the widgets inside the visible area,
+    // and the rest as set_visible_area() reveals them.
+    //
+    // Warm screens keep their subscriptions. Labels only mark themselves
+    // stale, so a background change costs a flag until the screen is shown.
+    //
+    // Library-only: main() gives every screen its own window and ScreenHost,
+    // so nothing in the app switches screens. It is for embedders that show
+    // several screens in one window.
+    class ScreenManager final {
+    public:
+        struct Options {
+            std::size_t warm{ 3 };           // built screens kept, the current one included
+            std::size_t poolLimit{ 16384 };  // per widget kind
+            bool arena{ true };
+            bool deferOffscreen{ true };
+        };
+
+        ScreenManager(const sf::Font& font, const Theme& theme, xs::core::VariableStore& store)
+            : ScreenManager(font, theme, store, Options()) {}
+
+        ScreenManager(const sf::Font& font, const Theme& theme, xs::core::VariableStore& store, Options options)
+            : m_font(font), m_theme(theme), m_store(store), m_options(options), m_pool(options.poolLimit) {
+            if (m_options.warm == 0) m_options.warm = 1;
+        }
+
+        ScreenManager(const ScreenManager&) = delete;
+        ScreenManager& operator=(const ScreenManager&) = delete;
+
+        // The image must outlive the manager. Returns false if name is taken.
+        bool add(const std::string& name, const xs::core::ScreenImage& image) {
+            if (find(name) != no_screen) return false;
+            m_screens.push_back(Entry{ name, &image, nullptr, 0, sf::FloatRect() });
+            return true;
+        }
+
+        // Makes name the current screen. Returns nullptr if it is unknown
+        // or has no root panel.
+        LoadedScreen* show(const std::string& name) {
+            const std::size_t k = find(name);
+            if (k == no_screen) return nullptr;
+            Entry& e = m_screens[k];
+            e.used = ++m_tick;
+
+            const sf::FloatRect area = visible_area(*e.image);
+            if (!e.screen) {
+                evict(k);
+                BuildOptions options;
+                options.pool = &m_pool;
+                options.arena = m_options.arena;
+                if (m_options.deferOffscreen) options.visible = area;
+                e.screen = std::make_unique<LoadedScreen>(build_screen(*e.image, m_font, m_theme, m_store, options));
+                ++m_builds;
+                if (!e.screen->root) {
+                    e.screen->release(m_pool);
+                    e.screen.reset();
+                    return nullptr;
+                }
+            }
+            else {
+                if (!same_rect(area, e.revealed)) e.screen->reveal(area);
+                e.screen->root->mark_dirty();
+            }
+            e.revealed = area;
+            m_current = k;
+            return e.screen.get();
+        }
+
+        LoadedScreen* current() const { return m_current == no_screen ? nullptr : m_screens[m_current].screen.get(); }
+
+        const std::string& current_name() const {
+            static const std::string none;
+            return m_current == no_screen ? none : m_screens[m_current].name;
+        }
+
+        bool is_warm(const std::string& name) const {
+            const std::size_t k = find(name);
+            return k != no_screen && m_screens[k].screen != nullptr;
+        }
+
+        // The part of the screens that is on the window. Empty, the default,
+        // means each screen's own size.
+        void set_visible_area(const sf::FloatRect& area) {
+            m_area = area;
+            if (LoadedScreen* s = current()) {
+                Entry& e = m_screens[m_current];
+                e.revealed = visible_area(*e.image);
+                s->reveal(e.revealed);
+            }
+        }
+
+        // Tears down every screen but the current one.
+        void trim() {
+            for (std::size_t k = 0; k < m_screens.size(); ++k) {
+                if (k != m_current) drop(k);
+            }
+        }
+
+        const WidgetPool& pool() const { return m_pool; }
+        std::uint64_t builds() const { return m_builds; }
+
+    private:
+        static constexpr std::size_t no_screen = static_cast<std::size_t>(-1);
+
+        struct Entry {
+            std::string name;
+            const xs::core::ScreenImage* image;
+            std::unique_ptr<LoadedScreen> screen;
+            std::uint64_t used;
+            sf::FloatRect revealed;
+        };
+
+        static bool same_rect(const sf::FloatRect& a, const sf::FloatRect& b) {
+            return a.left == b.left && a.top == b.top && a.width == b.width && a.height == b.height;
+        }
+
+        std::size_t find(const std::string& name) const {
+            for (std::size_t k = 0; k < m_screens.size(); ++k) {
+                if (m_screens[k].name == name) return k;
+            }
+            return no_screen;
+        }
+
+        sf::FloatRect visible_area(const xs::core::ScreenImage& image) const {
+            if (detail::has_area(m_area)) return m_area;
+            const xs::core::ScreenHeader& h = image.header();
+            return sf::FloatRect(0.f, 0.f, static_cast<float>(h.width), static_cast<float>(h.height));
+        }
+
+        // Makes room for building screen keep: least recently used first.
+        void evict(std::size_t keep) {
+            for (;;) {
+                std::size_t built = 0;
+                std::size_t oldest = no_screen;
+                for (std::size_t k = 0; k < m_screens.size(); ++k) {
+                    if (!m_screens[k].screen || k == keep) continue;
+                    ++built;
+                    if (oldest == no_screen || m_screens[k].used < m_screens[oldest].used) oldest = k;
+                }
+                if (built < m_options.warm) return;
+                drop(oldest);
+            }
+        }
+
+        void drop(std::size_t k) {
+            Entry& e = m_screens[k];
+            if (!e.screen) return;
+            e.screen->release(m_pool);
+            e.screen.reset();
+            if (m_current == k) m_current = no_screen;
+        }
+
+        const sf::Font& m_font;
+        const Theme& m_theme;
+        xs::core::VariableStore& m_store;
+        Options m_options;
+
+        WidgetPool m_pool;
+        std::vector<Entry> m_screens;
+        std::size_t m_current{ no_screen };
+        std::uint64_t m_tick{ 0 };
+        std::uint64_t m_builds{ 0 };
+        sf::FloatRect m_area;
+    };
+
+}
@@ -0,0 +1,367 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "xs_screen.hpp"
+#include "xs_ui.hpp"
+
+namespace xs::ui {
+
+    // Bump allocator for the widgets of one screen: one block instead of a
+    // heap allocation per widget and control block. Every widget allocated
+    // from it keeps it alive, so widgets handed to a WidgetPool outlive
+    // their screen; the memory goes once the last of them is destroyed.
+    // Single-threaded, like the widgets.
+    class WidgetArena final {
+    public:
+        explicit WidgetArena(std::size_t bytes) : m_resource(std::max<std::size_t>(bytes, 256)) {}
+
+        void* allocate(std::size_t bytes, std::size_t align) {
+            m_used += bytes;
+            return m_resource.allocate(bytes, align);
+        }
+
+        std::size_t used() const { return m_used; }
+
+    private:
+        std::pmr::monotonic_buffer_resource m_resource;
+        std::size_t m_used{ 0 };
+    };
+
+    template <typename T>
+    class ArenaAllocator {
+    public:
+        using value_type = T;
+
+        explicit ArenaAllocator(std::shared_ptr<WidgetArena> arena) : m_arena(std::move(arena)) {}
+
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.m_arena) {}
+
+        T* allocate(std::size_t n) { return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T))); }
+        void deallocate(T*, std::size_t) {}
+
+        template <typename U>
+        bool operator==(const ArenaAllocator<U>& other) const { return m_arena == other.m_arena; }
+        template <typename U>
+        bool operator!=(const ArenaAllocator<U>& other) const { return m_arena != other.m_arena; }
+
+    private:
+        template <typename U>
+        friend class ArenaAllocator;
+
+        std::shared_ptr<WidgetArena> m_arena;
+    };
+
+    // Unbound labels, buttons and text fields of torn-down screens, reused
+    // by build_screen() instead of new ones. Pooled widgets keep the theme
+    // they were built with, so use one pool per theme. Panels and trends
+    // are always built new.
+    class WidgetPool final {
+    public:
+        explicit WidgetPool(std::size_t limit = 16384) : m_limit(limit) {}
+
+        // Widgets of other kinds, or past the per-kind limit, are dropped.
+        void release(xs::core::WidgetKind kind, std::shared_ptr<Widget> w) {
+            const std::size_t k = slot(kind);
+            if (!w || k == no_slot || m_free[k].size() >= m_limit) return;
+            w->unbind();
+            w->set_parent(nullptr);
+            m_free[k].push_back(std::move(w));
+        }
+
+        // The caller resets the widget; nullptr if none is free.
+        template <typename T>
+        std::shared_ptr<T> acquire(xs::core::WidgetKind kind) {
+            const std::size_t k = slot(kind);
+            if (k == no_slot || m_free[k].empty()) return nullptr;
+            auto w = std::static_pointer_cast<T>(std::move(m_free[k].back()));
+            m_free[k].pop_back();
+            ++m_reused;
+            return w;
+        }
+
+        std::size_t available(xs::core::WidgetKind kind) const {
+            const std::size_t k = slot(kind);
+            return k == no_slot ? 0 : m_free[k].size();
+        }
+
+        std::size_t size() const { return m_free[0].size() + m_free[1].size() + m_free[2].size(); }
+        std::uint64_t reused() const { return m_reused; }
+
+        void clear() {
+            for (auto& f : m_free) f.clear();
+        }
+
+    private:
+        static constexpr std::size_t no_slot = 3;
+
+        static std::size_t slot(xs::core::WidgetKind kind) {
+            switch (kind) {
+            case xs::core::WidgetKind::Label: return 0;
+            case xs::core::WidgetKind::Button: return 1;
+            case xs::core::WidgetKind::TextField: return 2;
+            default: return no_slot;
+            }
+        }
+
+        std::size_t m_limit;
+        std::array<std::vector<std::shared_ptr<Widget>>, 3> m_free;
+        std::uint64_t m_reused{ 0 };
+    };
+
+    struct BuildOptions {
+        WidgetPool* pool{ nullptr };  // take widgets from here first
+        bool arena{ false };          // allocate new widgets from one arena per screen
+        sf::FloatRect visible;        // bind only widgets intersecting this; empty binds all
+    };
+
+    struct LoadedScreen {
+        std::shared_ptr<Panel> root;
+        sf::Vector2u size;
+        std::unordered_map<std::string, std::shared_ptr<Widget>> named;
+
+        // Widget of record k, or nullptr for records that build nothing.
+        std::vector<std::shared_ptr<Widget>> widgets;
+        // Records whose text and binding wait for reveal(). The image, theme
+        // and store passed to build_screen() must outlive them.
+        std::vector<std::uint32_t> deferred;
+
+        template <typename T>
+        std::shared_ptr<T> find(const std::string& id) const {
+            auto it = named.find(id);
+            return it == named.end() ? nullptr : std::dynamic_pointer_cast<T>(it->second);
+        }
+
+        // Binds the deferred widgets intersecting area. Returns how many.
+        std::size_t reveal(const sf::FloatRect& area);
+
+        // Unbinds the screen and moves its widgets to pool; the screen is
+        // empty afterwards.
+        void release(WidgetPool& pool);
+
+        const xs::core::ScreenImage* image{ nullptr };
+        const Theme* theme{ nullptr };
+        xs::core::VariableStore* store{ nullptr };
+    };
+
+    namespace detail {
+
+        inline bool has_area(const sf::FloatRect& r) { return r.width > 0.f && r.height > 0.f; }
+
+        template <typename T, typename... Args>
+        std::shared_ptr<T> make_widget(const std::shared_ptr<WidgetArena>& arena, Args&&... args) {
+            if (arena) return std::allocate_shared<T>(ArenaAllocator<T>(arena), std::forward<Args>(args)...);
+            return std::make_shared<T>(std::forward<Args>(args)...);
+        }
+
+        template <typename T>
+        std::shared_ptr<T> make_text_widget(const xs::core::WidgetRecord& r, const sf::Font& font, const Theme& theme,
+            WidgetPool* pool, const std::shared_ptr<WidgetArena>& arena) {
+            if (pool) {
+                if (auto w = pool->acquire<T>(r.kind)) {
+                    w->reset(font, r.charSize);
+                    return w;
+                }
+            }
+            return make_widget<T>(arena, font, r.charSize, theme);
+        }
+
+        // The widget of a record, without text or binding.
+        inline std::shared_ptr<Widget> create_widget(const xs::core::WidgetRecord& r, const sf::Font& font,
+            const Theme& theme, WidgetPool* pool, const std::shared_ptr<WidgetArena>& arena) {
+            using xs::core::WidgetKind;
+            switch (r.kind) {
+            case WidgetKind::Panel: return make_widget<Panel>(arena, theme);
+            case WidgetKind::Label: return make_text_widget<Label>(r, font, theme, pool, arena);
+            case WidgetKind::Button: return make_text_widget<Button>(r, font, theme, pool, arena);
+            case WidgetKind::TextField: return make_text_widget<TextField>(r, font, theme, pool, arena);
+            case WidgetKind::Trend: return make_widget<TrendChart>(arena, theme);
+            }
+            return nullptr;
+        }
+
+        // Sets the record's text and binds the widget to its tag.
+        inline void configure_widget(Widget& w, const xs::core::WidgetRecord& r, const xs::core::ScreenImage& image,
+            const Theme& theme, xs::core::VariableStore& store) {
+            using xs::core::WidgetKind;
+            using xs::core::ButtonAction;
+
+            const std::string text(image.str(r.text));
+            const std::string bind(image.str(r.bind));
+
+            switch (r.kind) {
+            case WidgetKind::Panel:
+                break;
+            case WidgetKind::Label: {
+                auto& l = static_cast<Label&>(w);
+                if (r.prefix.length) l.set_prefix(std::string(image.str(r.prefix)));
+                if (!bind.empty()) l.bind_to(store, bind);
+                else l.set_text(text);
+                break;
+            }
+            case WidgetKind::Button: {
+                auto& b = static_cast<Button&>(w);
+                b.set_caption(text);
+                if (r.action == ButtonAction::Toggle) {
+                    b.bind_toggle_bool(store, bind);
+                }
+                else if (r.action == ButtonAction::Step) {
+                    const xs::core::TagId tag = store.ensure_tag(bind, xs::core::Value::make_float(0.f));
+                    const float step = r.param;
+                    b.set_on_click([&store, tag, step]() {
+                        store.set(tag, xs::core::Value::make_float(store.get_float(tag, 0.f) + step));
+                        });
+                }
+                break;
+            }
+            case WidgetKind::TextField: {
+                auto& f = static_cast<TextField&>(w);
+                f.set_hint(text);
+                if (!bind.empty()) f.bind_string(store, bind);
+                break;
+            }
+            case WidgetKind::Trend: {
+                auto& t = static_cast<TrendChart&>(w);
+                if (r.param > 0.f) t.set_span(static_cast<std::int64_t>(r.param));
+                const std::size_t pen = t.add_pen(theme.accent);
+                if (!bind.empty()) t.bind_pen(pen, store, bind);
+                break;
+            }
+            }
+        }
+
+        // Creates the tag configure_widget() would bind to, so a deferred
+        // widget's tags exist from the start.
+        inline void ensure_widget_tag(const xs::core::WidgetRecord& r, const xs::core::ScreenImage& image,
+            xs::core::VariableStore& store) {
+            using xs::core::WidgetKind;
+            using xs::core::ButtonAction;
+            using xs::core::Value;
+
+            const std::string bind(image.str(r.bind));
+            if (bind.empty()) return;
+            switch (r.kind) {
+            case WidgetKind::Label:
+            case WidgetKind::TextField: store.ensure_tag(bind, Value::make_string("")); break;
+            case WidgetKind::Trend: store.ensure_tag(bind, Value::make_float(0.f)); break;
+            case WidgetKind::Button:
+                if (r.action == ButtonAction::Toggle) store.ensure_tag(bind, Value::make_bool(false));
+                else if (r.action == ButtonAction::Step) store.ensure_tag(bind, Value::make_float(0.f));
+                break;
+            default: break;
+            }
+        }
+
+        // Room for the widgets the pool cannot supply.
+        inline std::size_t arena_bytes(const xs::core::ScreenImage& image, const WidgetPool* pool) {
+            using xs::core::WidgetKind;
+            constexpr std::size_t overhead = 32;  // shared_ptr control block
+            std::array<std::size_t, 5> count{};
+            for (std::size_t k = 0; k < image.widget_count(); ++k) {
+                const auto kind = static_cast<std::size_t>(image.widget(k).kind);
+                if (kind < count.size()) ++count[kind];
+            }
+            auto fresh = [&](WidgetKind kind) {
+                const std::size_t n = count[static_cast<std::size_t>(kind)];
+                const std::size_t pooled = pool ? pool->available(kind) : 0;
+                return n > pooled ? n - pooled : 0;
+            };
+            return fresh(WidgetKind::Panel) * (sizeof(Panel) + overhead)
+                + fresh(WidgetKind::Label) * (sizeof(Label) + overhead)
+                + fresh(WidgetKind::Button) * (sizeof(Button) + overhead)
+                + fresh(WidgetKind::TextField) * (sizeof(TextField) + overhead)
+                + fresh(WidgetKind::Trend) * (sizeof(TrendChart) + overhead);
+        }
+
+    }
+
+    // Creates the declared tags in the store, then instantiates and binds the
+    // widget tree. Records are stored parent-first, so one pass is enough.
+    //
+    // With options, widgets come from the pool or the screen's arena, and
+    // widgets outside options.visible only get their geometry and tag: the
+    // subscription and the first format and layout wait for reveal().
+    inline LoadedScreen build_screen(const xs::core::ScreenImage& image, const sf::Font& font,
+        const Theme& theme, xs::core::VariableStore& store, const BuildOptions& options = {}) {
+        LoadedScreen screen;
+        screen.size = sf::Vector2u(image.header().width, image.header().height);
+        if (!image.valid()) return screen;
+        screen.image = &image;
+        screen.theme = &theme;
+        screen.store = &store;
+
+        image.create_tags(store);
+
+        const std::size_t n = image.widget_count();
+        std::vector<Panel*> panels(n, nullptr);
+        screen.widgets.resize(n);
+        const bool defer = detail::has_area(options.visible);
+        std::shared_ptr<WidgetArena> arena;
+        if (options.arena) arena = std::make_shared<WidgetArena>(detail::arena_bytes(image, options.pool));
+
+        for (std::size_t k = 0; k < n; ++k) {
+            const xs::core::WidgetRecord r = image.widget(k);
+            std::shared_ptr<Widget> w = detail::create_widget(r, font, theme, options.pool, arena);
+            if (!w) continue;
+
+            w->set_position(sf::Vector2f(r.x, r.y));
+            if (r.w > 0.f && r.h > 0.f) w->set_size(sf::Vector2f(r.w, r.h));
+
+            if (r.kind == xs::core::WidgetKind::Panel) {
+                panels[k] = static_cast<Panel*>(w.get());
+                if (!screen.root) screen.root = std::static_pointer_cast<Panel>(w);
+            }
+            else if (defer && !options.visible.intersects(sf::FloatRect(w->position(), w->size()))) {
+                detail::ensure_widget_tag(r, image, store);
+                screen.deferred.push_back(static_cast<std::uint32_t>(k));
+            }
+            else {
+                detail::configure_widget(*w, r, image, theme, store);
+            }
+
+            if (r.id.length) screen.named.emplace(std::string(image.str(r.id)), w);
+            if (r.parent < k && panels[r.parent]) panels[r.parent]->add(w);
+            screen.widgets[k] = std::move(w);
+        }
+
+        return screen;
+    }
+
+    inline std::size_t LoadedScreen::reveal(const sf::FloatRect& area) {
+        std::size_t bound = 0;
+        auto keep = deferred.begin();
+        for (std::uint32_t k : deferred) {
+            Widget& w = *widgets[k];
+            if (area.intersects(sf::FloatRect(w.position(), w.size()))) {
+                detail::configure_widget(w, image->widget(k), *image, *theme, *store);
+                ++bound;
+            }
+            else {
+                *keep++ = k;
+            }
+        }
+        deferred.erase(keep, deferred.end());
+        return bound;
+    }
+
+    inline void LoadedScreen::release(WidgetPool& pool) {
+        for (std::size_t k = 0; k < widgets.size(); ++k) {
+            if (widgets[k]) pool.release(image->widget(k).kind, std::move(widgets[k]));
+        }
+        widgets.clear();
+        deferred.clear();
+        named.clear();
+        root.reset();
+    }
+
+}
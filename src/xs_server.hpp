@@ -0,0 +1,743 @@
+#pragma once
+
+#ifdef __linux__
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "xs_core.hpp"
+#include "xs_ingest.hpp"
+#include "xs_protocol.hpp"
+
+namespace xs::core {
+
+    // Serves tags to other processes on the same machine over a Unix socket
+    // or loopback TCP, using the protocol in xs_protocol.hpp. The sockets are
+    // handled by an epoll loop on a thread of its own that never touches the
+    // store: writes go into the IngestQueue the UI thread already drains, and
+    // reads and subscriptions are answered from a mirror of the tags clients
+    // have asked for, which the UI thread refreshes in publish().
+    class ProtocolServer final {
+    public:
+        struct Stats {
+            std::uint64_t connections{ 0 };
+            std::uint64_t requests{ 0 };
+            std::uint64_t writes{ 0 };
+            std::uint64_t updates{ 0 };
+            std::uint64_t bytesOut{ 0 };
+        };
+
+        ProtocolServer(VariableStore& store, IngestQueue& ingest) : m_store(store), m_ingest(ingest) {}
+
+        ~ProtocolServer() {
+            stop();
+            for (int fd : m_listeners) ::close(fd);
+            if (m_wake >= 0) ::close(m_wake);
+            if (m_epoll >= 0) ::close(m_epoll);
+            for (const std::string& path : m_unixPaths) ::unlink(path.c_str());
+        }
+
+        ProtocolServer(const ProtocolServer&) = delete;
+        ProtocolServer& operator=(const ProtocolServer&) = delete;
+
+        bool listen_unix(const std::string& path, std::string& error) {
+            sockaddr_un addr{};
+            if (path.size() >= sizeof(addr.sun_path)) {
+                error = "socket path too long: " + path;
+                return false;
+            }
+            addr.sun_family = AF_UNIX;
+            std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+            const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0) return fail(error, "socket");
+            // A socket file left behind by a previous run would make bind fail.
+            ::unlink(path.c_str());
+            if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 64) != 0) {
+                ::close(fd);
+                return fail(error, "bind " + path);
+            }
+            m_listeners.push_back(fd);
+            m_unixPaths.push_back(path);
+            return true;
+        }
+
+        // Binds 127.0.0.1 only. Port 0 picks a free port; see tcp_port().
+        bool listen_tcp(std::uint16_t port, std::string& error) {
+            const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0) return fail(error, "socket");
+            const int on = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t len = sizeof(addr);
+            if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 64) != 0
+                || ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+                ::close(fd);
+                return fail(error, "bind 127.0.0.1:" + std::to_string(port));
+            }
+            m_tcpPort = ntohs(addr.sin_port);
+            m_listeners.push_back(fd);
+            return true;
+        }
+
+        std::uint16_t tcp_port() const { return m_tcpPort; }
+
+        bool start(std::string& error) {
+            if (m_thread.joinable()) return true;
+            m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+            m_wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (m_epoll < 0 || m_wake < 0) return fail(error, "epoll");
+            if (!watch_fd(m_wake, wake_key, EPOLLIN)) return fail(error, "epoll_ctl");
+            for (std::size_t k = 0; k < m_listeners.size(); ++k) {
+                if (!watch_fd(m_listeners[k], listener_key + k, EPOLLIN)) return fail(error, "epoll_ctl");
+            }
+            m_stop.store(false);
+            m_thread = std::thread([this] { run(); });
+            return true;
+        }
+
+        void stop() {
+            if (!m_thread.joinable()) return;
+            m_stop.store(true);
+            wake();
+            m_thread.join();
+            for (auto& entry : m_conns) ::close(entry.second->fd);
+            m_conns.clear();
+            m_subscribers.clear();
+        }
+
+        // UI thread, once per frame after the ingest queue is drained: answers
+        // the name lookups and watch requests of the network thread and copies
+        // the watched tags that changed into the mirror.
+        void publish() {
+            if (m_hasRequests.load(std::memory_order_acquire)) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_uiRequests.swap(m_requests);
+                m_hasRequests.store(false, std::memory_order_relaxed);
+            }
+            for (ControlRequest& r : m_uiRequests) {
+                if (r.resolve) {
+                    r.handles.resize(r.names.size());
+                    for (std::size_t k = 0; k < r.names.size(); ++k) {
+                        r.handles[k] = r.create
+                            ? m_store.ensure_tag(r.names[k], Value::make_int(0))
+                            : m_store.resolve(r.names[k]);
+                    }
+                }
+                for (TagId id : r.handles) {
+                    if (m_store.valid(id)) watch(id);
+                }
+            }
+            if (m_dirty.empty() && m_uiRequests.empty()) {
+                // The drain just made room for the writes that filled the queue.
+                if (m_writesBlocked.load(std::memory_order_acquire)) wake();
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_values.size() < m_store.size()) {
+                    m_values.resize(m_store.size());
+                    m_published.resize(m_store.size(), 0);
+                }
+                for (TagId id : m_dirty) {
+                    m_values[id] = m_store.at(id).get();
+                    m_published[id] = 1;
+                    m_changed.push_back(id);
+                    m_dirtyFlag[id] = 0;
+                }
+                for (ControlRequest& r : m_uiRequests) m_results.push_back(std::move(r));
+            }
+            m_dirty.clear();
+            m_uiRequests.clear();
+            wake();
+        }
+
+        // True while the network thread waits for publish(). post() also
+        // wakes the ingest queue's consumer, so an idle UI loop need not poll.
+        bool pending() const { return m_hasRequests.load(std::memory_order_acquire); }
+
+        Stats stats() const {
+            Stats s;
+            s.connections = m_statConnections.load(std::memory_order_relaxed);
+            s.requests = m_statRequests.load(std::memory_order_relaxed);
+            s.writes = m_statWrites.load(std::memory_order_relaxed);
+            s.updates = m_statUpdates.load(std::memory_order_relaxed);
+            s.bytesOut = m_statBytesOut.load(std::memory_order_relaxed);
+            return s;
+        }
+
+    private:
+        static constexpr std::uint64_t wake_key = 0;
+        static constexpr std::uint64_t listener_key = 1;
+        static constexpr std::uint64_t first_connection = 1024;
+        static constexpr std::size_t read_chunk = 64 * 1024;
+        // Updates for a client are held back (and keep coalescing) while this
+        // much output is still unsent.
+        static constexpr std::size_t out_high_water = 1 << 20;
+
+        // Network thread to UI thread: look up names (resolve) or start
+        // mirroring handles. The same object comes back as the result.
+        struct ControlRequest {
+            std::uint64_t conn{ 0 };
+            std::uint32_t request{ 0 };
+            bool resolve{ false };
+            bool create{ false };
+            bool read{ false };
+            std::vector<std::string> names;
+            std::vector<TagId> handles;
+        };
+
+        struct Watch {
+            double deadband{ 0.0 };
+            Value last;
+            bool sent{ false };
+            bool dirty{ false };
+        };
+
+        struct Connection {
+            int fd{ -1 };
+            std::uint64_t id{ 0 };
+            std::vector<std::uint8_t> in;
+            std::vector<std::uint8_t> out;
+            std::size_t outSent{ 0 };
+            bool writable{ true };
+            std::unordered_map<TagId, Watch> watches;
+            std::vector<TagId> dirty;
+            // Read requests waiting for their tags to be mirrored, by id.
+            std::vector<std::pair<std::uint32_t, std::vector<std::uint8_t>>> parked;
+            // Set while the write at the front of in waits for room in the
+            // ingest queue: nothing more is read or parsed until on_wake().
+            bool stalled{ false };
+            std::uint32_t writeNext{ 0 };      // entries of that write already queued
+            std::uint32_t writeAccepted{ 0 };
+        };
+
+        static bool fail(std::string& error, const std::string& what) {
+            error = what + ": " + std::strerror(errno);
+            return false;
+        }
+
+        // --- UI thread ---
+
+        void watch(TagId id) {
+            if (m_watched.size() <= id) {
+                m_watched.resize(m_store.size(), 0);
+                m_dirtyFlag.resize(m_store.size(), 0);
+            }
+            if (m_watched[id]) return;
+            m_watched[id] = 1;
+            // Subscribing reports the current value right away.
+            m_watchSubs.push_back(m_store.at(id).subscribe_scoped([this, id](const Value&) {
+                if (m_dirtyFlag[id]) return;
+                m_dirtyFlag[id] = 1;
+                m_dirty.push_back(id);
+            }));
+        }
+
+        void wake() {
+            const std::uint64_t one = 1;
+            [[maybe_unused]] const ssize_t n = ::write(m_wake, &one, sizeof(one));
+        }
+
+        // --- network thread ---
+
+        bool watch_fd(int fd, std::uint64_t key, std::uint32_t events) {
+            epoll_event ev{};
+            ev.events = events;
+            ev.data.u64 = key;
+            return ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) == 0;
+        }
+
+        void run() {
+            epoll_event events[64];
+            while (!m_stop.load(std::memory_order_acquire)) {
+                const int n = ::epoll_wait(m_epoll, events, 64, -1);
+                for (int k = 0; k < n; ++k) {
+                    const std::uint64_t key = events[k].data.u64;
+                    if (key == wake_key) on_wake();
+                    else if (key < first_connection) on_accept(m_listeners[key - listener_key]);
+                    else on_connection(key, events[k].events);
+                }
+            }
+        }
+
+        void on_accept(int listener) {
+            for (;;) {
+                const int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) return;
+                const int on = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));  // fails harmlessly on Unix sockets
+
+                auto conn = std::make_unique<Connection>();
+                conn->fd = fd;
+                conn->id = m_nextConn++;
+                if (!watch_fd(fd, conn->id, EPOLLIN | EPOLLRDHUP)) {
+                    ::close(fd);
+                    continue;
+                }
+                m_conns.emplace(conn->id, std::move(conn));
+                m_statConnections.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        void on_connection(std::uint64_t key, std::uint32_t events) {
+            auto it = m_conns.find(key);
+            if (it == m_conns.end()) return;
+            Connection& c = *it->second;
+
+            if (events & EPOLLOUT) {
+                c.writable = true;
+                if (!flush(c)) return close_connection(c);
+            }
+            if (c.stalled) {
+                // Hung up with nobody left to answer; the rest is dropped.
+                if (events & (EPOLLHUP | EPOLLERR)) return close_connection(c);
+            }
+            else if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                if (!receive(c)) return close_connection(c);
+            }
+            pump_updates(c);
+            if (!flush(c)) close_connection(c);
+        }
+
+        // Reads a bounded number of chunks so one busy client cannot starve
+        // the others; epoll reports the rest again. Returns false once the
+        // client is gone or sent garbage.
+        bool receive(Connection& c) {
+            for (int chunk = 0; chunk < 16; ++chunk) {
+                const std::size_t used = c.in.size();
+                c.in.resize(used + read_chunk);
+                const ssize_t n = ::recv(c.fd, c.in.data() + used, read_chunk, 0);
+                c.in.resize(used + static_cast<std::size_t>(n > 0 ? n : 0));
+                if (n == 0) return false;
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    return errno == EAGAIN || errno == EWOULDBLOCK;
+                }
+                if (!handle_frames(c)) return false;
+                if (c.stalled) break;
+            }
+            return true;
+        }
+
+        // resumed: the first frame is a stalled write, already counted.
+        bool handle_frames(Connection& c, bool resumed = false) {
+            std::size_t pos = 0;
+            for (;;) {
+                const long length = protocol::next_frame(c.in.data() + pos, c.in.size() - pos);
+                if (length < 0) return false;
+                if (length == 0) break;
+                if (!handle(c, c.in.data() + pos, static_cast<std::size_t>(length), resumed)) return false;
+                resumed = false;
+                // A stalled write stays in c.in and is parsed again on resume.
+                if (c.stalled) break;
+                pos += static_cast<std::size_t>(length);
+            }
+            c.in.erase(c.in.begin(), c.in.begin() + static_cast<long>(pos));
+            return true;
+        }
+
+        // Returns false for a malformed request, which closes the connection.
+        bool handle(Connection& c, const std::uint8_t* frame, std::size_t length, bool retry) {
+            const protocol::FrameHeader h = protocol::frame_header(frame);
+            protocol::FrameReader in(frame + sizeof(h), length - sizeof(h));
+            if (!retry) m_statRequests.fetch_add(1, std::memory_order_relaxed);
+
+            switch (static_cast<protocol::Op>(h.op)) {
+            case protocol::Op::Resolve: return on_resolve(c, h.request, in);
+            case protocol::Op::Read: return on_read(c, h.request, in, frame, length, retry);
+            case protocol::Op::Write: return on_write(c, h.request, in);
+            case protocol::Op::Subscribe: return on_subscribe(c, h.request, in);
+            case protocol::Op::Unsubscribe: return on_unsubscribe(c, h.request, in);
+            default:
+                send_error(c, h.request, "unknown op");
+                return true;
+            }
+        }
+
+        bool on_resolve(Connection& c, std::uint32_t request, protocol::FrameReader& in) {
+            std::uint8_t create = 0;
+            std::uint32_t n = 0;
+            if (!in.u8(create) || !in.u32(n) || !in.fits(n, sizeof(std::uint16_t))) return false;
+            ControlRequest r;
+            r.conn = c.id;
+            r.request = request;
+            r.resolve = true;
+            r.create = create != 0;
+            r.names.reserve(n);
+            for (std::uint32_t k = 0; k < n; ++k) {
+                std::string_view name;
+                if (!in.text16(name)) return false;
+                r.names.emplace_back(name);
+            }
+            post(std::move(r));
+            return true;
+        }
+
+        bool read_handles(protocol::FrameReader& in, std::vector<TagId>& out) {
+            std::uint32_t n = 0;
+            if (!in.u32(n) || !in.fits(n, sizeof(TagId))) return false;
+            out.resize(n);
+            for (TagId& id : out) {
+                if (!in.u32(id)) return false;
+            }
+            return true;
+        }
+
+        bool on_read(Connection& c, std::uint32_t request, protocol::FrameReader& in,
+                     const std::uint8_t* frame, std::size_t length, bool retry) {
+            if (!read_handles(in, m_handles)) return false;
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!retry) {
+                // Tags nobody has asked for yet are not mirrored: ask the UI
+                // thread for them and answer once publish() has run.
+                ControlRequest r;
+                for (TagId id : m_handles) {
+                    if (id >= m_published.size() || !m_published[id]) r.handles.push_back(id);
+                }
+                if (!r.handles.empty()) {
+                    lock.unlock();
+                    r.conn = c.id;
+                    r.request = request;
+                    r.read = true;
+                    post(std::move(r));
+                    c.parked.emplace_back(request, std::vector<std::uint8_t>(frame, frame + length));
+                    return true;
+                }
+            }
+
+            protocol::FrameWriter out(c.out);
+            out.begin(protocol::reply_op(protocol::Op::Read), request);
+            out.u32(static_cast<std::uint32_t>(m_handles.size()));
+            for (TagId id : m_handles) {
+                if (id < m_published.size() && m_published[id]) out.value(m_values[id]);
+                else out.missing();
+            }
+            out.end();
+            return true;
+        }
+
+        // A full queue is backpressure: the connection stalls on the entry
+        // that did not fit and resumes there once the UI thread has drained,
+        // while the other connections carry on.
+        bool on_write(Connection& c, std::uint32_t request, protocol::FrameReader& in) {
+            std::uint32_t n = 0;
+            if (!in.u32(n) || !in.fits(n, sizeof(TagId) + 1)) return false;
+            for (std::uint32_t k = 0; k < n; ++k) {
+                TagId id = invalid_tag;
+                Value v;
+                bool present = false;
+                if (!in.u32(id) || !in.value(v, present)) return false;
+                if (k < c.writeNext || !present) continue;
+                if (!m_ingest.try_push(id, std::move(v))) {
+                    c.writeNext = k;
+                    set_stalled(c, true);
+                    return true;
+                }
+                ++c.writeAccepted;
+            }
+            const std::uint32_t accepted = c.writeAccepted;
+            c.writeNext = 0;
+            c.writeAccepted = 0;
+            m_statWrites.fetch_add(accepted, std::memory_order_relaxed);
+            if (request != 0) reply_count(c, protocol::Op::Write, request, accepted);
+            return true;
+        }
+
+        void set_stalled(Connection& c, bool on) {
+            if (c.stalled == on) return;
+            c.stalled = on;
+            m_stalled += on ? 1 : -1;
+            m_writesBlocked.store(m_stalled > 0, std::memory_order_release);
+        }
+
+        // Picks a stalled connection up where its write stopped, then parses
+        // whatever it sent meanwhile. Returns false if it sent garbage.
+        bool resume(Connection& c) {
+            set_stalled(c, false);
+            return handle_frames(c, true);
+        }
+
+        bool on_subscribe(Connection& c, std::uint32_t request, protocol::FrameReader& in) {
+            double deadband = 0.0;
+            if (!in.f64(deadband) || !read_handles(in, m_handles)) return false;
+            if (!std::isfinite(deadband) || deadband < 0.0) deadband = 0.0;
+
+            ControlRequest r;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (TagId id : m_handles) {
+                    auto [it, added] = c.watches.try_emplace(id);
+                    it->second.deadband = deadband;
+                    if (!added) continue;
+                    m_subscribers[id].push_back(&c);
+                    // The first update carries the current value.
+                    if (id < m_published.size() && m_published[id]) mark_dirty(c, id, it->second);
+                    else r.handles.push_back(id);
+                }
+            }
+            if (!r.handles.empty()) {
+                r.conn = c.id;
+                post(std::move(r));
+            }
+            reply_count(c, protocol::Op::Subscribe, request, static_cast<std::uint32_t>(m_handles.size()));
+            return true;
+        }
+
+        bool on_unsubscribe(Connection& c, std::uint32_t request, protocol::FrameReader& in) {
+            if (!read_handles(in, m_handles)) return false;
+            std::uint32_t removed = 0;
+            for (TagId id : m_handles) {
+                if (c.watches.erase(id) == 0) continue;
+                drop_subscriber(id, &c);
+                ++removed;
+            }
+            reply_count(c, protocol::Op::Unsubscribe, request, removed);
+            return true;
+        }
+
+        void reply_count(Connection& c, protocol::Op op, std::uint32_t request, std::uint32_t n) {
+            protocol::FrameWriter out(c.out);
+            out.begin(protocol::reply_op(op), request);
+            out.u32(n);
+            out.end();
+        }
+
+        void send_error(Connection& c, std::uint32_t request, std::string_view message) {
+            protocol::FrameWriter out(c.out);
+            out.begin(protocol::reply_op(protocol::Op::Error), request);
+            out.text16(message);
+            out.end();
+        }
+
+        void post(ControlRequest&& r) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_requests.push_back(std::move(r));
+            m_hasRequests.store(true, std::memory_order_release);
+            m_ingest.wake();
+        }
+
+        static void mark_dirty(Connection& c, TagId id, Watch& w) {
+            if (w.dirty) return;
+            w.dirty = true;
+            c.dirty.push_back(id);
+        }
+
+        void drop_subscriber(TagId id, Connection* c) {
+            auto it = m_subscribers.find(id);
+            if (it == m_subscribers.end()) return;
+            auto& list = it->second;
+            list.erase(std::remove(list.begin(), list.end(), c), list.end());
+            if (list.empty()) m_subscribers.erase(it);
+        }
+
+        void on_wake() {
+            std::uint64_t count = 0;
+            [[maybe_unused]] const ssize_t n = ::read(m_wake, &count, sizeof(count));
+            if (m_stop.load(std::memory_order_acquire)) return;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_netChanged.swap(m_changed);
+                m_netResults.swap(m_results);
+            }
+            for (TagId id : m_netChanged) {
+                auto it = m_subscribers.find(id);
+                if (it == m_subscribers.end()) continue;
+                for (Connection* c : it->second) mark_dirty(*c, id, c->watches[id]);
+            }
+            m_netChanged.clear();
+
+            for (ControlRequest& r : m_netResults) {
+                auto it = m_conns.find(r.conn);
+                if (it == m_conns.end()) continue;
+                Connection& c = *it->second;
+                if (r.resolve) {
+                    protocol::FrameWriter out(c.out);
+                    out.begin(protocol::reply_op(protocol::Op::Resolve), r.request);
+                    out.u32(static_cast<std::uint32_t>(r.handles.size()));
+                    for (TagId id : r.handles) out.u32(id);
+                    out.end();
+                }
+                else if (r.read) {
+                    // The tags of the parked read are mirrored now, or do not
+                    // exist.
+                    auto p = std::find_if(c.parked.begin(), c.parked.end(),
+                        [&](const auto& entry) { return entry.first == r.request; });
+                    if (p == c.parked.end()) continue;
+                    const std::vector<std::uint8_t> frame = std::move(p->second);
+                    c.parked.erase(p);
+                    handle(c, frame.data(), frame.size(), true);
+                }
+            }
+            m_netResults.clear();
+
+            for (auto it = m_conns.begin(); it != m_conns.end();) {
+                Connection& c = *(it++)->second;
+                if (c.stalled && !resume(c)) {
+                    close_connection(c);
+                    continue;
+                }
+                pump_updates(c);
+                if (!flush(c)) close_connection(c);
+            }
+        }
+
+        // Turns the dirty subscriptions of a client into one Update frame,
+        // unless the client is not keeping up; then they stay dirty and only
+        // the latest value is sent once it drains.
+        void pump_updates(Connection& c) {
+            if (c.dirty.empty() || c.out.size() - c.outSent > out_high_water) return;
+
+            protocol::FrameWriter out(c.out);
+            out.begin(static_cast<std::uint8_t>(protocol::Op::Update), 0);
+            const std::size_t countAt = c.out.size();
+            out.u32(0);
+            std::uint32_t n = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (TagId id : c.dirty) {
+                    auto it = c.watches.find(id);
+                    if (it == c.watches.end()) continue;
+                    Watch& w = it->second;
+                    w.dirty = false;
+                    const Value& v = m_values[id];
+                    if (w.sent && !outside_deadband(w.last, v, w.deadband)) continue;
+                    w.last = v;
+                    w.sent = true;
+                    out.u32(id);
+                    out.value(v);
+                    ++n;
+                }
+            }
+            c.dirty.clear();
+            if (n == 0) {
+                c.out.resize(c.out.size() - out.size());
+                return;
+            }
+            std::memcpy(c.out.data() + countAt, &n, sizeof(n));
+            out.end();
+            m_statUpdates.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        static bool outside_deadband(const Value& last, const Value& v, double deadband) {
+            double a = 0.0;
+            double b = 0.0;
+            if (deadband > 0.0 && last.type() == v.type() && to_double(last, a) && to_double(v, b)) {
+                return std::fabs(b - a) >= deadband;
+            }
+            return !last.equals(v);
+        }
+
+        // Sends what the socket takes; arms EPOLLOUT for the rest.
+        bool flush(Connection& c) {
+            while (c.writable && c.outSent < c.out.size()) {
+                const ssize_t n = ::send(c.fd, c.out.data() + c.outSent, c.out.size() - c.outSent, MSG_NOSIGNAL);
+                if (n > 0) {
+                    c.outSent += static_cast<std::size_t>(n);
+                    m_statBytesOut.fetch_add(static_cast<std::uint64_t>(n), std::memory_order_relaxed);
+                    continue;
+                }
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    c.writable = false;
+                    break;
+                }
+                return false;
+            }
+            if (c.outSent == c.out.size()) {
+                c.out.clear();
+                c.outSent = 0;
+            }
+
+            epoll_event ev{};
+            ev.events = (c.stalled ? 0u : static_cast<std::uint32_t>(EPOLLIN | EPOLLRDHUP))
+                | (c.writable ? 0u : static_cast<std::uint32_t>(EPOLLOUT));
+            ev.data.u64 = c.id;
+            ::epoll_ctl(m_epoll, EPOLL_CTL_MOD, c.fd, &ev);
+            return true;
+        }
+
+        void close_connection(Connection& c) {
+            set_stalled(c, false);
+            for (const auto& w : c.watches) drop_subscriber(w.first, &c);
+            ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, c.fd, nullptr);
+            ::close(c.fd);
+            m_conns.erase(c.id);
+        }
+
+        VariableStore& m_store;
+        IngestQueue& m_ingest;
+
+        // UI thread only.
+        std::vector<std::uint8_t> m_watched;
+        std::vector<std::uint8_t> m_dirtyFlag;
+        std::vector<TagId> m_dirty;
+        std::vector<Subscription> m_watchSubs;
+        std::vector<ControlRequest> m_uiRequests;
+
+        // Shared, guarded by m_mutex.
+        std::mutex m_mutex;
+        std::vector<Value> m_values;
+        std::vector<std::uint8_t> m_published;
+        std::vector<TagId> m_changed;
+        std::vector<ControlRequest> m_requests;
+        std::vector<ControlRequest> m_results;
+        std::atomic<bool> m_hasRequests{ false };
+        std::atomic<bool> m_writesBlocked{ false };  // some connection waits for the drain
+
+        // Network thread only.
+        std::vector<int> m_listeners;
+        std::vector<std::string> m_unixPaths;
+        std::uint16_t m_tcpPort{ 0 };
+        int m_epoll{ -1 };
+        int m_wake{ -1 };
+        std::unordered_map<std::uint64_t, std::unique_ptr<Connection>> m_conns;
+        std::unordered_map<TagId, std::vector<Connection*>> m_subscribers;
+        std::uint64_t m_nextConn{ first_connection };
+        std::vector<TagId> m_handles;
+        std::vector<TagId> m_netChanged;
+        std::vector<ControlRequest> m_netResults;
+        std::size_t m_stalled{ 0 };
+
+        std::thread m_thread;
+        std::atomic<bool> m_stop{ false };
+        std::atomic<std::uint64_t> m_statConnections{ 0 };
+        std::atomic<std::uint64_t> m_statRequests{ 0 };
+        std::atomic<std::uint64_t> m_statWrites{ 0 };
+        std::atomic<std::uint64_t> m_statUpdates{ 0 };
+        std::atomic<std::uint64_t> m_statBytesOut{ 0 };
+    };
+
+}
+
+#endif
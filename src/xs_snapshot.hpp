@@ -0,0 +1,368 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "xs_core.hpp"
+#include "xs_mapped_file.hpp"
+
+namespace xs::core {
+
+    // Binary image of every tag in a store, used to bring retentive values
+    // back after a restart. Layout: header, one record per tag in TagId order,
+    // then a pool holding the names and the text of string values. Offsets
+    // are relative to the start of the pool.
+    inline constexpr char snapshot_magic[8] = { 'X', 'S', 'S', 'N', 'A', 'P', '0', '1' };
+    inline constexpr std::uint32_t snapshot_version = 1;
+
+    struct SnapshotHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t tagCount;
+        std::uint64_t poolBytes;
+        std::uint64_t reserved;
+    };
+
+    // bits holds an int64 for Int, Bool and Int64, the bits of a double for
+    // Float and Double, and the pool offset of the text for String.
+    struct SnapshotRecord {
+        std::uint32_t nameOffset;
+        std::uint32_t nameLength;
+        std::uint32_t textLength;
+        Value::Type type;
+        std::uint8_t reserved[3];
+        std::uint64_t bits;
+    };
+
+    static_assert(sizeof(SnapshotHeader) % 8 == 0, "snapshot header must keep 8-byte alignment");
+    static_assert(sizeof(SnapshotRecord) % 8 == 0, "snapshot record must keep 8-byte alignment");
+
+    namespace detail {
+
+        template <typename T>
+        T load_pod(const std::uint8_t* p) {
+            T v;
+            std::memcpy(&v, p, sizeof(T));
+            return v;
+        }
+
+        inline std::uint64_t double_bits(double d) {
+            std::uint64_t b;
+            std::memcpy(&b, &d, sizeof(b));
+            return b;
+        }
+
+        inline double bits_double(std::uint64_t b) {
+            double d;
+            std::memcpy(&d, &b, sizeof(d));
+            return d;
+        }
+
+        // Serialises count tags; name(k) returns a string_view, value(k) a
+        // const Value&. Fails only if the pool outgrows 32-bit offsets.
+        template <typename NameAt, typename ValueAt>
+        bool encode_snapshot(std::size_t count, NameAt name, ValueAt value, std::vector<std::uint8_t>& out) {
+            if (count > std::numeric_limits<std::uint32_t>::max()) return false;
+
+            std::uint64_t pool = 0;
+            for (std::size_t k = 0; k < count; ++k) {
+                pool += name(k).size();
+                const Value& v = value(k);
+                if (v.type() == Value::Type::String) pool += v.as_string().size();
+            }
+            if (pool > std::numeric_limits<std::uint32_t>::max()) return false;
+
+            const std::size_t recordsAt = sizeof(SnapshotHeader);
+            const std::size_t poolAt = recordsAt + count * sizeof(SnapshotRecord);
+            out.resize(poolAt + static_cast<std::size_t>(pool));
+
+            SnapshotHeader h{};
+            std::memcpy(h.magic, snapshot_magic, sizeof(h.magic));
+            h.version = snapshot_version;
+            h.tagCount = static_cast<std::uint32_t>(count);
+            h.poolBytes = pool;
+            std::memcpy(out.data(), &h, sizeof(h));
+
+            std::uint8_t* rec = out.data() + recordsAt;
+            std::uint8_t* text = out.data() + poolAt;
+            std::uint32_t used = 0;
+            auto put = [&](std::string_view s) {
+                if (!s.empty()) std::memcpy(text + used, s.data(), s.size());
+                const std::uint32_t at = used;
+                used += static_cast<std::uint32_t>(s.size());
+                return at;
+            };
+
+            for (std::size_t k = 0; k < count; ++k, rec += sizeof(SnapshotRecord)) {
+                const std::string_view n = name(k);
+                const Value& v = value(k);
+                SnapshotRecord r{};
+                r.nameOffset = put(n);
+                r.nameLength = static_cast<std::uint32_t>(n.size());
+                r.type = v.type();
+                switch (v.type()) {
+                case Value::Type::Int:    r.bits = static_cast<std::uint64_t>(static_cast<std::int64_t>(v.as_int())); break;
+                case Value::Type::Bool:   r.bits = v.as_bool() ? 1 : 0; break;
+                case Value::Type::Int64:  r.bits = static_cast<std::uint64_t>(v.as_int64()); break;
+                case Value::Type::Float:  r.bits = double_bits(v.as_float()); break;
+                case Value::Type::Double: r.bits = double_bits(v.as_double()); break;
+                case Value::Type::String: {
+                    const std::string_view s = v.as_string();
+                    r.bits = put(s);
+                    r.textLength = static_cast<std::uint32_t>(s.size());
+                    break;
+                }
+                }
+                std::memcpy(rec, &r, sizeof(r));
+            }
+            return true;
+        }
+
+        // Writes to a temporary file next to path and renames it over path,
+        // so a crash mid-write leaves the previous snapshot intact.
+        inline bool write_file_atomic(const std::string& path, const std::vector<std::uint8_t>& bytes, std::string& error) {
+            const std::string tmp = path + ".tmp";
+            {
+                std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+                out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+                out.flush();
+                if (!out) {
+                    error = "cannot write " + tmp;
+                    return false;
+                }
+            }
+            std::error_code ec;
+            std::filesystem::rename(tmp, path, ec);
+            if (ec) {
+                error = "cannot rename " + tmp + ": " + ec.message();
+                return false;
+            }
+            return true;
+        }
+
+    }
+
+    inline bool save_snapshot(const VariableStore& store, const std::string& path, std::string& error) {
+        std::vector<std::uint8_t> bytes;
+        const bool ok = detail::encode_snapshot(store.size(),
+            [&](std::size_t k) { return std::string_view(store.name(static_cast<TagId>(k))); },
+            [&](std::size_t k) -> const Value& { return store.at(static_cast<TagId>(k)).get(); },
+            bytes);
+        if (!ok) {
+            error = "snapshot too large";
+            return false;
+        }
+        return detail::write_file_atomic(path, bytes, error);
+    }
+
+    // Creates missing tags with their saved value and writes the saved value
+    // into existing ones. The writes go through one batch, so subscribers see
+    // each restored tag once. The file is validated before anything changes.
+    inline bool load_snapshot(VariableStore& store, const std::string& path, std::string& error) {
+        MappedFile file;
+        if (!file.open(path)) {
+            error = "cannot open " + path;
+            return false;
+        }
+        const std::uint8_t* base = file.data();
+        const std::size_t size = file.size();
+
+        if (size < sizeof(SnapshotHeader)) {
+            error = path + ": truncated snapshot";
+            return false;
+        }
+        const SnapshotHeader h = detail::load_pod<SnapshotHeader>(base);
+        if (std::memcmp(h.magic, snapshot_magic, sizeof(h.magic)) != 0) {
+            error = path + ": not a snapshot";
+            return false;
+        }
+        if (h.version != snapshot_version) {
+            error = path + ": unsupported snapshot version " + std::to_string(h.version);
+            return false;
+        }
+        const std::size_t poolAt = sizeof(SnapshotHeader) + static_cast<std::size_t>(h.tagCount) * sizeof(SnapshotRecord);
+        if (poolAt > size || h.poolBytes != size - poolAt) {
+            error = path + ": truncated snapshot";
+            return false;
+        }
+
+        const std::uint8_t* records = base + sizeof(SnapshotHeader);
+        const char* pool = reinterpret_cast<const char*>(base + poolAt);
+        auto in_pool = [&](std::uint64_t at, std::uint64_t length) {
+            return at <= h.poolBytes && length <= h.poolBytes - at;
+        };
+        for (std::uint32_t k = 0; k < h.tagCount; ++k) {
+            const SnapshotRecord r = detail::load_pod<SnapshotRecord>(records + k * sizeof(SnapshotRecord));
+            const bool typeOk = static_cast<std::uint8_t>(r.type) <= static_cast<std::uint8_t>(Value::Type::Int64);
+            if (!typeOk || r.nameLength == 0 || !in_pool(r.nameOffset, r.nameLength)
+                || (r.type == Value::Type::String && !in_pool(r.bits, r.textLength))) {
+                error = path + ": corrupt record " + std::to_string(k);
+                return false;
+            }
+        }
+
+        store.reserve(store.size() + h.tagCount);
+        UpdateBatch batch(store);
+        std::string name;
+        for (std::uint32_t k = 0; k < h.tagCount; ++k) {
+            const SnapshotRecord r = detail::load_pod<SnapshotRecord>(records + k * sizeof(SnapshotRecord));
+            Value v;
+            switch (r.type) {
+            case Value::Type::Int:    v = Value::make_int(static_cast<int>(static_cast<std::int64_t>(r.bits))); break;
+            case Value::Type::Bool:   v = Value::make_bool(r.bits != 0); break;
+            case Value::Type::Int64:  v = Value::make_int64(static_cast<std::int64_t>(r.bits)); break;
+            case Value::Type::Float:  v = Value::make_float(static_cast<float>(detail::bits_double(r.bits))); break;
+            case Value::Type::Double: v = Value::make_double(detail::bits_double(r.bits)); break;
+            case Value::Type::String: v = Value::make_string(std::string_view(pool + r.bits, r.textLength)); break;
+            }
+            name.assign(pool + r.nameOffset, r.nameLength);
+            const std::size_t before = store.size();
+            const TagId id = store.ensure_tag(name, v);
+            if (store.size() == before) store.set(id, v);
+        }
+        return true;
+    }
+
+    // Periodic snapshots that keep the UI thread out of the file I/O. A
+    // capture copies the values (copying a Value never allocates; long strings
+    // are shared) and any names added since this buffer was last used into one
+    // of two buffers; a worker thread encodes and writes it while the next
+    // capture fills the other. A capture is skipped while both are busy.
+    class SnapshotWriter final {
+    public:
+        explicit SnapshotWriter(std::string path, std::int64_t intervalMs = 10000)
+            : m_path(std::move(path)), m_interval(intervalMs), m_worker([this] { run(); }) {}
+
+        ~SnapshotWriter() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            m_worker.join();
+        }
+
+        SnapshotWriter(const SnapshotWriter&) = delete;
+        SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+        // Captures once the interval has passed; call from the loop that owns
+        // the store.
+        void tick(const VariableStore& store) {
+            const std::int64_t now = now_ms();
+            if (m_started && now - m_last < m_interval) return;
+            m_started = true;
+            m_last = now;
+            capture(store);
+        }
+
+        // When tick() next captures, as now_ms().
+        std::int64_t next_due() const { return m_started ? m_last + m_interval : 0; }
+
+        // Returns false if the capture was skipped.
+        bool capture(const VariableStore& store) {
+            Buffer& b = m_buffers[m_back];
+            if (b.busy.load(std::memory_order_acquire)) {
+                ++m_skipped;
+                return false;
+            }
+
+            const std::size_t n = store.size();
+            b.names.reserve(n);
+            for (std::size_t k = b.names.size(); k < n; ++k) b.names.push_back(store.name(static_cast<TagId>(k)));
+            b.values.resize(n);
+            for (std::size_t k = 0; k < n; ++k) b.values[k] = store.at(static_cast<TagId>(k)).get();
+
+            b.busy.store(true, std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_jobs.push_back(m_back);
+            }
+            m_wake.notify_one();
+            m_back ^= 1;
+            return true;
+        }
+
+        // Blocks until every capture so far is on disk.
+        void wait() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_idle.wait(lock, [this] { return m_jobs.empty() && !m_writing; });
+        }
+
+        const std::string& path() const { return m_path; }
+        std::uint64_t written() const { return m_written.load(); }
+        std::uint64_t failed() const { return m_failed.load(); }
+        std::uint64_t skipped() const { return m_skipped; }
+
+        std::string last_error() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_error;
+        }
+
+    private:
+        struct Buffer {
+            std::vector<std::string> names;
+            std::vector<Value> values;
+            std::atomic<bool> busy{ false };
+        };
+
+        void run() {
+            std::vector<std::uint8_t> bytes;
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for (;;) {
+                m_wake.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+                if (m_jobs.empty()) return;
+                const int index = m_jobs.front();
+                m_jobs.pop_front();
+                m_writing = true;
+                lock.unlock();
+
+                Buffer& b = m_buffers[index];
+                std::string error = "snapshot too large";
+                const bool ok = detail::encode_snapshot(b.values.size(),
+                    [&](std::size_t k) { return std::string_view(b.names[k]); },
+                    [&](std::size_t k) -> const Value& { return b.values[k]; },
+                    bytes) && detail::write_file_atomic(m_path, bytes, error);
+                b.busy.store(false, std::memory_order_release);
+                (ok ? m_written : m_failed).fetch_add(1);
+
+                lock.lock();
+                if (!ok) m_error = error;
+                m_writing = false;
+                if (m_jobs.empty()) m_idle.notify_all();
+            }
+        }
+
+        std::string m_path;
+        std::int64_t m_interval;
+        Buffer m_buffers[2];
+        int m_back{ 0 };
+        bool m_started{ false };
+        std::int64_t m_last{ 0 };
+        std::uint64_t m_skipped{ 0 };
+        std::atomic<std::uint64_t> m_written{ 0 };
+        std::atomic<std::uint64_t> m_failed{ 0 };
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_idle;
+        std::deque<int> m_jobs;
+        std::string m_error;
+        bool m_writing{ false };
+        bool m_stop{ false };
+        std::thread m_worker;
+    };
+
+}
@@ -0,0 +1,1552 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "xs_core.hpp"
+#include "xs_decimation.hpp"
+#include "xs_format.hpp"
+#include "xs_metrics.hpp"
+
+namespace xs::ui {
+    
+    struct Theme {
+        sf::Color bg{ sf::Color(22, 22, 26) };
+        sf::Color panel{ sf::Color(34, 34, 40) };
+        sf::Color border{ sf::Color(90, 90, 105) };
+        sf::Color text{ sf::Color(235, 235, 240) };
+        sf::Color hint{ sf::Color(170, 170, 185) };
+        sf::Color accent{ sf::Color(80, 160, 255) };
+        sf::Color uncertain{ sf::Color(240, 190, 70) };
+        sf::Color bad{ sf::Color(235, 85, 85) };
+    };
+
+    // Text colour for a bound value: warnings for doubtful data, and the
+    // hint colour for values frozen by a lost connection.
+    inline sf::Color quality_color(const Theme& theme, xs::core::Quality q) {
+        switch (q) {
+        case xs::core::Quality::Uncertain:   return theme.uncertain;
+        case xs::core::Quality::Bad:         return theme.bad;
+        case xs::core::Quality::CommFailure: return theme.hint;
+        default:                             return theme.text;
+        }
+    }
+
+    inline std::string value_to_string(const xs::core::Value& v) {
+        static const xs::core::FormatSpec spec;
+        xs::core::FormatBuffer buf;
+        return std::string(xs::core::format_value(v, spec, buf));
+    }
+
+    inline sf::FloatRect unite(const sf::FloatRect& a, const sf::FloatRect& b) {
+        if (a.width <= 0.f || a.height <= 0.f) return b;
+        if (b.width <= 0.f || b.height <= 0.f) return a;
+        const float left = std::min(a.left, b.left);
+        const float top = std::min(a.top, b.top);
+        const float right = std::max(a.left + a.width, b.left + b.width);
+        const float bottom = std::max(a.top + a.height, b.top + b.height);
+        return sf::FloatRect(left, top, right - left, bottom - top);
+    }
+
+    // SFML 2.6 has no waitEvent() timeout, so poll with short sleeps instead.
+    // The wait also ends early once wake() returns true, e.g. when another
+    // thread has queued tag updates.
+    template <typename Wake>
+    bool wait_event(sf::RenderWindow& window, sf::Event& e, sf::Time timeout, Wake&& wake) {
+        sf::Clock waited;
+        while (!window.pollEvent(e)) {
+            if (waited.getElapsedTime() >= timeout || wake()) return false;
+            sf::sleep(sf::milliseconds(5));
+        }
+        return true;
+    }
+
+    inline bool wait_event(sf::RenderWindow& window, sf::Event& e, sf::Time timeout) {
+        return wait_event(window, e, timeout, [] { return false; });
+    }
+
+    struct FrameStats {
+        std::uint64_t frames{ 0 };
+        std::uint64_t skipped{ 0 };
+        std::uint64_t full_repaints{ 0 };
+        std::uint64_t regions{ 0 };
+    };
+
+    struct DrawStats {
+        std::uint64_t calls{ 0 };
+        std::uint64_t vertices{ 0 };
+    };
+
+    inline DrawStats& draw_stats() {
+        thread_local DrawStats stats;
+        return stats;
+    }
+
+    inline void draw_counted(sf::RenderTarget& target, const sf::Drawable& d,
+        const sf::RenderStates& states = sf::RenderStates::Default) {
+        ++draw_stats().calls;
+        target.draw(d, states);
+    }
+
+    class Widget;
+
+    // Collects widget boxes into one triangle list and text into one glyph
+    // quad list per (font, character size), so a whole panel is drawn with a
+    // handful of draw calls. Boxes are drawn before text; widgets without a
+    // batched representation are drawn individually afterwards.
+    class RenderBatch final {
+    public:
+        void clear() {
+            m_shapes.clear();
+            for (auto& layer : m_text) layer.vertices.clear();
+            m_custom.clear();
+        }
+
+        bool empty() const {
+            if (!m_shapes.empty() || !m_custom.empty()) return false;
+            for (const auto& l : m_text) {
+                if (!l.vertices.empty()) return false;
+            }
+            return true;
+        }
+
+        void add_rect(const sf::FloatRect& r, const sf::Color& fill) {
+            if (fill.a == 0 || r.width <= 0.f || r.height <= 0.f) return;
+            add_quad(m_shapes, r.left, r.top, r.left + r.width, r.top + r.height, fill);
+        }
+
+        void add_shape(const sf::RectangleShape& box) {
+            const sf::Vector2f p = box.getPosition();
+            const sf::Vector2f sz = box.getSize();
+            add_rect(sf::FloatRect(p.x, p.y, sz.x, sz.y), box.getFillColor());
+
+            const float t = box.getOutlineThickness();
+            const sf::Color c = box.getOutlineColor();
+            if (t <= 0.f || c.a == 0) return;
+            const float l = p.x, top = p.y, r = p.x + sz.x, b = p.y + sz.y;
+            add_quad(m_shapes, l - t, top - t, r + t, top, c);
+            add_quad(m_shapes, l - t, b, r + t, b + t, c);
+            add_quad(m_shapes, l - t, top, l, b, c);
+            add_quad(m_shapes, r, top, r + t, b, c);
+        }
+
+        // Mirrors sf::Text's layout for the regular style with default
+        // spacing; only the text's position is honoured, not its rotation,
+        // scale or origin.
+        void add_text(const sf::Text& text) {
+            const sf::Font* font = text.getFont();
+            const sf::String& str = text.getString();
+            if (!font || str.isEmpty()) return;
+
+            const unsigned int size = text.getCharacterSize();
+            std::vector<sf::Vertex>& out = layer(font, size);
+            const sf::Color color = text.getFillColor();
+            const sf::Vector2f origin = text.getPosition();
+
+            const float whitespace = font->getGlyph(L' ', size, false).advance;
+            const float lineSpacing = font->getLineSpacing(size);
+            float x = 0.f;
+            float y = static_cast<float>(size);
+            sf::Uint32 prev = 0;
+
+            for (std::size_t k = 0; k < str.getSize(); ++k) {
+                const sf::Uint32 c = str[k];
+                if (c == L'\r') continue;
+
+                x += font->getKerning(prev, c, size);
+                prev = c;
+
+                if (c == L' ') { x += whitespace; continue; }
+                if (c == L'\t') { x += whitespace * 4.f; continue; }
+                if (c == L'\n') { y += lineSpacing; x = 0.f; continue; }
+
+                const sf::Glyph& g = font->getGlyph(c, size, false);
+                const float pad = 1.f;
+                const float left = origin.x + x + g.bounds.left - pad;
+                const float top = origin.y + y + g.bounds.top - pad;
+                const float right = origin.x + x + g.bounds.left + g.bounds.width + pad;
+                const float bottom = origin.y + y + g.bounds.top + g.bounds.height + pad;
+
+                const float u1 = static_cast<float>(g.textureRect.left) - pad;
+                const float v1 = static_cast<float>(g.textureRect.top) - pad;
+                const float u2 = static_cast<float>(g.textureRect.left + g.textureRect.width) + pad;
+                const float v2 = static_cast<float>(g.textureRect.top + g.textureRect.height) + pad;
+
+                out.emplace_back(sf::Vector2f(left, top), color, sf::Vector2f(u1, v1));
+                out.emplace_back(sf::Vector2f(right, top), color, sf::Vector2f(u2, v1));
+                out.emplace_back(sf::Vector2f(left, bottom), color, sf::Vector2f(u1, v2));
+                out.emplace_back(sf::Vector2f(left, bottom), color, sf::Vector2f(u1, v2));
+                out.emplace_back(sf::Vector2f(right, top), color, sf::Vector2f(u2, v1));
+                out.emplace_back(sf::Vector2f(right, bottom), color, sf::Vector2f(u2, v2));
+
+                x += g.advance;
+            }
+        }
+
+        void add_custom(const Widget& w) { m_custom.push_back(&w); }
+
+        void draw(sf::RenderTarget& target) const;
+
+    private:
+        struct TextLayer {
+            const sf::Font* font{ nullptr };
+            unsigned int size{ 0 };
+            std::vector<sf::Vertex> vertices;
+        };
+
+        static void add_quad(std::vector<sf::Vertex>& out, float l, float t, float r, float b, const sf::Color& c) {
+            out.emplace_back(sf::Vector2f(l, t), c);
+            out.emplace_back(sf::Vector2f(r, t), c);
+            out.emplace_back(sf::Vector2f(l, b), c);
+            out.emplace_back(sf::Vector2f(l, b), c);
+            out.emplace_back(sf::Vector2f(r, t), c);
+            out.emplace_back(sf::Vector2f(r, b), c);
+        }
+
+        std::vector<sf::Vertex>& layer(const sf::Font* font, unsigned int size) {
+            for (auto& l : m_text) {
+                if (l.font == font && l.size == size) return l.vertices;
+            }
+            m_text.push_back(TextLayer{ font, size, {} });
+            return m_text.back().vertices;
+        }
+
+        std::vector<sf::Vertex> m_shapes;
+        std::vector<TextLayer> m_text;
+        std::vector<const Widget*> m_custom;
+    };
+
+    class Widget {
+    public:
+        virtual ~Widget() = default;
+
+        virtual void handle_event(const sf::Event& e, const sf::RenderWindow& window) = 0;
+        virtual void update(float dt) { (void)dt; }
+        virtual void draw(sf::RenderTarget& target) const = 0;
+
+        // Adds this widget's geometry to a RenderBatch; widgets that do not
+        // override it are drawn with draw() after the batch.
+        virtual void batch(RenderBatch& b) const { b.add_custom(*this); }
+
+        virtual void set_position(const sf::Vector2f& p) { m_pos = p; mark_dirty(); geometry_changed(); }
+        virtual void set_size(const sf::Vector2f& s) { m_size = s; mark_dirty(); geometry_changed(); }
+
+        sf::Vector2f position() const { return m_pos; }
+        sf::Vector2f size() const { return m_size; }
+
+        // Area touched by draw(); includes outlines and text overflowing the box.
+        virtual sf::FloatRect visual_bounds() const {
+            return sf::FloatRect(m_pos.x - 1.f, m_pos.y - 1.f, m_size.x + 2.f, m_size.y + 2.f);
+        }
+
+        void mark_dirty() { m_dirty = true; }
+        virtual bool needs_redraw() const { return m_dirty; }
+        virtual void clear_dirty() { m_dirty = false; }
+
+        bool contains(const sf::Vector2f& p) const {
+            return (p.x >= m_pos.x && p.x <= m_pos.x + m_size.x &&
+                p.y >= m_pos.y && p.y <= m_pos.y + m_size.y);
+        }
+
+        void set_enabled(bool enabled) { m_enabled = enabled; mark_dirty(); }
+        bool enabled() const { return m_enabled; }
+
+        // Keyboard and text events are only delivered to the focused widget.
+        virtual bool has_focus() const { return false; }
+
+        void set_parent(Widget* parent) { m_parent = parent; }
+        virtual void child_geometry_changed() {}
+
+        // Drops tag subscriptions and callbacks, e.g. before the widget
+        // goes back to a WidgetPool.
+        virtual void unbind() {}
+
+    protected:
+        void geometry_changed() {
+            if (m_parent) m_parent->child_geometry_changed();
+        }
+
+        // Base part of the reset() of pooled widgets.
+        void reset_widget() {
+            m_parent = nullptr;
+            m_pos = sf::Vector2f(0.f, 0.f);
+            m_enabled = true;
+            m_dirty = true;
+        }
+
+        Widget* m_parent{ nullptr };
+        sf::Vector2f m_pos{ 0.f, 0.f };
+        sf::Vector2f m_size{ 0.f, 0.f };
+        bool m_enabled{ true };
+        bool m_dirty{ true };
+    };
+
+    inline void RenderBatch::draw(sf::RenderTarget& target) const {
+        DrawStats& stats = draw_stats();
+        if (!m_shapes.empty()) {
+            ++stats.calls;
+            stats.vertices += m_shapes.size();
+            target.draw(m_shapes.data(), m_shapes.size(), sf::Triangles);
+        }
+        for (const auto& l : m_text) {
+            if (l.vertices.empty()) continue;
+            ++stats.calls;
+            stats.vertices += l.vertices.size();
+            target.draw(l.vertices.data(), l.vertices.size(), sf::Triangles,
+                sf::RenderStates(&l.font->getTexture(l.size)));
+        }
+        for (const Widget* w : m_custom) w->draw(target);
+    }
+
+    // Shaped single-line text: the UTF-32 string handed to sf::Text and the
+    // pen position before each character, so caret placement is a lookup.
+    struct TextLayout {
+        sf::String text;
+        std::vector<float> caret;
+
+        float width() const { return caret.empty() ? 0.f : caret.back(); }
+        float caret_x(std::size_t pos) const {
+            if (caret.empty()) return 0.f;
+            return caret[std::min(pos, caret.size() - 1)];
+        }
+    };
+
+    // Layouts keyed by (font, size, string). Repeated values such as
+    // "ON"/"OFF" are shaped once and assigning the cached sf::String to a
+    // text reuses its buffer. Glyph advances are kept per (font, size) for
+    // ASCII. The cache is dropped as a whole once it holds 'capacity'
+    // layouts, so returned references are valid until the next get().
+    class TextLayoutCache final {
+    public:
+        explicit TextLayoutCache(std::size_t capacity = 4096) : m_capacity(capacity) {}
+
+        const TextLayout& get(const sf::Font& font, unsigned int size, std::string_view s) {
+            const std::uint64_t key = hash(font, size, s);
+            auto it = m_index.find(key);
+            if (it != m_index.end()) {
+                Entry& e = m_entries[it->second];
+                if (e.font == &font && e.size == size && e.key == s) {
+                    ++m_hits;
+                    return e.layout;
+                }
+            }
+
+            ++m_misses;
+            if (m_entries.size() >= m_capacity) clear();
+
+            Entry& e = m_entries.emplace_back();
+            e.font = &font;
+            e.size = size;
+            e.key.assign(s.data(), s.size());
+            shape(font, size, e);
+            m_index[key] = m_entries.size() - 1;
+            return e.layout;
+        }
+
+        void clear() {
+            m_entries.clear();
+            m_index.clear();
+        }
+
+        std::size_t size() const { return m_entries.size(); }
+        std::uint64_t hits() const { return m_hits; }
+        std::uint64_t misses() const { return m_misses; }
+
+    private:
+        struct Entry {
+            const sf::Font* font{ nullptr };
+            unsigned int size{ 0 };
+            std::string key;
+            TextLayout layout;
+        };
+
+        struct Advances {
+            float ascii[128];
+            bool known[128];
+        };
+
+        static std::uint64_t hash(const sf::Font& font, unsigned int size, std::string_view s) {
+            std::uint64_t h = 14695981039346656037ull;
+            const auto mix = [&h](std::uint64_t v) { h = (h ^ v) * 1099511628211ull; };
+            mix(reinterpret_cast<std::uintptr_t>(&font));
+            mix(size);
+            for (unsigned char c : s) mix(c);
+            return h;
+        }
+
+        float advance(const sf::Font& font, unsigned int size, Advances& table, std::uint32_t c) {
+            if (c >= 128) return font.getGlyph(c, size, false).advance;
+            if (!table.known[c]) {
+                table.ascii[c] = font.getGlyph(c, size, false).advance;
+                table.known[c] = true;
+            }
+            return table.ascii[c];
+        }
+
+        // Matches sf::Text::findCharacterPos() for regular, single-line text.
+        void shape(const sf::Font& font, unsigned int size, Entry& e) {
+            Advances& table = m_advances[(reinterpret_cast<std::uintptr_t>(&font) << 8) ^ size];
+            e.layout.text = sf::String(e.key);
+            const std::size_t n = e.layout.text.getSize();
+            e.layout.caret.resize(n + 1);
+
+            float x = 0.f;
+            std::uint32_t prev = 0;
+            e.layout.caret[0] = 0.f;
+            for (std::size_t k = 0; k < n; ++k) {
+                const std::uint32_t c = e.layout.text[k];
+                x += font.getKerning(prev, c, size);
+                prev = c;
+                if (c == '\t') x += 4.f * advance(font, size, table, ' ');
+                else if (c != '\n') x += advance(font, size, table, c);
+                e.layout.caret[k + 1] = x;
+            }
+        }
+
+        std::size_t m_capacity;
+        std::deque<Entry> m_entries;
+        std::unordered_map<std::uint64_t, std::size_t> m_index;
+        std::unordered_map<std::uint64_t, Advances> m_advances;
+        std::uint64_t m_hits{ 0 };
+        std::uint64_t m_misses{ 0 };
+    };
+
+    inline TextLayoutCache& text_layouts() {
+        thread_local TextLayoutCache cache;
+        return cache;
+    }
+
+    // When a bound label picks up tag changes. A change only marks the label
+    // stale; update() pulls the latest value at most once per intervalMs
+    // (0 = once per frame), so the tag rate never reaches text layout.
+    // Numeric changes smaller than deadband against the displayed value are
+    // dropped. immediate formats inside the tag callback instead.
+    struct RefreshPolicy {
+        std::int64_t intervalMs{ 0 };
+        double deadband{ 0.0 };
+        bool immediate{ false };
+    };
+
+    class Label final : public Widget {
+    public:
+        Label(const sf::Font& font, unsigned int charSize, const Theme& theme)
+            : m_theme(theme) {
+            m_text.setFont(font);
+            m_text.setCharacterSize(charSize);
+            m_text.setFillColor(m_theme.text);
+            m_size = sf::Vector2f(300.f, static_cast<float>(charSize) + 10.f);
+        }
+
+        void set_prefix(const std::string& p) {
+            if (p == m_prefix) return;
+            m_prefix = p;
+            rebuild();
+        }
+
+        void set_text(std::string_view t) {
+            if (t == m_valueText) return;
+            m_valueText.assign(t.data(), t.size());
+            rebuild();
+        }
+
+        void bind_to(xs::core::VariableStore& store, const std::string& varName,
+            xs::core::FormatSpec format = {}, RefreshPolicy refresh = {}) {
+            m_tag = store.ensure_tag(varName, xs::core::Value::make_string(""));
+            m_store = &store;
+            m_format = std::move(format);
+            m_refresh = refresh;
+            m_hasShown = false;
+            xs::core::Variable& var = store.at(m_tag);
+
+            m_sub = var.subscribe_scoped([this](const xs::core::Value& v) {
+                if (m_refresh.immediate) show(v);
+                else m_stale = true;
+                });
+            m_stale = false;
+            show(var.get());
+        }
+
+        void unbind() override {
+            m_sub.reset();
+            m_store = nullptr;
+            m_tag = xs::core::invalid_tag;
+            m_stale = false;
+        }
+
+        // Back to the constructed state, keeping string capacity.
+        void reset(const sf::Font& font, unsigned int charSize) {
+            unbind();
+            reset_widget();
+            m_prefix.clear();
+            m_valueText.clear();
+            m_shown.clear();
+            m_format = {};
+            m_refresh = {};
+            m_hasShown = false;
+            m_sinceRefresh = 0.f;
+            m_text.setFont(font);
+            m_text.setCharacterSize(charSize);
+            m_text.setFillColor(m_theme.text);
+            m_text.setString(sf::String());
+            m_text.setPosition(m_pos);
+            m_size = sf::Vector2f(300.f, static_cast<float>(charSize) + 10.f);
+        }
+
+        void update(float dt) override {
+            m_sinceRefresh += dt * 1000.f;
+            if (!m_stale || m_sinceRefresh < static_cast<float>(m_refresh.intervalMs)) return;
+            m_stale = false;
+            m_sinceRefresh = 0.f;
+            show(m_store->get(m_tag));
+        }
+
+        // A due refresh keeps the frame loop from idling.
+        bool needs_redraw() const override {
+            return m_dirty || (m_stale && m_sinceRefresh >= static_cast<float>(m_refresh.intervalMs));
+        }
+
+        void handle_event(const sf::Event&, const sf::RenderWindow&) override {
+            
+        }
+
+        void draw(sf::RenderTarget& target) const override {
+            draw_counted(target, m_text);
+        }
+
+        void batch(RenderBatch& b) const override {
+            b.add_text(m_text);
+        }
+
+        void set_position(const sf::Vector2f& p) override {
+            Widget::set_position(p);
+            m_text.setPosition(m_pos);
+        }
+
+        sf::FloatRect visual_bounds() const override {
+            return unite(Widget::visual_bounds(), m_text.getGlobalBounds());
+        }
+
+    private:
+        void show(const xs::core::Value& v) {
+            const sf::Color color = quality_color(m_theme, m_store->quality(m_tag));
+            if (color != m_text.getFillColor()) {
+                m_text.setFillColor(color);
+                mark_dirty();
+            }
+            double d = 0.0;
+            if (m_refresh.deadband > 0.0 && v.type() != xs::core::Value::Type::Bool && xs::core::to_double(v, d)) {
+                if (m_hasShown && std::fabs(d - m_shownValue) < m_refresh.deadband) return;
+                m_shownValue = d;
+                m_hasShown = true;
+            }
+            xs::core::FormatBuffer buf;
+            set_text(xs::core::format_value(v, m_format, buf));
+        }
+
+        void rebuild() {
+            m_shown.assign(m_prefix);
+            if (!m_shown.empty()) m_shown += ' ';
+            m_shown += m_valueText;
+            m_text.setString(text_layouts().get(*m_text.getFont(), m_text.getCharacterSize(), m_shown).text);
+            mark_dirty();
+        }
+
+    private:
+        Theme m_theme;
+        sf::Text m_text;
+        std::string m_prefix;
+        std::string m_valueText;
+        std::string m_shown;
+        xs::core::FormatSpec m_format;
+        RefreshPolicy m_refresh;
+        xs::core::VariableStore* m_store{ nullptr };
+        xs::core::TagId m_tag{ xs::core::invalid_tag };
+        bool m_stale{ false };
+        bool m_hasShown{ false };
+        float m_sinceRefresh{ 0.f };
+        double m_shownValue{ 0.0 };
+        xs::core::Subscription m_sub;
+    };
+
+    class Button final : public Widget {
+    public:
+        Button(const sf::Font& font, unsigned int charSize, const Theme& theme)
+            : m_theme(theme) {
+            m_box.setFillColor(m_theme.panel);
+            m_box.setOutlineThickness(1.f);
+            m_box.setOutlineColor(m_theme.border);
+
+            m_text.setFont(font);
+            m_text.setCharacterSize(charSize);
+            m_text.setFillColor(m_theme.text);
+
+            m_size = sf::Vector2f(200.f, 40.f);
+            m_box.setSize(m_size);
+        }
+
+        void set_caption(const std::string& s) {
+            m_caption = s;
+            m_text.setString(text_layouts().get(*m_text.getFont(), m_text.getCharacterSize(), m_caption).text);
+            m_textBounds = m_text.getLocalBounds();
+            center_text();
+            mark_dirty();
+        }
+
+        void set_on_click(std::function<void()> fn) { m_onClick = std::move(fn); }
+
+        void bind_toggle_bool(xs::core::VariableStore& store, const std::string& varName) {
+            m_tag = store.ensure_tag(varName, xs::core::Value::make_bool(false));
+            xs::core::Variable& var = store.at(m_tag);
+
+            m_sub = var.subscribe_scoped([this](const xs::core::Value& v) {
+                m_isOn = (v.type() == xs::core::Value::Type::Bool) ? v.as_bool() : false;
+                refresh_style();
+                });
+
+            set_on_click([&store, tag = m_tag]() {
+                const bool cur = store.get_bool(tag, false);
+                store.set(tag, xs::core::Value::make_bool(!cur));
+                });
+        }
+
+        void unbind() override {
+            m_sub.reset();
+            m_tag = xs::core::invalid_tag;
+            m_onClick = nullptr;
+        }
+
+        // Back to the constructed state, keeping string capacity.
+        void reset(const sf::Font& font, unsigned int charSize) {
+            unbind();
+            reset_widget();
+            m_hover = m_pressed = m_isOn = false;
+            m_box.setFillColor(m_theme.panel);
+            m_box.setOutlineColor(m_theme.border);
+            m_box.setPosition(m_pos);
+            m_text.setFont(font);
+            m_text.setCharacterSize(charSize);
+            m_text.setFillColor(m_theme.text);
+            m_text.setString(sf::String());
+            m_textBounds = sf::FloatRect();
+            m_caption = "Button";
+            m_size = sf::Vector2f(200.f, 40.f);
+            m_box.setSize(m_size);
+            center_text();
+        }
+
+        void handle_event(const sf::Event& e, const sf::RenderWindow& window) override {
+            if (!enabled()) return;
+
+            if (e.type == sf::Event::MouseMoved) {
+                const sf::Vector2f p(static_cast<float>(e.mouseMove.x), static_cast<float>(e.mouseMove.y));
+                const bool hover = contains(p);
+                if (hover != m_hover) {
+                    m_hover = hover;
+                    refresh_style();
+                }
+            }
+
+            if (e.type == sf::Event::MouseButtonPressed && e.mouseButton.button == sf::Mouse::Left) {
+                const sf::Vector2f p(static_cast<float>(e.mouseButton.x), static_cast<float>(e.mouseButton.y));
+                if (contains(p)) {
+                    m_pressed = true;
+                    refresh_style();
+                }
+            }
+
+            if (e.type == sf::Event::MouseButtonReleased && e.mouseButton.button == sf::Mouse::Left) {
+                const sf::Vector2f p(static_cast<float>(e.mouseButton.x), static_cast<float>(e.mouseButton.y));
+                const bool wasPressed = m_pressed;
+                m_pressed = false;
+                refresh_style();
+
+                if (wasPressed && contains(p)) {
+                    if (m_onClick) m_onClick();
+                }
+            }
+
+            (void)window;
+        }
+
+        void draw(sf::RenderTarget& target) const override {
+            draw_counted(target, m_box);
+            draw_counted(target, m_text);
+        }
+
+        void batch(RenderBatch& b) const override {
+            b.add_shape(m_box);
+            b.add_text(m_text);
+        }
+
+        void set_position(const sf::Vector2f& p) override {
+            Widget::set_position(p);
+            m_box.setPosition(m_pos);
+            center_text();
+        }
+
+        void set_size(const sf::Vector2f& s) override {
+            Widget::set_size(s);
+            m_box.setSize(m_size);
+            center_text();
+        }
+
+        sf::FloatRect visual_bounds() const override {
+            return unite(Widget::visual_bounds(), m_text.getGlobalBounds());
+        }
+
+    private:
+        void center_text() {
+            const sf::FloatRect& tb = m_textBounds;
+            const float x = m_pos.x + (m_size.x - tb.width) * 0.5f - tb.left;
+            const float y = m_pos.y + (m_size.y - tb.height) * 0.5f - tb.top;
+            m_text.setPosition(sf::Vector2f(x, y));
+        }
+
+        void refresh_style() {
+            sf::Color fill = m_theme.panel;
+            sf::Color outline = m_isOn ? m_theme.accent : m_theme.border;
+            sf::Color text = m_theme.text;
+
+            if (!enabled()) {
+                fill = sf::Color(45, 45, 52);
+                outline = sf::Color(80, 80, 90);
+                text = sf::Color(150, 150, 160);
+            }
+            else if (m_pressed) {
+                fill = sf::Color(28, 28, 34);
+            }
+            else if (m_hover) {
+                fill = sf::Color(40, 40, 48);
+            }
+
+            if (fill == m_box.getFillColor() && outline == m_box.getOutlineColor() &&
+                text == m_text.getFillColor()) return;
+
+            m_box.setFillColor(fill);
+            m_box.setOutlineColor(outline);
+            m_text.setFillColor(text);
+            mark_dirty();
+        }
+
+    private:
+        Theme m_theme;
+        sf::RectangleShape m_box;
+        sf::Text m_text;
+        sf::FloatRect m_textBounds;
+
+        std::string m_caption{ "Button" };
+        std::function<void()> m_onClick;
+
+        bool m_hover{ false };
+        bool m_pressed{ false };
+        bool m_isOn{ false };
+
+        xs::core::TagId m_tag{ xs::core::invalid_tag };
+        xs::core::Subscription m_sub;
+    };
+
+    class TextField final : public Widget {
+    public:
+        TextField(const sf::Font& font, unsigned int charSize, const Theme& theme)
+            : m_theme(theme) {
+            m_box.setFillColor(m_theme.panel);
+            m_box.setOutlineThickness(1.f);
+            m_box.setOutlineColor(m_theme.border);
+
+            m_text.setFont(font);
+            m_text.setCharacterSize(charSize);
+            m_text.setFillColor(m_theme.text);
+
+            m_hintText.setFont(font);
+            m_hintText.setCharacterSize(charSize);
+            m_hintText.setFillColor(m_theme.hint);
+
+            m_caret.setSize(sf::Vector2f(1.f, static_cast<float>(charSize)));
+            m_caret.setFillColor(m_theme.accent);
+
+            m_size = sf::Vector2f(260.f, 40.f);
+            m_box.setSize(m_size);
+        }
+
+        void set_hint(const std::string& s) {
+            m_hint = s;
+            m_hintText.setString(m_hint);
+            mark_dirty();
+        }
+
+        void set_text(std::string_view s) {
+            if (s == m_value) return;
+            m_value.assign(s.data(), s.size());
+            if (m_caretPos > m_value.size()) m_caretPos = m_value.size();
+            apply_text();
+        }
+
+        void bind_string(xs::core::VariableStore& store, const std::string& varName) {
+            m_tag = store.ensure_tag(varName, xs::core::Value::make_string(""));
+            xs::core::Variable& var = store.at(m_tag);
+
+            m_sub = var.subscribe_scoped([this](const xs::core::Value& v) {
+                if (!m_focused && v.type() == xs::core::Value::Type::String) {
+                    this->set_text(v.as_string());
+                }
+                });
+
+            m_commit = [&store, tag = m_tag, this]() {
+                store.set(tag, xs::core::Value::make_string(this->m_value));
+                };
+        }
+
+        void unbind() override {
+            m_sub.reset();
+            m_tag = xs::core::invalid_tag;
+            m_commit = nullptr;
+        }
+
+        // Back to the constructed state, keeping string capacity.
+        void reset(const sf::Font& font, unsigned int charSize) {
+            unbind();
+            reset_widget();
+            m_hint = "Enter text...";
+            m_value.clear();
+            m_caretX.clear();
+            m_focused = false;
+            m_caretPos = 0;
+            m_blinkTimer = 0.f;
+            m_caretVisible = false;
+            m_box.setOutlineColor(m_theme.border);
+            for (sf::Text* t : { &m_text, &m_hintText }) {
+                t->setFont(font);
+                t->setCharacterSize(charSize);
+                t->setString(sf::String());
+            }
+            m_caret.setSize(sf::Vector2f(1.f, static_cast<float>(charSize)));
+            m_size = sf::Vector2f(260.f, 40.f);
+            m_box.setSize(m_size);
+            set_position(m_pos);
+        }
+
+        void handle_event(const sf::Event& e, const sf::RenderWindow& window) override {
+            if (!enabled()) return;
+
+            if (e.type == sf::Event::MouseButtonPressed && e.mouseButton.button == sf::Mouse::Left) {
+                const sf::Vector2f p(static_cast<float>(e.mouseButton.x), static_cast<float>(e.mouseButton.y));
+                const bool nowFocused = contains(p);
+
+                if (m_focused && !nowFocused) {
+                    if (m_commit) m_commit();
+                }
+
+                m_focused = nowFocused;
+                refresh_style();
+
+                if (m_focused) {
+                    m_caretPos = m_value.size();
+                    update_caret_position();
+                }
+            }
+
+            if (!m_focused) return;
+
+            if (e.type == sf::Event::TextEntered) {
+                const sf::Uint32 code = e.text.unicode;
+
+                if (code == 8) {
+                    if (m_caretPos > 0 && !m_value.empty()) {
+                        m_value.erase(m_caretPos - 1, 1);
+                        --m_caretPos;
+                        apply_text();
+                    }
+                    return;
+                }
+
+                if (code == 13) {
+                    if (m_commit) m_commit();
+                    m_focused = false;
+                    refresh_style();
+                    return;
+                }
+
+                if (code == 9) return;
+
+                if (code >= 32 && code <= 126) {
+                    if (m_value.size() < m_maxLen) {
+                        m_value.insert(m_caretPos, 1, static_cast<char>(code));
+                        ++m_caretPos;
+                        apply_text();
+                    }
+                }
+            }
+
+            if (e.type == sf::Event::KeyPressed) {
+                if (e.key.code == sf::Keyboard::Left) {
+                    if (m_caretPos > 0) { --m_caretPos; update_caret_position(); }
+                }
+                else if (e.key.code == sf::Keyboard::Right) {
+                    if (m_caretPos < m_value.size()) { ++m_caretPos; update_caret_position(); }
+                }
+                else if (e.key.code == sf::Keyboard::Escape) {
+                    m_focused = false;
+                    refresh_style();
+                }
+            }
+
+            (void)window;
+        }
+
+        void update(float dt) override {
+            if (!m_focused) { m_caretVisible = false; return; }
+            m_blinkTimer += dt;
+            if (m_blinkTimer >= 0.5f) {
+                m_blinkTimer = 0.f;
+                m_caretVisible = !m_caretVisible;
+                mark_dirty();
+            }
+        }
+
+        void draw(sf::RenderTarget& target) const override {
+            draw_counted(target, m_box);
+
+            if (!m_value.empty()) draw_counted(target, m_text);
+            else draw_counted(target, m_hintText);
+
+            if (m_focused && m_caretVisible) draw_counted(target, m_caret);
+        }
+
+        void batch(RenderBatch& b) const override {
+            b.add_shape(m_box);
+            b.add_text(m_value.empty() ? m_hintText : m_text);
+            if (m_focused && m_caretVisible) b.add_shape(m_caret);
+        }
+
+        void set_position(const sf::Vector2f& p) override {
+            Widget::set_position(p);
+            m_box.setPosition(m_pos);
+
+            const float pad = 10.f;
+            m_text.setPosition(sf::Vector2f(m_pos.x + pad, m_pos.y + 8.f));
+            m_hintText.setPosition(sf::Vector2f(m_pos.x + pad, m_pos.y + 8.f));
+
+            update_caret_position();
+        }
+
+        void set_size(const sf::Vector2f& s) override {
+            Widget::set_size(s);
+            m_box.setSize(m_size);
+            update_caret_position();
+        }
+
+        bool has_focus() const override { return m_focused; }
+
+        sf::FloatRect visual_bounds() const override {
+            const sf::FloatRect text = m_value.empty() ? m_hintText.getGlobalBounds() : m_text.getGlobalBounds();
+            return unite(unite(Widget::visual_bounds(), text), m_caret.getGlobalBounds());
+        }
+
+    private:
+        void apply_text() {
+            const TextLayout& layout = text_layouts().get(*m_text.getFont(), m_text.getCharacterSize(), m_value);
+            m_text.setString(layout.text);
+            m_caretX = layout.caret;
+            update_caret_position();
+        }
+
+        void update_caret_position() {
+            const float pad = 10.f;
+            const float advance = m_caretX.empty() ? 0.f : m_caretX[std::min(m_caretPos, m_caretX.size() - 1)];
+
+            const float x = m_pos.x + pad + advance;
+            const float y = m_text.getPosition().y;
+            m_caret.setPosition(sf::Vector2f(x, y));
+            mark_dirty();
+        }
+
+        void refresh_style() {
+            mark_dirty();
+            if (!enabled()) {
+                m_box.setOutlineColor(sf::Color(80, 80, 90));
+                return;
+            }
+            m_box.setOutlineColor(m_focused ? m_theme.accent : m_theme.border);
+            m_blinkTimer = 0.f;
+            m_caretVisible = m_focused;
+        }
+
+    private:
+        Theme m_theme;
+
+        sf::RectangleShape m_box;
+        sf::Text m_text;
+        sf::Text m_hintText;
+        sf::RectangleShape m_caret;
+
+        std::string m_hint{ "Enter text..." };
+        std::string m_value;
+        std::vector<float> m_caretX;
+
+        bool m_focused{ false };
+        std::size_t m_caretPos{ 0 };
+        std::size_t m_maxLen{ 32 };
+
+        float m_blinkTimer{ 0.f };
+        bool m_caretVisible{ false };
+
+        xs::core::TagId m_tag{ xs::core::invalid_tag };
+        xs::core::Subscription m_sub;
+        std::function<void()> m_commit;
+    };
+
+    // Plots tag histories as per-pixel-column min/max envelopes, so the cost
+    // of a frame depends on the chart width rather than the sample count.
+    // Each pen is drawn as one line strip that is rebuilt only when its
+    // envelope changed.
+    class TrendChart final : public Widget {
+    public:
+        static constexpr std::int64_t default_span = 60000;
+
+        explicit TrendChart(const Theme& theme) : m_theme(theme), m_clock(xs::core::now_ms) {
+            m_box.setFillColor(m_theme.panel);
+            m_box.setOutlineThickness(1.f);
+            m_box.setOutlineColor(m_theme.border);
+
+            m_size = sf::Vector2f(400.f, 200.f);
+            m_box.setSize(m_size);
+        }
+
+        // lo == hi selects automatic scaling to the visible envelope.
+        std::size_t add_pen(const sf::Color& color, double lo = 0.0, double hi = 0.0) {
+            Pen p;
+            p.color = color;
+            p.lo = lo;
+            p.hi = hi;
+            p.envelope.reset(columns(), m_span);
+            m_pens.push_back(std::move(p));
+            return m_pens.size() - 1;
+        }
+
+        void bind_pen(std::size_t pen, xs::core::VariableStore& store, const std::string& varName) {
+            const xs::core::TagId tag = store.ensure_tag(varName, xs::core::Value::make_float(0.f));
+            m_pens[pen].sub = store.at(tag).subscribe_scoped([this, pen](const xs::core::Value& v) {
+                double d = 0.0;
+                if (xs::core::to_double(v, d)) add_sample(pen, m_clock(), d);
+                });
+        }
+
+        void add_sample(std::size_t pen, std::int64_t t, double v) { m_pens[pen].envelope.add(t, v); }
+
+        // Folds a pre-aggregated bucket, e.g. from Historian::query(), into the pen.
+        void add_envelope(std::size_t pen, std::int64_t t, double mn, double mx) {
+            m_pens[pen].envelope.add_range(t, mn, mx);
+        }
+
+        void set_span(std::int64_t ms) {
+            m_span = std::max<std::int64_t>(ms, 1);
+            reset_pens();
+        }
+        std::int64_t span() const { return m_span; }
+
+        void set_clock(std::function<std::int64_t()> clock) { m_clock = std::move(clock); }
+
+        void handle_event(const sf::Event&, const sf::RenderWindow&) override {}
+
+        void update(float dt) override {
+            (void)dt;
+            const std::int64_t now = m_clock();
+            for (auto& p : m_pens) {
+                p.envelope.advance_to(now);
+                if (p.envelope.version() != p.builtVersion) {
+                    rebuild(p);
+                    mark_dirty();
+                }
+            }
+        }
+
+        void draw(sf::RenderTarget& target) const override {
+            draw_counted(target, m_box);
+            for (const auto& p : m_pens) {
+                if (p.strip.getVertexCount() > 0) draw_counted(target, p.strip);
+            }
+        }
+
+        void set_position(const sf::Vector2f& p) override {
+            Widget::set_position(p);
+            m_box.setPosition(m_pos);
+            for (auto& pen : m_pens) pen.builtVersion = 0;
+        }
+
+        void set_size(const sf::Vector2f& s) override {
+            Widget::set_size(s);
+            m_box.setSize(m_size);
+            reset_pens();
+        }
+
+    private:
+        struct Pen {
+            sf::Color color;
+            double lo{ 0.0 };
+            double hi{ 0.0 };
+            xs::core::MinMaxDecimator envelope;
+            sf::VertexArray strip{ sf::LineStrip };
+            std::uint64_t builtVersion{ 0 };
+            xs::core::Subscription sub;
+        };
+
+        std::size_t columns() const { return std::max<std::size_t>(1, static_cast<std::size_t>(m_size.x)); }
+
+        void reset_pens() {
+            for (auto& p : m_pens) {
+                p.envelope.reset(columns(), m_span);
+                p.builtVersion = 0;
+            }
+        }
+
+        void rebuild(Pen& p) {
+            p.strip.clear();
+            p.builtVersion = p.envelope.version();
+
+            const std::size_t n = p.envelope.columns();
+            double lo = p.lo;
+            double hi = p.hi;
+            if (lo >= hi) {
+                lo = std::numeric_limits<double>::infinity();
+                hi = -lo;
+                for (std::size_t k = 0; k < n; ++k) {
+                    const auto& c = p.envelope.column(k);
+                    if (c.empty()) continue;
+                    lo = std::min(lo, c.min);
+                    hi = std::max(hi, c.max);
+                }
+                if (lo > hi) return;
+                if (lo == hi) { lo -= 1.0; hi += 1.0; }
+            }
+
+            const float bottom = m_pos.y + m_size.y;
+            const float scale = m_size.y / static_cast<float>(hi - lo);
+            auto y_of = [&](double v) {
+                return std::clamp(bottom - static_cast<float>(v - lo) * scale, m_pos.y, bottom);
+                };
+
+            for (std::size_t k = 0; k < n; ++k) {
+                const auto& c = p.envelope.column(k);
+                if (c.empty()) continue;
+                const float x = m_pos.x + static_cast<float>(k) + 0.5f;
+                p.strip.append(sf::Vertex(sf::Vector2f(x, y_of(c.min)), p.color));
+                p.strip.append(sf::Vertex(sf::Vector2f(x, y_of(c.max)), p.color));
+            }
+        }
+
+        Theme m_theme;
+        sf::RectangleShape m_box;
+        std::vector<Pen> m_pens;
+        std::int64_t m_span{ default_span };
+        std::function<std::int64_t()> m_clock;
+    };
+
+    // Shows the latest metrics sample. It is not a panel child: the app draws
+    // it over the composed frame and toggles it itself.
+    class MetricsOverlay final : public Widget {
+    public:
+        MetricsOverlay(const sf::Font& font, const Theme& theme) {
+            m_box.setFillColor(sf::Color(0, 0, 0, 200));
+            m_box.setOutlineThickness(1.f);
+            m_box.setOutlineColor(theme.border);
+
+            m_text.setFont(font);
+            m_text.setCharacterSize(12);
+            m_text.setFillColor(theme.text);
+
+            m_size = sf::Vector2f(230.f, 190.f);
+            m_box.setSize(m_size);
+            m_text.setString("collecting...");
+        }
+
+        void set_visible(bool on) { m_visible = on; mark_dirty(); }
+        bool visible() const { return m_visible; }
+
+        void show(const xs::core::MetricsSampler::Sample& s) {
+            m_lines.clear();
+            line("fps", s.fps, 1);
+            line("notifies/s", s.notifiesPerSec, 0);
+            line("callbacks/s", s.callbacksPerSec, 0);
+            line("cascade depth", s.maxDepth, 0);
+            line("sets/s", s.setsPerSec, 0);
+            line("gets/s", s.getsPerSec, 0);
+            line("tags", static_cast<double>(s.tags), 0);
+            line("draw calls/frame", s.drawCallsPerFrame, 1);
+            for (std::size_t k = 0; k < xs::core::phase_count; ++k) {
+                line(xs::core::phase_names[k], s.phaseMs[k], 3, " ms");
+            }
+            m_text.setString(m_lines);
+            mark_dirty();
+        }
+
+        void handle_event(const sf::Event&, const sf::RenderWindow&) override {}
+
+        void draw(sf::RenderTarget& target) const override {
+            if (!m_visible) return;
+            draw_counted(target, m_box);
+            draw_counted(target, m_text);
+        }
+
+        void set_position(const sf::Vector2f& p) override {
+            Widget::set_position(p);
+            m_box.setPosition(m_pos);
+            m_text.setPosition(sf::Vector2f(m_pos.x + 8.f, m_pos.y + 4.f));
+        }
+
+    private:
+        void line(const char* name, double v, int decimals, const char* unit = "") {
+            xs::core::FormatSpec spec;
+            spec.decimals = decimals;
+            spec.thousands = ',';
+            xs::core::FormatBuffer buf;
+            m_lines += name;
+            m_lines += ": ";
+            m_lines += xs::core::format_value(xs::core::Value::make_double(v), spec, buf);
+            m_lines += unit;
+            m_lines += '\n';
+        }
+
+        sf::RectangleShape m_box;
+        sf::Text m_text;
+        std::string m_lines;
+        bool m_visible{ false };
+    };
+
+    // Uniform grid over widget rectangles, stored as one flat id array with
+    // per-cell offsets. Ids within a cell keep insertion order.
+    class SpatialGrid final {
+    public:
+        explicit SpatialGrid(float cellSize = 64.f) : m_cellSize(cellSize) {}
+
+        void build(const std::vector<sf::FloatRect>& rects) {
+            m_cols = m_rows = 0;
+            m_offsets.clear();
+            m_ids.clear();
+            if (rects.empty()) return;
+
+            float left = rects[0].left, top = rects[0].top;
+            float right = left + rects[0].width, bottom = top + rects[0].height;
+            for (const auto& r : rects) {
+                left = std::min(left, r.left);
+                top = std::min(top, r.top);
+                right = std::max(right, r.left + r.width);
+                bottom = std::max(bottom, r.top + r.height);
+            }
+
+            m_origin = sf::Vector2f(left, top);
+            m_cols = std::clamp(static_cast<int>(std::ceil((right - left) / m_cellSize)), 1, max_cells_per_axis);
+            m_rows = std::clamp(static_cast<int>(std::ceil((bottom - top) / m_cellSize)), 1, max_cells_per_axis);
+            m_cell = sf::Vector2f(std::max(1.f, (right - left) / static_cast<float>(m_cols)),
+                std::max(1.f, (bottom - top) / static_cast<float>(m_rows)));
+
+            m_offsets.assign(static_cast<std::size_t>(m_cols) * m_rows + 1, 0);
+            for (const auto& r : rects) {
+                for_each_cell(r, [&](std::size_t c) { ++m_offsets[c + 1]; });
+            }
+            for (std::size_t c = 1; c < m_offsets.size(); ++c) m_offsets[c] += m_offsets[c - 1];
+
+            m_ids.resize(m_offsets.back());
+            std::vector<std::uint32_t> fill(m_offsets.begin(), m_offsets.end() - 1);
+            for (std::size_t id = 0; id < rects.size(); ++id) {
+                for_each_cell(rects[id], [&](std::size_t c) { m_ids[fill[c]++] = static_cast<std::uint32_t>(id); });
+            }
+        }
+
+        // Calls fn(id) for every rectangle whose cell covers p; callers still
+        // do the exact containment test.
+        template <typename Fn>
+        void query(const sf::Vector2f& p, Fn&& fn) const {
+            if (m_cols == 0) return;
+            const int c = static_cast<int>(std::floor((p.x - m_origin.x) / m_cell.x));
+            const int r = static_cast<int>(std::floor((p.y - m_origin.y) / m_cell.y));
+            if (c < 0 || r < 0 || c > m_cols || r > m_rows) return;
+            const std::size_t cell = static_cast<std::size_t>(std::min(r, m_rows - 1)) * m_cols + std::min(c, m_cols - 1);
+            for (std::uint32_t k = m_offsets[cell]; k < m_offsets[cell + 1]; ++k) fn(m_ids[k]);
+        }
+
+    private:
+        static constexpr int max_cells_per_axis = 512;
+
+        template <typename Fn>
+        void for_each_cell(const sf::FloatRect& r, Fn&& fn) const {
+            const int c0 = cell_of(r.left - m_origin.x, m_cell.x, m_cols);
+            const int c1 = cell_of(r.left + r.width - m_origin.x, m_cell.x, m_cols);
+            const int r0 = cell_of(r.top - m_origin.y, m_cell.y, m_rows);
+            const int r1 = cell_of(r.top + r.height - m_origin.y, m_cell.y, m_rows);
+            for (int row = r0; row <= r1; ++row) {
+                for (int col = c0; col <= c1; ++col) fn(static_cast<std::size_t>(row) * m_cols + col);
+            }
+        }
+
+        static int cell_of(float offset, float cell, int count) {
+            return std::clamp(static_cast<int>(std::floor(offset / cell)), 0, count - 1);
+        }
+
+        float m_cellSize;
+        sf::Vector2f m_origin;
+        sf::Vector2f m_cell{ 1.f, 1.f };
+        int m_cols{ 0 };
+        int m_rows{ 0 };
+        std::vector<std::uint32_t> m_offsets;
+        std::vector<std::uint32_t> m_ids;
+    };
+
+    class Panel final : public Widget {
+    public:
+        explicit Panel(const Theme& theme) : m_theme(theme) {
+            m_box.setFillColor(m_theme.panel);
+            m_box.setOutlineThickness(1.f);
+            m_box.setOutlineColor(m_theme.border);
+        }
+
+        void add(const std::shared_ptr<Widget>& w) {
+            w->set_parent(this);
+            m_children.push_back(w);
+            m_drawn.push_back(sf::FloatRect());
+            m_indexDirty = true;
+            mark_dirty();
+        }
+
+        // Pointer events go to the widgets under the cursor plus the ones that
+        // were hovered, pressed or focused before; keyboard and text events go
+        // to the focused widget only.
+        void handle_event(const sf::Event& e, const sf::RenderWindow& window) override {
+            switch (e.type) {
+            case sf::Event::MouseMoved:
+                route_pointer(e, window, sf::Vector2f(static_cast<float>(e.mouseMove.x), static_cast<float>(e.mouseMove.y)));
+                break;
+            case sf::Event::MouseButtonPressed:
+            case sf::Event::MouseButtonReleased:
+                route_pointer(e, window, sf::Vector2f(static_cast<float>(e.mouseButton.x), static_cast<float>(e.mouseButton.y)));
+                break;
+            case sf::Event::MouseWheelScrolled:
+                route_pointer(e, window, sf::Vector2f(static_cast<float>(e.mouseWheelScroll.x), static_cast<float>(e.mouseWheelScroll.y)));
+                break;
+            case sf::Event::TextEntered:
+            case sf::Event::KeyPressed:
+            case sf::Event::KeyReleased:
+                if (m_focus != no_child) {
+                    m_children[m_focus]->handle_event(e, window);
+                    if (!m_children[m_focus]->has_focus()) m_focus = no_child;
+                }
+                break;
+            default:
+                for (auto& w : m_children) w->handle_event(e, window);
+                break;
+            }
+        }
+
+        bool has_focus() const override { return m_focus != no_child; }
+
+        void child_geometry_changed() override { m_indexDirty = true; }
+
+        void update(float dt) override {
+            for (auto& w : m_children) w->update(dt);
+        }
+
+        void draw(sf::RenderTarget& target) const override {
+            draw_counted(target, m_box);
+            for (auto& w : m_children) w->draw(target);
+        }
+
+        void batch(RenderBatch& b) const override {
+            b.add_shape(m_box);
+            for (auto& w : m_children) w->batch(b);
+        }
+
+        // Draws the panel from a RenderBatch that is rebuilt only when some
+        // widget changed since the previous call.
+        void draw_batched(sf::RenderTarget& target) {
+            if (m_batch.empty() || needs_redraw()) {
+                m_batch.clear();
+                batch(m_batch);
+            }
+            m_batch.draw(target);
+        }
+
+        void set_batching(bool on) { m_batching = on; mark_dirty(); }
+        bool batching() const { return m_batching; }
+
+        void set_position(const sf::Vector2f& p) override {
+            Widget::set_position(p);
+            m_box.setPosition(m_pos);
+        }
+
+        void set_size(const sf::Vector2f& s) override {
+            Widget::set_size(s);
+            m_box.setSize(m_size);
+        }
+
+        bool needs_redraw() const override {
+            if (m_dirty) return true;
+            for (auto& w : m_children) {
+                if (w->needs_redraw()) return true;
+            }
+            return false;
+        }
+
+        void clear_dirty() override {
+            Widget::clear_dirty();
+            for (auto& w : m_children) w->clear_dirty();
+        }
+
+        // Retained path: the panel is kept in an offscreen texture and only
+        // the old and new areas of widgets that changed since the previous
+        // call are repainted before the texture is blitted to the target.
+        void compose(sf::RenderTarget& target, FrameStats& stats) {
+            const sf::Vector2u size = target.getSize();
+            if (m_cache.getSize() != size) {
+                if (!m_cache.create(size.x, size.y)) {
+                    target.clear(m_theme.bg);
+                    if (m_batching) draw_batched(target);
+                    else draw(target);
+                    clear_dirty();
+                    ++stats.full_repaints;
+                    return;
+                }
+                mark_dirty();
+            }
+
+            if (m_dirty) {
+                repaint_all();
+                ++stats.full_repaints;
+            }
+            else {
+                collect_damage();
+                if (m_damage.size() > max_damage_rects) {
+                    repaint_all();
+                    ++stats.full_repaints;
+                }
+                else {
+                    for (const auto& r : m_damage) repaint_region(r);
+                    stats.regions += m_damage.size();
+                }
+            }
+            clear_dirty();
+
+            m_cache.display();
+            draw_counted(target, sf::Sprite(m_cache.getTexture()));
+        }
+
+    private:
+        static constexpr std::size_t max_damage_rects = 64;
+        static constexpr std::uint32_t no_child = std::numeric_limits<std::uint32_t>::max();
+
+        void rebuild_index() {
+            m_rects.clear();
+            for (auto& w : m_children) m_rects.push_back(sf::FloatRect(w->position(), w->size()));
+            m_grid.build(m_rects);
+            m_indexDirty = false;
+        }
+
+        void route_pointer(const sf::Event& e, const sf::RenderWindow& window, const sf::Vector2f& p) {
+            if (m_indexDirty) rebuild_index();
+
+            m_targets.clear();
+            m_grid.query(p, [&](std::uint32_t id) {
+                if (m_children[id]->contains(p)) m_targets.push_back(id);
+                });
+            const std::size_t hits = m_targets.size();
+
+            m_targets.insert(m_targets.end(), m_hot.begin(), m_hot.end());
+            m_targets.insert(m_targets.end(), m_captured.begin(), m_captured.end());
+            if (m_focus != no_child) m_targets.push_back(m_focus);
+            std::sort(m_targets.begin() + static_cast<std::ptrdiff_t>(hits), m_targets.end());
+            m_targets.erase(std::unique(m_targets.begin() + static_cast<std::ptrdiff_t>(hits), m_targets.end()), m_targets.end());
+
+            m_hot.assign(m_targets.begin(), m_targets.begin() + static_cast<std::ptrdiff_t>(hits));
+            std::inplace_merge(m_targets.begin(), m_targets.begin() + static_cast<std::ptrdiff_t>(hits), m_targets.end());
+            m_targets.erase(std::unique(m_targets.begin(), m_targets.end()), m_targets.end());
+
+            for (std::uint32_t id : m_targets) m_children[id]->handle_event(e, window);
+
+            if (e.type == sf::Event::MouseButtonPressed) {
+                m_captured = m_hot;
+                m_focus = no_child;
+                for (std::uint32_t id : m_targets) {
+                    if (m_children[id]->has_focus()) { m_focus = id; break; }
+                }
+            }
+            else if (e.type == sf::Event::MouseButtonReleased) {
+                m_captured.clear();
+            }
+        }
+
+        void repaint_all() {
+            m_cache.setView(m_cache.getDefaultView());
+            m_cache.clear(m_theme.bg);
+            if (m_batching) draw_batched(m_cache);
+            else draw(m_cache);
+            for (std::size_t k = 0; k < m_children.size(); ++k) m_drawn[k] = m_children[k]->visual_bounds();
+        }
+
+        void collect_damage() {
+            m_damage.clear();
+            for (std::size_t k = 0; k < m_children.size(); ++k) {
+                if (!m_children[k]->needs_redraw()) continue;
+                const sf::FloatRect now = m_children[k]->visual_bounds();
+                m_damage.push_back(m_drawn[k]);
+                m_damage.push_back(now);
+                m_drawn[k] = now;
+            }
+        }
+
+        void repaint_region(const sf::FloatRect& r) {
+            const sf::Vector2u size = m_cache.getSize();
+            const float left = std::max(0.f, std::floor(r.left));
+            const float top = std::max(0.f, std::floor(r.top));
+            const float right = std::min(static_cast<float>(size.x), std::ceil(r.left + r.width));
+            const float bottom = std::min(static_cast<float>(size.y), std::ceil(r.top + r.height));
+            if (right <= left || bottom <= top) return;
+
+            const sf::FloatRect clip(left, top, right - left, bottom - top);
+            sf::View view(clip);
+            view.setViewport(sf::FloatRect(clip.left / size.x, clip.top / size.y,
+                clip.width / size.x, clip.height / size.y));
+            m_cache.setView(view);
+
+            sf::RectangleShape bg(sf::Vector2f(clip.width, clip.height));
+            bg.setPosition(sf::Vector2f(clip.left, clip.top));
+            bg.setFillColor(m_theme.bg);
+            draw_counted(m_cache, bg);
+            draw_counted(m_cache, m_box);
+            for (auto& w : m_children) {
+                if (w->visual_bounds().intersects(clip)) w->draw(m_cache);
+            }
+
+            m_cache.setView(m_cache.getDefaultView());
+        }
+
+    private:
+        Theme m_theme;
+        sf::RectangleShape m_box;
+        std::vector<std::shared_ptr<Widget>> m_children;
+
+        sf::RenderTexture m_cache;
+        std::vector<sf::FloatRect> m_drawn;
+        std::vector<sf::FloatRect> m_damage;
+
+        bool m_batching{ true };
+        RenderBatch m_batch;
+
+        SpatialGrid m_grid;
+        std::vector<sf::FloatRect> m_rects;
+        bool m_indexDirty{ true };
+        std::vector<std::uint32_t> m_targets;
+        std::vector<std::uint32_t> m_hot;
+        std::vector<std::uint32_t> m_captured;
+        std::uint32_t m_focus{ no_child };
+    };
+
+}
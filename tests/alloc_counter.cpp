@@ -0,0 +1,22 @@
+#include "alloc_counter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace xs::test {
+
+    std::atomic<std::size_t>& alloc_count() {
+        static std::atomic<std::size_t> count{ 0 };
+        return count;
+    }
+
+}
+
+void* operator new(std::size_t n) {
+    xs::test::alloc_count().fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
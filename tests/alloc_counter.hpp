@@ -0,0 +1,22 @@
+#pragma once
+
+// Counts global heap allocations; the replacement operator new/delete live in
+// alloc_counter.cpp, which must be linked into the executable.
+
+#include <atomic>
+#include <cstddef>
+
+namespace xs::test {
+
+    std::atomic<std::size_t>& alloc_count();
+
+    class AllocScope final {
+    public:
+        AllocScope() : m_start(alloc_count().load(std::memory_order_relaxed)) {}
+        std::size_t allocations() const { return alloc_count().load(std::memory_order_relaxed) - m_start; }
+
+    private:
+        std::size_t m_start;
+    };
+
+}
@@ -0,0 +1,112 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../src/xs_alarm.hpp"
+
+using xs::core::AlarmConfig;
+using xs::core::AlarmEngine;
+using xs::core::AlarmEvent;
+using xs::core::AlarmId;
+using xs::core::AlarmKind;
+using xs::core::TagId;
+using xs::core::UpdateBatch;
+using xs::core::Value;
+using xs::core::VariableStore;
+
+// 100k tags doing a random walk in [-6, 6], each with HI/HIHI/LO/LOLO limits
+// (deadband 0.5). Every iteration moves all tags in one batch.
+
+namespace {
+
+    constexpr int kTags = 100000;
+
+    struct Plant {
+        VariableStore store;
+        AlarmEngine alarms{ store };
+        std::vector<TagId> tags;
+        std::vector<float> values;
+        std::mt19937 rng{ 42 };
+
+        explicit Plant(float spread) {
+            alarms.set_clock([]() { return std::int64_t{ 0 }; });
+            std::uniform_real_distribution<float> start(-spread, spread);
+            for (int k = 0; k < kTags; ++k) {
+                values.push_back(start(rng));
+                const TagId t = store.ensure_tag("plc.t" + std::to_string(k), Value::make_float(values.back()));
+                tags.push_back(t);
+                alarms.add(t, config(AlarmKind::HiHi, 4.0));
+                alarms.add(t, config(AlarmKind::Hi, 2.0));
+                alarms.add(t, config(AlarmKind::Lo, -2.0));
+                alarms.add(t, config(AlarmKind::LoLo, -4.0));
+            }
+        }
+
+        static AlarmConfig config(AlarmKind kind, double limit) {
+            AlarmConfig c;
+            c.kind = kind;
+            c.limit = limit;
+            c.deadband = 0.5;
+            return c;
+        }
+
+        float step(std::size_t k) {
+            std::uniform_real_distribution<float> d(-0.3f, 0.3f);
+            values[k] = std::clamp(values[k] + d(rng), -6.f, 6.f);
+            return values[k];
+        }
+    };
+
+}
+
+static void BM_Alarm_RandomWalk(benchmark::State& state) {
+    Plant p(5.f);
+    std::uint64_t raised = 0;
+    p.alarms.set_listener([&raised](AlarmId, AlarmEvent e) { raised += (e == AlarmEvent::Raised); });
+
+    const auto before = p.alarms.evaluations();
+    for (auto _ : state) {
+        UpdateBatch batch(p.store);
+        for (std::size_t k = 0; k < p.tags.size(); ++k) p.store.set(p.tags[k], Value::make_float(p.step(k)));
+    }
+    state.counters["evals/s"] = benchmark::Counter(
+        static_cast<double>(p.alarms.evaluations() - before), benchmark::Counter::kIsRate);
+    state.counters["raised/iter"] = static_cast<double>(raised) / static_cast<double>(state.iterations());
+    state.counters["active"] = static_cast<double>(p.alarms.active_count());
+}
+BENCHMARK(BM_Alarm_RandomWalk)->Unit(benchmark::kMillisecond);
+
+// Latency from VariableStore::set() to the Raised event, one unbatched write
+// at a time, pushing a random tag across its HI limit and back.
+static void BM_Alarm_RaiseLatency(benchmark::State& state) {
+    using Clock = std::chrono::steady_clock;
+    Plant p(0.f);
+    Clock::time_point raisedAt;
+    p.alarms.set_listener([&raisedAt](AlarmId, AlarmEvent e) {
+        if (e == AlarmEvent::Raised) raisedAt = Clock::now();
+    });
+
+    std::vector<double> samples;
+    std::uniform_int_distribution<std::size_t> pick(0, p.tags.size() - 1);
+    for (auto _ : state) {
+        const TagId t = p.tags[pick(p.rng)];
+        const Clock::time_point start = Clock::now();
+        p.store.set(t, Value::make_float(3.f));
+        samples.push_back(std::chrono::duration<double, std::nano>(raisedAt - start).count());
+
+        state.PauseTiming();
+        p.store.set(t, Value::make_float(0.f));
+        state.ResumeTiming();
+    }
+
+    std::sort(samples.begin(), samples.end());
+    if (!samples.empty()) {
+        state.counters["p50_ns"] = samples[samples.size() / 2];
+        state.counters["p99_ns"] = samples[samples.size() * 99 / 100];
+    }
+}
+BENCHMARK(BM_Alarm_RaiseLatency);
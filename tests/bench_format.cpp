@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/xs_format.hpp"
+#include "alloc_counter.hpp"
+
+using xs::core::FormatBuffer;
+using xs::core::FormatSpec;
+using xs::core::Value;
+
+// Formats a screenful of analog values per iteration, the work a bound
+// label does on every update. The baseline is the previous
+// ostringstream + setprecision path followed by the prefix concatenation.
+
+namespace {
+
+    constexpr std::size_t kValues = 256;
+
+    std::vector<Value> analog_values() {
+        std::vector<Value> values;
+        for (std::size_t k = 0; k < kValues; ++k) {
+            values.push_back(Value::make_float(static_cast<float>(k) * 3.7f - 120.25f));
+        }
+        return values;
+    }
+
+    void report(benchmark::State& state, std::size_t allocations) {
+        const double n = static_cast<double>(state.iterations()) * static_cast<double>(kValues);
+        state.counters["allocs/value"] = static_cast<double>(allocations) / n;
+        state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(kValues));
+    }
+
+}
+
+static void BM_Format_ToChars(benchmark::State& state) {
+    const std::vector<Value> values = analog_values();
+    FormatSpec spec;
+    spec.decimals = 2;
+    spec.unit = "degC";
+    FormatBuffer buf;
+
+    const xs::test::AllocScope allocs;
+    for (auto _ : state) {
+        for (const auto& v : values) benchmark::DoNotOptimize(xs::core::format_value(v, spec, buf).size());
+    }
+    report(state, allocs.allocations());
+}
+BENCHMARK(BM_Format_ToChars);
+
+static void BM_Format_Ostream(benchmark::State& state) {
+    const std::vector<Value> values = analog_values();
+    const std::string prefix = "Temperature:";
+
+    const xs::test::AllocScope allocs;
+    for (auto _ : state) {
+        for (const auto& v : values) {
+            std::ostringstream oss;
+            oss << std::fixed << std::setprecision(2) << v.as_float();
+            std::string text = oss.str();
+            std::string combined = prefix;
+            combined += " ";
+            combined += text;
+            combined += " degC";
+            benchmark::DoNotOptimize(combined.size());
+        }
+    }
+    report(state, allocs.allocations());
+}
+BENCHMARK(BM_Format_Ostream);
@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/xs_ingest.hpp"
+
+using xs::core::IngestQueue;
+using xs::core::TagId;
+using xs::core::Value;
+using xs::core::VariableStore;
+
+// Producers push a fixed number of float updates spread over 5,000 tags while
+// the benchmark thread drains them into the store, as the UI loop would.
+static void BM_Ingest_Throughput(benchmark::State& state) {
+    const int producers = static_cast<int>(state.range(0));
+    constexpr int tagCount = 5000;
+    constexpr int perProducer = 1 << 16;
+
+    VariableStore store;
+    std::vector<TagId> tags;
+    for (int k = 0; k < tagCount; ++k) {
+        tags.push_back(store.ensure_tag("io." + std::to_string(k), Value::make_float(0.f)));
+    }
+
+    IngestQueue q(1 << 14);
+    std::int64_t total = 0;
+
+    for (auto _ : state) {
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p]() {
+                for (int k = 0; k < perProducer; ++k) {
+                    q.push(tags[static_cast<std::size_t>((k * producers + p) % tagCount)],
+                        Value::make_float(static_cast<float>(k)));
+                }
+                });
+        }
+
+        const std::size_t expected = static_cast<std::size_t>(producers) * perProducer;
+        std::size_t received = 0;
+        while (received < expected) {
+            const std::size_t n = q.drain(store);
+            if (n == 0) std::this_thread::yield();
+            received += n;
+        }
+        for (auto& t : threads) t.join();
+        total += static_cast<std::int64_t>(received);
+    }
+
+    state.SetItemsProcessed(total);
+    state.counters["updates/s"] = benchmark::Counter(static_cast<double>(total), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Ingest_Throughput)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,113 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "../src/xs_core.hpp"
+
+using xs::core::Value;
+using xs::core::Variable;
+
+// One variable fanned out to N subscribers, each with a small closure as a
+// widget binding would have. The baseline is the previous vector of
+// std::function with a linear unsubscribe.
+
+namespace {
+
+    struct LegacyVariable {
+        struct Subscriber {
+            std::size_t id;
+            std::function<void(const Value&)> cb;
+        };
+
+        void set(const Value& v) {
+            if (value.equals(v)) return;
+            value = v;
+            for (auto& s : subs) {
+                if (s.cb) s.cb(value);
+            }
+        }
+
+        std::size_t subscribe(std::function<void(const Value&)> cb) {
+            subs.push_back(Subscriber{ ++nextId, cb });
+            if (cb) cb(value);
+            return nextId;
+        }
+
+        void unsubscribe(std::size_t id) {
+            for (std::size_t k = 0; k < subs.size(); ++k) {
+                if (subs[k].id == id) {
+                    subs.erase(subs.begin() + static_cast<long>(k));
+                    return;
+                }
+            }
+        }
+
+        Value value{ Value::make_int(0) };
+        std::vector<Subscriber> subs;
+        std::size_t nextId{ 0 };
+    };
+
+    template <typename V>
+    void fan_out(benchmark::State& state, V& var, std::vector<std::int64_t>& sinks) {
+        const auto n = static_cast<std::size_t>(state.range(0));
+        for (std::size_t k = 0; k < n; ++k) {
+            std::int64_t* sink = &sinks[k];
+            var.subscribe([sink](const Value& v) { *sink += v.as_int(); });
+        }
+        int x = 0;
+        for (auto _ : state) {
+            var.set(Value::make_int(++x));
+        }
+        benchmark::DoNotOptimize(sinks.data());
+        state.counters["callbacks/s"] = benchmark::Counter(
+            static_cast<double>(state.iterations()) * static_cast<double>(n), benchmark::Counter::kIsRate);
+    }
+
+    // Subscribes N, then removes them in random order.
+    template <typename V>
+    void churn(benchmark::State& state) {
+        const auto n = static_cast<std::size_t>(state.range(0));
+        std::vector<std::size_t> ids(n);
+        std::vector<std::size_t> order(n);
+        std::uint32_t seed = 12345;
+        for (std::size_t k = 0; k < n; ++k) order[k] = k;
+        for (std::size_t k = n; k > 1; --k) {
+            seed = seed * 1664525u + 1013904223u;
+            std::swap(order[k - 1], order[seed % k]);
+        }
+        std::int64_t sink = 0;
+        for (auto _ : state) {
+            V var;
+            for (std::size_t k = 0; k < n; ++k) {
+                ids[k] = var.subscribe([&sink](const Value&) { ++sink; });
+            }
+            for (std::size_t k : order) var.unsubscribe(ids[k]);
+        }
+        benchmark::DoNotOptimize(sink);
+        state.counters["ops/s"] = benchmark::Counter(
+            static_cast<double>(state.iterations()) * static_cast<double>(2 * n), benchmark::Counter::kIsRate);
+    }
+
+}
+
+static void BM_Notify_FanOut(benchmark::State& state) {
+    Variable var(Value::make_int(0));
+    std::vector<std::int64_t> sinks(static_cast<std::size_t>(state.range(0)), 0);
+    fan_out(state, var, sinks);
+}
+BENCHMARK(BM_Notify_FanOut)->Arg(100)->Arg(10000);
+
+static void BM_Notify_FanOut_Legacy(benchmark::State& state) {
+    LegacyVariable var;
+    std::vector<std::int64_t> sinks(static_cast<std::size_t>(state.range(0)), 0);
+    fan_out(state, var, sinks);
+}
+BENCHMARK(BM_Notify_FanOut_Legacy)->Arg(100)->Arg(10000);
+
+static void BM_Subscribe_Churn(benchmark::State& state) { churn<Variable>(state); }
+BENCHMARK(BM_Subscribe_Churn)->Arg(10000);
+
+static void BM_Subscribe_Churn_Legacy(benchmark::State& state) { churn<LegacyVariable>(state); }
+BENCHMARK(BM_Subscribe_Churn_Legacy)->Arg(10000);
@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/xs_scaling.hpp"
+
+using xs::core::RegisterScale;
+using xs::core::ScaleTable;
+using xs::core::TagId;
+using xs::core::Value;
+using xs::core::VariableStore;
+
+// A 100k-register int16 block from a field driver, about 1% of which moves
+// past its deadband between reads. The kernels alone (vector and scalar),
+// the whole bulk path into the store, and the per-tag path it replaces:
+// scale, clamp and deadband each register by hand, then set() it.
+
+namespace {
+
+    struct Block {
+        VariableStore store;
+        std::vector<RegisterScale> scales;
+        std::vector<std::vector<std::int16_t>> reads;
+
+        explicit Block(std::size_t n) {
+            store.reserve(n);
+            std::mt19937 rng(3);
+            std::uniform_int_distribution<int> base(-20000, 20000);
+            std::uniform_int_distribution<int> pick(0, 99);
+            std::vector<std::int16_t> raw(n);
+            for (std::size_t k = 0; k < n; ++k) {
+                const TagId id = store.ensure_tag("rtu.ai" + std::to_string(k), Value::make_float(0.f));
+                scales.push_back(RegisterScale{ id, 0.01f, -5.f, -150.f, 150.f, 0.5f });
+                raw[k] = static_cast<std::int16_t>(base(rng));
+            }
+            // Alternating reads, each moving 1% of the registers well past the deadband.
+            for (int r = 0; r < 2; ++r) {
+                for (std::size_t k = 0; k < n; ++k) {
+                    if (pick(rng) == 0) raw[k] = static_cast<std::int16_t>(raw[k] + (r == 0 ? 500 : -500));
+                }
+                reads.push_back(raw);
+            }
+        }
+    };
+
+    template <typename Kernel>
+    void run_kernel(benchmark::State& state, Kernel kernel) {
+        const auto n = static_cast<std::size_t>(state.range(0));
+        Block block(n);
+        ScaleTable t(block.scales);
+        std::vector<float> scaled(n);
+        std::vector<std::uint64_t> changed(xs::core::mask_words(n));
+        std::size_t r = 0;
+        std::size_t moved = 0;
+        for (auto _ : state) {
+            moved += kernel(t, block.reads[r++ % 2].data(), n, scaled.data(), changed.data());
+            benchmark::DoNotOptimize(changed.data());
+        }
+        state.counters["changed"] = static_cast<double>(moved) / static_cast<double>(state.iterations());
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+}
+
+static void BM_Scale_Kernel(benchmark::State& state) {
+    run_kernel(state, [](ScaleTable& t, const std::int16_t* raw, std::size_t n, float* out, std::uint64_t* mask) {
+        return t.scale(raw, n, out, mask);
+    });
+}
+BENCHMARK(BM_Scale_Kernel)->Arg(100000)->Arg(8000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Scale_KernelScalar(benchmark::State& state) {
+    run_kernel(state, [](ScaleTable& t, const std::int16_t* raw, std::size_t n, float* out, std::uint64_t* mask) {
+        return t.scale_scalar(raw, n, out, mask);
+    });
+}
+BENCHMARK(BM_Scale_KernelScalar)->Arg(100000)->Arg(8000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Scale_ApplyBlock(benchmark::State& state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    Block block(n);
+    ScaleTable t(block.scales);
+    std::size_t r = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(xs::core::apply_block(block.store, t, block.reads[r++ % 2].data(), n, 1));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Scale_ApplyBlock)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Scale_PerTag(benchmark::State& state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    Block block(n);
+    std::vector<float> last(n, NAN);
+    std::size_t r = 0;
+    for (auto _ : state) {
+        const std::int16_t* raw = block.reads[r++ % 2].data();
+        xs::core::UpdateBatch batch(block.store);
+        for (std::size_t k = 0; k < n; ++k) {
+            const RegisterScale& s = block.scales[k];
+            float y = static_cast<float>(raw[k]) * s.gain + s.offset;
+            y = std::fmin(std::fmax(y, s.lo), s.hi);
+            if (std::fabs(y - last[k]) <= s.deadband) continue;
+            last[k] = y;
+            block.store.set(s.tag, Value::make_float(y), xs::core::Quality::Good, 1);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Scale_PerTag)->Arg(100000)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,98 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../src/xs_screen.hpp"
+
+using xs::core::ScreenCompiler;
+using xs::core::ScreenFile;
+using xs::core::VariableStore;
+
+// Load time of a 10,000-widget screen from its text and compiled forms,
+// including tag creation and one pass over every widget record (what the
+// UI builder does before it touches SFML).
+
+namespace {
+
+    constexpr int kWidgets = 10000;
+
+    std::string make_screen(int widgets) {
+        std::string s = "screen 1920 1080\n";
+        for (int k = 0; k < widgets / 3; ++k) s += "tag plc.t" + std::to_string(k) + " float 0\n";
+        s += "panel 0 0 1920 1080\n";
+        for (int k = 0; k < widgets; ++k) {
+            const std::string xy = std::to_string((k % 20) * 96) + " " + std::to_string((k / 20) * 26);
+            const std::string tag = "plc.t" + std::to_string(k / 3);
+            switch (k % 3) {
+            case 0: s += "label " + xy + " size=12 prefix=\"T" + std::to_string(k) + "\" bind=" + tag + "\n"; break;
+            case 1: s += "button " + xy + " 90 22 size=12 caption=\"Start\" step=" + tag + " by=1\n"; break;
+            default: s += "textfield " + xy + " 90 22 size=12 hint=\"Name\" bind=" + tag + "\n"; break;
+            }
+        }
+        s += "end\n";
+        return s;
+    }
+
+    struct ScreenFiles {
+        std::string text;
+        std::string binary;
+
+        ScreenFiles() {
+            const auto dir = std::filesystem::temp_directory_path();
+            text = (dir / "xs_bench_screen.xss").string();
+            binary = (dir / "xs_bench_screen.xsb").string();
+            std::ofstream(text, std::ios::binary) << make_screen(kWidgets);
+            std::string error;
+            xs::core::compile_screen_file(text, binary, error);
+        }
+    };
+
+    const ScreenFiles& files() {
+        static const ScreenFiles f;
+        return f;
+    }
+
+    void load(benchmark::State& state, const std::string& path) {
+        for (auto _ : state) {
+            ScreenFile file;
+            std::string error;
+            if (!file.load(path, error)) {
+                state.SkipWithError(error.c_str());
+                break;
+            }
+            VariableStore store;
+            file.image().create_tags(store);
+            float area = 0.f;
+            for (std::size_t k = 0; k < file.image().widget_count(); ++k) {
+                const auto r = file.image().widget(k);
+                area += r.w * r.h + static_cast<float>(file.image().str(r.bind).size());
+            }
+            benchmark::DoNotOptimize(area);
+        }
+        state.counters["widgets/s"] = benchmark::Counter(
+            static_cast<double>(state.iterations()) * kWidgets, benchmark::Counter::kIsRate);
+    }
+
+}
+
+static void BM_ScreenLoad_Text(benchmark::State& state) { load(state, files().text); }
+BENCHMARK(BM_ScreenLoad_Text)->Unit(benchmark::kMillisecond);
+
+static void BM_ScreenLoad_Compiled(benchmark::State& state) { load(state, files().binary); }
+BENCHMARK(BM_ScreenLoad_Compiled)->Unit(benchmark::kMillisecond);
+
+static void BM_ScreenCompile(benchmark::State& state) {
+    const std::string source = make_screen(kWidgets);
+    std::vector<std::uint8_t> bytes;
+    for (auto _ : state) {
+        ScreenCompiler c;
+        std::string error;
+        c.compile(source, bytes, error);
+        benchmark::DoNotOptimize(bytes.data());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * source.size()));
+}
+BENCHMARK(BM_ScreenCompile)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,115 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "../src/xs_snapshot.hpp"
+#include "alloc_counter.hpp"
+
+using xs::core::Value;
+using xs::core::VariableStore;
+
+// Restart path for a large tag database: saving, restoring into an empty
+// store through the mapped file, restoring over existing tags, and the part
+// of a background snapshot that runs on the UI thread. Every 16th tag holds
+// a string longer than the inline buffer.
+
+namespace {
+
+    std::string bench_path() {
+        return (std::filesystem::temp_directory_path() / "xs_bench_snapshot.xsv").string();
+    }
+
+    void fill(VariableStore& store, std::size_t tags) {
+        store.reserve(tags);
+        for (std::size_t k = 0; k < tags; ++k) {
+            const std::string name = "plc.area" + std::to_string(k % 64) + ".tag" + std::to_string(k);
+            switch (k % 4) {
+            case 0: store.ensure_tag(name, Value::make_float(static_cast<float>(k) * 0.5f)); break;
+            case 1: store.ensure_tag(name, Value::make_int(static_cast<int>(k))); break;
+            case 2: store.ensure_tag(name, Value::make_bool(k % 3 == 0)); break;
+            default:
+                store.ensure_tag(name, Value::make_string(k % 16 == 3 ? "recipe " + std::to_string(k) + " running on line B" : "auto"));
+                break;
+            }
+        }
+    }
+
+}
+
+static void BM_Snapshot_Save(benchmark::State& state) {
+    VariableStore store;
+    fill(store, static_cast<std::size_t>(state.range(0)));
+    const std::string path = bench_path();
+    std::string error;
+    for (auto _ : state) {
+        if (!xs::core::save_snapshot(store, path, error)) state.SkipWithError(error.c_str());
+    }
+    state.counters["MB"] = static_cast<double>(std::filesystem::file_size(path)) / 1e6;
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    std::filesystem::remove(path);
+}
+BENCHMARK(BM_Snapshot_Save)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+static void BM_Snapshot_LoadEmpty(benchmark::State& state) {
+    const std::string path = bench_path();
+    std::string error;
+    {
+        VariableStore src;
+        fill(src, static_cast<std::size_t>(state.range(0)));
+        if (!xs::core::save_snapshot(src, path, error)) state.SkipWithError(error.c_str());
+    }
+    for (auto _ : state) {
+        auto store = std::make_unique<VariableStore>();
+        if (!xs::core::load_snapshot(*store, path, error)) state.SkipWithError(error.c_str());
+        benchmark::DoNotOptimize(store->size());
+        state.PauseTiming();
+        store.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    std::filesystem::remove(path);
+}
+BENCHMARK(BM_Snapshot_LoadEmpty)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// The screen already created every tag; the snapshot only overwrites values.
+static void BM_Snapshot_LoadExisting(benchmark::State& state) {
+    const std::string path = bench_path();
+    VariableStore store;
+    fill(store, static_cast<std::size_t>(state.range(0)));
+    std::string error;
+    if (!xs::core::save_snapshot(store, path, error)) state.SkipWithError(error.c_str());
+    for (auto _ : state) {
+        if (!xs::core::load_snapshot(store, path, error)) state.SkipWithError(error.c_str());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    std::filesystem::remove(path);
+}
+BENCHMARK(BM_Snapshot_LoadExisting)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// UI-thread cost of a periodic snapshot once both buffers hold the names.
+static void BM_Snapshot_Capture(benchmark::State& state) {
+    VariableStore store;
+    fill(store, static_cast<std::size_t>(state.range(0)));
+    const std::string path = bench_path();
+    xs::core::SnapshotWriter writer(path, 0);
+    writer.capture(store);
+    writer.capture(store);
+    writer.wait();
+
+    std::size_t allocations = 0;
+    for (auto _ : state) {
+        const xs::test::AllocScope allocs;
+        if (!writer.capture(store)) state.SkipWithError("capture skipped");
+        allocations += allocs.allocations();
+        state.PauseTiming();
+        writer.wait();
+        state.ResumeTiming();
+    }
+    state.counters["allocs"] = static_cast<double>(allocations) / static_cast<double>(state.iterations());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    std::filesystem::remove(path);
+}
+BENCHMARK(BM_Snapshot_Capture)->Arg(1000000)->Unit(benchmark::kMillisecond);
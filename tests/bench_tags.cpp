@@ -0,0 +1,176 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/xs_core.hpp"
+
+using xs::core::TagId;
+using xs::core::TagTree;
+using xs::core::Value;
+using xs::core::VariableStore;
+
+// Tag naming at plant scale: 1M dotted names spread over 16 lines, 64 units
+// and a handful of signals each. Exact lookups through the store's hash
+// index, the radix tree and a plain unordered_map; enumerating one unit's
+// tags through the tree versus scanning every name; and the memory each
+// index needs on top of the names themselves.
+
+namespace {
+
+    const char* const signals[] = { "run", "speed", "temp", "alarm.high", "alarm.low", "mode", "setpoint", "fault" };
+
+    std::vector<std::string> make_names(std::size_t tags) {
+        std::vector<std::string> names;
+        names.reserve(tags);
+        for (std::size_t k = 0; names.size() < tags; ++k) {
+            names.push_back("line" + std::to_string(k % 16) + ".unit" + std::to_string(k / 128 % 64) + ".dev"
+                + std::to_string(k / 8192) + "." + signals[k / 16 % 8]);
+        }
+        return names;
+    }
+
+    struct Fixture {
+        std::vector<std::string> names;
+        VariableStore store;
+        TagTree tree;
+        std::unordered_map<std::string, TagId> map;
+
+        explicit Fixture(std::size_t tags) : names(make_names(tags)) {
+            store.reserve(tags);
+            map.reserve(tags);
+            for (const std::string& n : names) {
+                const TagId id = store.ensure_tag(n, Value::make_int(0));
+                tree.insert(n, id);
+                map.emplace(n, id);
+            }
+        }
+    };
+
+    Fixture& fixture(std::size_t tags) {
+        static Fixture f(tags);
+        return f;
+    }
+
+    // Visits the names in a shuffled but repeatable order, so the lookups
+    // are not helped by insertion locality.
+    template <typename Lookup>
+    void run_lookups(benchmark::State& state, Lookup lookup) {
+        const Fixture& f = fixture(static_cast<std::size_t>(state.range(0)));
+        std::uint64_t found = 0;
+        std::size_t k = 0;
+        for (auto _ : state) {
+            k = (k + 7919) % f.names.size();
+            found += lookup(f, f.names[k]) != xs::core::invalid_tag;
+        }
+        if (found != static_cast<std::uint64_t>(state.iterations())) state.SkipWithError("missing tag");
+        state.SetItemsProcessed(state.iterations());
+    }
+
+}
+
+static void BM_Tags_LookupIndex(benchmark::State& state) {
+    run_lookups(state, [](const Fixture& f, const std::string& n) { return f.store.resolve(n); });
+}
+BENCHMARK(BM_Tags_LookupIndex)->Arg(1000000);
+
+static void BM_Tags_LookupTree(benchmark::State& state) {
+    run_lookups(state, [](const Fixture& f, const std::string& n) { return f.tree.find(n); });
+}
+BENCHMARK(BM_Tags_LookupTree)->Arg(1000000);
+
+static void BM_Tags_LookupMap(benchmark::State& state) {
+    run_lookups(state, [](const Fixture& f, const std::string& n) {
+        const auto it = f.map.find(n);
+        return it == f.map.end() ? xs::core::invalid_tag : it->second;
+    });
+}
+BENCHMARK(BM_Tags_LookupMap)->Arg(1000000);
+
+static void BM_Tags_PrefixTree(benchmark::State& state) {
+    const Fixture& f = fixture(static_cast<std::size_t>(state.range(0)));
+    std::size_t hits = 0;
+    for (auto _ : state) {
+        hits = 0;
+        f.tree.for_each_prefix("line3.unit12.", [&](TagId) { ++hits; });
+        benchmark::DoNotOptimize(hits);
+    }
+    state.counters["tags"] = static_cast<double>(hits);
+}
+BENCHMARK(BM_Tags_PrefixTree)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Tags_PrefixScan(benchmark::State& state) {
+    const Fixture& f = fixture(static_cast<std::size_t>(state.range(0)));
+    std::size_t hits = 0;
+    for (auto _ : state) {
+        hits = 0;
+        for (const std::string& n : f.names) hits += n.compare(0, 13, "line3.unit12.") == 0;
+        benchmark::DoNotOptimize(hits);
+    }
+    state.counters["tags"] = static_cast<double>(hits);
+}
+BENCHMARK(BM_Tags_PrefixScan)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Tags_MatchWildcard(benchmark::State& state) {
+    const Fixture& f = fixture(static_cast<std::size_t>(state.range(0)));
+    f.store.match("line3*");  // builds the tree outside the timed loop
+    std::size_t hits = 0;
+    for (auto _ : state) {
+        hits = 0;
+        f.store.for_each_match("line3.unit*.alarm.*", [&](TagId) { ++hits; });
+        benchmark::DoNotOptimize(hits);
+    }
+    state.counters["tags"] = static_cast<double>(hits);
+}
+BENCHMARK(BM_Tags_MatchWildcard)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+
+// Index overhead only; the names live in the store either way. The map
+// figure counts its node, key copy and bucket array.
+static void BM_Tags_Memory(benchmark::State& state) {
+    const Fixture& f = fixture(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) benchmark::DoNotOptimize(f.tree.size());
+    std::size_t mapBytes = f.map.bucket_count() * sizeof(void*);
+    for (const auto& [name, id] : f.map) {
+        mapBytes += sizeof(void*) + sizeof(std::size_t) + sizeof(name) + sizeof(id);
+        if (name.capacity() > 15) mapBytes += name.capacity() + 1;
+    }
+    state.counters["tree_MB"] = static_cast<double>(f.tree.memory_bytes()) / 1e6;
+    state.counters["map_MB"] = static_cast<double>(mapBytes) / 1e6;
+}
+BENCHMARK(BM_Tags_Memory)->Arg(1000000)->Iterations(1);
+
+// Health scans over the dense metadata arrays: one byte of quality and
+// eight of timestamp per tag, no values touched.
+static void BM_Tags_ScanQuality(benchmark::State& state) {
+    VariableStore store;
+    const auto tags = static_cast<std::size_t>(state.range(0));
+    store.reserve(tags);
+    for (std::size_t k = 0; k < tags; ++k) {
+        const TagId id = store.ensure_tag("t" + std::to_string(k), Value::make_int(0));
+        if (k % 1000 == 0) store.set_quality(id, xs::core::Quality::CommFailure);
+    }
+    for (auto _ : state) benchmark::DoNotOptimize(store.count_quality(xs::core::Quality::CommFailure));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Tags_ScanQuality)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Tags_ScanStale(benchmark::State& state) {
+    VariableStore store;
+    const auto tags = static_cast<std::size_t>(state.range(0));
+    store.reserve(tags);
+    for (std::size_t k = 0; k < tags; ++k) {
+        const TagId id = store.ensure_tag("t" + std::to_string(k), Value::make_int(0));
+        store.set(id, Value::make_int(1), xs::core::Quality::Good, k % 1000 == 0 ? 1 : 2);
+    }
+    std::vector<TagId> stale;
+    for (auto _ : state) {
+        stale.clear();
+        store.stale_tags(2, stale);
+        benchmark::DoNotOptimize(stale.data());
+    }
+    state.counters["stale"] = static_cast<double>(stale.size());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Tags_ScanStale)->Arg(1000000)->Unit(benchmark::kMicrosecond);
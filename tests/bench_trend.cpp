@@ -0,0 +1,84 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "../src/xs_decimation.hpp"
+
+using xs::core::MinMaxDecimator;
+
+namespace {
+
+    constexpr std::size_t kColumns = 1920;
+
+    struct Series {
+        std::vector<std::int64_t> t;
+        std::vector<double> v;
+
+        explicit Series(std::size_t n) : t(n), v(n) {
+            double x = 0.0;
+            for (std::size_t k = 0; k < n; ++k) {
+                t[k] = static_cast<std::int64_t>(k);
+                x += std::sin(static_cast<double>(k) * 0.001) + ((k * 7919) % 13) * 0.01 - 0.06;
+                v[k] = x;
+            }
+        }
+    };
+
+}
+
+// Baseline: recompute every column envelope from the full series each frame.
+static void BM_Trend_RecomputeFull(benchmark::State& state) {
+    const Series s(static_cast<std::size_t>(state.range(0)));
+    const std::size_t n = s.t.size();
+    std::vector<double> mn(kColumns), mx(kColumns);
+
+    for (auto _ : state) {
+        std::fill(mn.begin(), mn.end(), 1e300);
+        std::fill(mx.begin(), mx.end(), -1e300);
+        for (std::size_t k = 0; k < n; ++k) {
+            const std::size_t c = k * kColumns / n;
+            mn[c] = std::min(mn[c], s.v[k]);
+            mx[c] = std::max(mx[c], s.v[k]);
+        }
+        benchmark::DoNotOptimize(mn.data());
+        benchmark::DoNotOptimize(mx.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(n));
+}
+BENCHMARK(BM_Trend_RecomputeFull)->Arg(1 << 20)->Arg(1 << 23)->Unit(benchmark::kMillisecond);
+
+// Streaming: a window already holding N samples receives one frame's worth of
+// new samples and the envelope is read back for drawing.
+static void BM_Trend_IncrementalFrame(benchmark::State& state) {
+    const std::size_t total = static_cast<std::size_t>(state.range(0));
+    const std::size_t perFrame = static_cast<std::size_t>(state.range(1));
+    const Series s(total + perFrame * 4096);
+
+    MinMaxDecimator d(kColumns, static_cast<std::int64_t>(total));
+    d.add_block(s.t.data(), s.v.data(), total);
+
+    // The new samples are replayed once used up, shifted by the replayed
+    // span so time keeps moving forward.
+    const std::int64_t replaySpan = static_cast<std::int64_t>(s.t.size() - total);
+    std::vector<std::int64_t> t(perFrame);
+    std::int64_t shift = 0;
+    std::size_t pos = total;
+    double sink = 0.0;
+    for (auto _ : state) {
+        if (pos + perFrame > s.t.size()) {
+            pos = total;
+            shift += replaySpan;
+        }
+        for (std::size_t k = 0; k < perFrame; ++k) t[k] = s.t[pos + k] + shift;
+        d.add_block(t.data(), s.v.data() + pos, perFrame);
+        pos += perFrame;
+        for (std::size_t k = 0; k < d.columns(); ++k) sink += d.column(k).max;
+    }
+    benchmark::DoNotOptimize(sink);
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(perFrame));
+    state.counters["frames/s"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Trend_IncrementalFrame)->Args({ 1 << 20, 1000 })->Args({ 1 << 23, 20000 });
@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/xs_ui.hpp"
+
+#ifndef XS_ASSET_DIR
+#define XS_ASSET_DIR "assets"
+#endif
+
+// Dispatches synthetic mouse sweeps against a generated grid of buttons. No
+// window is opened, but text layout needs a GL context (Mesa's software GL
+// under Xvfb is enough).
+
+namespace {
+
+    struct EventScreen {
+        sf::Font font;
+        sf::RenderWindow window;
+        xs::ui::Theme theme;
+        std::shared_ptr<xs::ui::Panel> panel;
+        std::vector<std::shared_ptr<xs::ui::Widget>> widgets;
+        std::vector<sf::Event> sweep;
+
+        bool build(int count) {
+            if (!font.loadFromFile(XS_ASSET_DIR "/fonts/Roboto-Regular.ttf")) return false;
+
+            constexpr int cols = 50;
+            panel = std::make_shared<xs::ui::Panel>(theme);
+            for (int k = 0; k < count; ++k) {
+                auto b = std::make_shared<xs::ui::Button>(font, 12, theme);
+                b->set_position(sf::Vector2f(static_cast<float>(k % cols) * 64.f, static_cast<float>(k / cols) * 34.f));
+                b->set_size(sf::Vector2f(60.f, 30.f));
+                b->set_caption("B" + std::to_string(k));
+                panel->add(b);
+                widgets.push_back(b);
+            }
+
+            const float width = cols * 64.f;
+            const float height = static_cast<float>((count + cols - 1) / cols) * 34.f;
+            for (int k = 0; k < 256; ++k) {
+                sf::Event e;
+                e.type = sf::Event::MouseMoved;
+                e.mouseMove.x = static_cast<int>(width * static_cast<float>(k) / 256.f);
+                e.mouseMove.y = static_cast<int>(height * static_cast<float>((k * 37) % 256) / 256.f);
+                sweep.push_back(e);
+            }
+            return true;
+        }
+    };
+
+}
+
+static void BM_Events_Broadcast(benchmark::State& state) {
+    EventScreen screen;
+    if (!screen.build(static_cast<int>(state.range(0)))) {
+        state.SkipWithError("cannot load font");
+        return;
+    }
+    for (auto _ : state) {
+        for (const auto& e : screen.sweep) {
+            for (auto& w : screen.widgets) w->handle_event(e, screen.window);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(screen.sweep.size()));
+}
+BENCHMARK(BM_Events_Broadcast)->Arg(500)->Arg(2000)->Arg(8000);
+
+static void BM_Events_Routed(benchmark::State& state) {
+    EventScreen screen;
+    if (!screen.build(static_cast<int>(state.range(0)))) {
+        state.SkipWithError("cannot load font");
+        return;
+    }
+    for (auto _ : state) {
+        for (const auto& e : screen.sweep) screen.panel->handle_event(e, screen.window);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(screen.sweep.size()));
+}
+BENCHMARK(BM_Events_Routed)->Arg(500)->Arg(2000)->Arg(8000);
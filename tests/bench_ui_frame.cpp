@@ -0,0 +1,187 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/xs_ui.hpp"
+
+#ifndef XS_ASSET_DIR
+#define XS_ASSET_DIR "assets"
+#endif
+
+// Whole frames of a synthetic screen: N widgets bound to M tags, a number of
+// tag writes per frame, a mouse sweep with an occasional click, and the
+// retained compose path into an offscreen texture. Every iteration is one
+// frame; event, update, draw and display are timed separately and reported
+// as percentiles. Needs a GL context (Mesa's software GL is enough).
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    struct FrameScreen {
+        sf::Font font;
+        xs::ui::Theme theme;
+        xs::core::VariableStore store;
+        sf::RenderTexture target;
+        std::shared_ptr<xs::ui::Panel> panel;
+        std::vector<xs::core::TagId> analogs;
+        std::vector<sf::Event> sweep;
+        sf::RenderWindow window;
+
+        // Tag j is a float, bool or string by j % 3; widget k binds tag k % M
+        // with the matching kind (label, toggle button, text field).
+        bool build(int widgets, int tags) {
+            if (!font.loadFromFile(XS_ASSET_DIR "/fonts/Roboto-Regular.ttf")) return false;
+            if (!target.create(1920, 1080)) return false;
+
+            for (int j = 0; j < tags; ++j) {
+                const std::string name = "plc.t" + std::to_string(j);
+                switch (j % 3) {
+                case 0: analogs.push_back(store.ensure_tag(name, xs::core::Value::make_float(0.f))); break;
+                case 1: store.ensure_tag(name, xs::core::Value::make_bool(false)); break;
+                default: store.ensure_tag(name, xs::core::Value::make_string("auto")); break;
+                }
+            }
+
+            constexpr int cols = 20;
+            panel = std::make_shared<xs::ui::Panel>(theme);
+            panel->set_size(sf::Vector2f(1920.f, 1080.f));
+            for (int k = 0; k < widgets; ++k) {
+                const int j = k % tags;
+                const std::string name = "plc.t" + std::to_string(j);
+                const sf::Vector2f pos(static_cast<float>(k % cols) * 96.f, static_cast<float>(k / cols % 41) * 26.f);
+                std::shared_ptr<xs::ui::Widget> w;
+                switch (j % 3) {
+                case 0: {
+                    auto l = std::make_shared<xs::ui::Label>(font, 12, theme);
+                    l->bind_to(store, name);
+                    w = l;
+                    break;
+                }
+                case 1: {
+                    auto b = std::make_shared<xs::ui::Button>(font, 12, theme);
+                    b->set_caption("Run");
+                    b->bind_toggle_bool(store, name);
+                    w = b;
+                    break;
+                }
+                default: {
+                    auto f = std::make_shared<xs::ui::TextField>(font, 12, theme);
+                    f->bind_string(store, name);
+                    w = f;
+                    break;
+                }
+                }
+                w->set_position(pos);
+                if (j % 3 != 0) w->set_size(sf::Vector2f(90.f, 22.f));
+                panel->add(w);
+            }
+
+            for (int k = 0; k < 64; ++k) {
+                sf::Event e;
+                e.type = sf::Event::MouseMoved;
+                e.mouseMove.x = (k * 131) % 1920;
+                e.mouseMove.y = (k * 71) % 1080;
+                sweep.push_back(e);
+            }
+            return true;
+        }
+    };
+
+    struct PhaseTimes {
+        std::vector<double> event, update, draw, display;
+
+        static double us(Clock::time_point a, Clock::time_point b) {
+            return std::chrono::duration<double, std::micro>(b - a).count();
+        }
+    };
+
+    void percentiles(benchmark::State& state, const char* phase, std::vector<double>& samples) {
+        if (samples.empty()) return;
+        std::sort(samples.begin(), samples.end());
+        const std::string p(phase);
+        state.counters[p + "_p50_us"] = samples[samples.size() / 2];
+        state.counters[p + "_p95_us"] = samples[samples.size() * 95 / 100];
+        state.counters[p + "_p99_us"] = samples[samples.size() * 99 / 100];
+    }
+
+}
+
+// Args: widgets, tags, tag writes per frame.
+static void BM_Frame(benchmark::State& state) {
+    FrameScreen screen;
+    if (!screen.build(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)))) {
+        state.SkipWithError("cannot load font or create render texture");
+        return;
+    }
+    const auto writes = static_cast<std::size_t>(state.range(2));
+    const float dt = 1.f / 60.f;
+
+    xs::ui::FrameStats stats;
+    screen.panel->compose(screen.target, stats);
+    screen.target.display();
+
+    PhaseTimes t;
+    std::uint32_t seed = 12345;
+    std::size_t frame = 0;
+    float v = 0.f;
+    for (auto _ : state) {
+        const Clock::time_point t0 = Clock::now();
+        for (int k = 0; k < 4; ++k) {
+            screen.panel->handle_event(screen.sweep[(frame * 4 + static_cast<std::size_t>(k)) % screen.sweep.size()], screen.window);
+        }
+        if (frame % 30 == 0) {
+            // Widget 1 is a toggle button.
+            sf::Event e;
+            e.type = sf::Event::MouseButtonPressed;
+            e.mouseButton.button = sf::Mouse::Left;
+            e.mouseButton.x = 96 + 10;
+            e.mouseButton.y = 10;
+            screen.panel->handle_event(e, screen.window);
+            e.type = sf::Event::MouseButtonReleased;
+            screen.panel->handle_event(e, screen.window);
+        }
+
+        const Clock::time_point t1 = Clock::now();
+        if (!screen.analogs.empty()) {
+            xs::core::UpdateBatch batch(screen.store);
+            for (std::size_t k = 0; k < writes; ++k) {
+                seed = seed * 1664525u + 1013904223u;
+                v += 0.25f;
+                screen.store.set(screen.analogs[seed % screen.analogs.size()], xs::core::Value::make_float(v));
+            }
+        }
+        screen.panel->update(dt);
+
+        const Clock::time_point t2 = Clock::now();
+        screen.panel->compose(screen.target, stats);
+
+        const Clock::time_point t3 = Clock::now();
+        screen.target.display();
+        const Clock::time_point t4 = Clock::now();
+
+        t.event.push_back(PhaseTimes::us(t0, t1));
+        t.update.push_back(PhaseTimes::us(t1, t2));
+        t.draw.push_back(PhaseTimes::us(t2, t3));
+        t.display.push_back(PhaseTimes::us(t3, t4));
+        ++frame;
+    }
+
+    percentiles(state, "event", t.event);
+    percentiles(state, "update", t.update);
+    percentiles(state, "draw", t.draw);
+    percentiles(state, "display", t.display);
+    const double frames = static_cast<double>(state.iterations());
+    state.counters["regions/frame"] = static_cast<double>(stats.regions) / frames;
+    state.counters["repaints/frame"] = static_cast<double>(stats.full_repaints) / frames;
+}
+BENCHMARK(BM_Frame)
+    ->Args({ 300, 300, 20 })
+    ->Args({ 2000, 1000, 200 })
+    ->Args({ 2000, 1000, 5000 })
+    ->Unit(benchmark::kMillisecond);
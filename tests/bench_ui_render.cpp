@@ -0,0 +1,102 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+
+#include "../src/xs_ui.hpp"
+
+#ifndef XS_ASSET_DIR
+#define XS_ASSET_DIR "assets"
+#endif
+
+// Draws a generated screen of labels, buttons and text fields into an
+// offscreen texture with per-widget draw() and with the batched path. Needs
+// a GL context (Mesa's software GL under Xvfb is enough).
+
+namespace {
+
+    struct RenderScreen {
+        sf::Font font;
+        xs::ui::Theme theme;
+        sf::RenderTexture target;
+        std::shared_ptr<xs::ui::Panel> panel;
+
+        bool build(int count) {
+            if (!font.loadFromFile(XS_ASSET_DIR "/fonts/Roboto-Regular.ttf")) return false;
+            if (!target.create(1920, 1080)) return false;
+
+            constexpr int cols = 20;
+            panel = std::make_shared<xs::ui::Panel>(theme);
+            panel->set_size(sf::Vector2f(1920.f, 1080.f));
+            for (int k = 0; k < count; ++k) {
+                const sf::Vector2f pos(static_cast<float>(k % cols) * 96.f, static_cast<float>(k / cols) * 26.f);
+                switch (k % 3) {
+                case 0: {
+                    auto w = std::make_shared<xs::ui::Label>(font, 12, theme);
+                    w->set_text("T" + std::to_string(k) + " 12.34");
+                    w->set_position(pos);
+                    panel->add(w);
+                    break;
+                }
+                case 1: {
+                    auto w = std::make_shared<xs::ui::Button>(font, 12, theme);
+                    w->set_position(pos);
+                    w->set_size(sf::Vector2f(90.f, 22.f));
+                    w->set_caption("Start " + std::to_string(k));
+                    panel->add(w);
+                    break;
+                }
+                default: {
+                    auto w = std::make_shared<xs::ui::TextField>(font, 12, theme);
+                    w->set_position(pos);
+                    w->set_size(sf::Vector2f(90.f, 22.f));
+                    w->set_text("sp " + std::to_string(k));
+                    panel->add(w);
+                    break;
+                }
+                }
+            }
+            return true;
+        }
+    };
+
+    template <typename Draw>
+    void render_bench(benchmark::State& state, Draw&& draw) {
+        RenderScreen screen;
+        if (!screen.build(static_cast<int>(state.range(0)))) {
+            state.SkipWithError("cannot load font or create render texture");
+            return;
+        }
+
+        xs::ui::draw_stats() = xs::ui::DrawStats{};
+        for (auto _ : state) {
+            screen.target.clear(screen.theme.bg);
+            draw(screen);
+            screen.target.display();
+        }
+        const double frames = static_cast<double>(state.iterations());
+        state.counters["draw_calls/frame"] = static_cast<double>(xs::ui::draw_stats().calls) / frames;
+    }
+
+}
+
+static void BM_Render_PerWidget(benchmark::State& state) {
+    render_bench(state, [](RenderScreen& s) { s.panel->draw(s.target); });
+}
+BENCHMARK(BM_Render_PerWidget)->Arg(300)->Arg(2000)->Unit(benchmark::kMillisecond);
+
+static void BM_Render_Batched(benchmark::State& state) {
+    render_bench(state, [](RenderScreen& s) {
+        s.panel->draw_batched(s.target);
+        s.panel->clear_dirty();
+        });
+}
+BENCHMARK(BM_Render_Batched)->Arg(300)->Arg(2000)->Unit(benchmark::kMillisecond);
+
+static void BM_Render_BatchedRebuild(benchmark::State& state) {
+    render_bench(state, [](RenderScreen& s) {
+        s.panel->mark_dirty();
+        s.panel->draw_batched(s.target);
+        });
+}
+BENCHMARK(BM_Render_BatchedRebuild)->Arg(300)->Arg(2000)->Unit(benchmark::kMillisecond);
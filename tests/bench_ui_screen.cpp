@@ -0,0 +1,67 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "../src/xs_screen_ui.hpp"
+
+#ifndef XS_ASSET_DIR
+#define XS_ASSET_DIR "assets"
+#endif
+
+// Full screen load including widget instantiation and binding, for a
+// 10,000-widget screen in text and compiled form.
+
+namespace {
+
+    constexpr int kWidgets = 10000;
+
+    void write_screen(const std::string& path) {
+        std::ofstream s(path, std::ios::binary);
+        s << "screen 1920 1080\npanel 0 0 1920 1080\n";
+        for (int k = 0; k < kWidgets; ++k) {
+            const std::string xy = std::to_string((k % 20) * 96) + " " + std::to_string((k / 20) * 26);
+            const std::string tag = "plc.t" + std::to_string(k / 3);
+            switch (k % 3) {
+            case 0: s << "label " << xy << " size=12 prefix=\"T" << k << "\" bind=" << tag << "\n"; break;
+            case 1: s << "button " << xy << " 90 22 size=12 caption=\"Start\" toggle=" << tag << "\n"; break;
+            default: s << "textfield " << xy << " 90 22 size=12 hint=\"Name\" bind=" << tag << "\n"; break;
+            }
+        }
+        s << "end\n";
+    }
+
+    void build(benchmark::State& state, bool compiled) {
+        sf::Font font;
+        if (!font.loadFromFile(XS_ASSET_DIR "/fonts/Roboto-Regular.ttf")) {
+            state.SkipWithError("font not found");
+            return;
+        }
+        const auto dir = std::filesystem::temp_directory_path();
+        const std::string text = (dir / "xs_bench_ui_screen.xss").string();
+        const std::string binary = (dir / "xs_bench_ui_screen.xsb").string();
+        write_screen(text);
+        std::string error;
+        xs::core::compile_screen_file(text, binary, error);
+
+        const xs::ui::Theme theme;
+        for (auto _ : state) {
+            xs::core::ScreenFile file;
+            if (!file.load(compiled ? binary : text, error)) {
+                state.SkipWithError(error.c_str());
+                break;
+            }
+            xs::core::VariableStore store;
+            auto screen = xs::ui::build_screen(file.image(), font, theme, store);
+            benchmark::DoNotOptimize(screen.root.get());
+        }
+    }
+
+}
+
+static void BM_ScreenBuild_Text(benchmark::State& state) { build(state, false); }
+BENCHMARK(BM_ScreenBuild_Text)->Unit(benchmark::kMillisecond);
+
+static void BM_ScreenBuild_Compiled(benchmark::State& state) { build(state, true); }
+BENCHMARK(BM_ScreenBuild_Compiled)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,117 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "../src/xs_screen_manager.hpp"
+
+#ifndef XS_ASSET_DIR
+#define XS_ASSET_DIR "assets"
+#endif
+
+// Screen-switch latency between two 5,000-widget screens: rebuilding the
+// screen on every switch as main() used to, a ScreenManager that keeps only
+// the current screen (every switch builds, from the pool and with
+// off-screen widgets deferred), and one that keeps both warm. Only the
+// first 1920x1080 of each screen is visible.
+
+namespace {
+
+    constexpr int kWidgets = 5000;
+
+    void write_screen(const std::string& path, char line) {
+        std::ofstream s(path, std::ios::binary);
+        s << "screen 1920 1080\npanel 0 0 1920 " << (kWidgets / 20 + 1) * 26 << "\n";
+        for (int k = 0; k < kWidgets; ++k) {
+            const std::string xy = std::to_string((k % 20) * 96) + " " + std::to_string((k / 20) * 26);
+            const std::string tag = std::string("line") + line + ".t" + std::to_string(k / 3);
+            switch (k % 3) {
+            case 0: s << "label " << xy << " size=12 prefix=\"" << line << k << "\" bind=" << tag << "\n"; break;
+            case 1: s << "button " << xy << " 90 22 size=12 caption=\"Start\" toggle=" << tag << "\n"; break;
+            default: s << "textfield " << xy << " 90 22 size=12 hint=\"Name\" bind=" << tag << "\n"; break;
+            }
+        }
+        s << "end\n";
+    }
+
+    struct SwitchFixture {
+        sf::Font font;
+        xs::ui::Theme theme;
+        xs::core::VariableStore store;
+        xs::core::ScreenFile a;
+        xs::core::ScreenFile b;
+        std::string error;
+
+        bool load() {
+            if (!font.loadFromFile(XS_ASSET_DIR "/fonts/Roboto-Regular.ttf")) {
+                error = "font not found";
+                return false;
+            }
+            const auto dir = std::filesystem::temp_directory_path();
+            for (char line : { 'a', 'b' }) {
+                const std::string text = (dir / (std::string("xs_bench_switch_") + line + ".xss")).string();
+                const std::string binary = (dir / (std::string("xs_bench_switch_") + line + ".xsb")).string();
+                write_screen(text, line);
+                if (!xs::core::compile_screen_file(text, binary, error)) return false;
+                if (!(line == 'a' ? a : b).load(binary, error)) return false;
+            }
+            return true;
+        }
+    };
+
+    void manager_switch(benchmark::State& state, std::size_t warm, bool defer) {
+        SwitchFixture f;
+        if (!f.load()) {
+            state.SkipWithError(f.error.c_str());
+            return;
+        }
+        xs::ui::ScreenManager::Options options;
+        options.warm = warm;
+        options.deferOffscreen = defer;
+        xs::ui::ScreenManager screens(f.font, f.theme, f.store, options);
+        screens.add("a", f.a.image());
+        screens.add("b", f.b.image());
+        screens.show("a");
+        screens.show("b");
+
+        bool toA = true;
+        for (auto _ : state) {
+            auto* screen = screens.show(toA ? "a" : "b");
+            benchmark::DoNotOptimize(screen);
+            toA = !toA;
+        }
+        state.counters["builds"] = static_cast<double>(screens.builds());
+        state.counters["reused"] = static_cast<double>(screens.pool().reused());
+        const auto* current = screens.current();
+        state.counters["deferred"] = current ? static_cast<double>(current->deferred.size()) : 0.0;
+    }
+
+}
+
+static void BM_ScreenSwitch_Rebuild(benchmark::State& state) {
+    SwitchFixture f;
+    if (!f.load()) {
+        state.SkipWithError(f.error.c_str());
+        return;
+    }
+    xs::ui::LoadedScreen screen = xs::ui::build_screen(f.a.image(), f.font, f.theme, f.store);
+    bool toA = false;
+    for (auto _ : state) {
+        // The old screen is torn down before the new one is built.
+        screen = xs::ui::LoadedScreen();
+        screen = xs::ui::build_screen((toA ? f.a : f.b).image(), f.font, f.theme, f.store);
+        benchmark::DoNotOptimize(screen.root.get());
+        toA = !toA;
+    }
+}
+BENCHMARK(BM_ScreenSwitch_Rebuild)->Unit(benchmark::kMillisecond);
+
+static void BM_ScreenSwitch_PooledEager(benchmark::State& state) { manager_switch(state, 1, false); }
+BENCHMARK(BM_ScreenSwitch_PooledEager)->Unit(benchmark::kMillisecond);
+
+static void BM_ScreenSwitch_PooledDeferred(benchmark::State& state) { manager_switch(state, 1, true); }
+BENCHMARK(BM_ScreenSwitch_PooledDeferred)->Unit(benchmark::kMillisecond);
+
+static void BM_ScreenSwitch_Warm(benchmark::State& state) { manager_switch(state, 2, true); }
+BENCHMARK(BM_ScreenSwitch_Warm)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,222 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "../src/xs_ui.hpp"
+#include "alloc_counter.hpp"
+
+#ifndef XS_ASSET_DIR
+#define XS_ASSET_DIR "assets"
+#endif
+
+// Label updates and text field editing through the layout cache, against
+// the previous code paths (string concatenation + setString for labels,
+// copying the sf::Text and measuring the prefix for the caret). Each run
+// reports heap allocations per update.
+
+namespace {
+
+    struct Fonts {
+        sf::Font font;
+        bool ok{ false };
+        Fonts() : ok(font.loadFromFile(XS_ASSET_DIR "/fonts/Roboto-Regular.ttf")) {}
+    };
+
+    const sf::Font* font() {
+        static Fonts fonts;
+        return fonts.ok ? &fonts.font : nullptr;
+    }
+
+    void report(benchmark::State& state, std::size_t allocations, std::int64_t updates) {
+        state.counters["allocs/update"] = static_cast<double>(allocations) / static_cast<double>(updates);
+        state.SetItemsProcessed(updates);
+    }
+
+    // Ten keystrokes, caret walk to the start and back, ten backspaces.
+    std::vector<sf::Event> typing() {
+        std::vector<sf::Event> events;
+        sf::Event click;
+        click.type = sf::Event::MouseButtonPressed;
+        click.mouseButton.button = sf::Mouse::Left;
+        click.mouseButton.x = 20;
+        click.mouseButton.y = 20;
+        events.push_back(click);
+        const auto key = [&events](sf::Keyboard::Key code) {
+            sf::Event e;
+            e.type = sf::Event::KeyPressed;
+            e.key.code = code;
+            events.push_back(e);
+        };
+        const auto text = [&events](sf::Uint32 code) {
+            sf::Event e;
+            e.type = sf::Event::TextEntered;
+            e.text.unicode = code;
+            events.push_back(e);
+        };
+        for (char c : std::string("Pump 7 ok!")) text(static_cast<sf::Uint32>(c));
+        for (int k = 0; k < 10; ++k) key(sf::Keyboard::Left);
+        for (int k = 0; k < 10; ++k) key(sf::Keyboard::Right);
+        for (int k = 0; k < 10; ++k) text(8);
+        return events;
+    }
+
+}
+
+static void BM_Label_Toggle(benchmark::State& state) {
+    if (!font()) {
+        state.SkipWithError("cannot load font");
+        return;
+    }
+    const xs::ui::Theme theme;
+    xs::ui::Label label(*font(), 16, theme);
+    label.set_prefix("Pump:");
+    const std::string values[] = { "ON", "OFF" };
+    std::int64_t updates = 0;
+    label.set_text(values[1]);
+
+    xs::test::AllocScope allocs;
+    for (auto _ : state) {
+        label.set_text(values[updates++ & 1]);
+    }
+    report(state, allocs.allocations(), updates);
+}
+BENCHMARK(BM_Label_Toggle);
+
+static void BM_Label_Toggle_Legacy(benchmark::State& state) {
+    if (!font()) {
+        state.SkipWithError("cannot load font");
+        return;
+    }
+    sf::Text text;
+    text.setFont(*font());
+    text.setCharacterSize(16);
+    const std::string prefix = "Pump:";
+    const std::string values[] = { "ON", "OFF" };
+    std::int64_t updates = 0;
+
+    xs::test::AllocScope allocs;
+    for (auto _ : state) {
+        std::string combined = prefix;
+        combined += " ";
+        combined += values[updates++ & 1];
+        text.setString(combined);
+        benchmark::DoNotOptimize(text.getLocalBounds());
+    }
+    report(state, allocs.allocations(), updates);
+}
+BENCHMARK(BM_Label_Toggle_Legacy);
+
+static void BM_TextField_Editing(benchmark::State& state) {
+    if (!font()) {
+        state.SkipWithError("cannot load font");
+        return;
+    }
+    const xs::ui::Theme theme;
+    xs::ui::TextField field(*font(), 16, theme);
+    field.set_position(sf::Vector2f(0.f, 0.f));
+    const std::vector<sf::Event> events = typing();
+    sf::RenderWindow window;
+    std::int64_t updates = 0;
+
+    xs::test::AllocScope allocs;
+    for (auto _ : state) {
+        for (const auto& e : events) field.handle_event(e, window);
+        updates += static_cast<std::int64_t>(events.size());
+    }
+    report(state, allocs.allocations(), updates);
+}
+BENCHMARK(BM_TextField_Editing);
+
+static void BM_TextField_Editing_Legacy(benchmark::State& state) {
+    if (!font()) {
+        state.SkipWithError("cannot load font");
+        return;
+    }
+    sf::Text text;
+    text.setFont(*font());
+    text.setCharacterSize(16);
+    const std::vector<sf::Event> events = typing();
+    std::string value;
+    std::size_t caret = 0;
+    std::int64_t updates = 0;
+
+    const auto place_caret = [&]() {
+        sf::Text tmp = text;
+        tmp.setString(value.substr(0, caret));
+        benchmark::DoNotOptimize(tmp.getLocalBounds().width);
+    };
+
+    xs::test::AllocScope allocs;
+    for (auto _ : state) {
+        for (const auto& e : events) {
+            if (e.type == sf::Event::TextEntered && e.text.unicode == 8) {
+                if (caret > 0) value.erase(--caret, 1);
+                text.setString(value);
+            }
+            else if (e.type == sf::Event::TextEntered) {
+                value.insert(caret++, 1, static_cast<char>(e.text.unicode));
+                text.setString(value);
+            }
+            else if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::Left) {
+                if (caret > 0) --caret;
+            }
+            else if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::Right) {
+                if (caret < value.size()) ++caret;
+            }
+            place_caret();
+        }
+        updates += static_cast<std::int64_t>(events.size());
+    }
+    report(state, allocs.allocations(), updates);
+}
+BENCHMARK(BM_TextField_Editing_Legacy);
+
+// A vibration tag written 1000 times per frame. With the per-frame policy
+// the label formats once per frame; immediate formats on every write.
+static void label_fast_tag(benchmark::State& state, xs::ui::RefreshPolicy refresh) {
+    if (!font()) {
+        state.SkipWithError("cannot load font");
+        return;
+    }
+    constexpr int writes = 1000;
+    const xs::ui::Theme theme;
+    xs::core::VariableStore store;
+    const xs::core::TagId tag = store.ensure_tag("vib.x", xs::core::Value::make_double(0.0));
+    xs::ui::Label label(*font(), 16, theme);
+    label.bind_to(store, "vib.x", xs::core::FormatSpec{}, refresh);
+
+    xs::ui::TextLayoutCache& cache = xs::ui::text_layouts();
+    const std::uint64_t before = cache.hits() + cache.misses();
+    double v = 0.0;
+    for (auto _ : state) {
+        for (int k = 0; k < writes; ++k) {
+            v += 0.013;
+            store.set(tag, xs::core::Value::make_double(v));
+        }
+        label.update(1.f / 60.f);
+    }
+    const double frames = static_cast<double>(state.iterations());
+    state.counters["layouts/frame"] = static_cast<double>(cache.hits() + cache.misses() - before) / frames;
+    state.counters["writes/s"] = benchmark::Counter(frames * writes, benchmark::Counter::kIsRate);
+}
+
+static void BM_Label_FastTag_Immediate(benchmark::State& state) {
+    xs::ui::RefreshPolicy refresh;
+    refresh.immediate = true;
+    label_fast_tag(state, refresh);
+}
+BENCHMARK(BM_Label_FastTag_Immediate);
+
+static void BM_Label_FastTag_PerFrame(benchmark::State& state) {
+    label_fast_tag(state, xs::ui::RefreshPolicy{});
+}
+BENCHMARK(BM_Label_FastTag_PerFrame);
+
+static void BM_Label_FastTag_Deadband(benchmark::State& state) {
+    xs::ui::RefreshPolicy refresh;
+    refresh.intervalMs = 100;
+    refresh.deadband = 0.5;
+    label_fast_tag(state, refresh);
+}
+BENCHMARK(BM_Label_FastTag_Deadband);
@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "../src/xs_core.hpp"
+#include "alloc_counter.hpp"
+#include "legacy_value.hpp"
+
+using xs::core::Value;
+using xs::test::LegacyValue;
+
+namespace {
+
+    const std::string kLong = "Line 3 / Boiler feed pump running in remote mode";
+
+    template <typename V>
+    void copy_bench(benchmark::State& state, const V& src) {
+        constexpr std::size_t batch = 1024;
+        std::vector<V> dst;
+        dst.reserve(batch);
+        const xs::test::AllocScope allocs;
+        for (auto _ : state) {
+            dst.clear();
+            for (std::size_t k = 0; k < batch; ++k) dst.push_back(src);
+            benchmark::DoNotOptimize(dst.data());
+        }
+        const double copies = static_cast<double>(state.iterations()) * static_cast<double>(batch);
+        state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(batch));
+        state.counters["allocs/copy"] = static_cast<double>(allocs.allocations()) / copies;
+        state.counters["bytes/value"] = static_cast<double>(sizeof(V));
+    }
+
+}
+
+static void BM_LegacyValue_CopyFloat(benchmark::State& state) {
+    copy_bench(state, LegacyValue::make_float(23.5f));
+}
+BENCHMARK(BM_LegacyValue_CopyFloat);
+
+static void BM_Value_CopyFloat(benchmark::State& state) {
+    copy_bench(state, Value::make_float(23.5f));
+}
+BENCHMARK(BM_Value_CopyFloat);
+
+static void BM_LegacyValue_CopyLongString(benchmark::State& state) {
+    copy_bench(state, LegacyValue::make_string(kLong));
+}
+BENCHMARK(BM_LegacyValue_CopyLongString);
+
+static void BM_Value_CopyLongString(benchmark::State& state) {
+    copy_bench(state, Value::make_string(kLong));
+}
+BENCHMARK(BM_Value_CopyLongString);
+
+static void BM_LegacyValue_EqualsString(benchmark::State& state) {
+    const LegacyValue a = LegacyValue::make_string("OFF");
+    const LegacyValue b = LegacyValue::make_string("ON");
+    for (auto _ : state) benchmark::DoNotOptimize(a.equals(b));
+}
+BENCHMARK(BM_LegacyValue_EqualsString);
+
+static void BM_Value_EqualsString(benchmark::State& state) {
+    const Value a = Value::make_string("OFF");
+    const Value b = Value::make_string("ON");
+    for (auto _ : state) benchmark::DoNotOptimize(a.equals(b));
+}
+BENCHMARK(BM_Value_EqualsString);
@@ -0,0 +1,38 @@
+#pragma once
+
+// The pre-union Value layout, kept only as a baseline for size and
+// allocation comparisons.
+
+#include <string>
+
+namespace xs::test {
+
+    struct LegacyValue {
+        enum class Type { Int, Float, Bool, String };
+
+        Type type{ Type::Int };
+        int i{ 0 };
+        float f{ 0.0f };
+        bool b{ false };
+        std::string s;
+
+        static LegacyValue make_float(float v) {
+            LegacyValue x; x.type = Type::Float; x.f = v; return x;
+        }
+        static LegacyValue make_string(const std::string& v) {
+            LegacyValue x; x.type = Type::String; x.s = v; return x;
+        }
+
+        bool equals(const LegacyValue& other) const {
+            if (type != other.type) return false;
+            switch (type) {
+            case Type::Int:    return i == other.i;
+            case Type::Float:  return f == other.f;
+            case Type::Bool:   return b == other.b;
+            case Type::String: return s == other.s;
+            default:           return false;
+            }
+        }
+    };
+
+}
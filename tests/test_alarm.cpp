@@ -0,0 +1,270 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "../src/xs_alarm.hpp"
+
+using xs::core::AlarmConfig;
+using xs::core::AlarmEngine;
+using xs::core::AlarmEvent;
+using xs::core::AlarmId;
+using xs::core::AlarmKind;
+using xs::core::TagId;
+using xs::core::Value;
+using xs::core::VariableStore;
+
+namespace {
+
+    struct Fixture {
+        VariableStore store;
+        TagId tag{ store.ensure_tag("t", Value::make_float(0.f)) };
+        std::int64_t now{ 1000 };
+        AlarmEngine alarms{ store };
+        std::vector<std::pair<AlarmId, AlarmEvent>> events;
+
+        Fixture() {
+            alarms.set_clock([this]() { return now; });
+            alarms.set_listener([this](AlarmId id, AlarmEvent e) { events.emplace_back(id, e); });
+        }
+
+        void set(float v) { store.set(tag, Value::make_float(v)); }
+    };
+
+    AlarmConfig limit(AlarmKind kind, double value, double deadband = 0.0) {
+        AlarmConfig c;
+        c.kind = kind;
+        c.limit = value;
+        c.deadband = deadband;
+        return c;
+    }
+
+}
+
+TEST(AlarmEngine, HighLimitWithDeadband) {
+    Fixture f;
+    const AlarmId hi = f.alarms.add(f.tag, limit(AlarmKind::Hi, 80.0, 2.0));
+
+    f.set(79.f);
+    EXPECT_FALSE(f.alarms.active(hi));
+    f.set(80.f);
+    EXPECT_TRUE(f.alarms.active(hi));
+    f.set(78.5f);
+    EXPECT_TRUE(f.alarms.active(hi));
+    f.set(77.9f);
+    EXPECT_FALSE(f.alarms.active(hi));
+    EXPECT_EQ(f.events.size(), 2u);
+}
+
+TEST(AlarmEngine, LowLimits) {
+    Fixture f;
+    const AlarmId lo = f.alarms.add(f.tag, limit(AlarmKind::Lo, 10.0, 1.0));
+    const AlarmId lolo = f.alarms.add(f.tag, limit(AlarmKind::LoLo, 5.0));
+
+    f.set(7.f);
+    EXPECT_TRUE(f.alarms.active(lo));
+    EXPECT_FALSE(f.alarms.active(lolo));
+    f.set(4.f);
+    EXPECT_TRUE(f.alarms.active(lolo));
+    EXPECT_EQ(f.alarms.active_count(), 2u);
+    f.set(10.5f);
+    EXPECT_TRUE(f.alarms.active(lo));
+    f.set(11.5f);
+    EXPECT_EQ(f.alarms.active_count(), 0u);
+}
+
+TEST(AlarmEngine, DeviationFollowsSetpointTag) {
+    Fixture f;
+    const TagId sp = f.store.ensure_tag("sp", Value::make_float(50.f));
+    AlarmConfig c = limit(AlarmKind::Deviation, 5.0);
+    c.setpointTag = sp;
+    const AlarmId dev = f.alarms.add(f.tag, c);
+
+    f.set(53.f);
+    EXPECT_FALSE(f.alarms.active(dev));
+    f.store.set(sp, Value::make_float(60.f));
+    EXPECT_TRUE(f.alarms.active(dev));
+    f.set(58.f);
+    EXPECT_FALSE(f.alarms.active(dev));
+}
+
+TEST(AlarmEngine, RateOfChange) {
+    Fixture f;
+    const AlarmId roc = f.alarms.add(f.tag, limit(AlarmKind::RateOfChange, 10.0));
+
+    f.now += 1000;
+    f.set(5.f);
+    EXPECT_FALSE(f.alarms.active(roc));
+    f.now += 100;
+    f.set(7.f);
+    EXPECT_TRUE(f.alarms.active(roc));
+    f.now += 1000;
+    f.set(7.5f);
+    EXPECT_FALSE(f.alarms.active(roc));
+}
+
+TEST(AlarmEngine, RateOfChangeClearsWhileTheValueHolds) {
+    Fixture f;
+    const AlarmId roc = f.alarms.add(f.tag, limit(AlarmKind::RateOfChange, 10.0));
+
+    f.now += 1000;
+    f.set(5.f);
+    f.now += 100;
+    f.set(7.f);
+    EXPECT_TRUE(f.alarms.active(roc));
+
+    // No further samples: the step is spread over the time since.
+    f.now += 50;
+    f.alarms.tick();
+    EXPECT_TRUE(f.alarms.active(roc));
+    f.now += 500;
+    f.alarms.tick();
+    EXPECT_FALSE(f.alarms.active(roc));
+
+    const std::uint64_t evaluations = f.alarms.evaluations();
+    f.now += 1000;
+    f.alarms.tick();
+    EXPECT_EQ(f.alarms.evaluations(), evaluations);
+}
+
+TEST(AlarmEngine, NextDueIsTheFirstTimerOrRateDecay) {
+    Fixture f;
+    const std::int64_t never = std::numeric_limits<std::int64_t>::max();
+    AlarmConfig delayed = limit(AlarmKind::Hi, 10.0);
+    delayed.onDelay = 500;
+    const AlarmId hi = f.alarms.add(f.tag, delayed);
+    const AlarmId roc = f.alarms.add(f.tag, limit(AlarmKind::RateOfChange, 10.0));
+    EXPECT_EQ(f.alarms.next_due(), never);
+
+    f.now = 2000;
+    f.set(20.f);  // 20/s, which decays below 10/s after 3000
+    EXPECT_TRUE(f.alarms.active(roc));
+    EXPECT_EQ(f.alarms.next_due(), 2500);
+
+    f.now = 2100;
+    f.set(22.f);  // 2 in 100 ms: 20/s, which decays to 10/s by 2200
+    EXPECT_TRUE(f.alarms.active(roc));
+    EXPECT_EQ(f.alarms.next_due(), 2201);
+
+    f.now = 2199;
+    f.alarms.tick();
+    EXPECT_TRUE(f.alarms.active(roc));
+    f.now = f.alarms.next_due();
+    f.alarms.tick();
+    EXPECT_FALSE(f.alarms.active(roc));
+    EXPECT_EQ(f.alarms.next_due(), 2500);
+
+    f.now = 2500;
+    f.alarms.tick();
+    EXPECT_TRUE(f.alarms.active(hi));
+    EXPECT_EQ(f.alarms.next_due(), never);
+}
+
+TEST(AlarmEngine, OnAndOffDelays) {
+    Fixture f;
+    AlarmConfig c = limit(AlarmKind::Hi, 10.0);
+    c.onDelay = 500;
+    c.offDelay = 200;
+    const AlarmId hi = f.alarms.add(f.tag, c);
+
+    f.set(20.f);
+    f.now += 400;
+    f.alarms.tick();
+    EXPECT_FALSE(f.alarms.active(hi));
+    f.now += 100;
+    f.alarms.tick();
+    EXPECT_TRUE(f.alarms.active(hi));
+
+    f.set(0.f);
+    EXPECT_TRUE(f.alarms.active(hi));
+    f.set(20.f);
+    f.now += 1000;
+    f.alarms.tick();
+    EXPECT_TRUE(f.alarms.active(hi));
+
+    f.set(0.f);
+    f.now += 200;
+    f.alarms.tick();
+    EXPECT_FALSE(f.alarms.active(hi));
+}
+
+TEST(AlarmEngine, ShortExcursionDoesNotRaise) {
+    Fixture f;
+    AlarmConfig c = limit(AlarmKind::Hi, 10.0);
+    c.onDelay = 500;
+    const AlarmId hi = f.alarms.add(f.tag, c);
+
+    f.set(20.f);
+    f.now += 100;
+    f.set(0.f);
+    f.now += 1000;
+    f.alarms.tick();
+    EXPECT_FALSE(f.alarms.active(hi));
+    EXPECT_TRUE(f.events.empty());
+}
+
+TEST(AlarmEngine, AlarmListKeepsUnacknowledgedAlarms) {
+    Fixture f;
+    const AlarmId hi = f.alarms.add(f.tag, limit(AlarmKind::Hi, 10.0));
+    const AlarmId hihi = f.alarms.add(f.tag, limit(AlarmKind::HiHi, 20.0));
+
+    f.set(25.f);
+    EXPECT_EQ(f.alarms.alarm_list().size(), 2u);
+    f.set(0.f);
+    EXPECT_EQ(f.alarms.alarm_list().size(), 2u);
+    EXPECT_EQ(f.alarms.active_count(), 0u);
+
+    EXPECT_TRUE(f.alarms.acknowledge(hi));
+    EXPECT_FALSE(f.alarms.acknowledge(hi));
+    ASSERT_EQ(f.alarms.alarm_list().size(), 1u);
+    EXPECT_EQ(f.alarms.alarm_list()[0], hihi);
+
+    f.set(15.f);
+    f.alarms.acknowledge_all();
+    ASSERT_EQ(f.alarms.alarm_list().size(), 1u);
+    EXPECT_EQ(f.alarms.alarm_list()[0], hi);
+    EXPECT_TRUE(f.alarms.acknowledged(hi));
+}
+
+TEST(AlarmEngine, ShelvingSuppressesUntilExpiry) {
+    Fixture f;
+    const AlarmId hi = f.alarms.add(f.tag, limit(AlarmKind::Hi, 10.0));
+    f.set(20.f);
+    ASSERT_TRUE(f.alarms.active(hi));
+
+    EXPECT_TRUE(f.alarms.shelve(hi, f.now + 1000));
+    EXPECT_FALSE(f.alarms.active(hi));
+    EXPECT_TRUE(f.alarms.alarm_list().empty());
+    f.set(30.f);
+    EXPECT_FALSE(f.alarms.active(hi));
+
+    f.now += 1000;
+    f.alarms.tick();
+    EXPECT_FALSE(f.alarms.shelved(hi));
+    EXPECT_TRUE(f.alarms.active(hi));
+}
+
+TEST(AlarmEngine, PublishesActiveCount) {
+    Fixture f;
+    const TagId count = f.store.ensure_tag("alarms.active", Value::make_int(0));
+    f.alarms.publish_count(count);
+    f.alarms.add(f.tag, limit(AlarmKind::Hi, 10.0));
+    f.alarms.add(f.tag, limit(AlarmKind::HiHi, 20.0));
+
+    f.set(25.f);
+    EXPECT_EQ(f.store.get(count).as_int(), 2);
+    f.set(15.f);
+    EXPECT_EQ(f.store.get(count).as_int(), 1);
+}
+
+TEST(AlarmEngine, EvaluatesOnlyAlarmsOfTheChangedTag) {
+    Fixture f;
+    const TagId other = f.store.ensure_tag("other", Value::make_float(0.f));
+    f.alarms.add(f.tag, limit(AlarmKind::Hi, 10.0));
+    f.alarms.add(other, limit(AlarmKind::Hi, 10.0));
+
+    const auto before = f.alarms.evaluations();
+    f.set(5.f);
+    EXPECT_EQ(f.alarms.evaluations() - before, 1u);
+}
@@ -1,6 +1,14 @@
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
 #include "../src/xs_core.hpp"
+#include "alloc_counter.hpp"
 
 TEST(Value, Equals_Int) {
     xs::core::Value a = xs::core::Value::make_int(10);
@@ -24,7 +32,7 @@ TEST(Variable, SubscribeImmediatelyReceivesCurrentValue) {
 
     v.subscribe([&](const xs::core::Value& x) {
         got = true;
-        last = (x.type == xs::core::Value::Type::Bool) ? x.b : false;
+        last = (x.type() == xs::core::Value::Type::Bool) ? x.as_bool() : false;
         });
 
     EXPECT_TRUE(got);
@@ -46,13 +54,149 @@ TEST(Variable, SetNotifiesSubscribersOnlyOnChange) {
     EXPECT_EQ(calls, 2);
 }
 
+TEST(Variable, UnsubscribeByIdIsStableAcrossRemovals) {
+    xs::core::Variable v(xs::core::Value::make_int(0));
+
+    std::vector<int> calls(4, 0);
+    std::vector<std::size_t> ids;
+    for (int k = 0; k < 4; ++k) ids.push_back(v.subscribe([&calls, k](const xs::core::Value&) { ++calls[k]; }));
+
+    v.unsubscribe(ids[1]);
+    v.unsubscribe(ids[1]);
+    v.set(xs::core::Value::make_int(1));
+    EXPECT_EQ(calls, (std::vector<int>{ 2, 1, 2, 2 }));
+
+    // The freed slot is reused, but the old id must not reach the new entry.
+    int fresh = 0;
+    v.subscribe([&](const xs::core::Value&) { ++fresh; });
+    v.unsubscribe(ids[1]);
+    v.unsubscribe(ids[3]);
+    v.set(xs::core::Value::make_int(2));
+    EXPECT_EQ(calls, (std::vector<int>{ 3, 1, 3, 2 }));
+    EXPECT_EQ(fresh, 2);
+    EXPECT_EQ(v.subscriber_count(), 3u);
+}
+
+TEST(Variable, CallbackMayUnsubscribeItselfAndOthers) {
+    xs::core::Variable v(xs::core::Value::make_int(0));
+
+    int first = 0;
+    int second = 0;
+    std::size_t firstId = 0;
+    std::size_t secondId = 0;
+    firstId = v.subscribe([&](const xs::core::Value& x) {
+        ++first;
+        if (x.as_int() == 1) {
+            v.unsubscribe(firstId);
+            v.unsubscribe(secondId);
+        }
+        });
+    secondId = v.subscribe([&](const xs::core::Value&) { ++second; });
+
+    v.set(xs::core::Value::make_int(1));
+    v.set(xs::core::Value::make_int(2));
+
+    EXPECT_EQ(first, 2);
+    EXPECT_EQ(second, 1);
+    EXPECT_EQ(v.subscriber_count(), 0u);
+}
+
+TEST(Variable, SubscribeDuringNotifyJoinsAfterwards) {
+    xs::core::Variable v(xs::core::Value::make_int(0));
+
+    int added = 0;
+    std::vector<int> seen;
+    v.subscribe([&](const xs::core::Value& x) {
+        if (x.as_int() == 1) {
+            v.subscribe([&](const xs::core::Value& y) { ++added; seen.push_back(y.as_int()); });
+        }
+        });
+
+    v.set(xs::core::Value::make_int(1));
+    EXPECT_EQ(added, 1);
+
+    v.set(xs::core::Value::make_int(2));
+    EXPECT_EQ(added, 2);
+    EXPECT_EQ(seen, (std::vector<int>{ 1, 2 }));
+}
+
+TEST(Variable, NestedSetDeliversLatestValue) {
+    xs::core::Variable v(xs::core::Value::make_int(0));
+
+    // Clamps the value from inside its own notification.
+    v.subscribe([&](const xs::core::Value& x) {
+        if (x.as_int() > 10) v.set(xs::core::Value::make_int(10));
+        });
+    int last = -1;
+    v.subscribe([&](const xs::core::Value& x) { last = x.as_int(); });
+
+    v.set(xs::core::Value::make_int(50));
+    EXPECT_EQ(v.get().as_int(), 10);
+    EXPECT_EQ(last, 10);
+}
+
+TEST(Variable, ScopedSubscriptionDetachesOnDestruction) {
+    xs::core::Variable v(xs::core::Value::make_int(0));
+
+    int calls = 0;
+    {
+        xs::core::Subscription sub = v.subscribe_scoped([&](const xs::core::Value&) { ++calls; });
+        xs::core::Subscription moved = std::move(sub);
+        EXPECT_FALSE(sub);
+        v.set(xs::core::Value::make_int(1));
+    }
+    v.set(xs::core::Value::make_int(2));
+    EXPECT_EQ(calls, 2);
+    EXPECT_EQ(v.subscriber_count(), 0u);
+
+    // Destroying the owner from inside a notification is deferred safely.
+    auto owned = std::make_unique<xs::core::Subscription>();
+    *owned = v.subscribe_scoped([&](const xs::core::Value& x) { if (x.as_int() == 3) owned.reset(); });
+    v.set(xs::core::Value::make_int(3));
+    EXPECT_EQ(owned, nullptr);
+    EXPECT_EQ(v.subscriber_count(), 0u);
+}
+
+TEST(Variable, SmallCallbacksDoNotAllocate) {
+    xs::core::Variable v(xs::core::Value::make_int(0));
+    v.subscribe([](const xs::core::Value&) {});
+    v.unsubscribe(v.subscribe([](const xs::core::Value&) {}));
+
+    int* counter = nullptr;
+    int calls = 0;
+    counter = &calls;
+    xs::test::AllocScope scope;
+    const std::size_t id = v.subscribe([counter, &v](const xs::core::Value&) { ++*counter; (void)v; });
+    v.set(xs::core::Value::make_int(1));
+    v.unsubscribe(id);
+    EXPECT_EQ(scope.allocations(), 0u);
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(VariableStore, QualityChangeNotifiesEvenWithEqualValue) {
+    using xs::core::Quality;
+    xs::core::VariableStore s;
+    const xs::core::TagId t = s.ensure_tag("a", xs::core::Value::make_int(5));
+    EXPECT_EQ(s.quality(t), Quality::Good);
+
+    std::vector<Quality> seen;
+    s.at(t).subscribe([&](const xs::core::Value&) { seen.push_back(s.quality(t)); });
+
+    s.set(t, xs::core::Value::make_int(5), Quality::Good, 0);
+    s.set(t, xs::core::Value::make_int(5), Quality::Uncertain, 0);
+    s.set_quality(t, Quality::Uncertain);
+    s.set(t, xs::core::Value::make_int(6));
+    s.set_quality(t, Quality::Good);
+    EXPECT_EQ(seen, (std::vector<Quality>{ Quality::Good, Quality::Uncertain, Quality::Uncertain, Quality::Good }));
+}
+
 TEST(VariableStore, EnsureCreatesIfMissing) {
     xs::core::VariableStore s;
     EXPECT_FALSE(s.has("a"));
 
     s.ensure("a", xs::core::Value::make_int(5));
     EXPECT_TRUE(s.has("a"));
-    EXPECT_EQ(s.get("a").i, 5);
+    EXPECT_EQ(s.get("a").as_int(), 5);
 }
 
 TEST(VariableStore, GetBoolFloatStringFallbacks) {
@@ -69,4 +213,329 @@ TEST(VariableStore, GetBoolFloatStringFallbacks) {
     EXPECT_EQ(s.get_bool("b", true), false);
     EXPECT_FLOAT_EQ(s.get_float("f", 0.f), 2.25f);
     EXPECT_EQ(s.get_string("s", ""), "hello");
-}
\ No newline at end of file
+}
+
+TEST(VariableStore, ResolveReturnsStableHandles) {
+    xs::core::VariableStore s;
+    EXPECT_EQ(s.resolve("missing"), xs::core::invalid_tag);
+
+    const xs::core::TagId a = s.ensure_tag("a", xs::core::Value::make_int(1));
+    const xs::core::TagId b = s.ensure_tag("b", xs::core::Value::make_int(2));
+    EXPECT_NE(a, b);
+    EXPECT_EQ(s.resolve("a"), a);
+    EXPECT_EQ(s.ensure_tag("a", xs::core::Value::make_int(99)), a);
+    EXPECT_EQ(s.name(b), "b");
+    EXPECT_EQ(s.size(), 2u);
+    EXPECT_EQ(s.get(a).as_int(), 1);
+}
+
+TEST(VariableStore, ResolvesEveryTagAcrossIndexGrowth) {
+    xs::core::VariableStore s;
+    for (int k = 0; k < 5000; ++k) s.ensure_tag("plc.tag" + std::to_string(k), xs::core::Value::make_int(k));
+    s.reserve(20000);
+    for (int k = 5000; k < 10000; ++k) s.ensure_tag("plc.tag" + std::to_string(k), xs::core::Value::make_int(k));
+
+    ASSERT_EQ(s.size(), 10000u);
+    for (int k = 0; k < 10000; ++k) {
+        const xs::core::TagId id = s.resolve("plc.tag" + std::to_string(k));
+        ASSERT_NE(id, xs::core::invalid_tag) << k;
+        EXPECT_EQ(s.get(id).as_int(), k);
+    }
+    EXPECT_EQ(s.resolve("plc.tag10000"), xs::core::invalid_tag);
+    EXPECT_EQ(s.resolve("plc.tag"), xs::core::invalid_tag);
+}
+
+TEST(VariableStore, HandleAndNameAccessShareTheSameVariable) {
+    xs::core::VariableStore s;
+    const xs::core::TagId t = s.ensure_tag("t", xs::core::Value::make_float(1.0f));
+
+    int calls = 0;
+    s.at("t").subscribe([&](const xs::core::Value&) { ++calls; });
+
+    s.set(t, xs::core::Value::make_float(2.0f));
+    EXPECT_FLOAT_EQ(s.get_float("t", 0.f), 2.0f);
+
+    s.set("t", xs::core::Value::make_float(3.0f));
+    EXPECT_FLOAT_EQ(s.get_float(t, 0.f), 3.0f);
+    EXPECT_EQ(calls, 3);
+
+    EXPECT_EQ(s.get_bool(xs::core::invalid_tag, true), true);
+    EXPECT_EQ(s.get_string(xs::core::invalid_tag, "x"), "x");
+}
+
+TEST(UpdateBatch, CoalescesWritesAndNotifiesOncePerTag) {
+    xs::core::VariableStore s;
+    const xs::core::TagId a = s.ensure_tag("a", xs::core::Value::make_int(0));
+    const xs::core::TagId b = s.ensure_tag("b", xs::core::Value::make_int(0));
+
+    int callsA = 0;
+    int callsB = 0;
+    int lastA = -1;
+    s.at(a).subscribe([&](const xs::core::Value& v) { ++callsA; lastA = v.as_int(); });
+    s.at(b).subscribe([&](const xs::core::Value&) { ++callsB; });
+
+    {
+        xs::core::UpdateBatch batch(s);
+        for (int k = 1; k <= 1000; ++k) s.set(a, xs::core::Value::make_int(k));
+        s.set(b, xs::core::Value::make_int(0));
+        EXPECT_EQ(s.get(a).as_int(), 0);
+        EXPECT_EQ(s.pending(), 2u);
+    }
+
+    EXPECT_EQ(callsA, 2);
+    EXPECT_EQ(lastA, 1000);
+    EXPECT_EQ(callsB, 1);
+    EXPECT_EQ(s.pending(), 0u);
+}
+
+TEST(UpdateBatch, SubscriberWritesAreAppliedWithinTheSameCommit) {
+    xs::core::VariableStore s;
+    const xs::core::TagId src = s.ensure_tag("pump.enabled", xs::core::Value::make_bool(false));
+    const xs::core::TagId view = s.ensure_tag("pump.enabled.view", xs::core::Value::make_string("OFF"));
+
+    s.at(src).subscribe([&](const xs::core::Value& v) {
+        s.set(view, xs::core::Value::make_string(v.as_bool() ? "ON" : "OFF"));
+        });
+
+    int viewCalls = 0;
+    s.at(view).subscribe([&](const xs::core::Value&) { ++viewCalls; });
+
+    s.begin_batch();
+    s.set(src, xs::core::Value::make_bool(true));
+    s.begin_batch();
+    s.set(src, xs::core::Value::make_bool(false));
+    s.set(src, xs::core::Value::make_bool(true));
+    s.commit();
+    EXPECT_TRUE(s.in_batch());
+    EXPECT_EQ(viewCalls, 1);
+    s.commit();
+
+    EXPECT_FALSE(s.in_batch());
+    EXPECT_EQ(s.get_string(view, ""), "ON");
+    EXPECT_EQ(viewCalls, 2);
+}
+
+TEST(UpdateBatch, SteadyCommitsDoNotAllocate) {
+    xs::core::VariableStore s;
+    std::vector<xs::core::TagId> tags;
+    for (int k = 0; k < 5000; ++k) {
+        tags.push_back(s.ensure_tag("plc.r" + std::to_string(k), xs::core::Value::make_int(0)));
+        s.at(tags.back()).subscribe([](const xs::core::Value&) {});
+    }
+    auto scan = [&](int base) {
+        xs::core::UpdateBatch batch(s);
+        for (std::size_t k = 0; k < tags.size(); ++k) s.set(tags[k], xs::core::Value::make_int(base + static_cast<int>(k)));
+    };
+    scan(1);
+
+    xs::test::AllocScope scope;
+    scan(2);
+    scan(3);
+    EXPECT_EQ(scope.allocations(), 0u);
+    EXPECT_EQ(s.get(tags.back()).as_int(), 3 + 4999);
+}
+
+TEST(TagTree, SplitsEdgesAndFindsExactNames) {
+    xs::core::TagTree t;
+    t.insert("pump.enabled.view", 0);
+    t.insert("pump.enabled", 1);
+    t.insert("pump.speed", 2);
+    t.insert("pumphouse.level", 3);
+    t.insert("operator.name", 4);
+
+    EXPECT_EQ(t.size(), 5u);
+    EXPECT_EQ(t.find("pump.enabled"), 1u);
+    EXPECT_EQ(t.find("pump.enabled.view"), 0u);
+    EXPECT_EQ(t.find("pumphouse.level"), 3u);
+    EXPECT_EQ(t.find("pump"), xs::core::invalid_tag);
+    EXPECT_EQ(t.find("pump.enable"), xs::core::invalid_tag);
+    EXPECT_EQ(t.find("pump.enabled.viewer"), xs::core::invalid_tag);
+}
+
+TEST(TagTree, EnumeratesPrefixesInNameOrder) {
+    xs::core::TagTree t;
+    const std::vector<std::string> names = { "line3.pump2.speed", "line3.pump1.speed", "line3.pump1.run",
+        "line3.valve", "line30.pump1.run", "line4.pump1.run" };
+    for (std::size_t k = 0; k < names.size(); ++k) t.insert(names[k], static_cast<xs::core::TagId>(k));
+
+    auto under = [&](std::string_view prefix) {
+        std::vector<std::string> out;
+        t.for_each_prefix(prefix, [&](xs::core::TagId id) { out.push_back(names[id]); });
+        return out;
+    };
+    EXPECT_EQ(under("line3.pump"), (std::vector<std::string>{ "line3.pump1.run", "line3.pump1.speed", "line3.pump2.speed" }));
+    EXPECT_EQ(under("line3.pump1.r"), (std::vector<std::string>{ "line3.pump1.run" }));
+    EXPECT_EQ(under("line3.valve"), (std::vector<std::string>{ "line3.valve" }));
+    EXPECT_EQ(under("line3").size(), 5u);
+    EXPECT_EQ(under("").size(), names.size());
+    EXPECT_TRUE(under("line5").empty());
+    EXPECT_TRUE(under("line3.pump3").empty());
+}
+
+TEST(TagPattern, MatchesGlobs) {
+    using xs::core::match_pattern;
+    EXPECT_TRUE(match_pattern("boiler.*", "boiler.temp"));
+    EXPECT_TRUE(match_pattern("boiler.*", "boiler.drum.level"));
+    EXPECT_FALSE(match_pattern("boiler.*", "boiler"));
+    EXPECT_TRUE(match_pattern("line?.pump*.run", "line3.pump12.run"));
+    EXPECT_FALSE(match_pattern("line?.pump*.run", "line30.pump1.run"));
+    EXPECT_TRUE(match_pattern("*.alarm", "a.b.alarm"));
+    EXPECT_TRUE(match_pattern("*", ""));
+    EXPECT_FALSE(match_pattern("a", "ab"));
+}
+
+TEST(VariableStore, MatchUsesPrefixesAndWildcards) {
+    xs::core::VariableStore s;
+    for (const char* name : { "line3.pump2.run", "line3.pump1.run", "line3.pump1.speed", "line3.valve", "line4.pump1.run" }) {
+        s.ensure_tag(name, xs::core::Value::make_int(0));
+    }
+    auto names = [&](std::string_view pattern) {
+        std::vector<std::string> out;
+        for (xs::core::TagId id : s.match(pattern)) out.push_back(s.name(id));
+        return out;
+    };
+    EXPECT_EQ(names("line3.pump*"), (std::vector<std::string>{ "line3.pump1.run", "line3.pump1.speed", "line3.pump2.run" }));
+    EXPECT_EQ(names("line?.pump1.run"), (std::vector<std::string>{ "line3.pump1.run", "line4.pump1.run" }));
+    EXPECT_EQ(names("line3.valve"), (std::vector<std::string>{ "line3.valve" }));
+
+    // Tags created after the tree was built are found too.
+    s.ensure_tag("line3.pump0.run", xs::core::Value::make_int(0));
+    EXPECT_EQ(names("line3.pump*.run"), (std::vector<std::string>{ "line3.pump0.run", "line3.pump1.run", "line3.pump2.run" }));
+}
+
+TEST(VariableStore, PatternSubscriptionsSeeExistingAndLaterTags) {
+    xs::core::VariableStore s;
+    const xs::core::TagId temp = s.ensure_tag("boiler.temp", xs::core::Value::make_float(80.f));
+    s.ensure_tag("turbine.speed", xs::core::Value::make_float(0.f));
+
+    std::vector<std::pair<std::string, float>> seen;
+    const std::size_t sub = s.subscribe_pattern("boiler.*", [&](xs::core::TagId id, const xs::core::Value& v) {
+        seen.emplace_back(s.name(id), v.as_float());
+    });
+    ASSERT_EQ(seen.size(), 1u);
+
+    s.set(temp, xs::core::Value::make_float(81.f));
+    s.set("turbine.speed", xs::core::Value::make_float(3000.f));
+    const xs::core::TagId level = s.ensure_tag("boiler.drum.level", xs::core::Value::make_float(0.5f));
+    s.set(level, xs::core::Value::make_float(0.6f));
+    EXPECT_EQ(seen, (std::vector<std::pair<std::string, float>>{
+        { "boiler.temp", 80.f }, { "boiler.temp", 81.f }, { "boiler.drum.level", 0.5f }, { "boiler.drum.level", 0.6f } }));
+
+    s.unsubscribe_pattern(sub);
+    s.set(temp, xs::core::Value::make_float(82.f));
+    s.ensure_tag("boiler.pressure", xs::core::Value::make_float(1.f));
+    EXPECT_EQ(seen.size(), 4u);
+}
+
+TEST(VariableStore, PatternSubscriptionMayRemoveItself) {
+    xs::core::VariableStore s;
+    const xs::core::TagId a = s.ensure_tag("a.x", xs::core::Value::make_int(0));
+    int calls = 0;
+    std::size_t sub = 0;
+    sub = s.subscribe_pattern("a.*", [&](xs::core::TagId, const xs::core::Value& v) {
+        ++calls;
+        if (v.as_int() == 1) s.unsubscribe_pattern(sub);
+    });
+    s.set(a, xs::core::Value::make_int(1));
+    s.set(a, xs::core::Value::make_int(2));
+    EXPECT_EQ(calls, 2);
+    s.subscribe_pattern("b.*", [](xs::core::TagId, const xs::core::Value&) {});
+}
+
+TEST(VariableStore, PatternSubscriptionMayReplaceItself) {
+    xs::core::VariableStore s;
+    const xs::core::TagId a = s.ensure_tag("a.x", xs::core::Value::make_int(0));
+    const xs::core::TagId b = s.ensure_tag("b.x", xs::core::Value::make_int(0));
+    std::vector<std::string> seen;
+    std::size_t sub = 0;
+    sub = s.subscribe_pattern("a.*", [&, label = std::string("first pattern, long enough to allocate")](
+        xs::core::TagId, const xs::core::Value& v) {
+        if (v.as_int() != 1) return;
+        s.unsubscribe_pattern(sub);
+        sub = s.subscribe_pattern("b.*", [&](xs::core::TagId, const xs::core::Value& w) {
+            seen.push_back("b" + std::to_string(w.as_int()));
+        });
+        // Still inside the retired callback: its captures must be alive.
+        seen.push_back(label);
+    });
+    s.set(a, xs::core::Value::make_int(1));
+    s.set(a, xs::core::Value::make_int(2));
+    s.set(b, xs::core::Value::make_int(3));
+    EXPECT_EQ(seen, (std::vector<std::string>{ "b0", "first pattern, long enough to allocate", "b3" }));
+    s.unsubscribe_pattern(sub);
+}
+
+TEST(VariableStore, SourceWritesRecordQualityAndTimestamp) {
+    using xs::core::Quality;
+    xs::core::VariableStore s;
+    const xs::core::TagId t = s.ensure_tag("plc.temp", xs::core::Value::make_float(20.f));
+    EXPECT_EQ(s.quality(t), Quality::Good);
+    EXPECT_EQ(s.timestamp(t), 0);
+
+    int calls = 0;
+    s.at(t).subscribe([&](const xs::core::Value&) { ++calls; });
+
+    // Same value and quality: only the timestamp moves.
+    s.set(t, xs::core::Value::make_float(20.f), Quality::Good, 1000);
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(s.timestamp(t), 1000);
+
+    s.set(t, xs::core::Value::make_float(20.f), Quality::CommFailure, 2000);
+    EXPECT_EQ(calls, 2);
+    EXPECT_EQ(s.quality(t), Quality::CommFailure);
+
+    // A plain write keeps the metadata.
+    s.set(t, xs::core::Value::make_float(21.f));
+    EXPECT_EQ(calls, 3);
+    EXPECT_EQ(s.quality(t), Quality::CommFailure);
+    EXPECT_EQ(s.timestamp(t), 2000);
+}
+
+TEST(VariableStore, BatchedWritesKeepTheLastQuality) {
+    using xs::core::Quality;
+    xs::core::VariableStore s;
+    const xs::core::TagId t = s.ensure_tag("a", xs::core::Value::make_int(0));
+    std::vector<Quality> seen;
+    s.at(t).subscribe([&](const xs::core::Value&) { seen.push_back(s.quality(t)); });
+
+    {
+        xs::core::UpdateBatch batch(s);
+        s.set(t, xs::core::Value::make_int(1), Quality::Bad, 10);
+        s.set(t, xs::core::Value::make_int(2));
+        s.set_quality(t, Quality::Uncertain);
+        EXPECT_EQ(s.quality(t), Quality::Good);
+    }
+    EXPECT_EQ(s.get(t).as_int(), 2);
+    EXPECT_EQ(s.quality(t), Quality::Uncertain);
+    EXPECT_EQ(s.timestamp(t), 10);
+    EXPECT_EQ(seen, (std::vector<Quality>{ Quality::Good, Quality::Uncertain }));
+
+    {
+        xs::core::UpdateBatch batch(s);
+        s.set_quality(t, Quality::Good);
+    }
+    EXPECT_EQ(s.get(t).as_int(), 2);
+    EXPECT_EQ(seen.back(), Quality::Good);
+}
+
+TEST(VariableStore, ScansQualityAndTimestampArrays) {
+    using xs::core::Quality;
+    xs::core::VariableStore s;
+    for (int k = 0; k < 10; ++k) s.ensure_tag("t" + std::to_string(k), xs::core::Value::make_int(k));
+    for (xs::core::TagId id = 0; id < 10; ++id) {
+        const Quality q = id % 3 == 0 ? Quality::Bad : Quality::Good;
+        s.set(id, xs::core::Value::make_int(static_cast<int>(id)), q, 100 * static_cast<std::int64_t>(id));
+    }
+    s.set_quality(4, Quality::CommFailure);
+
+    EXPECT_EQ(s.count_quality(Quality::Bad), 4u);
+    EXPECT_EQ(s.qualities().size(), 10u);
+
+    std::vector<xs::core::TagId> out;
+    s.tags_not_good(out);
+    EXPECT_EQ(out, (std::vector<xs::core::TagId>{ 0, 3, 4, 6, 9 }));
+
+    out.clear();
+    s.stale_tags(300, out);
+    EXPECT_EQ(out, (std::vector<xs::core::TagId>{ 0, 1, 2 }));
+}
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include "../src/xs_decimation.hpp"
+
+using xs::core::MinMaxDecimator;
+
+TEST(MinMaxDecimator, FoldsSamplesIntoColumns) {
+    MinMaxDecimator d(10, 100);
+    EXPECT_EQ(d.column_width(), 10);
+
+    for (int t = 0; t < 100; ++t) d.add(t, static_cast<double>(t % 10));
+    EXPECT_EQ(d.window_end(), 100);
+    for (std::size_t k = 0; k < 10; ++k) {
+        EXPECT_DOUBLE_EQ(d.column(k).min, 0.0);
+        EXPECT_DOUBLE_EQ(d.column(k).max, 9.0);
+    }
+}
+
+TEST(MinMaxDecimator, ScrollsAndDropsOldSamples) {
+    MinMaxDecimator d(4, 40);
+    d.add(5, 1.0);
+    d.add(35, 2.0);
+    d.add(45, 3.0);
+    EXPECT_EQ(d.window_end(), 50);
+    EXPECT_DOUBLE_EQ(d.column(0).max, -std::numeric_limits<double>::infinity());
+    EXPECT_TRUE(d.column(0).empty());
+    EXPECT_DOUBLE_EQ(d.column(2).max, 2.0);
+    EXPECT_DOUBLE_EQ(d.column(3).max, 3.0);
+
+    d.add(0, 100.0);
+    EXPECT_DOUBLE_EQ(d.column(3).max, 3.0);
+
+    const auto before = d.version();
+    d.advance_to(1000);
+    EXPECT_NE(d.version(), before);
+    for (std::size_t k = 0; k < 4; ++k) EXPECT_TRUE(d.column(k).empty());
+}
+
+TEST(MinMaxDecimator, AcceptsPreAggregatedRanges) {
+    MinMaxDecimator d(2, 20);
+    d.add_range(3, -5.0, 5.0);
+    d.add_range(15, 1.0, 2.0);
+    EXPECT_DOUBLE_EQ(d.column(0).min, -5.0);
+    EXPECT_DOUBLE_EQ(d.column(1).max, 2.0);
+}
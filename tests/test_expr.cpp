@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "../src/xs_expr.hpp"
+
+using xs::core::Expression;
+using xs::core::ExpressionEngine;
+using xs::core::UpdateBatch;
+using xs::core::Value;
+using xs::core::VariableStore;
+
+namespace {
+
+    Value eval(VariableStore& store, const char* source) {
+        Expression e;
+        std::string error;
+        EXPECT_TRUE(e.compile(source, store, error)) << source << ": " << error;
+        Value out;
+        EXPECT_TRUE(e.evaluate(store, out)) << source;
+        return out;
+    }
+
+    std::string compile_error(const char* source) {
+        VariableStore store;
+        Expression e;
+        std::string error;
+        EXPECT_FALSE(e.compile(source, store, error)) << source;
+        return error;
+    }
+
+}
+
+TEST(Expression, Arithmetic) {
+    VariableStore store;
+    store.set("temperature", Value::make_float(25.f));
+
+    EXPECT_DOUBLE_EQ(eval(store, "temperature * 1.8 + 32").as_double(), 77.0);
+    EXPECT_EQ(eval(store, "1 + 2 * 3").as_int(), 7);
+    EXPECT_EQ(eval(store, "(1 + 2) * 3").as_int(), 9);
+    EXPECT_EQ(eval(store, "-7 % 3").as_int(), -1);
+    EXPECT_DOUBLE_EQ(eval(store, "7 / 2").as_double(), 3.5);
+    EXPECT_EQ(eval(store, "max(abs(-4), min(10, 6))").as_int(), 6);
+    EXPECT_EQ(eval(store, "3000000000 + 1").type(), Value::Type::Int64);
+}
+
+TEST(Expression, Int64MinWrapsLikeTheOtherIntegerOps) {
+    VariableStore store;
+    const std::int64_t lowest = std::numeric_limits<std::int64_t>::min();
+    store.set("counter", Value::make_int64(lowest));
+
+    EXPECT_EQ(eval(store, "-counter").as_int64(), lowest);
+    EXPECT_EQ(eval(store, "abs(counter)").as_int64(), lowest);
+    EXPECT_EQ(eval(store, "counter - 1").as_int64(), std::numeric_limits<std::int64_t>::max());
+    EXPECT_EQ(eval(store, "-(counter + 1)").as_int64(), std::numeric_limits<std::int64_t>::max());
+    EXPECT_EQ(eval(store, "abs(counter + 1)").as_int64(), std::numeric_limits<std::int64_t>::max());
+}
+
+TEST(Expression, LogicAndStrings) {
+    VariableStore store;
+    store.set("pump.enabled", Value::make_bool(true));
+    store.set("mode", Value::make_string("auto"));
+
+    EXPECT_EQ(eval(store, "pump.enabled ? \"ON\" : \"OFF\"").as_string(), "ON");
+    EXPECT_EQ(eval(store, "!pump.enabled ? \"ON\" : \"OFF\"").as_string(), "OFF");
+    EXPECT_TRUE(eval(store, "mode == \"auto\" && pump.enabled").as_bool());
+    EXPECT_TRUE(eval(store, "mode != 1 || false").as_bool());
+    EXPECT_EQ(eval(store, "\"mode=\" + mode").as_string(), "mode=auto");
+    EXPECT_EQ(eval(store, "1 < 2 ? 2 > 3 ? 10 : 20 : 30").as_int(), 20);
+}
+
+TEST(Expression, ResolvesTagsAtCompileTime) {
+    VariableStore store;
+    Expression e;
+    std::string error;
+    ASSERT_TRUE(e.compile("a + a * b", store, error)) << error;
+    ASSERT_EQ(e.dependencies().size(), 2u);
+    EXPECT_EQ(store.name(e.dependencies()[0]), "a");
+    EXPECT_EQ(store.name(e.dependencies()[1]), "b");
+}
+
+TEST(Expression, ReportsErrors) {
+    EXPECT_EQ(compile_error(""), "unexpected end of expression");
+    EXPECT_EQ(compile_error("1 +"), "unexpected end of expression");
+    EXPECT_EQ(compile_error("(1 + 2"), "expected ')'");
+    EXPECT_EQ(compile_error("a b"), "unexpected 'b'");
+    EXPECT_EQ(compile_error("sqrt(2)"), "unknown function 'sqrt'");
+    EXPECT_EQ(compile_error("\"open"), "unterminated string");
+    EXPECT_EQ(compile_error("x ? 1"), "expected ':'");
+}
+
+TEST(Expression, RuntimeErrorsLeaveOutputUntouched) {
+    VariableStore store;
+    store.set("d", Value::make_int(0));
+    Expression e;
+    std::string error;
+    ASSERT_TRUE(e.compile("10 / d", store, error));
+    Value out = Value::make_int(42);
+    EXPECT_FALSE(e.evaluate(store, out));
+    EXPECT_EQ(out.as_int(), 42);
+}
+
+TEST(ExpressionEngine, KeepsDerivedTagsUpToDate) {
+    VariableStore store;
+    store.set("pump.enabled", Value::make_bool(false));
+    ExpressionEngine engine(store);
+    std::string error;
+    ASSERT_TRUE(engine.define("pump.enabled.view", "pump.enabled ? \"ON\" : \"OFF\"", error)) << error;
+
+    EXPECT_EQ(store.get_string("pump.enabled.view", ""), "OFF");
+    store.set("pump.enabled", Value::make_bool(true));
+    EXPECT_EQ(store.get_string("pump.enabled.view", ""), "ON");
+}
+
+TEST(ExpressionEngine, EvaluatesOncePerChangeSetInDependencyOrder) {
+    VariableStore store;
+    store.set("a", Value::make_int(1));
+    store.set("b", Value::make_int(2));
+    ExpressionEngine engine(store);
+    std::string error;
+    // Defined out of order on purpose: sum2 depends on sum.
+    ASSERT_TRUE(engine.define("sum2", "sum * 2 + a", error)) << error;
+    ASSERT_TRUE(engine.define("sum", "a + b", error)) << error;
+    EXPECT_EQ(store.get("sum2").as_int(), 7);
+
+    int notified = 0;
+    store.at("sum2").subscribe([&](const Value&) { ++notified; });
+    notified = 0;
+
+    const auto before = engine.evaluations();
+    {
+        UpdateBatch batch(store);
+        store.set("a", Value::make_int(10));
+        store.set("b", Value::make_int(20));
+    }
+    EXPECT_EQ(engine.evaluations() - before, 2u);
+    EXPECT_EQ(store.get("sum").as_int(), 30);
+    EXPECT_EQ(store.get("sum2").as_int(), 70);
+    EXPECT_EQ(notified, 1);
+}
+
+TEST(ExpressionEngine, OnlyDependentsAreEvaluated) {
+    VariableStore store;
+    ExpressionEngine engine(store);
+    std::string error;
+    ASSERT_TRUE(engine.define("x2", "x * 2", error));
+    ASSERT_TRUE(engine.define("y2", "y * 2", error));
+
+    const auto before = engine.evaluations();
+    store.set("x", Value::make_int(4));
+    EXPECT_EQ(engine.evaluations() - before, 1u);
+    EXPECT_EQ(store.get("x2").as_int(), 8);
+}
+
+TEST(ExpressionEngine, RejectsCyclesAndRedefinition) {
+    VariableStore store;
+    ExpressionEngine engine(store);
+    std::string error;
+    ASSERT_TRUE(engine.define("b", "a + 1", error));
+    ASSERT_TRUE(engine.define("c", "b + 1", error));
+    EXPECT_FALSE(engine.define("a", "c + 1", error));
+    EXPECT_EQ(error, "a: circular reference through 'c'");
+    EXPECT_FALSE(engine.define("d", "d + 1", error));
+    EXPECT_FALSE(engine.define("b", "1", error));
+    EXPECT_EQ(error, "b: already defined");
+}
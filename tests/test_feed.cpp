@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/xs_feed.hpp"
+
+using xs::core::IngestQueue;
+using xs::core::Quality;
+using xs::core::ScreenFeed;
+using xs::core::TagId;
+using xs::core::Value;
+using xs::core::VariableStore;
+
+namespace {
+
+    // What build_screen() would leave in a screen's mirror store.
+    void build_mirror(VariableStore& mirror) {
+        mirror.ensure_tag("plc.temp", Value::make_float(0.f));
+        mirror.ensure_tag("pump.run", Value::make_bool(false));
+        mirror.ensure_tag("screen.only", Value::make_int(7));
+    }
+
+}
+
+TEST(ScreenFeed, MirrorsTheScreensTagsFrameByFrame) {
+    VariableStore store;
+    IngestQueue writes(64);
+    const TagId temp = store.ensure_tag("plc.temp", Value::make_float(21.5f));
+    const TagId run = store.ensure_tag("pump.run", Value::make_bool(true));
+    store.ensure_tag("unrelated", Value::make_int(1));
+
+    ScreenFeed feed(store, writes);
+    VariableStore mirror;
+    build_mirror(mirror);
+    feed.connect(mirror);
+    EXPECT_FALSE(feed.apply(mirror));
+
+    feed.publish();
+    ASSERT_TRUE(feed.connected());
+    EXPECT_EQ(store.get("screen.only").as_int(), 7);  // created from the mirror's default
+    ASSERT_TRUE(feed.apply(mirror));
+    EXPECT_FLOAT_EQ(mirror.get_float("plc.temp", 0.f), 21.5f);
+    EXPECT_TRUE(mirror.get_bool("pump.run", false));
+
+    // Only what changed is applied, and each tag notifies once per frame.
+    int notifies = 0;
+    mirror.at(mirror.resolve("plc.temp")).subscribe([&](const Value&) { ++notifies; });
+    notifies = 0;
+    for (int k = 0; k < 5; ++k) store.set(temp, Value::make_float(22.f + static_cast<float>(k)));
+    store.set(run, Value::make_bool(true), Quality::CommFailure, 99);
+    feed.publish();
+    EXPECT_TRUE(feed.has_frame());
+    ASSERT_TRUE(feed.apply(mirror));
+    EXPECT_EQ(notifies, 1);
+    EXPECT_FLOAT_EQ(mirror.get_float("plc.temp", 0.f), 26.f);
+    EXPECT_EQ(mirror.quality(mirror.resolve("pump.run")), Quality::CommFailure);
+    EXPECT_EQ(mirror.timestamp(mirror.resolve("pump.run")), 99);
+
+    // Nothing changed: no frame.
+    feed.publish();
+    EXPECT_FALSE(feed.apply(mirror));
+    EXPECT_TRUE(writes.empty());
+    feed.disconnect();
+}
+
+TEST(ScreenFeed, ScreenWritesGoThroughTheIngestQueue) {
+    VariableStore store;
+    IngestQueue writes(64);
+    ScreenFeed feed(store, writes);
+    VariableStore mirror;
+    build_mirror(mirror);
+    feed.connect(mirror);
+    feed.publish();
+    ASSERT_TRUE(feed.apply(mirror));
+    EXPECT_TRUE(writes.empty());
+
+    mirror.set("pump.run", Value::make_bool(true));
+    EXPECT_FALSE(store.get_bool("pump.run", false));
+    EXPECT_EQ(writes.drain(store), 1u);
+    EXPECT_TRUE(store.get_bool("pump.run", false));
+
+    // The change comes back in the next frame without being written again.
+    feed.publish();
+    ASSERT_TRUE(feed.apply(mirror));
+    EXPECT_TRUE(writes.empty());
+    feed.disconnect();
+}
+
+TEST(ScreenFeed, FullIngestQueueKeepsScreenWritesForTheNextFrame) {
+    VariableStore store;
+    IngestQueue writes(2);
+    const TagId other = store.ensure_tag("other", Value::make_int(0));
+    ScreenFeed feed(store, writes);
+    VariableStore mirror;
+    build_mirror(mirror);
+    feed.connect(mirror);
+    feed.publish();
+    ASSERT_TRUE(feed.apply(mirror));
+
+    while (writes.try_push(other, Value::make_int(1))) {}
+    mirror.set("screen.only", Value::make_int(8));
+    mirror.set("pump.run", Value::make_bool(true));
+    mirror.set("screen.only", Value::make_int(9));  // replaces the waiting write
+    EXPECT_EQ(feed.pending_writes(), 2u);
+
+    // Still full: nothing is lost and nothing blocks.
+    EXPECT_FALSE(feed.apply(mirror));
+    EXPECT_EQ(feed.pending_writes(), 2u);
+
+    writes.drain(store);
+    EXPECT_FALSE(feed.apply(mirror));
+    EXPECT_EQ(feed.pending_writes(), 0u);
+    writes.drain(store);
+    EXPECT_EQ(store.get("screen.only").as_int(), 9);
+    EXPECT_TRUE(store.get_bool("pump.run", false));
+    feed.disconnect();
+}
+
+TEST(ScreenFeed, SuspendedFeedsCostNothingAndCatchUpOnResume) {
+    VariableStore store;
+    IngestQueue writes(64);
+    const TagId temp = store.ensure_tag("plc.temp", Value::make_float(1.f));
+    ScreenFeed feed(store, writes);
+    VariableStore mirror;
+    build_mirror(mirror);
+    feed.connect(mirror);
+    feed.publish();
+    ASSERT_TRUE(feed.apply(mirror));
+    EXPECT_EQ(store.at(temp).subscriber_count(), 1u);
+
+    feed.set_active(false);
+    EXPECT_FALSE(feed.active());
+    EXPECT_EQ(store.at(temp).subscriber_count(), 0u);
+    store.set(temp, Value::make_float(2.f));
+    feed.publish();
+    EXPECT_FALSE(feed.has_frame());
+
+    feed.set_active(true);
+    EXPECT_TRUE(feed.wait_active());
+    feed.publish();
+    ASSERT_TRUE(feed.apply(mirror));
+    EXPECT_FLOAT_EQ(mirror.get_float("plc.temp", 0.f), 2.f);
+
+    feed.close();
+    feed.set_active(false);
+    EXPECT_FALSE(feed.wait_active());
+    feed.disconnect();
+}
+
+TEST(ScreenFeed, RenderThreadNeverWaitsForTheLoop) {
+    VariableStore store;
+    IngestQueue writes(1024);
+    const TagId temp = store.ensure_tag("plc.temp", Value::make_float(0.f));
+    ScreenFeed feed(store, writes);
+
+    std::atomic<bool> done{ false };
+    std::atomic<int> lastSeen{ -1 };
+    std::thread render([&] {
+        VariableStore mirror;
+        build_mirror(mirror);
+        feed.connect(mirror);
+        while (!done) {
+            if (feed.apply(mirror)) lastSeen = static_cast<int>(mirror.get_float("plc.temp", -1.f));
+            std::this_thread::yield();
+        }
+        feed.disconnect();
+    });
+
+    while (!feed.connected()) {
+        feed.publish();
+        std::this_thread::yield();
+    }
+    for (int k = 1; k <= 2000; ++k) {
+        store.set(temp, Value::make_float(static_cast<float>(k)));
+        writes.drain(store);
+        feed.publish();
+    }
+    // The render thread ends up on the last frame, whatever it skipped.
+    for (int spin = 0; spin < 100000 && lastSeen != 2000; ++spin) std::this_thread::yield();
+    done = true;
+    render.join();
+    EXPECT_EQ(lastSeen, 2000);
+    EXPECT_FLOAT_EQ(store.get_float(temp, 0.f), 2000.f);
+}
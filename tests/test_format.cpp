@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <string>
+
+#include "../src/xs_format.hpp"
+#include "alloc_counter.hpp"
+
+using xs::core::FormatBuffer;
+using xs::core::FormatSpec;
+using xs::core::Value;
+using xs::core::format_value;
+
+namespace {
+
+    std::string fmt(const Value& v, const FormatSpec& spec = {}) {
+        FormatBuffer buf;
+        return std::string(format_value(v, spec, buf));
+    }
+
+    FormatSpec notation(FormatSpec::Notation n, int decimals, const std::string& unit = "") {
+        FormatSpec spec;
+        spec.notation = n;
+        spec.decimals = decimals;
+        spec.unit = unit;
+        return spec;
+    }
+
+}
+
+TEST(Format, DefaultsMatchPreviousLabelText) {
+    EXPECT_EQ(fmt(Value::make_float(23.5f)), "23.50");
+    EXPECT_EQ(fmt(Value::make_double(-0.005)), "-0.01");
+    EXPECT_EQ(fmt(Value::make_int(-42)), "-42");
+    EXPECT_EQ(fmt(Value::make_int64(1234567890123ll)), "1234567890123");
+    EXPECT_EQ(fmt(Value::make_bool(true)), "true");
+    EXPECT_EQ(fmt(Value::make_string("Line 3 / Boiler feed pump running in remote mode")),
+        "Line 3 / Boiler feed pump running in remote mode");
+}
+
+TEST(Format, DecimalsUnitsAndThousands) {
+    FormatSpec spec;
+    spec.decimals = 1;
+    spec.unit = "bar";
+    EXPECT_EQ(fmt(Value::make_double(4.26), spec), "4.3 bar");
+
+    spec.decimals = 0;
+    spec.thousands = ',';
+    spec.unit = "rpm";
+    EXPECT_EQ(fmt(Value::make_double(1234567.4), spec), "1,234,567 rpm");
+    EXPECT_EQ(fmt(Value::make_int(-1000), spec), "-1,000 rpm");
+    EXPECT_EQ(fmt(Value::make_int(999), spec), "999 rpm");
+
+    spec.decimals = 3;
+    spec.thousands = '\'';
+    spec.unit.clear();
+    EXPECT_EQ(fmt(Value::make_double(12345.6789), spec), "12'345.679");
+}
+
+TEST(Format, EngineeringNotation) {
+    const FormatSpec eng = notation(FormatSpec::Notation::Engineering, 2);
+    EXPECT_EQ(fmt(Value::make_double(12345.0), eng), "12.35e3");
+    EXPECT_EQ(fmt(Value::make_double(0.00042), eng), "420.00e-6");
+    EXPECT_EQ(fmt(Value::make_double(0.0), eng), "0.00");
+    EXPECT_EQ(fmt(Value::make_int(5), eng), "5.00");
+    // Rounding carries into the next exponent.
+    EXPECT_EQ(fmt(Value::make_double(999.999), eng), "1.00e3");
+
+    const FormatSpec si = notation(FormatSpec::Notation::SiPrefix, 1, "W");
+    EXPECT_EQ(fmt(Value::make_double(1500.0), si), "1.5 kW");
+    EXPECT_EQ(fmt(Value::make_double(-2.5e6), si), "-2.5 MW");
+    EXPECT_EQ(fmt(Value::make_double(0.0125), si), "12.5 mW");
+    EXPECT_EQ(fmt(Value::make_double(7.0), si), "7.0 W");
+    EXPECT_EQ(fmt(Value::make_double(3e18), si), "3.0e18 W");
+}
+
+TEST(Format, OutOfRangeValuesStayInTheBuffer) {
+    FormatSpec spec;
+    spec.decimals = 40;
+    const std::string big = fmt(Value::make_double(1e300), spec);
+    EXPECT_LE(big.size(), FormatBuffer::capacity);
+    EXPECT_NE(big.find("e+300"), std::string::npos);
+
+    EXPECT_EQ(fmt(Value::make_double(std::numeric_limits<double>::infinity())), "inf");
+}
+
+TEST(Format, DoesNotAllocate) {
+    FormatSpec spec;
+    spec.decimals = 1;
+    spec.thousands = ',';
+    spec.unit = "degC";
+    const Value values[] = { Value::make_float(21.5f), Value::make_double(-1234.25), Value::make_int(7) };
+
+    FormatBuffer buf;
+    std::size_t chars = 0;
+    xs::test::AllocScope scope;
+    for (int k = 0; k < 100; ++k) {
+        for (const auto& v : values) chars += format_value(v, spec, buf).size();
+    }
+    EXPECT_EQ(scope.allocations(), 0u);
+    EXPECT_GT(chars, 0u);
+}
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "../src/xs_historian.hpp"
+
+using xs::core::Historian;
+using xs::core::HistoryConfig;
+using xs::core::SampleRing;
+using xs::core::SwingingDoor;
+using xs::core::TagId;
+using xs::core::Value;
+using xs::core::VariableStore;
+
+namespace {
+
+    std::string temp_path(const char* name) {
+        const auto p = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove(p);
+        return p.string();
+    }
+
+    std::vector<std::pair<std::int64_t, double>> compress(SwingingDoor& door, const std::vector<double>& values) {
+        std::vector<std::pair<std::int64_t, double>> out;
+        auto emit = [&](std::int64_t t, double v) { out.emplace_back(t, v); };
+        for (std::size_t k = 0; k < values.size(); ++k) door.add(static_cast<std::int64_t>(k), values[k], emit);
+        door.close(emit);
+        return out;
+    }
+
+}
+
+TEST(SampleRing, KeepsNewestSamplesInOrder) {
+    SampleRing r(4);
+    for (int k = 0; k < 6; ++k) r.push(k, k * 10.0);
+    ASSERT_EQ(r.size(), 4u);
+    EXPECT_EQ(r.time(0), 2);
+    EXPECT_DOUBLE_EQ(r.value(3), 50.0);
+}
+
+TEST(SwingingDoor, StoresOnlyEndpointsOfARamp) {
+    std::vector<double> ramp;
+    for (int k = 0; k <= 100; ++k) ramp.push_back(k * 0.5);
+
+    SwingingDoor door(0.0, 0.1);
+    const auto stored = compress(door, ramp);
+    ASSERT_EQ(stored.size(), 2u);
+    EXPECT_EQ(stored.front().first, 0);
+    EXPECT_EQ(stored.back().first, 100);
+}
+
+TEST(SwingingDoor, ArchivesTheCorner) {
+    std::vector<double> values;
+    for (int k = 0; k <= 10; ++k) values.push_back(k);
+    for (int k = 11; k <= 20; ++k) values.push_back(10.0);
+
+    SwingingDoor door(0.0, 0.01);
+    const auto stored = compress(door, values);
+    ASSERT_EQ(stored.size(), 3u);
+    EXPECT_EQ(stored[1].first, 10);
+    EXPECT_EQ(stored[2].first, 20);
+}
+
+TEST(SwingingDoor, DeadbandDropsNoise) {
+    std::vector<double> values;
+    for (int k = 0; k < 100; ++k) values.push_back((k % 2) ? 20.04 : 19.96);
+
+    SwingingDoor door(0.1, 0.0);
+    EXPECT_EQ(compress(door, values).size(), 1u);
+}
+
+TEST(Historian, RecordsSubscribedTagsInMemory) {
+    VariableStore s;
+    const TagId t = s.ensure_tag("temperature", Value::make_float(20.f));
+
+    std::int64_t now = 1000;
+    Historian h(s);
+    h.set_clock([&]() { return now; });
+    ASSERT_TRUE(h.record(t));
+    EXPECT_FALSE(h.record(t));
+
+    for (int k = 1; k <= 9; ++k) {
+        now += 100;
+        s.set(t, Value::make_float(20.f + static_cast<float>(k)));
+    }
+    EXPECT_EQ(h.stored(t), 10u);
+
+    const auto buckets = h.query(t, 1000, 2000, 2);
+    ASSERT_EQ(buckets.size(), 2u);
+    EXPECT_EQ(buckets[0].count, 5u);
+    EXPECT_DOUBLE_EQ(buckets[0].min, 20.0);
+    EXPECT_DOUBLE_EQ(buckets[0].max, 24.0);
+    EXPECT_DOUBLE_EQ(buckets[1].avg, 27.0);
+}
+
+TEST(Historian, FlushesBlocksAndQueriesThroughTheMapping) {
+    const std::string path = temp_path("xs_historian_test.xsh");
+    {
+        VariableStore s;
+        const TagId flow = s.ensure_tag("flow", Value::make_double(0.0));
+        const TagId other = s.ensure_tag("other", Value::make_double(0.0));
+
+        Historian h(s, path);
+        h.set_clock([]() { return std::int64_t{ 0 }; });
+        h.record(flow, HistoryConfig{ 64, 0.0, 0.0 });
+        h.record(other, HistoryConfig{ 64, 0.0, 0.0 });
+        for (int k = 0; k < 1000; ++k) {
+            h.sample(flow, 10 + k, static_cast<double>(k));
+            h.sample(other, 10 + k, -1.0);
+        }
+        h.flush();
+
+        const auto all = h.query(flow, 10, 2000, 1);
+        ASSERT_EQ(all.size(), 1u);
+        EXPECT_EQ(all[0].count, 1000u);
+        EXPECT_DOUBLE_EQ(all[0].min, 0.0);
+        EXPECT_DOUBLE_EQ(all[0].max, 999.0);
+    }
+
+    VariableStore s;
+    const TagId flow = s.ensure_tag("flow", Value::make_double(0.0));
+    Historian h(s, path);
+
+    const auto buckets = h.query(flow, 10, 1010, 10);
+    ASSERT_EQ(buckets.size(), 10u);
+    EXPECT_EQ(buckets[3].count, 100u);
+    EXPECT_DOUBLE_EQ(buckets[3].min, 300.0);
+    EXPECT_DOUBLE_EQ(buckets[3].max, 399.0);
+    EXPECT_DOUBLE_EQ(buckets[3].avg, 349.5);
+
+    const auto empty = h.query(flow, 5000, 6000, 1);
+    EXPECT_EQ(empty[0].count, 0u);
+    EXPECT_TRUE(std::isnan(empty[0].avg));
+
+    std::filesystem::remove(path);
+}
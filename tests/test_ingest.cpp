@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/xs_ingest.hpp"
+
+using xs::core::IngestQueue;
+using xs::core::TagId;
+using xs::core::TagUpdate;
+using xs::core::Value;
+using xs::core::VariableStore;
+
+TEST(IngestQueue, RoundsCapacityAndRejectsWhenFull) {
+    IngestQueue q(5);
+    EXPECT_EQ(q.capacity(), 8u);
+
+    for (int k = 0; k < 8; ++k) EXPECT_TRUE(q.try_push(0, Value::make_int(k)));
+    EXPECT_FALSE(q.try_push(0, Value::make_int(8)));
+
+    TagUpdate u;
+    EXPECT_TRUE(q.try_pop(u));
+    EXPECT_EQ(u.value.as_int(), 0);
+    EXPECT_TRUE(q.try_push(0, Value::make_int(8)));
+}
+
+TEST(IngestQueue, PushesWakeTheConsumer) {
+    xs::core::WakeSignal wake;
+    IngestQueue q(8);
+    q.set_wake(&wake);
+    EXPECT_FALSE(wake.wait_for(0));
+
+    // A wake that comes first is not lost, and one covers many pushes.
+    q.push(0, Value::make_int(1));
+    q.push(0, Value::make_int(2));
+    EXPECT_TRUE(wake.wait_for(10000));
+    EXPECT_FALSE(wake.wait_for(1));
+
+    std::thread producer([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        q.push(0, Value::make_int(3));
+    });
+    EXPECT_TRUE(wake.wait_for(10000));
+    producer.join();
+
+    q.wake();
+    EXPECT_TRUE(wake.wait_for(0));
+}
+
+TEST(IngestQueue, DrainAppliesAsOneBatch) {
+    VariableStore s;
+    const TagId t = s.ensure_tag("flow", Value::make_float(0.f));
+    int calls = 0;
+    s.at(t).subscribe([&](const Value&) { ++calls; });
+
+    IngestQueue q(64);
+    for (int k = 1; k <= 10; ++k) q.push(t, Value::make_float(static_cast<float>(k)));
+    q.push(xs::core::invalid_tag, Value::make_int(1));
+
+    EXPECT_EQ(q.drain(s), 11u);
+    EXPECT_FLOAT_EQ(s.get_float(t, 0.f), 10.f);
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(IngestQueue, DrainCarriesQualityAndStampsTime) {
+    VariableStore store;
+    const TagId a = store.ensure_tag("a", Value::make_int(0));
+    const TagId b = store.ensure_tag("b", Value::make_int(0));
+
+    IngestQueue q(16);
+    q.push(a, Value::make_int(1));
+    q.push(b, Value::make_int(0), xs::core::Quality::CommFailure, 1234);
+    const std::int64_t before = xs::core::now_ms();
+    EXPECT_EQ(q.drain(store), 2u);
+
+    EXPECT_EQ(store.quality(a), xs::core::Quality::Good);
+    EXPECT_GE(store.timestamp(a), before);
+    EXPECT_EQ(store.quality(b), xs::core::Quality::CommFailure);
+    EXPECT_EQ(store.timestamp(b), 1234);
+}
+
+TEST(IngestQueue, StressManyProducers) {
+    constexpr int producers = 8;
+    constexpr int perProducer = 20000;
+
+    VariableStore s;
+    std::vector<TagId> tags;
+    std::vector<int> lastSeen(producers, -1);
+    bool ordered = true;
+    for (int p = 0; p < producers; ++p) {
+        tags.push_back(s.ensure_tag("io." + std::to_string(p), Value::make_int(-1)));
+        s.at(tags.back()).subscribe([&, p](const Value& v) {
+            if (v.as_int() < lastSeen[p]) ordered = false;
+            lastSeen[p] = v.as_int();
+            });
+    }
+
+    IngestQueue q(1024);
+    std::atomic<bool> go{ false };
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            while (!go.load()) std::this_thread::yield();
+            const std::string text = "long string payload from producer " + std::to_string(p);
+            for (int k = 0; k < perProducer; ++k) {
+                q.push(tags[p], Value::make_int(k));
+                if (k % 1000 == 0) q.push(xs::core::invalid_tag, Value::make_string(text));
+            }
+            });
+    }
+
+    go.store(true);
+    std::size_t received = 0;
+    const std::size_t expected = static_cast<std::size_t>(producers) * (perProducer + perProducer / 1000);
+    while (received < expected) {
+        const std::size_t n = q.drain(s);
+        if (n == 0) std::this_thread::yield();
+        received += n;
+    }
+    for (auto& t : threads) t.join();
+
+    EXPECT_EQ(received, expected);
+    EXPECT_TRUE(ordered);
+    for (int p = 0; p < producers; ++p) EXPECT_EQ(s.get(tags[p]).as_int(), perProducer - 1);
+    TagUpdate u;
+    EXPECT_FALSE(q.try_pop(u));
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "../src/xs_core.hpp"
+
+using xs::core::Metrics;
+using xs::core::MetricsSampler;
+using xs::core::Value;
+using xs::core::VariableStore;
+
+namespace {
+
+    // Resets the thread's counters and restores 'enabled' afterwards.
+    struct MetricsScope {
+        explicit MetricsScope(bool on) {
+            xs::core::metrics() = Metrics{};
+            xs::core::metrics().enabled = on;
+        }
+        ~MetricsScope() { xs::core::metrics() = Metrics{}; }
+    };
+
+}
+
+TEST(Metrics, DisabledCountersStayAtZero) {
+    MetricsScope scope(false);
+    VariableStore s;
+    const auto a = s.ensure_tag("a", Value::make_int(0));
+    s.at(a).subscribe([](const Value&) {});
+    s.set(a, Value::make_int(1));
+    (void)s.get(a);
+
+    const Metrics& m = xs::core::metrics();
+    EXPECT_EQ(m.sets, 0u);
+    EXPECT_EQ(m.gets, 0u);
+    EXPECT_EQ(m.notifies, 0u);
+}
+
+TEST(Metrics, CountsSetsGetsCallbacksAndCascadeDepth) {
+    MetricsScope scope(true);
+    VariableStore s;
+    const auto a = s.ensure_tag("a", Value::make_int(0));
+    const auto b = s.ensure_tag("b", Value::make_int(0));
+    const auto c = s.ensure_tag("c", Value::make_int(0));
+    s.at(a).subscribe([&](const Value& v) { s.set(b, v); });
+    s.at(b).subscribe([&](const Value& v) { s.set(c, v); });
+    s.at(c).subscribe([](const Value&) {});
+    s.at(c).subscribe([](const Value&) {});
+    xs::core::metrics().sets = 0;
+
+    s.set(a, Value::make_int(5));
+    EXPECT_EQ(s.get_float(c, 0.f), 5.f);
+
+    const Metrics& m = xs::core::metrics();
+    EXPECT_EQ(m.sets, 3u);
+    EXPECT_EQ(m.gets, 1u);
+    EXPECT_EQ(m.notifies, 3u);
+    EXPECT_EQ(m.callbacks, 4u);
+    EXPECT_EQ(m.maxDepth, 3u);
+    EXPECT_EQ(m.depth, 0u);
+}
+
+TEST(Metrics, SamplerReportsRatesAndWritesCsv) {
+    MetricsScope scope(true);
+    const std::string path = ::testing::TempDir() + "xs_metrics_test.csv";
+    MetricsSampler sampler(1000);
+    ASSERT_TRUE(sampler.open_csv(path));
+
+    VariableStore s;
+    const auto a = s.ensure_tag("a", Value::make_int(0));
+    EXPECT_FALSE(sampler.tick(10000, s.size(), 0, 0));
+    for (int k = 1; k <= 200; ++k) s.set(a, Value::make_int(k));
+    EXPECT_FALSE(sampler.tick(10500, s.size(), 30, 100));
+    {
+        xs::core::PhaseTimer timer(xs::core::Phase::Draw);
+    }
+    EXPECT_TRUE(sampler.tick(12000, s.size(), 100, 500));
+
+    const MetricsSampler::Sample& last = sampler.last();
+    EXPECT_DOUBLE_EQ(last.seconds, 2.0);
+    EXPECT_DOUBLE_EQ(last.fps, 50.0);
+    EXPECT_DOUBLE_EQ(last.setsPerSec, 100.0);
+    EXPECT_DOUBLE_EQ(last.drawCallsPerFrame, 5.0);
+    EXPECT_EQ(last.tags, 1u);
+    EXPECT_GE(last.phaseMs[static_cast<std::size_t>(xs::core::Phase::Draw)], 0.0);
+
+    std::ifstream in(path);
+    std::string header, row;
+    std::getline(in, header);
+    std::getline(in, row);
+    EXPECT_EQ(header.rfind("time_ms,fps,", 0), 0u);
+    EXPECT_NE(header.find("display_ms"), std::string::npos);
+    EXPECT_EQ(row.rfind("12000,50,", 0), 0u);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/xs_scaling.hpp"
+
+using xs::core::Quality;
+using xs::core::RegisterScale;
+using xs::core::ScaleTable;
+using xs::core::TagId;
+using xs::core::Value;
+using xs::core::VariableStore;
+
+namespace {
+
+    std::vector<RegisterScale> random_scales(std::size_t n, std::mt19937& rng) {
+        std::uniform_real_distribution<float> gain(-2.f, 2.f);
+        std::uniform_real_distribution<float> offset(-100.f, 100.f);
+        std::uniform_int_distribution<int> pick(0, 3);
+        std::vector<RegisterScale> out(n);
+        for (std::size_t k = 0; k < n; ++k) {
+            out[k].tag = static_cast<TagId>(k);
+            out[k].gain = gain(rng);
+            out[k].offset = offset(rng);
+            if (pick(rng) == 0) {
+                out[k].lo = -500.f;
+                out[k].hi = 500.f;
+            }
+            out[k].deadband = pick(rng) == 0 ? 0.f : static_cast<float>(pick(rng)) * 10.f;
+        }
+        return out;
+    }
+
+    // Runs both kernels over several rounds of drifting input and checks
+    // they agree on every scaled value, changed bit and remembered value.
+    template <typename Raw, typename Gen>
+    void compare_kernels(std::size_t n, Gen next) {
+        std::mt19937 rng(7);
+        const auto scales = random_scales(n, rng);
+        ScaleTable simd(scales);
+        ScaleTable scalar(scales);
+
+        std::vector<Raw> raw(n);
+        std::vector<float> a(n), b(n);
+        std::vector<std::uint64_t> ma(xs::core::mask_words(n)), mb(xs::core::mask_words(n));
+        for (int round = 0; round < 8; ++round) {
+            for (auto& r : raw) r = next(rng);
+            const std::size_t na = simd.scale(raw.data(), n, a.data(), ma.data());
+            const std::size_t nb = scalar.scale_scalar(raw.data(), n, b.data(), mb.data());
+            ASSERT_EQ(na, nb) << "round " << round;
+            ASSERT_EQ(ma, mb) << "round " << round;
+            for (std::size_t k = 0; k < n; ++k) {
+                // FLOAT_EQ leaves room for a compiler that fuses the scalar multiply-add.
+                ASSERT_FLOAT_EQ(a[k], b[k]) << k;
+                if (!std::isnan(scalar.last(k))) ASSERT_FLOAT_EQ(simd.last(k), scalar.last(k)) << k;
+                else ASSERT_TRUE(std::isnan(simd.last(k))) << k;
+            }
+        }
+    }
+
+}
+
+TEST(Scaling, VectorKernelMatchesScalarForInt16) {
+    compare_kernels<std::int16_t>(1003, [](std::mt19937& rng) {
+        return static_cast<std::int16_t>(std::uniform_int_distribution<int>(-32768, 32767)(rng));
+    });
+}
+
+TEST(Scaling, VectorKernelMatchesScalarForUInt16) {
+    compare_kernels<std::uint16_t>(1002, [](std::mt19937& rng) {
+        return static_cast<std::uint16_t>(std::uniform_int_distribution<int>(0, 65535)(rng) % 600);
+    });
+}
+
+TEST(Scaling, VectorKernelMatchesScalarForFloat) {
+    compare_kernels<float>(1001, [](std::mt19937& rng) {
+        const int special = std::uniform_int_distribution<int>(0, 50)(rng);
+        if (special == 0) return std::numeric_limits<float>::quiet_NaN();
+        if (special == 1) return std::numeric_limits<float>::infinity();
+        return std::uniform_real_distribution<float>(-400.f, 400.f)(rng);
+    });
+}
+
+TEST(Scaling, DeadbandIsMeasuredFromTheLastWrittenValue) {
+    ScaleTable t({ RegisterScale{ 0, 0.1f, 0.f, 0.f, 100.f, 1.f } });
+    std::vector<float> out(1);
+    std::uint64_t mask = 0;
+
+    const std::int16_t first = 200;
+    EXPECT_EQ(t.scale(&first, 1, out.data(), &mask), 1u);
+    EXPECT_FLOAT_EQ(out[0], 20.f);
+
+    // Creeping by 0.5 at a time is only reported once it adds up past 1.
+    const std::int16_t steps[] = { 205, 210, 215 };
+    std::vector<std::size_t> changed;
+    for (std::int16_t raw : steps) changed.push_back(t.scale(&raw, 1, out.data(), &mask));
+    EXPECT_EQ(changed, (std::vector<std::size_t>{ 0, 0, 1 }));
+    EXPECT_FLOAT_EQ(t.last(0), 21.5f);
+
+    // Clamped at hi.
+    const std::int16_t high = 5000;
+    t.scale(&high, 1, out.data(), &mask);
+    EXPECT_FLOAT_EQ(out[0], 100.f);
+}
+
+TEST(Scaling, ApplyBlockWritesOnlyChangedRegisters) {
+    VariableStore store;
+    std::vector<RegisterScale> scales;
+    for (int k = 0; k < 10; ++k) {
+        const TagId id = store.ensure_tag("rack.ai" + std::to_string(k), Value::make_float(0.f));
+        scales.push_back(RegisterScale{ id, 0.5f, 1.f, 0.f, 1000.f, 2.f });
+    }
+    ScaleTable t(scales);
+
+    int notifications = 0;
+    for (TagId id = 0; id < 10; ++id) store.at(id).subscribe([&](const Value&) { ++notifications; });
+    notifications = 0;
+
+    std::vector<std::uint16_t> raw(10, 100);
+    EXPECT_EQ(xs::core::apply_block(store, t, raw.data(), raw.size(), 5000), 10u);
+    EXPECT_EQ(notifications, 10);
+    EXPECT_FLOAT_EQ(store.get_float(3, 0.f), 51.f);
+    EXPECT_EQ(store.timestamp(3), 5000);
+
+    raw[3] = 102;  // +1, inside the deadband
+    raw[7] = 110;  // +5
+    notifications = 0;
+    EXPECT_EQ(xs::core::apply_block(store, t, raw.data(), raw.size(), 6000), 1u);
+    EXPECT_EQ(notifications, 1);
+    EXPECT_FLOAT_EQ(store.get_float(7, 0.f), 56.f);
+    EXPECT_FLOAT_EQ(store.get_float(3, 0.f), 51.f);
+    EXPECT_EQ(store.timestamp(3), 5000);
+
+    // After a failed read the driver marks the tags and resets the table, so
+    // the next good block restores every tag even if the values are equal.
+    for (TagId id = 0; id < 10; ++id) store.set_quality(id, Quality::CommFailure);
+    t.reset();
+    EXPECT_EQ(xs::core::apply_block(store, t, raw.data(), raw.size(), 7000), 10u);
+    EXPECT_EQ(store.count_quality(Quality::Good), 10u);
+}
+
+TEST(Scaling, PushBlockQueuesOnlyChangedRegisters) {
+    VariableStore store;
+    ScaleTable t;
+    for (int k = 0; k < 5; ++k) t.add(RegisterScale{ store.ensure_tag("t" + std::to_string(k), Value::make_float(0.f)) });
+    xs::core::IngestQueue queue(16);
+
+    std::vector<float> raw = { 1.f, 2.f, 3.f, 4.f, 5.f };
+    EXPECT_EQ(xs::core::push_block(queue, t, raw.data(), raw.size()), 5u);
+    raw[1] = 7.f;
+    raw[4] = 8.f;
+    EXPECT_EQ(xs::core::push_block(queue, t, raw.data(), raw.size()), 2u);
+    EXPECT_EQ(queue.drain(store), 7u);
+    EXPECT_FLOAT_EQ(store.get_float(t.tag(1), 0.f), 7.f);
+    EXPECT_FLOAT_EQ(store.get_float(t.tag(4), 0.f), 8.f);
+    EXPECT_GT(store.timestamp(t.tag(4)), 0);
+}
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../src/xs_screen.hpp"
+
+using xs::core::ButtonAction;
+using xs::core::ScreenCompiler;
+using xs::core::ScreenFile;
+using xs::core::ScreenImage;
+using xs::core::Value;
+using xs::core::VariableStore;
+using xs::core::WidgetKind;
+using xs::core::no_parent;
+
+namespace {
+
+    const char* kScreen = R"(# demo
+screen 800 600
+tag pump.enabled bool true
+tag operator.name string "Ivan Petrov"
+tag temperature float 23.5
+tag counter int64 -42
+
+panel 10 20 700 500 id=root
+    label 40 35 size=22 text="Title \"quoted\""
+    label 40 85 prefix="Pump:" bind=pump.enabled
+    button 240 78 220 42 caption="+0.25" step=temperature by=0.25
+    panel 300 300 200 100
+        textfield 310 310 180 30 hint="Name" bind=operator.name
+    end
+    trend 480 78 240 102 span=60000 bind=temperature id=trend
+end
+)";
+
+    ScreenImage compile(const char* source, std::vector<std::uint8_t>& bytes) {
+        std::string error;
+        ScreenCompiler c;
+        EXPECT_TRUE(c.compile(source, bytes, error)) << error;
+        ScreenImage image;
+        EXPECT_TRUE(image.open(bytes.data(), bytes.size()));
+        return image;
+    }
+
+    std::string compile_error(const char* source) {
+        std::vector<std::uint8_t> bytes;
+        std::string error;
+        ScreenCompiler c;
+        EXPECT_FALSE(c.compile(source, bytes, error));
+        return error;
+    }
+
+    std::string temp_path(const char* name) {
+        const auto p = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove(p);
+        return p.string();
+    }
+
+}
+
+TEST(Screen, CompilesWidgetTree) {
+    std::vector<std::uint8_t> bytes;
+    const ScreenImage image = compile(kScreen, bytes);
+
+    EXPECT_EQ(image.header().width, 800u);
+    EXPECT_EQ(image.header().height, 600u);
+    ASSERT_EQ(image.widget_count(), 7u);
+
+    const auto root = image.widget(0);
+    EXPECT_EQ(root.kind, WidgetKind::Panel);
+    EXPECT_EQ(root.parent, no_parent);
+    EXPECT_EQ(image.str(root.id), "root");
+    EXPECT_FLOAT_EQ(root.w, 700.f);
+
+    const auto title = image.widget(1);
+    EXPECT_EQ(title.kind, WidgetKind::Label);
+    EXPECT_EQ(title.charSize, 22);
+    EXPECT_EQ(image.str(title.text), "Title \"quoted\"");
+
+    const auto step = image.widget(3);
+    EXPECT_EQ(step.action, ButtonAction::Step);
+    EXPECT_EQ(image.str(step.bind), "temperature");
+    EXPECT_FLOAT_EQ(step.param, 0.25f);
+
+    EXPECT_EQ(image.widget(5).kind, WidgetKind::TextField);
+    EXPECT_EQ(image.widget(5).parent, 4u);
+    EXPECT_EQ(image.widget(6).parent, 0u);
+    EXPECT_FLOAT_EQ(image.widget(6).param, 60000.f);
+}
+
+TEST(Screen, CreatesTagsWithInitialValues) {
+    std::vector<std::uint8_t> bytes;
+    const ScreenImage image = compile(kScreen, bytes);
+
+    VariableStore store;
+    image.create_tags(store);
+    EXPECT_EQ(store.size(), 4u);
+    EXPECT_TRUE(store.get_bool("pump.enabled", false));
+    EXPECT_EQ(store.get_string("operator.name", ""), "Ivan Petrov");
+    EXPECT_FLOAT_EQ(store.get_float("temperature", 0.f), 23.5f);
+    EXPECT_EQ(store.get("counter").as_int64(), -42);
+}
+
+TEST(Screen, ExistingTagsKeepTheirValues) {
+    std::vector<std::uint8_t> bytes;
+    const ScreenImage image = compile(kScreen, bytes);
+
+    VariableStore store;
+    store.set("temperature", Value::make_float(99.f));
+    image.create_tags(store);
+    EXPECT_FLOAT_EQ(store.get_float("temperature", 0.f), 99.f);
+}
+
+TEST(Screen, ReportsErrorsWithLineNumbers) {
+    EXPECT_EQ(compile_error("panel 0 0 10 10\nfoo 1 2\nend\n"), "line 2: unknown element 'foo'");
+    EXPECT_EQ(compile_error("label 1 2 text=x\n"), "line 1: 'label' must be inside a panel");
+    EXPECT_EQ(compile_error("panel 0 0 10\n"), "line 1: 'panel' expects 4 numbers");
+    EXPECT_EQ(compile_error("panel 0 0 10 10\n"), "missing 'end' for panel");
+    EXPECT_EQ(compile_error("tag x bool maybe\n"), "line 1: bool must be true or false");
+    EXPECT_EQ(compile_error("panel 0 0 1 1\nlabel 0 0 text=\"open\nend\n"), "line 2: unterminated string");
+    EXPECT_EQ(compile_error("panel 0 0 1 1\nend\npanel 0 0 1 1\nend\n"), "line 3: only one top-level panel is allowed");
+}
+
+TEST(Screen, RejectsTruncatedImages) {
+    std::vector<std::uint8_t> bytes;
+    compile(kScreen, bytes);
+
+    ScreenImage image;
+    EXPECT_FALSE(image.open(bytes.data(), bytes.size() - 1));
+    EXPECT_FALSE(image.open(bytes.data(), 8));
+}
+
+TEST(Screen, LoadsTextAndCompiledFilesAlike) {
+    const std::string text = temp_path("xs_screen_test.xss");
+    const std::string binary = temp_path("xs_screen_test.xsb");
+    {
+        std::ofstream out(text, std::ios::binary);
+        out << kScreen;
+    }
+
+    std::string error;
+    ASSERT_TRUE(xs::core::compile_screen_file(text, binary, error)) << error;
+
+    ScreenFile fromText, fromBinary;
+    ASSERT_TRUE(fromText.load(text, error)) << error;
+    ASSERT_TRUE(fromBinary.load(binary, error)) << error;
+
+    const ScreenImage& a = fromText.image();
+    const ScreenImage& b = fromBinary.image();
+    ASSERT_EQ(a.widget_count(), b.widget_count());
+    ASSERT_EQ(a.tag_count(), b.tag_count());
+    for (std::size_t k = 0; k < a.widget_count(); ++k) {
+        EXPECT_EQ(a.widget(k).kind, b.widget(k).kind);
+        EXPECT_EQ(a.str(a.widget(k).text), b.str(b.widget(k).text));
+    }
+
+    std::filesystem::remove(text);
+    std::filesystem::remove(binary);
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../src/xs_screen_manager.hpp"
+
+#ifndef XS_ASSET_DIR
+#define XS_ASSET_DIR "assets"
+#endif
+
+using xs::core::ScreenCompiler;
+using xs::core::ScreenImage;
+using xs::core::Value;
+using xs::core::VariableStore;
+using xs::ui::Label;
+using xs::ui::ScreenManager;
+
+namespace {
+
+    // Two labels: one on the 800x600 screen, one far below it.
+    std::string screen_source(const std::string& line) {
+        return "screen 800 600\n"
+            "panel 0 0 800 3000\n"
+            "    label 10 10 id=top bind=" + line + ".top\n"
+            "    label 10 2500 id=below bind=" + line + ".below\n"
+            "end\n";
+    }
+
+    struct Screens {
+        std::vector<std::uint8_t> bytesA, bytesB;
+        ScreenImage a, b;
+        sf::Font font;
+        xs::ui::Theme theme;
+        VariableStore store;
+
+        Screens() {
+            compile(screen_source("a"), bytesA, a);
+            compile(screen_source("b"), bytesB, b);
+            font.loadFromFile(XS_ASSET_DIR "/fonts/Roboto-Regular.ttf");
+        }
+
+        static void compile(const std::string& source, std::vector<std::uint8_t>& bytes, ScreenImage& image) {
+            std::string error;
+            ScreenCompiler c;
+            EXPECT_TRUE(c.compile(source, bytes, error)) << error;
+            EXPECT_TRUE(image.open(bytes.data(), bytes.size()));
+        }
+
+        std::size_t subscribers(const char* tag) { return store.at(store.resolve(tag)).subscriber_count(); }
+    };
+
+    ScreenManager::Options options(std::size_t warm) {
+        ScreenManager::Options o;
+        o.warm = warm;
+        return o;
+    }
+
+}
+
+TEST(ScreenManager, PooledWidgetsRebindToTheNewScreensTags) {
+    Screens s;
+    ScreenManager screens(s.font, s.theme, s.store, options(1));
+    ASSERT_TRUE(screens.add("a", s.a));
+    ASSERT_TRUE(screens.add("b", s.b));
+    EXPECT_FALSE(screens.add("a", s.b));
+
+    ASSERT_NE(screens.show("a"), nullptr);
+    const Label* oldTop = screens.current()->find<Label>("top").get();
+    const Label* oldBelow = screens.current()->find<Label>("below").get();
+    EXPECT_EQ(s.subscribers("a.top"), 1u);
+
+    // Only one screen stays built, so b reuses a's widgets.
+    ASSERT_NE(screens.show("b"), nullptr);
+    EXPECT_FALSE(screens.is_warm("a"));
+    EXPECT_EQ(screens.builds(), 2u);
+    EXPECT_GT(screens.pool().reused(), 0u);
+    const auto top = screens.current()->find<Label>("top");
+    EXPECT_TRUE(top.get() == oldTop || top.get() == oldBelow);
+    EXPECT_EQ(s.subscribers("a.top"), 0u);
+    EXPECT_EQ(s.subscribers("b.top"), 1u);
+
+    // The old tag no longer reaches the reused label; the new one does.
+    screens.current()->root->clear_dirty();
+    s.store.set("a.top", Value::make_string("old"));
+    EXPECT_FALSE(top->needs_redraw());
+    s.store.set("b.top", Value::make_string("new"));
+    EXPECT_TRUE(top->needs_redraw());
+}
+
+TEST(ScreenManager, WarmScreensStayBoundAndAreNotRebuilt) {
+    Screens s;
+    ScreenManager screens(s.font, s.theme, s.store, options(2));
+    screens.add("a", s.a);
+    screens.add("b", s.b);
+    screens.show("a");
+    screens.show("b");
+    ASSERT_NE(screens.show("a"), nullptr);
+    EXPECT_EQ(screens.builds(), 2u);
+    EXPECT_EQ(screens.current_name(), "a");
+    EXPECT_TRUE(screens.is_warm("b"));
+    EXPECT_EQ(s.subscribers("a.top"), 1u);
+    EXPECT_EQ(s.subscribers("b.top"), 1u);
+
+    screens.trim();
+    EXPECT_FALSE(screens.is_warm("b"));
+    EXPECT_EQ(s.subscribers("b.top"), 0u);
+    EXPECT_EQ(s.subscribers("a.top"), 1u);
+    EXPECT_EQ(screens.show("missing"), nullptr);
+}
+
+TEST(ScreenManager, OffscreenWidgetsBindWhenRevealed) {
+    Screens s;
+    ScreenManager screens(s.font, s.theme, s.store, options(1));
+    screens.add("a", s.a);
+    ASSERT_NE(screens.show("a"), nullptr);
+    EXPECT_EQ(screens.current()->deferred.size(), 1u);
+    EXPECT_EQ(s.subscribers("a.top"), 1u);
+    EXPECT_EQ(s.subscribers("a.below"), 0u);  // the tag exists, unbound
+
+    screens.set_visible_area(sf::FloatRect(0.f, 2000.f, 800.f, 600.f));
+    EXPECT_TRUE(screens.current()->deferred.empty());
+    EXPECT_EQ(s.subscribers("a.below"), 1u);
+}
@@ -0,0 +1,323 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/xs_protocol.hpp"
+
+using xs::core::TagId;
+using xs::core::Value;
+
+namespace protocol = xs::core::protocol;
+
+TEST(Protocol, ValuesRoundTripThroughFrames) {
+    const std::string text = "a string well past the inline buffer";
+    const std::vector<Value> values = {
+        Value::make_int(-7), Value::make_float(1.25f), Value::make_bool(true), Value::make_string("ok"),
+        Value::make_string(text), Value::make_double(-0.125), Value::make_int64(1LL << 40),
+    };
+
+    std::vector<std::uint8_t> bytes;
+    protocol::FrameWriter out(bytes);
+    out.begin(static_cast<std::uint8_t>(protocol::Op::Update), 9);
+    out.u32(static_cast<std::uint32_t>(values.size()));
+    for (const Value& v : values) out.value(v);
+    out.missing();
+    out.end();
+
+    ASSERT_EQ(protocol::next_frame(bytes.data(), bytes.size() - 1), 0);
+    ASSERT_EQ(protocol::next_frame(bytes.data(), bytes.size()), static_cast<long>(bytes.size()));
+    const protocol::FrameHeader h = protocol::frame_header(bytes.data());
+    EXPECT_EQ(h.request, 9u);
+
+    protocol::FrameReader in(bytes.data() + sizeof(h), bytes.size() - sizeof(h));
+    std::uint32_t n = 0;
+    ASSERT_TRUE(in.u32(n));
+    ASSERT_EQ(n, values.size());
+    for (const Value& expected : values) {
+        Value v;
+        bool present = false;
+        ASSERT_TRUE(in.value(v, present));
+        EXPECT_TRUE(present);
+        EXPECT_TRUE(v.equals(expected));
+    }
+    Value v;
+    bool present = true;
+    ASSERT_TRUE(in.value(v, present));
+    EXPECT_FALSE(present);
+    EXPECT_TRUE(in.done());
+    EXPECT_FALSE(in.value(v, present));
+}
+
+TEST(Protocol, RejectsTruncatedAndOversizedInput) {
+    std::vector<std::uint8_t> bytes;
+    protocol::FrameWriter out(bytes);
+    out.begin(static_cast<std::uint8_t>(protocol::Op::Read), 1);
+    out.value(Value::make_string("truncated text"));
+    out.end();
+
+    // Cut inside the string: the reader must not run past the payload.
+    protocol::FrameReader in(bytes.data() + sizeof(protocol::FrameHeader), bytes.size() - sizeof(protocol::FrameHeader) - 4);
+    Value v;
+    bool present = false;
+    EXPECT_FALSE(in.value(v, present));
+
+    std::uint32_t huge = protocol::max_frame + 1;
+    std::memcpy(bytes.data(), &huge, sizeof(huge));
+    EXPECT_EQ(protocol::next_frame(bytes.data(), bytes.size()), -1);
+    std::uint32_t tiny = 3;
+    std::memcpy(bytes.data(), &tiny, sizeof(tiny));
+    EXPECT_EQ(protocol::next_frame(bytes.data(), bytes.size()), -1);
+}
+
+#ifdef __linux__
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../src/xs_client.hpp"
+#include "../src/xs_server.hpp"
+
+using xs::core::ProtocolClient;
+using xs::core::TagUpdate;
+
+namespace {
+
+    // Plays the UI thread: owns the store and, like the main loop, drains
+    // the ingest queue and publishes. Tests touch the store through run().
+    class ServerHost {
+    public:
+        explicit ServerHost(std::size_t queue = 4096) : m_ingest(queue), m_server(m_store, m_ingest) {
+            m_store.ensure_tag("plc.temp", Value::make_float(21.5f));
+            m_store.ensure_tag("plc.run", Value::make_bool(true));
+            m_store.ensure_tag("operator.name", Value::make_string("ops"));
+        }
+
+        ~ServerHost() {
+            m_stop = true;
+            if (m_thread.joinable()) m_thread.join();
+        }
+
+        bool start(std::string& error) {
+            m_path = (std::filesystem::temp_directory_path() / "xs_test_server.sock").string();
+            if (!m_server.listen_unix(m_path, error) || !m_server.start(error)) return false;
+            m_thread = std::thread([this] { loop(); });
+            return true;
+        }
+
+        const std::string& path() const { return m_path; }
+
+        // While off, the queue fills up as it would behind a busy UI thread.
+        void set_draining(bool on) { m_draining = on; }
+
+        void run(std::function<void(xs::core::VariableStore&)> fn) {
+            std::promise<void> done;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_tasks.push_back([&] {
+                    fn(m_store);
+                    done.set_value();
+                });
+            }
+            done.get_future().wait();
+        }
+
+    private:
+        void loop() {
+            while (!m_stop) {
+                std::vector<std::function<void()>> tasks;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    tasks.swap(m_tasks);
+                }
+                for (auto& t : tasks) t();
+                if (m_draining) m_ingest.drain(m_store);
+                m_server.publish();
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+            // The server is destroyed with the host, on the test thread.
+            m_server.stop();
+        }
+
+        xs::core::VariableStore m_store;
+        xs::core::IngestQueue m_ingest;
+        xs::core::ProtocolServer m_server;
+        std::string m_path;
+        std::thread m_thread;
+        std::atomic<bool> m_stop{ false };
+        std::atomic<bool> m_draining{ true };
+        std::mutex m_mutex;
+        std::vector<std::function<void()>> m_tasks;
+    };
+
+    // Collects pushed updates until pred holds or a second has passed.
+    template <typename Pred>
+    bool wait_for_updates(ProtocolClient& client, std::vector<TagUpdate>& got, Pred pred) {
+        const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (!pred(got)) {
+            if (std::chrono::steady_clock::now() > until) return false;
+            client.poll_updates(got, 20);
+        }
+        return true;
+    }
+
+}
+
+TEST(ProtocolServer, ResolvesReadsAndWrites) {
+    ServerHost host;
+    std::string error;
+    ASSERT_TRUE(host.start(error)) << error;
+    ProtocolClient client;
+    ASSERT_TRUE(client.connect_unix(host.path(), error)) << error;
+
+    std::vector<TagId> ids;
+    ASSERT_TRUE(client.resolve({ "plc.temp", "missing.tag", "operator.name" }, ids));
+    ASSERT_EQ(ids.size(), 3u);
+    EXPECT_EQ(ids[1], xs::core::invalid_tag);
+
+    std::vector<TagUpdate> values;
+    ASSERT_TRUE(client.read({ ids[0], ids[2], 999 }, values));
+    ASSERT_EQ(values.size(), 3u);
+    EXPECT_FLOAT_EQ(values[0].value.as_float(), 21.5f);
+    EXPECT_EQ(values[1].value.as_string(), "ops");
+    EXPECT_EQ(values[2].id, xs::core::invalid_tag);
+
+    std::uint32_t accepted = 0;
+    ASSERT_TRUE(client.write({ TagUpdate{ ids[2], Value::make_string("night shift operator on line 2") } }, true, &accepted));
+    EXPECT_EQ(accepted, 1u);
+    // Writes reach the store on the next drain; reads see them once published.
+    const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    do {
+        ASSERT_TRUE(client.read({ ids[2] }, values));
+    } while (values[0].value.as_string() != "night shift operator on line 2" && std::chrono::steady_clock::now() < until);
+    EXPECT_EQ(values[0].value.as_string(), "night shift operator on line 2");
+
+    std::string stored;
+    host.run([&](xs::core::VariableStore& store) { stored = std::string(store.get("operator.name").as_string()); });
+    EXPECT_EQ(stored, "night shift operator on line 2");
+
+    ASSERT_TRUE(client.resolve({ "rig.new" }, ids, true));
+    ASSERT_NE(ids[0], xs::core::invalid_tag);
+}
+
+TEST(ProtocolServer, SubscriptionsCoalesceAndRespectDeadband) {
+    ServerHost host;
+    std::string error;
+    ASSERT_TRUE(host.start(error)) << error;
+    ProtocolClient client;
+    ASSERT_TRUE(client.connect_unix(host.path(), error)) << error;
+
+    std::vector<TagId> ids;
+    ASSERT_TRUE(client.resolve({ "plc.temp", "plc.run" }, ids));
+    ASSERT_TRUE(client.subscribe({ ids[0] }, 1.0));
+    ASSERT_TRUE(client.subscribe({ ids[1] }));
+
+    std::vector<TagUpdate> got;
+    ASSERT_TRUE(wait_for_updates(client, got, [](const auto& g) { return g.size() >= 2; }));
+    got.clear();
+
+    // Many writes between two publishes arrive as the latest value only.
+    host.run([&](xs::core::VariableStore& store) {
+        for (int k = 0; k < 100; ++k) store.set(ids[1], Value::make_bool(k % 2 == 0));
+        store.set(ids[0], Value::make_float(22.0f));  // inside the deadband
+    });
+    ASSERT_TRUE(wait_for_updates(client, got, [](const auto& g) { return !g.empty(); }));
+    client.poll_updates(got, 50);
+    ASSERT_EQ(got.size(), 1u);
+    EXPECT_EQ(got[0].id, ids[1]);
+    EXPECT_FALSE(got[0].value.as_bool());
+
+    got.clear();
+    host.run([&](xs::core::VariableStore& store) { store.set(ids[0], Value::make_float(23.0f)); });
+    ASSERT_TRUE(wait_for_updates(client, got, [](const auto& g) { return !g.empty(); }));
+    EXPECT_EQ(got[0].id, ids[0]);
+    EXPECT_FLOAT_EQ(got[0].value.as_float(), 23.0f);
+
+    ASSERT_TRUE(client.unsubscribe({ ids[0] }));
+    got.clear();
+    host.run([&](xs::core::VariableStore& store) { store.set(ids[0], Value::make_float(40.0f)); });
+    EXPECT_EQ(client.poll_updates(got, 100), 0u);
+}
+
+TEST(ProtocolServer, FullIngestQueueStallsOnlyTheWritingClient) {
+    ServerHost host(8);
+    std::string error;
+    ASSERT_TRUE(host.start(error)) << error;
+    ProtocolClient writer;
+    ProtocolClient reader;
+    ASSERT_TRUE(writer.connect_unix(host.path(), error)) << error;
+    ASSERT_TRUE(reader.connect_unix(host.path(), error)) << error;
+    std::vector<TagId> ids;
+    ASSERT_TRUE(reader.resolve({ "plc.temp" }, ids));
+
+    host.set_draining(false);
+    std::vector<TagUpdate> updates;
+    for (int k = 1; k <= 50; ++k) updates.push_back(TagUpdate{ ids[0], Value::make_float(static_cast<float>(k)) });
+    std::uint32_t accepted = 0;
+    std::atomic<bool> written{ false };
+    std::thread write([&] {
+        writer.write(updates, true, &accepted);
+        written = true;
+    });
+
+    // The network thread keeps serving the other client meanwhile.
+    std::vector<TagUpdate> values;
+    for (int k = 0; k < 5; ++k) {
+        ASSERT_TRUE(reader.read(ids, values));
+        EXPECT_FLOAT_EQ(values[0].value.as_float(), 21.5f);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_FALSE(written);
+
+    host.set_draining(true);
+    write.join();
+    EXPECT_EQ(accepted, 50u);
+    // The last entries reach the store on the next drain.
+    float stored = 0.f;
+    const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    do {
+        host.run([&](xs::core::VariableStore& store) { stored = store.get_float(ids[0], 0.f); });
+    } while (stored != 50.f && std::chrono::steady_clock::now() < until);
+    EXPECT_FLOAT_EQ(stored, 50.f);
+}
+
+TEST(ProtocolServer, DropsClientsThatSendGarbage) {
+    ServerHost host;
+    std::string error;
+    ASSERT_TRUE(host.start(error)) << error;
+
+    // A frame length below the header size poisons the stream.
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, host.path().c_str(), sizeof(addr.sun_path) - 1);
+    ASSERT_EQ(::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)), 0);
+    const std::uint32_t garbage[4] = { 3, 0, 0, 0 };
+    ASSERT_EQ(::send(fd, garbage, sizeof(garbage), MSG_NOSIGNAL), static_cast<ssize_t>(sizeof(garbage)));
+    timeval timeout{ 1, 0 };
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    char byte = 0;
+    EXPECT_EQ(::recv(fd, &byte, 1, 0), 0);
+    ::close(fd);
+
+    // Other clients are unaffected.
+    ProtocolClient good;
+    ASSERT_TRUE(good.connect_unix(host.path(), error)) << error;
+    std::vector<TagId> ids;
+    ASSERT_TRUE(good.resolve({ "plc.temp" }, ids));
+    std::vector<TagUpdate> values;
+    ASSERT_TRUE(good.read(ids, values));
+    EXPECT_FLOAT_EQ(values[0].value.as_float(), 21.5f);
+}
+
+#endif
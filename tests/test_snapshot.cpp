@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../src/xs_snapshot.hpp"
+
+using xs::core::SnapshotWriter;
+using xs::core::TagId;
+using xs::core::Value;
+using xs::core::VariableStore;
+
+namespace {
+
+    std::string temp_path(const char* name) {
+        const auto p = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove(p);
+        return p.string();
+    }
+
+    const std::string long_text = "a retentive string longer than the inline buffer";
+
+    void fill(VariableStore& store) {
+        store.ensure_tag("plc.count", Value::make_int(-42));
+        store.ensure_tag("plc.temp", Value::make_float(23.5f));
+        store.ensure_tag("plc.run", Value::make_bool(true));
+        store.ensure_tag("operator.name", Value::make_string("ops"));
+        store.ensure_tag("operator.note", Value::make_string(long_text));
+        store.ensure_tag("plc.flow", Value::make_double(0.1));
+        store.ensure_tag("plc.total", Value::make_int64(9000000000LL));
+        store.ensure_tag("plc.empty", Value::make_string(""));
+    }
+
+}
+
+TEST(Snapshot, RoundTripsEveryType) {
+    const std::string path = temp_path("xs_snapshot_roundtrip.xsv");
+    VariableStore src;
+    fill(src);
+    std::string error;
+    ASSERT_TRUE(xs::core::save_snapshot(src, path, error)) << error;
+
+    VariableStore dst;
+    ASSERT_TRUE(xs::core::load_snapshot(dst, path, error)) << error;
+    ASSERT_EQ(dst.size(), src.size());
+    for (TagId id = 0; id < src.size(); ++id) {
+        EXPECT_EQ(dst.name(id), src.name(id));
+        EXPECT_TRUE(dst.get(id).equals(src.get(id))) << src.name(id);
+    }
+    EXPECT_EQ(dst.get("operator.note").as_string(), long_text);
+    EXPECT_EQ(dst.get("plc.total").as_int64(), 9000000000LL);
+    std::filesystem::remove(path);
+}
+
+TEST(Snapshot, RestoresIntoExistingTagsAndNotifiesOnce) {
+    const std::string path = temp_path("xs_snapshot_existing.xsv");
+    VariableStore src;
+    fill(src);
+    std::string error;
+    ASSERT_TRUE(xs::core::save_snapshot(src, path, error)) << error;
+
+    // A screen has already created some tags with defaults, in another order.
+    VariableStore dst;
+    const TagId name = dst.ensure_tag("operator.name", Value::make_string(""));
+    const TagId local = dst.ensure_tag("local.only", Value::make_int(7));
+    int calls = 0;
+    dst.at(name).subscribe([&](const Value&) { ++calls; });
+    calls = 0;
+
+    ASSERT_TRUE(xs::core::load_snapshot(dst, path, error)) << error;
+    EXPECT_EQ(dst.get(name).as_string(), "ops");
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(dst.get(local).as_int(), 7);
+    EXPECT_EQ(dst.size(), src.size() + 1);
+    EXPECT_FALSE(dst.in_batch());
+    std::filesystem::remove(path);
+}
+
+TEST(Snapshot, RejectsMissingAndCorruptFiles) {
+    VariableStore store;
+    std::string error;
+    EXPECT_FALSE(xs::core::load_snapshot(store, temp_path("xs_snapshot_missing.xsv"), error));
+
+    const std::string path = temp_path("xs_snapshot_corrupt.xsv");
+    VariableStore src;
+    fill(src);
+    ASSERT_TRUE(xs::core::save_snapshot(src, path, error)) << error;
+    const auto full = std::filesystem::file_size(path);
+
+    // Truncated: the pool no longer matches the header.
+    std::filesystem::resize_file(path, full - 3);
+    error.clear();
+    EXPECT_FALSE(xs::core::load_snapshot(store, path, error));
+    EXPECT_FALSE(error.empty());
+
+    // A name offset pointing past the pool.
+    ASSERT_TRUE(xs::core::save_snapshot(src, path, error)) << error;
+    {
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(sizeof(xs::core::SnapshotHeader));
+        const std::uint32_t bad = 0xFFFFFF00u;
+        f.write(reinterpret_cast<const char*>(&bad), sizeof(bad));
+    }
+    EXPECT_FALSE(xs::core::load_snapshot(store, path, error));
+
+    // Wrong magic.
+    {
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        f << "not a snapshot at all, just some text";
+    }
+    EXPECT_FALSE(xs::core::load_snapshot(store, path, error));
+    EXPECT_EQ(store.size(), 0u);
+    std::filesystem::remove(path);
+}
+
+TEST(SnapshotWriter, WritesValuesAsOfTheCapture) {
+    const std::string path = temp_path("xs_snapshot_writer.xsv");
+    VariableStore store;
+    fill(store);
+    const TagId count = store.resolve("plc.count");
+    {
+        SnapshotWriter writer(path, 0);
+        ASSERT_TRUE(writer.capture(store));
+        // Changes after the capture belong to the next snapshot.
+        store.set(count, Value::make_int(1));
+        store.ensure_tag("plc.late", Value::make_int(2));
+        writer.wait();
+        EXPECT_EQ(writer.written(), 1u);
+        EXPECT_EQ(writer.failed(), 0u);
+
+        VariableStore first;
+        std::string error;
+        ASSERT_TRUE(xs::core::load_snapshot(first, path, error)) << error;
+        EXPECT_EQ(first.get("plc.count").as_int(), -42);
+        EXPECT_FALSE(first.has("plc.late"));
+
+        // Each buffer picks up the new tag; the destructor flushes the last one.
+        ASSERT_TRUE(writer.capture(store));
+        writer.wait();
+        ASSERT_TRUE(writer.capture(store));
+    }
+
+    VariableStore last;
+    std::string error;
+    ASSERT_TRUE(xs::core::load_snapshot(last, path, error)) << error;
+    EXPECT_EQ(last.get("plc.count").as_int(), 1);
+    EXPECT_EQ(last.get("plc.late").as_int(), 2);
+    EXPECT_EQ(last.get("operator.note").as_string(), long_text);
+    std::filesystem::remove(path);
+}
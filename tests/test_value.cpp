@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "../src/xs_core.hpp"
+#include "alloc_counter.hpp"
+#include "legacy_value.hpp"
+
+using xs::core::Value;
+using xs::test::AllocScope;
+using xs::test::LegacyValue;
+
+namespace {
+    const std::string kShort = "pump.enabled";
+    const std::string kLong = "Line 3 / Boiler feed pump running in remote mode";
+}
+
+TEST(Value, IsSmallerThanLegacyLayout) {
+    EXPECT_LE(sizeof(Value), 24u);
+    EXPECT_LT(sizeof(Value), sizeof(LegacyValue));
+}
+
+TEST(Value, ScalarRoundTrip) {
+    EXPECT_EQ(Value::make_int(-7).as_int(), -7);
+    EXPECT_FLOAT_EQ(Value::make_float(2.5f).as_float(), 2.5f);
+    EXPECT_TRUE(Value::make_bool(true).as_bool());
+    EXPECT_DOUBLE_EQ(Value::make_double(1e300).as_double(), 1e300);
+    EXPECT_EQ(Value::make_int64(1LL << 40).as_int64(), 1LL << 40);
+    EXPECT_EQ(Value::make_int64(5).type(), Value::Type::Int64);
+    EXPECT_EQ(Value().type(), Value::Type::Int);
+}
+
+TEST(Value, StringsInlineAndShared) {
+    const Value s = Value::make_string(kShort);
+    const Value l = Value::make_string(kLong);
+    EXPECT_EQ(s.as_string(), kShort);
+    EXPECT_EQ(l.as_string(), kLong);
+    EXPECT_EQ(Value::make_string("").as_string(), "");
+    EXPECT_EQ(Value::make_int(1).as_string(), "");
+
+    std::string moved = kLong;
+    const Value m = Value::make_string(std::move(moved));
+    EXPECT_EQ(m.as_string(), kLong);
+    EXPECT_TRUE(m.equals(l));
+    EXPECT_FALSE(s.equals(l));
+}
+
+TEST(Value, CopyAndMoveKeepContents) {
+    Value a = Value::make_string(kLong);
+    Value b = a;
+    Value c = std::move(a);
+    EXPECT_EQ(b.as_string(), kLong);
+    EXPECT_EQ(c.as_string(), kLong);
+    EXPECT_EQ(a.type(), Value::Type::Int);
+
+    b = Value::make_float(1.0f);
+    EXPECT_EQ(c.as_string(), kLong);
+    c = c;
+    EXPECT_EQ(c.as_string(), kLong);
+}
+
+TEST(Value, StringReadsAreZeroCopy) {
+    const Value v = Value::make_string(kLong);
+    const AllocScope scope;
+    for (int k = 0; k < 100; ++k) {
+        EXPECT_EQ(v.as_string().size(), kLong.size());
+    }
+    EXPECT_EQ(scope.allocations(), 0u);
+}
+
+TEST(Value, CopiesAllocateLessThanLegacy) {
+    const Value shortV = Value::make_string(kShort);
+    const Value longV = Value::make_string(kLong);
+    const LegacyValue legacyLong = LegacyValue::make_string(kLong);
+
+    std::vector<Value> values(100);
+    std::vector<LegacyValue> legacy(100);
+
+    const AllocScope ours;
+    for (auto& v : values) v = shortV;
+    for (auto& v : values) v = longV;
+    const std::size_t oursAllocs = ours.allocations();
+
+    const AllocScope theirs;
+    for (auto& v : legacy) v = legacyLong;
+    const std::size_t legacyAllocs = theirs.allocations();
+
+    EXPECT_EQ(oursAllocs, 0u);
+    EXPECT_GE(legacyAllocs, legacy.size());
+}
+
+TEST(VariableStore, GetReturnsReferenceWithoutCopy) {
+    xs::core::VariableStore s;
+    const xs::core::TagId t = s.ensure_tag("name", Value::make_string(kLong));
+
+    const AllocScope scope;
+    const Value& v = s.get(t);
+    EXPECT_EQ(v.as_string(), kLong);
+    EXPECT_EQ(s.get("name").as_string(), kLong);
+    EXPECT_EQ(scope.allocations(), 0u);
+}